@@ -8,6 +8,9 @@
 #include "menu.h"
 #include "game.h"
 #include "save_load.h"
+#include "journal.h"
+#include "trace.h"
+#include "position.h"
 #include <vector>
 #include <commdlg.h>
 #include <sstream>
@@ -37,12 +40,43 @@ static void ReturnToMenu()
     Menu_SetHasResume(true);
 }
 
+// autosave journal next to the executable; a game found there on startup is offered as Resume
+static std::wstring JournalFilePath()
+{
+    return Board_ExeDirFilePath(L"autosave.amzj");
+}
+
+// File > Save performance trace (Ctrl+Shift+T): the recent timeline as Chrome trace JSON
+static void DumpTrace(HWND hWnd)
+{
+    std::wstring path = Board_ExeDirFilePath(L"trace.json");
+    if (Trace_Dump(path))
+        MessageBoxW(hWnd, (L"Trace written to " + path + L"\nOpen it in chrome://tracing or ui.perfetto.dev.").c_str(),
+            L"Trace", MB_OK | MB_ICONINFORMATION);
+    else
+        MessageBoxW(hWnd, (L"Cannot write " + path).c_str(), L"Trace", MB_OK | MB_ICONERROR);
+}
+
+static void StartAutosave()
+{
+    std::wstring path = JournalFilePath();
+    JournalState recovered;
+    bool resume = Journal_Recover(path, recovered) && !recovered.line.empty();
+    if (resume)
+    {
+        Journal_RestoreGame(recovered);
+        Menu_SetHasResume(true);
+    }
+    if (Journal_Start(path, resume ? &recovered : nullptr))
+        Game_SetEventCallback(Journal_OnGameEvent);
+}
+
 // NewGame dialog result
 struct NewGameOptions
 {
     bool accepted;
     bool opponentIsAI; // true = AI (default), false = Human
-    int boardSize;     // 8 or 10 (default 8)
+    int boardSize;     // 8, 10, 12, 14 or 16 (default 8)
     int difficulty;    // 0=Easy,1=Intermediate,2=Expert (shown but disabled)
     bool aiFirst;      // true if AI moves first (AI is black), default false (Player first)
 };
@@ -55,6 +89,9 @@ enum {
     NG_ID_OPP_HUMAN,
     NG_ID_BS_8,
     NG_ID_BS_10,
+    NG_ID_BS_12,
+    NG_ID_BS_14,
+    NG_ID_BS_16,
     NG_ID_DIFF_EASY,
     NG_ID_DIFF_INTER,
     NG_ID_DIFF_EXPERT,
@@ -87,8 +124,11 @@ static LRESULT CALLBACK NewGameDlgProc(HWND hwnd, UINT msg, WPARAM wParam, LPARA
         CreateWindowW(L"STATIC", L"Board size:", WS_CHILD | WS_VISIBLE, left, top, 80, 20, hwnd, nullptr, hInst, nullptr);
         CreateWindowW(L"BUTTON", L"8x8", WS_CHILD | WS_VISIBLE | BS_AUTORADIOBUTTON | WS_GROUP, left+90, top, 60, 20, hwnd, (HMENU)NG_ID_BS_8, hInst, nullptr);
         CreateWindowW(L"BUTTON", L"10x10", WS_CHILD | WS_VISIBLE | BS_AUTORADIOBUTTON, left+160, top, 80, 20, hwnd, (HMENU)NG_ID_BS_10, hInst, nullptr);
+        CreateWindowW(L"BUTTON", L"12x12", WS_CHILD | WS_VISIBLE | BS_AUTORADIOBUTTON, left+90, top+22, 70, 20, hwnd, (HMENU)NG_ID_BS_12, hInst, nullptr);
+        CreateWindowW(L"BUTTON", L"14x14", WS_CHILD | WS_VISIBLE | BS_AUTORADIOBUTTON, left+160, top+22, 70, 20, hwnd, (HMENU)NG_ID_BS_14, hInst, nullptr);
+        CreateWindowW(L"BUTTON", L"16x16", WS_CHILD | WS_VISIBLE | BS_AUTORADIOBUTTON, left+230, top+22, 70, 20, hwnd, (HMENU)NG_ID_BS_16, hInst, nullptr);
 
-        top += 34;
+        top += 56;
         // Difficulty radio buttons (shown only when AI selected)
         CreateWindowW(L"STATIC", L"AI difficulty:", WS_CHILD | WS_VISIBLE, left, top, 100, 20, hwnd, nullptr, hInst, nullptr);
         CreateWindowW(L"BUTTON", L"Easy", WS_CHILD | WS_VISIBLE | BS_AUTORADIOBUTTON | WS_GROUP, left+110, top, 80, 20, hwnd, (HMENU)NG_ID_DIFF_EASY, hInst, nullptr);
@@ -106,7 +146,7 @@ static LRESULT CALLBACK NewGameDlgProc(HWND hwnd, UINT msg, WPARAM wParam, LPARA
 
         // set defaults: AI, 8x8, Intermediate, Player first
         CheckRadioButton(hwnd, NG_ID_OPP_AI, NG_ID_OPP_HUMAN, NG_ID_OPP_AI);
-        CheckRadioButton(hwnd, NG_ID_BS_8, NG_ID_BS_10, NG_ID_BS_8);
+        CheckRadioButton(hwnd, NG_ID_BS_8, NG_ID_BS_16, NG_ID_BS_8);
         CheckRadioButton(hwnd, NG_ID_DIFF_EASY, NG_ID_DIFF_EXPERT, NG_ID_DIFF_INTER);
         CheckRadioButton(hwnd, NG_ID_AI_PLAYERFIRST, NG_ID_AI_AIFIRST, NG_ID_AI_PLAYERFIRST);
         // difficulty controls enabled because AI is default
@@ -149,8 +189,9 @@ static LRESULT CALLBACK NewGameDlgProc(HWND hwnd, UINT msg, WPARAM wParam, LPARA
                 {
                     popts->accepted = true;
                     popts->opponentIsAI = (IsDlgButtonChecked(hwnd, NG_ID_OPP_AI) == BST_CHECKED);
-                    if (IsDlgButtonChecked(hwnd, NG_ID_BS_8) == BST_CHECKED) popts->boardSize = 8;
-                    else popts->boardSize = 10;
+                    popts->boardSize = 8;
+                    for (int bs = NG_ID_BS_8; bs <= NG_ID_BS_16; ++bs)
+                        if (IsDlgButtonChecked(hwnd, bs) == BST_CHECKED) popts->boardSize = 8 + 2 * (bs - NG_ID_BS_8);
                     if (popts->opponentIsAI)
                     {
                         if (IsDlgButtonChecked(hwnd, NG_ID_DIFF_EASY) == BST_CHECKED) popts->difficulty = 0;
@@ -194,7 +235,7 @@ static NewGameOptions ShowNewGameDialog(HWND parent)
     wc.lpszClassName = L"NewGameDlgClass";
     RegisterClass(&wc);
 
-    int dlgW = 380, dlgH = 250;
+    int dlgW = 380, dlgH = 272;
     RECT pr; GetClientRect(parent, &pr);
     int px = pr.right/2 - dlgW/2;
     int py = pr.bottom/2 - dlgH/2;
@@ -263,6 +304,13 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
     // register callback so board can return to menu
     Board_SetModeChangeCallback(ReturnToMenu);
 
+    // keep the most recent zones of every thread for DumpTrace
+    Trace_SetThreadName("UI");
+    Trace_Start();
+
+    // restore an interrupted game and journal every move from here on
+    StartAutosave();
+
     HACCEL hAccelTable = LoadAccelerators(hInstance, MAKEINTRESOURCE(IDC_AMAZONCHESS));
 
     MSG msg;
@@ -363,6 +411,9 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             case IDM_EXIT:
                 DestroyWindow(hWnd);
                 break;
+            case IDM_TRACE:
+                DumpTrace(hWnd);
+                break;
             default:
                 return DefWindowProc(hWnd, message, wParam, lParam);
             }
@@ -463,30 +514,22 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                     ofn.lpstrDefExt = L"pbn";
                     if (GetOpenFileNameW(&ofn))
                     {
-                        std::vector<std::wstring> lines;
+                        std::vector<GameMoveInput> moves;
                         int fileBoardSize = 8; bool fileOppIsAI = true; bool fileAIFirst = false;
-                        if (LoadHistoryFromFile(szFile, lines, fileBoardSize, fileOppIsAI, fileAIFirst))
+                        PositionSetup fileSetup;
+                        int badLine = 0;
+                        if (LoadGameFromFile(szFile, moves, fileBoardSize, fileOppIsAI, fileAIFirst, &badLine, &fileSetup))
                         {
-                            // reinit game using header values
-                            Game_Init(fileBoardSize, fileOppIsAI, 1, fileAIFirst);
-                            // replay moves
-                            for (const auto &entry : lines)
+                            // reinit game using header values; .pbn has no difficulty, so the current one is kept
+                            Game_Init(fileBoardSize, fileOppIsAI, Game_GetAIDifficulty(), fileAIFirst, &fileSetup);
+                            // validate and replay the parsed moves in one batch
+                            int illegalLine = 0;
+                            if (!Game_LoadMoves(moves, &illegalLine) && badLine == 0) badLine = illegalLine;
+                            if (badLine != 0)
                             {
-                                if (entry.empty()) continue;
-                                size_t pos = entry.find(L"] ");
-                                if (pos == std::wstring::npos) continue;
-                                std::wstring rest = entry.substr(pos + 2);
-                                std::wstringstream ss(rest);
-                                std::wstring a,b,c;
-                                if (!(ss >> a >> b >> c)) continue;
-                                if (a.size() < 2 || b.size() < 2 || c.size() < 2) continue;
-                                int fromC = a[0] - L'A';
-                                int fromR = _wtoi(a.substr(1).c_str()) - 1;
-                                int toC = b[0] - L'A';
-                                int toR = _wtoi(b.substr(1).c_str()) - 1;
-                                int arrowC = c[0] - L'A';
-                                int arrowR = _wtoi(c.substr(1).c_str()) - 1;
-                                Game_MakeMove(fromR, fromC, toR, toC, arrowR, arrowC);
+                                wchar_t msg[128];
+                                swprintf_s(msg, L"Illegal or malformed move at line %d.\nThe game was loaded up to the move before it.", badLine);
+                                MessageBoxW(hWnd, msg, L"Load Warning", MB_OK | MB_ICONWARNING);
                             }
                             // switch to game interface
                             g_appMode = MODE_GAME;
@@ -521,7 +564,15 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             EndPaint(hWnd, &ps);
         }
         break;
+    case WM_APP_ENGINE_DONE:
+        Board_OnEngineDone(wParam);
+        break;
+    case WM_APP_ENGINE_PROGRESS:
+        Board_OnEngineProgress(wParam);
+        break;
     case WM_DESTROY:
+        Game_SetEventCallback(nullptr);
+        Journal_Stop();
         Board_Cleanup();
         Menu_Cleanup();
         PostQuitMessage(0);
@@ -9,6 +9,7 @@
 #define IDD_ABOUTBOX			103
 #define IDM_ABOUT				104
 #define IDM_EXIT				105
+#define IDM_TRACE				110
 #define IDI_AMAZONCHESS			107
 #define IDI_SMALL				108
 #define IDC_AMAZONCHESS			109
@@ -25,6 +26,6 @@
 #define _APS_NEXT_RESOURCE_VALUE	129
 #define _APS_NEXT_COMMAND_VALUE		32771
 #define _APS_NEXT_CONTROL_VALUE		1000
-#define _APS_NEXT_SYMED_VALUE		110
+#define _APS_NEXT_SYMED_VALUE		111
 #endif
 #endif
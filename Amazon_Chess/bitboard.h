@@ -0,0 +1,169 @@
+#pragma once
+
+// Multi-word bitboards for the territory evaluator (eval.cpp), one instantiation per board size.
+// Bit sq = row * N + col of an N x N board is bit (sq % 64) of word sq / 64, so a 16x16 board fills
+// four words (256 bits). Queen moves are generated set-wise: one shift per step and direction moves
+// every square of a set at once, masked with the empty squares it may enter.
+
+#include <cstdint>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static inline int Bitboard_PopCount64(uint64_t v)
+{
+#ifdef _MSC_VER
+    return (int)__popcnt64(v);
+#else
+    return __builtin_popcountll(v);
+#endif
+}
+
+static inline int Bitboard_LowestBit64(uint64_t v)   // v != 0
+{
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward64(&idx, v);
+    return (int)idx;
+#else
+    return __builtin_ctzll(v);
+#endif
+}
+
+template <int N>
+struct Bitboard
+{
+    static const int kWords = (N * N + 63) / 64;
+    uint64_t w[kWords];
+};
+
+template <int N>
+static inline Bitboard<N> Bitboard_Empty()
+{
+    Bitboard<N> b = {};
+    return b;
+}
+
+template <int N>
+static inline void Bitboard_Set(Bitboard<N> &b, int sq) { b.w[sq >> 6] |= 1ull << (sq & 63); }
+
+template <int N>
+static inline bool Bitboard_Test(const Bitboard<N> &b, int sq) { return (b.w[sq >> 6] >> (sq & 63)) & 1; }
+
+template <int N>
+static inline bool Bitboard_Any(const Bitboard<N> &b)
+{
+    uint64_t any = 0;
+    for (int i = 0; i < Bitboard<N>::kWords; ++i) any |= b.w[i];
+    return any != 0;
+}
+
+template <int N>
+static inline int Bitboard_Count(const Bitboard<N> &b)
+{
+    int n = 0;
+    for (int i = 0; i < Bitboard<N>::kWords; ++i) n += Bitboard_PopCount64(b.w[i]);
+    return n;
+}
+
+template <int N>
+static inline Bitboard<N> operator&(const Bitboard<N> &a, const Bitboard<N> &b)
+{
+    Bitboard<N> r;
+    for (int i = 0; i < Bitboard<N>::kWords; ++i) r.w[i] = a.w[i] & b.w[i];
+    return r;
+}
+
+template <int N>
+static inline Bitboard<N> operator|(const Bitboard<N> &a, const Bitboard<N> &b)
+{
+    Bitboard<N> r;
+    for (int i = 0; i < Bitboard<N>::kWords; ++i) r.w[i] = a.w[i] | b.w[i];
+    return r;
+}
+
+// a & ~b
+template <int N>
+static inline Bitboard<N> Bitboard_AndNot(const Bitboard<N> &a, const Bitboard<N> &b)
+{
+    Bitboard<N> r;
+    for (int i = 0; i < Bitboard<N>::kWords; ++i) r.w[i] = a.w[i] & ~b.w[i];
+    return r;
+}
+
+// calls visit(sq) for every set bit in ascending order
+template <int N, typename Visit>
+static inline void Bitboard_ForEach(const Bitboard<N> &b, Visit visit)
+{
+    for (int i = 0; i < Bitboard<N>::kWords; ++i)
+    {
+        for (uint64_t v = b.w[i]; v; v &= v - 1) visit(i * 64 + Bitboard_LowestBit64(v));
+    }
+}
+
+// every bit moved by S squares (S > 0 towards higher squares); bits leaving the words are dropped
+template <int N, int S>
+static inline Bitboard<N> Bitboard_Shift(const Bitboard<N> &b)
+{
+    const int W = Bitboard<N>::kWords;
+    const int k = S > 0 ? S : -S;   // 1..N+1, always below 64
+    Bitboard<N> r;
+    if (S > 0)
+    {
+        for (int i = W - 1; i > 0; --i) r.w[i] = (b.w[i] << k) | (b.w[i - 1] >> (64 - k));
+        r.w[0] = b.w[0] << k;
+    }
+    else
+    {
+        for (int i = 0; i < W - 1; ++i) r.w[i] = (b.w[i] >> k) | (b.w[i + 1] << (64 - k));
+        r.w[W - 1] = b.w[W - 1] >> k;
+    }
+    return r;
+}
+
+// the board squares, and the board without its first / last column (targets of steps that change
+// the column, so a shift cannot wrap from one row's edge into the next row)
+template <int N>
+struct BitboardMasks
+{
+    Bitboard<N> board, notFirstCol, notLastCol;
+
+    BitboardMasks() : board(), notFirstCol(), notLastCol()
+    {
+        for (int sq = 0; sq < N * N; ++sq)
+        {
+            Bitboard_Set(board, sq);
+            if (sq % N != 0) Bitboard_Set(notFirstCol, sq);
+            if (sq % N != N - 1) Bitboard_Set(notLastCol, sq);
+        }
+    }
+
+    static const BitboardMasks &Get()
+    {
+        static const BitboardMasks masks;
+        return masks;
+    }
+};
+
+// squares reached from 'from' by sliding S squares per step through 'open'
+template <int N, int S>
+static inline Bitboard<N> Bitboard_Slide(const Bitboard<N> &from, const Bitboard<N> &open)
+{
+    Bitboard<N> reach = Bitboard_Empty<N>();
+    for (Bitboard<N> g = Bitboard_Shift<N, S>(from) & open; Bitboard_Any(g); g = Bitboard_Shift<N, S>(g) & open)
+        reach = reach | g;
+    return reach;
+}
+
+// all squares a queen on any square of 'from' reaches over empty squares ('empty' must lie on the board)
+template <int N>
+static inline Bitboard<N> Bitboard_QueenTargets(const Bitboard<N> &from, const Bitboard<N> &empty)
+{
+    const BitboardMasks<N> &m = BitboardMasks<N>::Get();
+    Bitboard<N> east = empty & m.notFirstCol;   // targets of steps that increase the column
+    Bitboard<N> west = empty & m.notLastCol;    // targets of steps that decrease the column
+    return Bitboard_Slide<N, 1>(from, east) | Bitboard_Slide<N, -1>(from, west)
+        | Bitboard_Slide<N, N>(from, empty) | Bitboard_Slide<N, -N>(from, empty)
+        | Bitboard_Slide<N, N + 1>(from, east) | Bitboard_Slide<N, N - 1>(from, west)
+        | Bitboard_Slide<N, -N + 1>(from, east) | Bitboard_Slide<N, -N - 1>(from, west);
+}
@@ -1,6 +1,12 @@
 #include "board.h"
 #include "game.h"
 #include "save_load.h"
+#include "position.h"
+#include "position_index.h"
+#include "engine.h"
+#include "eval.h"
+#include "solved_table.h"
+#include "trace.h"
 // #include "Mouse.h"  // custom mouse removed; use system cursor
 #include <d2d1.h>
 #include <dwrite.h>
@@ -13,6 +19,8 @@
 #include <shellapi.h>
 #include <sstream>
 #include <mmsystem.h>
+#include <mutex>
+#include <thread>
 
 #pragma comment(lib, "d2d1")
 #pragma comment(lib, "dwrite")
@@ -101,21 +109,67 @@ static void RedrawMainWindow()
 }
 
 // Game configuration (make available before rendering code)
-static int g_boardN = 10; // current board size (6/8/10)
+static int g_boardN = 10; // current board size (Game_GetBoardSize)
 static bool g_opponentIsAI = true;
 static int  g_aiDifficulty = 1;
 
 // selection state for human move flow
 enum SelectState { SELECT_IDLE=0, SELECT_MOVE, SELECT_ARROW };
+// optional position index (games.amzx next to the executable, built by Amazon_Tools index-build);
+// the side panel shows how archived games that reached the current position ended
+static PositionIndex g_positionIndex;
+static bool g_positionIndexTried = false;
+static PositionIndexStats g_positionStats;
+static void UpdatePositionStats();
+// optional solved tables (solved5.amzs, solved6.amzs next to the executable, built by Amazon_Tools
+// solve); the engine answers positions found in them with proven wins and losses
+static SolvedTable g_solvedTable;
+static int g_solvedTableSize = 0;   // board size the table was looked up for (0: not yet)
+
+// Engine tasks run one at a time on g_engineThread: the AI opponent's move, or continuous multi-PV
+// analysis of the displayed position (toggled by the "Ana" button). Results come back to the UI
+// thread as WM_APP_ENGINE_DONE / WM_APP_ENGINE_PROGRESS tagged with g_engineGeneration, so messages
+// from a search that was stopped in the meantime are ignored. One Engine (and its transposition
+// table) serves all searches, so stepping back and forth through a game reuses earlier work.
+enum EngineTask { ENGINE_IDLE = 0, ENGINE_AI_MOVE, ENGINE_ANALYSIS };
+#define ANALYSIS_LINES 3
+static Engine* g_engine = nullptr;
+static std::thread g_engineThread;
+static EngineTask g_engineTask = ENGINE_IDLE;   // UI thread only
+static WPARAM g_engineGeneration = 0;
+static Position g_engineRoot;                   // position being searched
+static SearchResult g_engineResult;             // written by the worker, read after join
+static SearchStats g_lastSearchStats;
+static bool g_hasSearchStats = false;
+static int g_lastSearchProven = 0;              // +1 / -1: the last search found a solved win / loss
+static bool g_analysisOn = false;
+static std::mutex g_analysisMutex;
+static SearchResult g_analysisResult;           // latest completed analysis iteration (guarded)
+static D2D1_RECT_F g_btnAnalyzeRect = D2D1::RectF();
+static void StartEngineTask();
+static void StopEngineTask();
+static void AnnounceWinnerIfOver();
+
 static SelectState g_selectState = SELECT_IDLE;
 static int g_selFromR=-1, g_selFromC=-1;
 static int g_selToR=-1, g_selToC=-1;
 static std::vector<std::pair<int,int>> g_legalMoves;
 static std::vector<std::pair<int,int>> g_legalArrows;
 
+// Hint heatmap (the "Hint" toggle): every move of the selected amazon, or of the hovered one while
+// nothing is selected, scored in one Eval_Children batch. Destinations (arrows once a destination
+// is chosen) are tinted from red to green by their best score for the mover. The batch is redone
+// only when the position or the amazon changes.
+static bool g_hintsOn = false;
+static D2D1_RECT_F g_btnHintRect = D2D1::RectF();
+static bool g_hintValid = false;
+static uint64_t g_hintKey = 0;                  // position hash and amazon square of the batch
+static std::vector<PosMove> g_hintMoves;
+static std::vector<int> g_hintScores;
+
 void Board_StartNewGame(int boardSize, bool opponentIsAI, int aiDifficulty)
 {
-    if (boardSize != 6 && boardSize != 8 && boardSize != 10) boardSize = 8;
+    if (!Position_HasStandardSetup(boardSize)) boardSize = 8;
     g_boardN = boardSize;
     g_opponentIsAI = opponentIsAI;
     g_aiDifficulty = (aiDifficulty >= 0) ? aiDifficulty : 1;
@@ -288,8 +342,79 @@ static bool PointInList(const std::vector<std::pair<int,int>>& list, int r, int
     return false;
 }
 
+// square of the amazon the heatmap shows, -1 for none
+static int HintAmazonSquare()
+{
+    if (!g_hintsOn) return -1;
+    if (Game_IsOpponentAI() && Game_IsAIBlack() == Game_IsBlackToMove()) return -1;
+    if (g_selectState != SELECT_IDLE) return g_selFromR * g_boardN + g_selFromC;
+    if (g_hoverRow < 0 || g_hoverCol < 0) return -1;
+    const GamePiece* p = Game_GetPieceAt(g_hoverRow, g_hoverCol);
+    if (!p || p->isWhite == Game_IsBlackToMove()) return -1;
+    return g_hoverRow * g_boardN + g_hoverCol;
+}
+
+static void UpdateHints(int square)
+{
+    Position pos;
+    Game_GetPosition(pos);
+    uint64_t key = pos.symHash[0] ^ ((uint64_t)(square + 1) * 0x9E3779B97F4A7C15ull);
+    if (g_hintValid && key == g_hintKey) return;
+    TRACE_ZONE("hint heatmap");
+    g_hintValid = true;
+    g_hintKey = key;
+    std::vector<PosMove> all;
+    Position_GetKernels(pos.size).generateMoves(pos, all);
+    g_hintMoves.clear();
+    for (const PosMove &m : all) if (m.from == square) g_hintMoves.push_back(m);
+    g_hintScores.resize(g_hintMoves.size());
+    Eval_Children(pos, g_hintMoves.data(), (int)g_hintMoves.size(), g_hintScores.data());
+}
+
+static void DrawHintHeatmap()
+{
+    int from = HintAmazonSquare();
+    if (from < 0) return;
+    UpdateHints(from);
+    const int N = g_boardN;
+    int to = (g_selectState == SELECT_ARROW) ? g_selToR * N + g_selToC : -1;
+    int best[POSITION_MAX_SQUARES];
+    bool shown[POSITION_MAX_SQUARES] = {};
+    int lo = 0, hi = 0;
+    bool any = false;
+    for (size_t i = 0; i < g_hintMoves.size(); ++i)
+    {
+        const PosMove &m = g_hintMoves[i];
+        if (to >= 0 && m.to != to) continue;
+        int sq = to >= 0 ? m.arrow : m.to;
+        int v = g_hintScores[i];
+        if (!shown[sq] || v > best[sq]) best[sq] = v;
+        shown[sq] = true;
+        lo = any ? min(lo, v) : v;
+        hi = any ? max(hi, v) : v;
+        any = true;
+    }
+    if (!any) return;
+
+    ComPtr<ID2D1SolidColorBrush> heat;
+    if (FAILED(g_pRenderTarget->CreateSolidColorBrush(D2D1::ColorF(0, 0, 0, 0), &heat))) return;
+    for (int sq = 0; sq < N * N; ++sq)
+    {
+        if (!shown[sq]) continue;
+        float t = hi > lo ? (float)(best[sq] - lo) / (float)(hi - lo) : 1.0f;
+        heat->SetColor(D2D1::ColorF(1.0f - t, 0.35f + 0.55f * t, 0.15f, 0.55f));
+        int r = sq / N, c = sq % N;
+        D2D1_RECT_F rct = D2D1::RectF(g_boardLeft + c * g_tileSize, g_boardTop + r * g_tileSize,
+                                     g_boardLeft + (c + 1) * g_tileSize, g_boardTop + (r + 1) * g_tileSize);
+        g_pRenderTarget->FillRectangle(rct, heat.Get());
+        // the best squares get a frame
+        if (best[sq] == hi && g_pLineBrush) g_pRenderTarget->DrawRectangle(rct, g_pLineBrush.Get(), 3.0f);
+    }
+}
+
 void Board_Render(HWND hwnd)
 {
+    TRACE_ZONE("Board_Render");
     if (FAILED(CreateDeviceResources(hwnd))) return;
     g_pRenderTarget->BeginDraw();
 
@@ -371,6 +496,7 @@ void Board_Render(HWND hwnd)
             if (g_pRedBrush) g_pRenderTarget->FillRectangle(rct, g_pRedBrush.Get());
         }
     }
+    DrawHintHeatmap();
 
     // decorative outer border and beads
     if (g_pBeadBrush && g_pLineBrush)
@@ -425,6 +551,12 @@ void Board_Render(HWND hwnd)
         // next button below undo
         float ny = uy + btnSize + 6.0f;
         g_btnNextRect = D2D1::RectF(left, ny, left + btnSize, ny + btnSize);
+        // analysis toggle below next
+        float ay = ny + btnSize + 6.0f;
+        g_btnAnalyzeRect = D2D1::RectF(left, ay, left + btnSize, ay + btnSize);
+        // hint heatmap toggle below analysis
+        float hintY = ay + btnSize + 6.0f;
+        g_btnHintRect = D2D1::RectF(left, hintY, left + btnSize, hintY + btnSize);
     }
 
     // draw menu button top-right
@@ -511,6 +643,28 @@ void Board_Render(HWND hwnd)
         g_pRenderTarget->DrawLine(D2D1::Point2F(cx - s, cy), D2D1::Point2F(cx - s - (s*0.9f), cy + (s*0.6f)), arrowBrush2.Get(), 1.4f);
     }
 
+    // draw analysis toggle below next (bead colour while analysis runs)
+    if (g_pHoverBrush && g_pLineBrush)
+    {
+        float corner = 6.0f;
+        ID2D1Brush* fillBrushAna = (g_analysisOn && g_pBeadBrush) ? (ID2D1Brush*)g_pBeadBrush.Get() : (ID2D1Brush*)g_pHoverBrush.Get();
+        g_pRenderTarget->FillRoundedRectangle(D2D1::RoundedRect(g_btnAnalyzeRect, corner, corner), fillBrushAna);
+        g_pRenderTarget->DrawRoundedRectangle(D2D1::RoundedRect(g_btnAnalyzeRect, corner, corner), g_pLineBrush.Get(), 1.0f);
+        if (g_pTextFormatCenter)
+            g_pRenderTarget->DrawTextW(L"Ana", 3, g_pTextFormatCenter.Get(), g_btnAnalyzeRect, g_pLineBrush.Get());
+    }
+
+    // draw hint toggle below analysis (bead colour while the heatmap is on)
+    if (g_pHoverBrush && g_pLineBrush)
+    {
+        float corner = 6.0f;
+        ID2D1Brush* fillBrushHint = (g_hintsOn && g_pBeadBrush) ? (ID2D1Brush*)g_pBeadBrush.Get() : (ID2D1Brush*)g_pHoverBrush.Get();
+        g_pRenderTarget->FillRoundedRectangle(D2D1::RoundedRect(g_btnHintRect, corner, corner), fillBrushHint);
+        g_pRenderTarget->DrawRoundedRectangle(D2D1::RoundedRect(g_btnHintRect, corner, corner), g_pLineBrush.Get(), 1.0f);
+        if (g_pTextFormatCenter)
+            g_pRenderTarget->DrawTextW(L"Hint", 4, g_pTextFormatCenter.Get(), g_btnHintRect, g_pLineBrush.Get());
+    }
+
     // hover highlight
     if (g_mouseInside && g_hoverRow >=0 && g_hoverCol >=0)
     {
@@ -850,6 +1004,78 @@ void Board_Render(HWND hwnd)
             else if (g_pTextFormatCenter)
                 g_pRenderTarget->DrawTextW(aiText.c_str(), (UINT32)aiText.size(), g_pTextFormatCenter.Get(), trect2, g_pLineBrush.Get());
         }
+
+        // archived games reaching this position (only when an index is present)
+        if (g_positionIndex.entries && tfLabel)
+        {
+            wchar_t buf[96];
+            swprintf_s(buf, L"Archive: %u games (B %u / W %u)", g_positionStats.games, g_positionStats.blackWins, g_positionStats.whiteWins);
+            std::wstring idxText = buf;
+            float idxH = panelFontSize * 1.0f;
+            float idxTop = bottomTextTop - idxH - 6.0f;
+            D2D1_RECT_F trect3 = D2D1::RectF(panelLeft + pad, idxTop, circX - circR - pad, idxTop + idxH);
+            g_pRenderTarget->DrawTextW(idxText.c_str(), (UINT32)idxText.size(), tfLabel.Get(), trect3, g_pLineBrush.Get());
+        }
+
+        // engine status under the panel: the analysis lines while analysing, otherwise the last AI
+        // search statistics (full JSON goes to the debugger output)
+        if (g_engineTask == ENGINE_ANALYSIS && tfLabel)
+        {
+            SearchResult snapshot;
+            {
+                std::lock_guard<std::mutex> lock(g_analysisMutex);
+                snapshot = g_analysisResult;
+            }
+            wchar_t buf[64];
+            if (snapshot.proven) swprintf_s(buf, L"Analysis  solved position");
+            else swprintf_s(buf, L"Analysis  depth %d  %.0f kN/s", snapshot.stats.depth, snapshot.stats.nodesPerSecond / 1000.0);
+            std::wstring statusText = buf;
+            for (const SearchLine &line : snapshot.lines)
+            {
+                // score / 100 from the side to move (or the proven result), then the first moves of the line
+                if (snapshot.proven) swprintf_s(buf, L"\n%ls ", line.score > 0 ? L"win" : L"loss");
+                else swprintf_s(buf, L"\n%+.1f ", line.score / 100.0);
+                statusText += buf;
+                Position walk = g_engineRoot;
+                for (size_t i = 0; i < line.pv.size() && i < 3; ++i)
+                {
+                    std::string mv = Engine_MoveToString(walk, line.pv[i]);
+                    statusText += L' ';
+                    statusText.append(mv.begin(), mv.end());
+                    Position_MakeMove(walk, line.pv[i]);
+                }
+            }
+            float statusTop = panelTop + panelH + 10.0f;
+            D2D1_RECT_F statusRect = D2D1::RectF(panelLeft + pad, statusTop, panelLeft + panelW - pad, statusTop + panelFontSize * 5.0f);
+            g_pRenderTarget->DrawTextW(statusText.c_str(), (UINT32)statusText.size(), tfLabel.Get(), statusRect, g_pLineBrush.Get());
+        }
+        else if ((g_engineTask == ENGINE_AI_MOVE || g_hasSearchStats) && tfLabel)
+        {
+            bool thinking = g_engineTask == ENGINE_AI_MOVE;
+            const SearchStats &st = g_lastSearchStats;
+            wchar_t buf[256];
+            if (g_hasSearchStats && g_lastSearchProven && !thinking)
+            {
+                swprintf_s(buf, L"Last search\nsolved position:\nside to move %ls", g_lastSearchProven > 0 ? L"wins" : L"loses");
+            }
+            else if (g_hasSearchStats)
+            {
+                double ttRate = st.ttProbes ? 100.0 * st.ttHits / st.ttProbes : 0.0;
+                double cacheRate = st.evalCalls ? 100.0 * st.evalCacheHits / st.evalCalls : 0.0;
+                double evalShare = st.timeMs > 0.0 ? 100.0 * st.evalMs / st.timeMs : 0.0;
+                swprintf_s(buf, L"%ls\ndepth %d/%d  %.0f kN/s\nTT hits %.0f%%  cache %.0f%%\neval %.0f%% of %.1f s",
+                    thinking ? L"AI thinking..." : L"Last search",
+                    st.depth, st.seldepth, st.nodesPerSecond / 1000.0, ttRate, cacheRate, evalShare, st.timeMs / 1000.0);
+            }
+            else
+            {
+                swprintf_s(buf, L"AI thinking...");
+            }
+            std::wstring statusText = buf;
+            float statusTop = panelTop + panelH + 10.0f;
+            D2D1_RECT_F statusRect = D2D1::RectF(panelLeft + pad, statusTop, panelLeft + panelW - pad, statusTop + panelFontSize * 5.0f);
+            g_pRenderTarget->DrawTextW(statusText.c_str(), (UINT32)statusText.size(), tfLabel.Get(), statusRect, g_pLineBrush.Get());
+        }
     }
 
     HRESULT hrEnd = g_pRenderTarget->EndDraw();
@@ -900,7 +1126,8 @@ void Board_OnMouseMove(int x, int y)
     bool overHistory = PtInRectF(g_btnHistoryRect, x, y);
     bool overUndo = PtInRectF(g_btnUndoRect, x, y);
     bool overNext = PtInRectF(g_btnNextRect, x, y);
-    if (PtInRectF(g_menuButtonRectWindow, x, y) || overHistory) overButton = true;
+    if (PtInRectF(g_menuButtonRectWindow, x, y) || overHistory || PtInRectF(g_btnAnalyzeRect, x, y)
+        || PtInRectF(g_btnHintRect, x, y)) overButton = true;
 
     // if over undo/next and disabled, show forbidden cursor
     if (overUndo && ! (Game_GetCurrentMoveIndex() > 0))
@@ -924,6 +1151,41 @@ void Board_OnMouseMove(int x, int y)
     }
 }
 
+// after a move (human or AI), check for end-game and announce the winner
+static void AnnounceWinnerIfOver()
+{
+    int winner = Game_CheckForWinner(); // 0 none, 1 white wins, 2 black wins
+    if (winner != 0)
+    {
+        // display winner
+        std::wstring msg = (winner == 1) ? L"White wins!" : L"Black wins!";
+        // choose sound: if human vs human -> chimes; if vs AI -> chimes if human wins else explode
+        if (!Game_IsOpponentAI())
+        {
+            PlayWavByName(L"chimes.wav");
+        }
+        else
+        {
+            // determine human color: if AI is black, human is white
+            bool aiIsBlack = Game_IsAIBlack();
+            bool humanWon = (winner == 1 && !aiIsBlack) || (winner == 2 && aiIsBlack) ? false : false; // placeholder
+            // compute correctly: humanIsWhite = !aiIsBlack
+            bool humanIsWhite = !aiIsBlack;
+            if ((winner == 1 && humanIsWhite) || (winner == 2 && !humanIsWhite))
+            {
+                // human won
+                PlayWavByName(L"chimes.wav");
+            }
+            else
+            {
+                // AI won
+                PlayWavByName(L"explode.wav");
+            }
+        }
+        MessageBoxW(nullptr, msg.c_str(), L"Game Over", MB_OK | MB_ICONINFORMATION);
+    }
+}
+
 void CancelSelection()
 {
     g_selectState = SELECT_IDLE;
@@ -933,6 +1195,7 @@ void CancelSelection()
 
 void Board_OnLButtonDown(int x, int y)
 {
+    TRACE_ZONE("Board_OnLButtonDown");
     // check menu button first
     if (PtInRectF(g_menuButtonRectWindow, x, y))
     {
@@ -967,6 +1230,24 @@ void Board_OnLButtonDown(int x, int y)
         return;
     }
 
+    // analysis toggle
+    if (PtInRectF(g_btnAnalyzeRect, x, y))
+    {
+        g_analysisOn = !g_analysisOn;
+        if (g_engineTask == ENGINE_ANALYSIS) StopEngineTask(); // an AI move in progress is left alone
+        StartEngineTask();
+        RedrawMainWindow();
+        return;
+    }
+
+    // hint heatmap toggle
+    if (PtInRectF(g_btnHintRect, x, y))
+    {
+        g_hintsOn = !g_hintsOn;
+        RedrawMainWindow();
+        return;
+    }
+
     // if widget visible, check its controls
     if (g_widgetVisible)
     {
@@ -1023,6 +1304,8 @@ void Board_OnLButtonDown(int x, int y)
     // selection state machine for human play
     if (g_selectState == SELECT_IDLE)
     {
+        // the AI's pieces are not selectable (also while it is thinking)
+        if (Game_IsOpponentAI() && Game_IsAIBlack() == Game_IsBlackToMove()) return;
         const GamePiece* p = Game_GetPieceAt(row,col);
         if (!p) return; // clicked empty
         bool blackToMove = Game_IsBlackToMove();
@@ -1070,36 +1353,7 @@ void Board_OnLButtonDown(int x, int y)
         PlayWavByName(L"click.wav");
 
         // after move, check for end-game
-        int winner = Game_CheckForWinner(); // 0 none, 1 white wins, 2 black wins
-        if (winner != 0)
-        {
-            // display winner
-            std::wstring msg = (winner == 1) ? L"White wins!" : L"Black wins!";
-            // choose sound: if human vs human -> chimes; if vs AI -> chimes if human wins else explode
-            if (!Game_IsOpponentAI())
-            {
-                PlayWavByName(L"chimes.wav");
-            }
-            else
-            {
-                // determine human color: if AI is black, human is white
-                bool aiIsBlack = Game_IsAIBlack();
-                bool humanWon = (winner == 1 && !aiIsBlack) || (winner == 2 && aiIsBlack) ? false : false; // placeholder
-                // compute correctly: humanIsWhite = !aiIsBlack
-                bool humanIsWhite = !aiIsBlack;
-                if ((winner == 1 && humanIsWhite) || (winner == 2 && !humanIsWhite))
-                {
-                    // human won
-                    PlayWavByName(L"chimes.wav");
-                }
-                else
-                {
-                    // AI won
-                    PlayWavByName(L"explode.wav");
-                }
-            }
-            MessageBoxW(nullptr, msg.c_str(), L"Game Over", MB_OK | MB_ICONINFORMATION);
-        }
+        AnnounceWinnerIfOver();
 
         // update history window if open
         UpdateHistoryWindowContents();
@@ -1122,6 +1376,13 @@ void Board_OnMouseWheel(int delta)
 
 void Board_Cleanup()
 {
+    StopEngineTask();
+    if (g_engine)
+    {
+        Engine_Destroy(g_engine);
+        g_engine = nullptr;
+    }
+    SolvedTable_Close(g_solvedTable);
     DiscardDeviceResources();
     g_pDWriteFactory.Reset();
     g_pD2DFactory.Reset();
@@ -1166,6 +1427,24 @@ LRESULT CALLBACK HistoryWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
         }
         break;
     }
+    case WM_DRAWITEM:
+    {
+        // rows are formatted when drawn, so only the moves in view ever become text
+        const DRAWITEMSTRUCT* dis = (const DRAWITEMSTRUCT*)lParam;
+        if (dis->CtlID != ID_HISTORY_LIST || dis->itemID == (UINT)-1) break;
+        const wchar_t* text = (dis->itemID == 0) ? L"Game Start" : Game_GetMoveText((int)dis->itemID - 1);
+        bool selected = (dis->itemState & ODS_SELECTED) != 0;
+        FillRect(dis->hDC, &dis->rcItem, GetSysColorBrush(selected ? COLOR_HIGHLIGHT : COLOR_WINDOW));
+        HGDIOBJ oldFont = g_hHistoryFont ? SelectObject(dis->hDC, g_hHistoryFont) : nullptr;
+        SetBkMode(dis->hDC, TRANSPARENT);
+        SetTextColor(dis->hDC, GetSysColor(selected ? COLOR_HIGHLIGHTTEXT : COLOR_WINDOWTEXT));
+        RECT rc = dis->rcItem;
+        rc.left += 2;
+        DrawTextW(dis->hDC, text, -1, &rc, DT_SINGLELINE | DT_VCENTER | DT_NOPREFIX);
+        if (oldFont) SelectObject(dis->hDC, oldFont);
+        if (dis->itemState & ODS_FOCUS) DrawFocusRect(dis->hDC, &dis->rcItem);
+        return TRUE;
+    }
     case WM_DESTROY:
         if (g_hHistoryEdit)
         {
@@ -1190,7 +1469,6 @@ LRESULT CALLBACK HistoryWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
 
 static void CreateOrUpdateHistoryWindow()
 {
-    const auto &hist = Game_GetHistory();
     if (g_hHistoryWnd && IsWindow(g_hHistoryWnd))
     {
         // refresh contents
@@ -1221,8 +1499,10 @@ static void CreateOrUpdateHistoryWindow()
     ShowWindow(g_hHistoryWnd, SW_SHOWNOACTIVATE);
     SetWindowPos(g_hHistoryWnd, HWND_TOPMOST, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
 
-    // create a listbox instead of edit so clicks are easy to detect
-    g_hHistoryEdit = CreateWindowExW(WS_EX_CLIENTEDGE, L"LISTBOX", nullptr, WS_CHILD | WS_VISIBLE | LBS_NOTIFY | LBS_NOINTEGRALHEIGHT | WS_VSCROLL,
+    // create a listbox instead of edit so clicks are easy to detect; it holds no strings, only a row
+    // count, and draws each row from the move log (WM_DRAWITEM)
+    g_hHistoryEdit = CreateWindowExW(WS_EX_CLIENTEDGE, L"LISTBOX", nullptr,
+        WS_CHILD | WS_VISIBLE | LBS_NOTIFY | LBS_NOINTEGRALHEIGHT | LBS_OWNERDRAWFIXED | LBS_NODATA | WS_VSCROLL,
         8, 8, 400, 520, g_hHistoryWnd, (HMENU)ID_HISTORY_LIST, GetModuleHandle(NULL), nullptr);
     if (!g_hHistoryEdit) return;
 
@@ -1242,7 +1522,17 @@ static void CreateOrUpdateHistoryWindow()
     g_hHistoryFont = CreateFontW(-MulDiv(14, dpi, 72), 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE, DEFAULT_CHARSET,
         OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS, CLEARTYPE_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Consolas");
     if (g_hHistoryFont)
+    {
         SendMessageW(g_hHistoryEdit, WM_SETFONT, (WPARAM)g_hHistoryFont, TRUE);
+        // owner-drawn rows take their height from the font
+        HDC listDc = GetDC(g_hHistoryEdit);
+        HGDIOBJ oldFont = SelectObject(listDc, g_hHistoryFont);
+        TEXTMETRICW tm = {};
+        GetTextMetricsW(listDc, &tm);
+        SelectObject(listDc, oldFont);
+        ReleaseDC(g_hHistoryEdit, listDc);
+        SendMessageW(g_hHistoryEdit, LB_SETITEMHEIGHT, 0, (LPARAM)(tm.tmHeight + 2));
+    }
 
     // register history-changed callback so the window updates in real-time
     Game_SetHistoryChangedCallback(OnGameHistoryChanged);
@@ -1256,14 +1546,9 @@ static void CreateOrUpdateHistoryWindow()
 static void UpdateHistoryWindowContents()
 {
     if (!g_hHistoryEdit || !IsWindow(g_hHistoryEdit)) return;
-    SendMessageW(g_hHistoryEdit, LB_RESETCONTENT, 0, 0);
-    // first item is Game Start (0 moves applied)
-    SendMessageW(g_hHistoryEdit, LB_ADDSTRING, 0, (LPARAM)L"Game Start");
-    const auto &hist = Game_GetHistory();
-    for (size_t i = 0; i < hist.size(); ++i)
-    {
-        SendMessageW(g_hHistoryEdit, LB_ADDSTRING, 0, (LPARAM)hist[i].c_str());
-    }
+    // first row is Game Start (0 moves applied), then one row per move; rows are drawn on demand
+    SendMessageW(g_hHistoryEdit, LB_SETCOUNT, (WPARAM)(Game_GetTotalMoves() + 1), 0);
+    InvalidateRect(g_hHistoryEdit, nullptr, FALSE);
     // set selection to current move index (number of moves applied)
     int sel = Game_GetCurrentMoveIndex();
     if (sel < 0) sel = 0;
@@ -1277,9 +1562,176 @@ static void UpdateHistoryWindowContents()
     }
 }
 
+std::wstring Board_ExeDirFilePath(const std::wstring &name)
+{
+    wchar_t path[MAX_PATH] = {};
+    DWORD len = GetModuleFileNameW(nullptr, path, MAX_PATH);
+    if (len == 0 || len == MAX_PATH) return name;
+    for (int i = (int)len - 1; i >= 0; --i) { if (path[i] == L'\\' || path[i] == L'/') { path[i+1] = 0; break; } }
+    return std::wstring(path) + name;
+}
+
 // callback invoked by game logic when history changes
+static void UpdatePositionStats()
+{
+    if (!g_positionIndexTried)
+    {
+        g_positionIndexTried = true;
+        PositionIndex_Open(g_positionIndex, Board_ExeDirFilePath(L"games.amzx"));
+    }
+    g_positionStats = PositionIndexStats();
+    if (!g_positionIndex.entries) return;
+    Position pos;
+    Game_GetPosition(pos);
+    size_t count = 0;
+    const PositionIndexEntry* hits = PositionIndex_Find(g_positionIndex, Position_CanonicalKey(pos), count);
+    PositionIndex_Summarize(hits, count, g_positionStats);
+}
+
+static bool IsAITurn()
+{
+    return Game_IsOpponentAI() && Game_IsAIBlack() == Game_IsBlackToMove();
+}
+
+static void OnAnalysisProgress(void* user, const SearchResult &progress)
+{
+    {
+        std::lock_guard<std::mutex> lock(g_analysisMutex);
+        g_analysisResult = progress;
+    }
+    HWND hwnd = FindMainWindow();
+    if (hwnd) PostMessageW(hwnd, WM_APP_ENGINE_PROGRESS, (WPARAM)(size_t)user, 0);
+}
+
+// opens the solved table for the board size about to be searched; only while no search is running
+static void AttachSolvedTable(int size)
+{
+    if (size == g_solvedTableSize) return;
+    g_solvedTableSize = size;
+    SolvedTable_Close(g_solvedTable);
+    if (SolvedTable_CodeBits(size) > 0)
+        SolvedTable_Open(g_solvedTable, Board_ExeDirFilePath(L"solved" + std::to_wstring(size) + L".amzs"));
+    Engine_SetSolvedTable(g_engine, g_solvedTable.records ? &g_solvedTable : nullptr);
+}
+
+// stops and joins the running search; its pending messages become stale
+static void StopEngineTask()
+{
+    if (g_engineThread.joinable())
+    {
+        Engine_Stop(g_engine);
+        g_engineThread.join();
+    }
+    g_engineTask = ENGINE_IDLE;
+    ++g_engineGeneration;
+}
+
+// Starts the AI search when it is the AI's turn at the end of the move line, otherwise analysis of
+// the displayed position if it is switched on.
+static void StartEngineTask()
+{
+    if (g_engineTask != ENGINE_IDLE) return;
+    HWND hwnd = FindMainWindow();
+    if (!hwnd) return;
+    Position pos;
+    Game_GetPosition(pos);
+    if (!Position_HasAnyMove(pos)) return;
+
+    EngineTask task = ENGINE_IDLE;
+    SearchLimits limits;
+    if (IsAITurn() && !Game_CanStepForward())
+    {
+        static const int kThinkMs[3] = { 300, 1000, 3000 }; // easy, intermediate, expert
+        static const uint64_t kSolverNodes[3] = { 0, 1000000, 4000000 };   // endgame solver budget
+        // selective search (SearchLimits): reductions after this many moves, and the destinations
+        // and arrows per destination kept at each node. Only expert uses it: 3,12,6 beat full width
+        // at equal time on 8x8 to 16x16, narrower settings did not.
+        static const int kLmrMoves[3] = { 0, 0, 3 };
+        static const int kKeepDestinations[3] = { 0, 0, 12 };
+        static const int kKeepArrows[3] = { 0, 0, 6 };
+        int level = Game_GetAIDifficulty();
+        task = ENGINE_AI_MOVE;
+        limits.timeMs = kThinkMs[level];
+        limits.solverNodes = kSolverNodes[level];
+        limits.lmrMoves = kLmrMoves[level];
+        limits.keepDestinations = kKeepDestinations[level];
+        limits.keepArrows = kKeepArrows[level];
+    }
+    else if (g_analysisOn)
+    {
+        // infinite multi-PV search on every core (and the endgame solver once few squares remain),
+        // below normal priority so the UI stays responsive
+        task = ENGINE_ANALYSIS;
+        limits.timeMs = 0;
+        limits.multiPV = ANALYSIS_LINES;
+        limits.threads = (int)std::thread::hardware_concurrency();
+        limits.background = true;
+        limits.solverNodes = 50000000;
+        limits.onProgress = OnAnalysisProgress;
+        limits.progressUser = (void*)(size_t)g_engineGeneration;
+        std::lock_guard<std::mutex> lock(g_analysisMutex);
+        g_analysisResult = SearchResult();
+    }
+    if (task == ENGINE_IDLE) return;
+
+    if (!g_engine) g_engine = Engine_Create(64);
+    AttachSolvedTable(pos.size);
+    g_engineRoot = pos;
+    g_engineTask = task;
+    WPARAM generation = g_engineGeneration;
+    g_engineThread = std::thread([hwnd, limits, generation]()
+    {
+        Trace_SetThreadName("engine");
+        Engine_Search(g_engine, g_engineRoot, limits, g_engineResult);
+        PostMessageW(hwnd, WM_APP_ENGINE_DONE, generation, 0);
+    });
+}
+
+void Board_OnEngineProgress(WPARAM generation)
+{
+    if (generation == g_engineGeneration && g_engineTask == ENGINE_ANALYSIS) RedrawMainWindow();
+}
+
+void Board_OnEngineDone(WPARAM generation)
+{
+    if (generation != g_engineGeneration || g_engineTask == ENGINE_IDLE) return;
+    if (g_engineThread.joinable()) g_engineThread.join();
+    EngineTask task = g_engineTask;
+    g_engineTask = ENGINE_IDLE;
+    ++g_engineGeneration;
+    g_lastSearchStats = g_engineResult.stats;
+    g_hasSearchStats = true;
+    g_lastSearchProven = g_engineResult.proven ? (g_engineResult.score > 0 ? 1 : -1) : 0;
+    std::string json;
+    SearchResult_ToJson(g_engineRoot, g_engineResult, json);
+    json += "\n";
+    OutputDebugStringA(json.c_str());
+
+    if (task == ENGINE_AI_MOVE && g_engineResult.hasMove)
+    {
+        // the search is stopped whenever the position changes, so it still matches the board
+        const PosMove &m = g_engineResult.best;
+        int n = g_engineRoot.size;
+        Game_MakeMove(m.from / n, m.from % n, m.to / n, m.to % n, m.arrow / n, m.arrow % n);
+        PlayWavByName(L"click.wav");
+        AnnounceWinnerIfOver();
+        UpdateHistoryWindowContents();
+    }
+    RedrawMainWindow();
+}
+
 static void OnGameHistoryChanged()
 {
+    UpdatePositionStats();
+    // a search of a position that is no longer displayed is abandoned and the engine restarts
+    // on the new one (analysis) or moves for the AI if it is now its turn
+    if (g_engineTask != ENGINE_IDLE)
+    {
+        Position pos;
+        Game_GetPosition(pos);
+        if (pos.symHash[0] != g_engineRoot.symHash[0]) StopEngineTask();
+    }
+    StartEngineTask();
     // If history window is open, refresh contents but do not change activation
     if (g_hHistoryWnd && IsWindow(g_hHistoryWnd))
     {
@@ -1293,25 +1745,11 @@ static void OnGameHistoryChanged()
 static void PlayWavByName(const wchar_t* filename)
 {
     if (!filename) return;
-    wchar_t path[MAX_PATH] = {};
-    DWORD len = GetModuleFileNameW(nullptr, path, MAX_PATH);
-    if (len == 0 || len == MAX_PATH)
-    {
-        path[0] = 0;
-    }
-    else
-    {
-        for (int i = (int)len - 1; i >= 0; --i) { if (path[i] == L'\\' || path[i] == L'/') { path[i+1] = 0; break; } }
-    }
-
-    wchar_t fullPath[MAX_PATH] = {};
-    wcscpy_s(fullPath, MAX_PATH, path);
-    wcscat_s(fullPath, MAX_PATH, L"resources\\");
-    wcscat_s(fullPath, MAX_PATH, filename);
+    std::wstring fullPath = Board_ExeDirFilePath(std::wstring(L"resources\\") + filename);
 
-    if (GetFileAttributesW(fullPath) != INVALID_FILE_ATTRIBUTES)
+    if (GetFileAttributesW(fullPath.c_str()) != INVALID_FILE_ATTRIBUTES)
     {
-        PlaySoundW(fullPath, nullptr, SND_FILENAME | SND_ASYNC | SND_NODEFAULT);
+        PlaySoundW(fullPath.c_str(), nullptr, SND_FILENAME | SND_ASYNC | SND_NODEFAULT);
     }
     else if (GetFileAttributesW(filename) != INVALID_FILE_ATTRIBUTES)
     {
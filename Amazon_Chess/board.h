@@ -3,6 +3,7 @@
 #include <Windows.h>
 #include <d2d1.h>
 #include <wrl/client.h>
+#include <string>
 
 // Board module public API
 HRESULT Board_CreateDeviceIndependentResources();
@@ -19,6 +20,18 @@ void    Board_OnMouseLeave();
 void    Board_OnLButtonDown(int x, int y);
 void    Board_OnLButtonUp(int x, int y);
 
+// The engine (AI opponent or analysis) searches on a worker thread and posts these messages to the
+// main window; WPARAM carries the search generation so results of a stopped search are dropped.
+// The window procedure forwards them to the board, which plays the AI move or redraws on the UI thread.
+#define WM_APP_ENGINE_DONE     (WM_APP + 1)
+#define WM_APP_ENGINE_PROGRESS (WM_APP + 2)
+void    Board_OnEngineDone(WPARAM generation);
+void    Board_OnEngineProgress(WPARAM generation);
+
+// File 'name' next to the executable (just 'name' if the executable path is unknown); the position
+// index, solved tables, autosave journal, trace dump and sounds all live there.
+std::wstring Board_ExeDirFilePath(const std::wstring &name);
+
 // Callback from board to application (e.g. return to menu)
 typedef void(*ModeChangeCallback)();
 void    Board_SetModeChangeCallback(ModeChangeCallback cb);
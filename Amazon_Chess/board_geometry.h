@@ -0,0 +1,88 @@
+#pragma once
+
+// Board geometry for one board size, generated at compile time: the queen ray from every square in
+// each of the 8 directions (nearest square first) and the square maps of the 8 board symmetries.
+// Kernels templated on the size walk these rays instead of stepping rows/cols with bounds checks.
+// The territory evaluator works on bitboards (bitboard.h) instead.
+
+#include <cstdint>
+
+#define GEOMETRY_DIRS 8
+
+template <int N>
+struct BoardGeometry
+{
+    uint8_t rayLen[N * N][GEOMETRY_DIRS];
+    uint8_t ray[N * N][GEOMETRY_DIRS][N - 1];
+};
+
+template <int N>
+struct BoardSymmetry
+{
+    uint8_t sym[8][N * N];                      // [symmetry][square] -> mapped square
+};
+
+template <int N>
+constexpr BoardGeometry<N> MakeBoardGeometry()
+{
+    BoardGeometry<N> g = {};
+    const int dr[GEOMETRY_DIRS] = { -1, 1, 0, 0, -1, -1, 1, 1 };
+    const int dc[GEOMETRY_DIRS] = { 0, 0, -1, 1, -1, 1, -1, 1 };
+    for (int r = 0; r < N; ++r)
+    {
+        for (int c = 0; c < N; ++c)
+        {
+            int sq = r * N + c;
+            for (int d = 0; d < GEOMETRY_DIRS; ++d)
+            {
+                int len = 0;
+                for (int rr = r + dr[d], cc = c + dc[d]; rr >= 0 && rr < N && cc >= 0 && cc < N; rr += dr[d], cc += dc[d])
+                    g.ray[sq][d][len++] = (uint8_t)(rr * N + cc);
+                g.rayLen[sq][d] = (uint8_t)len;
+            }
+        }
+    }
+    return g;
+}
+
+template <int N>
+constexpr BoardSymmetry<N> MakeBoardSymmetry()
+{
+    BoardSymmetry<N> g = {};
+    const int m = N - 1;
+    for (int r = 0; r < N; ++r)
+    {
+        for (int c = 0; c < N; ++c)
+        {
+            int sq = r * N + c;
+            // same order as the symmetry hashes of Position
+            g.sym[0][sq] = (uint8_t)(r * N + c);
+            g.sym[1][sq] = (uint8_t)(r * N + (m - c));
+            g.sym[2][sq] = (uint8_t)((m - r) * N + c);
+            g.sym[3][sq] = (uint8_t)((m - r) * N + (m - c));
+            g.sym[4][sq] = (uint8_t)(c * N + r);
+            g.sym[5][sq] = (uint8_t)(c * N + (m - r));
+            g.sym[6][sq] = (uint8_t)((m - c) * N + r);
+            g.sym[7][sq] = (uint8_t)((m - c) * N + (m - r));
+        }
+    }
+    return g;
+}
+
+template <int N>
+struct Geometry
+{
+    static constexpr BoardGeometry<N> value = MakeBoardGeometry<N>();
+};
+
+template <int N>
+constexpr BoardGeometry<N> Geometry<N>::value;
+
+template <int N>
+struct Symmetry
+{
+    static constexpr BoardSymmetry<N> value = MakeBoardSymmetry<N>();
+};
+
+template <int N>
+constexpr BoardSymmetry<N> Symmetry<N>::value;
@@ -0,0 +1,27 @@
+#pragma once
+
+// Little-endian integer packing shared by the binary file formats (.amzb, .amzx, .amzs, .amzt,
+// .amzc, ...), so every format reads and writes its headers the same way, and a portable fopen.
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+static inline void ByteIO_PutU16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static inline void ByteIO_PutU32(uint8_t* p, uint32_t v) { for (int i = 0; i < 4; ++i) p[i] = (uint8_t)(v >> (8 * i)); }
+static inline void ByteIO_PutU64(uint8_t* p, uint64_t v) { for (int i = 0; i < 8; ++i) p[i] = (uint8_t)(v >> (8 * i)); }
+static inline uint16_t ByteIO_GetU16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline uint32_t ByteIO_GetU32(const uint8_t* p) { uint32_t v = 0; for (int i = 3; i >= 0; --i) v = (v << 8) | p[i]; return v; }
+static inline uint64_t ByteIO_GetU64(const uint8_t* p) { uint64_t v = 0; for (int i = 7; i >= 0; --i) v = (v << 8) | p[i]; return v; }
+
+// fopen without the MSVC deprecation warning; nullptr on failure
+static inline FILE* ByteIO_OpenFile(const std::string &path, const char* mode)
+{
+#ifdef _WIN32
+    FILE* f = nullptr;
+    if (fopen_s(&f, path.c_str(), mode) != 0) return nullptr;
+    return f;
+#else
+    return fopen(path.c_str(), mode);
+#endif
+}
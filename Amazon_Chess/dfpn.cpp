@@ -0,0 +1,515 @@
+#include "dfpn.h"
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+// Proof numbers in negamax form: phi is the proof number of "the side to move wins", delta its
+// disproof number. A won position is (0, kInf), a lost one (kInf, 0).
+static const uint32_t kInf = 0x3FFFFFFF;
+
+struct DfpnEntry
+{
+    uint64_t key = 0;
+    uint32_t phi = 0, delta = 0;
+    uint64_t work = 0;          // positions expanded below the entry, decides replacement
+};
+
+struct DfpnChild
+{
+    PosMove move;
+    uint64_t key;
+    uint32_t phi, delta;
+};
+
+struct DfpnSolver
+{
+    std::vector<DfpnEntry> tt;  // two-slot buckets
+    size_t ttMask = 0;
+
+    // per solve
+    const PositionKernels* kernels = nullptr;
+    DfpnLimits limits;
+    Clock::time_point start;
+    uint64_t nodes = 0;
+    bool aborted = false;
+    bool rootHasMove = false;
+    PosMove rootMove = {};
+    std::vector<PosMove> moves;
+    std::vector<DfpnChild> children[POSITION_MAX_SQUARES + 1];   // per ply, kept while searching below
+    std::vector<uint64_t> countMemo;    // one-player move counts that fell short (SeparatedOutcome)
+};
+
+// ---- regions ----
+
+// Labels the 8-connected regions of non-arrow squares; region[sq] is the region index of a square
+// (255 for arrows) and owners[r] has bit 0 set for a white amazon in region r, bit 1 for a black one.
+static int LabelRegions(const Position &pos, uint8_t* region, uint8_t* owners, int* empty)
+{
+    const int n = pos.size, squares = n * n;
+    for (int sq = 0; sq < squares; ++sq) region[sq] = 255;
+    uint8_t stack[POSITION_MAX_SQUARES];
+    int count = 0;
+    for (int start = 0; start < squares; ++start)
+    {
+        if (pos.cell[start] == CELL_ARROW || region[start] != 255) continue;
+        uint8_t r = (uint8_t)count++;
+        owners[r] = 0;
+        empty[r] = 0;
+        int top = 0;
+        stack[top++] = (uint8_t)start;
+        region[start] = r;
+        while (top > 0)
+        {
+            int sq = stack[--top];
+            uint8_t c = pos.cell[sq];
+            if (c == CELL_EMPTY) ++empty[r];
+            else if (c == CELL_WHITE) owners[r] |= 1;
+            else owners[r] |= 2;
+            int row = sq / n, col = sq % n;
+            for (int dr = -1; dr <= 1; ++dr)
+            {
+                for (int dc = -1; dc <= 1; ++dc)
+                {
+                    int rr = row + dr, cc = col + dc;
+                    if (rr < 0 || rr >= n || cc < 0 || cc >= n) continue;
+                    int next = rr * n + cc;
+                    if (pos.cell[next] == CELL_ARROW || region[next] != 255) continue;
+                    region[next] = r;
+                    stack[top++] = (uint8_t)next;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+void Dfpn_AnalyzeRegions(const Position &pos, DfpnRegions &out)
+{
+    out = DfpnRegions();
+    uint8_t region[POSITION_MAX_SQUARES], owners[POSITION_MAX_SQUARES];
+    int empty[POSITION_MAX_SQUARES];
+    int count = LabelRegions(pos, region, owners, empty);
+    for (int r = 0; r < count; ++r)
+    {
+        if (owners[r] == 0) continue;
+        out.reachableEmpty += empty[r];
+        if (owners[r] == 3) out.sharedEmpty += empty[r];
+        else out.ownEmpty[owners[r] - 1] += empty[r];
+    }
+}
+
+// ---- separated positions ----
+
+// Once no region is shared, each side plays alone: every move fills exactly one empty square of the
+// mover's own regions, and the side to move wins iff it can make more moves than the opponent. Those
+// counts are found by a one-player search over one side's moves, which is far smaller than the game
+// tree that interleaves both sides' moves.
+
+static const int kCountMemo = 1 << 14;
+static const uint64_t kCountBudget = 20000;    // one-player nodes per separated position
+
+struct MoveCounter
+{
+    int n = 0;
+    uint8_t cell[POSITION_MAX_SQUARES];
+    uint8_t amazon[POSITION_AMAZONS];
+    uint8_t piece = 0;          // CELL_WHITE or CELL_BLACK
+    uint64_t hash = 0;
+    uint64_t nodes = 0;
+    bool aborted = false;
+};
+
+// random keys for arrows and amazons per square
+struct CountKeys
+{
+    uint64_t arrow[POSITION_MAX_SQUARES], amazon[POSITION_MAX_SQUARES];
+
+    CountKeys()
+    {
+        uint64_t x = 0x2545F4914F6CDD1Dull;
+        for (int sq = 0; sq < POSITION_MAX_SQUARES; ++sq)
+        {
+            arrow[sq] = Next(x);
+            amazon[sq] = Next(x);
+        }
+    }
+
+    static uint64_t Next(uint64_t &x)   // splitmix64
+    {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+};
+
+static const CountKeys &Keys()
+{
+    static const CountKeys keys;
+    return keys;
+}
+
+static const int kDirRow[8] = { -1, -1, -1, 0, 0, 1, 1, 1 };
+static const int kDirCol[8] = { -1, 0, 1, -1, 1, -1, 0, 1 };
+
+// empty squares 8-connected to the counter's amazons: no more moves than that are possible
+static int ReachableEmpty(const MoveCounter &c)
+{
+    uint8_t seen[POSITION_MAX_SQUARES] = {};
+    uint8_t stack[POSITION_MAX_SQUARES];
+    int top = 0, count = 0;
+    for (int i = 0; i < POSITION_AMAZONS; ++i) { seen[c.amazon[i]] = 1; stack[top++] = c.amazon[i]; }
+    while (top > 0)
+    {
+        int sq = stack[--top];
+        int row = sq / c.n, col = sq % c.n;
+        for (int d = 0; d < 8; ++d)
+        {
+            int rr = row + kDirRow[d], cc = col + kDirCol[d];
+            if (rr < 0 || rr >= c.n || cc < 0 || cc >= c.n) continue;
+            int next = rr * c.n + cc;
+            if (seen[next] || c.cell[next] != CELL_EMPTY) continue;
+            seen[next] = 1;
+            stack[top++] = (uint8_t)next;
+            ++count;
+        }
+    }
+    return count;
+}
+
+// Moves the counter's side can certainly still make: every amazon walks one king step at a time and
+// shoots back at the square it left, preferring squares with few free neighbours so it does not cut
+// its region in two. Any queen move needs a free neighbour, so a walk only stops when it is stuck.
+static int GreedyMoveCount(const MoveCounter &c)
+{
+    const int n = c.n;
+    uint8_t cell[POSITION_MAX_SQUARES];
+    std::copy(c.cell, c.cell + n * n, cell);
+    int moves = 0;
+    for (int i = 0; i < POSITION_AMAZONS; ++i)
+    {
+        int sq = c.amazon[i];
+        for (;;)
+        {
+            int best = -1, bestFree = 9;
+            int row = sq / n, col = sq % n;
+            for (int d = 0; d < 8; ++d)
+            {
+                int rr = row + kDirRow[d], cc = col + kDirCol[d];
+                if (rr < 0 || rr >= n || cc < 0 || cc >= n || cell[rr * n + cc] != CELL_EMPTY) continue;
+                int freeCount = 0;
+                for (int e = 0; e < 8; ++e)
+                {
+                    int r2 = rr + kDirRow[e], c2 = cc + kDirCol[e];
+                    if (r2 < 0 || r2 >= n || c2 < 0 || c2 >= n) continue;
+                    int around = r2 * n + c2;
+                    freeCount += (around != sq && cell[around] == CELL_EMPTY);
+                }
+                if (freeCount < bestFree) { bestFree = freeCount; best = rr * n + cc; }
+            }
+            if (best < 0) break;
+            cell[sq] = CELL_ARROW;
+            cell[best] = c.piece;
+            sq = best;
+            ++moves;
+        }
+    }
+    return moves;
+}
+
+// true if the counter's side can make 'need' more moves on its own; memo holds positions (hash
+// with the need in the low bits) known to fall short
+static bool CanMakeMoves(MoveCounter &c, uint64_t* memo, int need)
+{
+    if (need <= 0) return true;
+    if (++c.nodes > kCountBudget) { c.aborted = true; return false; }
+    if (ReachableEmpty(c) < need) return false;
+    if (GreedyMoveCount(c) >= need) return true;
+    uint64_t slot = c.hash & (kCountMemo - 1);
+    uint64_t entry = (c.hash & ~0xFFull) | (uint64_t)need;
+    if ((memo[slot] & ~0xFFull) == (c.hash & ~0xFFull) && (int)(memo[slot] & 0xFF) <= need) return false;
+
+    const CountKeys &keys = Keys();
+    const int n = c.n;
+    for (int i = 0; i < POSITION_AMAZONS; ++i)
+    {
+        int from = c.amazon[i];
+        for (int d = 0; d < 8; ++d)
+        {
+            for (int rr = from / n + kDirRow[d], cc = from % n + kDirCol[d];
+                rr >= 0 && rr < n && cc >= 0 && cc < n && c.cell[rr * n + cc] == CELL_EMPTY;
+                rr += kDirRow[d], cc += kDirCol[d])
+            {
+                int to = rr * n + cc;
+                c.cell[from] = CELL_EMPTY;
+                c.cell[to] = c.piece;
+                c.amazon[i] = (uint8_t)to;
+                for (int e = 0; e < 8; ++e)
+                {
+                    for (int ar = rr + kDirRow[e], ac = cc + kDirCol[e];
+                        ar >= 0 && ar < n && ac >= 0 && ac < n && c.cell[ar * n + ac] == CELL_EMPTY;
+                        ar += kDirRow[e], ac += kDirCol[e])
+                    {
+                        int arrow = ar * n + ac;
+                        uint64_t delta = keys.amazon[from] ^ keys.amazon[to] ^ keys.arrow[arrow];
+                        c.cell[arrow] = CELL_ARROW;
+                        c.hash ^= delta;
+                        bool ok = CanMakeMoves(c, memo, need - 1);
+                        c.hash ^= delta;
+                        c.cell[arrow] = CELL_EMPTY;
+                        if (ok || c.aborted)
+                        {
+                            c.cell[to] = CELL_EMPTY;
+                            c.cell[from] = c.piece;
+                            c.amazon[i] = (uint8_t)from;
+                            return ok;
+                        }
+                    }
+                }
+                c.cell[to] = CELL_EMPTY;
+                c.cell[from] = c.piece;
+                c.amazon[i] = (uint8_t)from;
+            }
+        }
+    }
+    memo[slot] = entry;
+    return false;
+}
+
+static void InitCounter(MoveCounter &c, const Position &pos, int side)
+{
+    c.n = pos.size;
+    std::copy(pos.cell, pos.cell + c.n * c.n, c.cell);
+    std::copy(pos.amazon[side], pos.amazon[side] + POSITION_AMAZONS, c.amazon);
+    c.piece = (uint8_t)(side == 0 ? CELL_WHITE : CELL_BLACK);
+    c.hash = side ? 0x9E3779B97F4A7C15ull : 0;
+    const CountKeys &keys = Keys();
+    for (int sq = 0; sq < c.n * c.n; ++sq)
+    {
+        if (c.cell[sq] == CELL_ARROW) c.hash ^= keys.arrow[sq];
+        else if (c.cell[sq] == c.piece) c.hash ^= keys.amazon[sq];
+    }
+    c.nodes = 0;
+    c.aborted = false;
+}
+
+// DFPN_UNKNOWN unless the sides are separated and the counts were found within the budget
+static DfpnOutcome SeparatedOutcome(const Position &pos, uint64_t* memo)
+{
+    DfpnRegions regions;
+    Dfpn_AnalyzeRegions(pos, regions);
+    if (regions.sharedEmpty > 0) return DFPN_UNKNOWN;
+    int us = pos.blackToMove ? 1 : 0, them = 1 - us;
+    MoveCounter mine, theirs;
+    InitCounter(mine, pos, us);
+    InitCounter(theirs, pos, them);
+    int theirLow = GreedyMoveCount(theirs);
+    if (regions.ownEmpty[us] <= theirLow) return DFPN_LOSS;
+    if (GreedyMoveCount(mine) > regions.ownEmpty[them]) return DFPN_WIN;
+
+    // the opponent's exact count, then whether we can make one more
+    int theirs_ = theirLow;
+    while (CanMakeMoves(theirs, memo, theirs_ + 1)) ++theirs_;
+    if (theirs.aborted) return DFPN_UNKNOWN;
+    bool win = CanMakeMoves(mine, memo, theirs_ + 1);
+    if (mine.aborted) return DFPN_UNKNOWN;
+    return win ? DFPN_WIN : DFPN_LOSS;
+}
+
+// ---- transposition table ----
+
+static DfpnEntry* Lookup(DfpnSolver* s, uint64_t key)
+{
+    size_t b = (size_t)key & s->ttMask & ~(size_t)1;
+    if (s->tt[b].key == key && s->tt[b].work) return &s->tt[b];
+    if (s->tt[b + 1].key == key && s->tt[b + 1].work) return &s->tt[b + 1];
+    return nullptr;
+}
+
+static void Store(DfpnSolver* s, uint64_t key, uint32_t phi, uint32_t delta, uint64_t work)
+{
+    size_t b = (size_t)key & s->ttMask & ~(size_t)1;
+    DfpnEntry* e = &s->tt[b];
+    if (e->key != key)
+    {
+        DfpnEntry* other = &s->tt[b + 1];
+        // keep the entry that took more work to compute
+        if (other->key == key || other->work < e->work) e = other;
+    }
+    e->key = key;
+    e->phi = phi;
+    e->delta = delta;
+    e->work = std::max<uint64_t>(work, 1);
+}
+
+// ---- search ----
+
+static void CheckLimits(DfpnSolver* s)
+{
+    if (s->limits.maxNodes && s->nodes >= s->limits.maxNodes) s->aborted = true;
+    if (s->limits.stop && s->limits.stop->load(std::memory_order_relaxed)) s->aborted = true;
+    if (s->limits.timeMs > 0
+        && std::chrono::duration<double, std::milli>(Clock::now() - s->start).count() >= s->limits.timeMs)
+        s->aborted = true;
+}
+
+static inline uint32_t Add(uint32_t a, uint32_t b)
+{
+    if (a >= kInf || b >= kInf) return kInf;
+    return std::min<uint32_t>(a + b, kInf - 1);
+}
+
+// Expands 'pos' (key 'key', not terminal) until its proof number reaches thPhi or its disproof
+// number thDelta, and returns both. The children's numbers are kept on the ply's list while the
+// search below runs, so only the child just searched has to be updated.
+static void Mid(DfpnSolver* s, Position &pos, int ply, uint64_t key, uint32_t thPhi, uint32_t thDelta,
+    uint32_t &phi, uint32_t &delta)
+{
+    uint64_t nodesBefore = s->nodes;
+    if ((++s->nodes & 1023) == 0) CheckLimits(s);
+    if (ply > 0 && !Lookup(s, key))
+    {
+        // first visit: the region bounds may settle it without expanding
+        DfpnOutcome known = SeparatedOutcome(pos, s->countMemo.data());
+        if (known != DFPN_UNKNOWN)
+        {
+            phi = (known == DFPN_WIN) ? 0 : kInf;
+            delta = (known == DFPN_WIN) ? kInf : 0;
+            Store(s, key, phi, delta, 1);
+            return;
+        }
+    }
+
+    std::vector<DfpnChild> &children = s->children[ply];
+    children.clear();
+    s->kernels->generateMoves(pos, s->moves);
+    for (const PosMove &m : s->moves)
+    {
+        DfpnChild c;
+        c.move = m;
+        s->kernels->makeMove(pos, m);
+        c.key = Position_CanonicalKey(pos);
+        if (!s->kernels->hasAnyMove(pos))
+        {
+            c.phi = kInf;       // the opponent is stuck: this move wins
+            c.delta = 0;
+        }
+        else if (const DfpnEntry* e = Lookup(s, c.key))
+        {
+            c.phi = e->phi;
+            c.delta = e->delta;
+        }
+        else
+        {
+            c.phi = 1;
+            c.delta = 1;
+        }
+        s->kernels->unmakeMove(pos, m);
+        children.push_back(c);
+    }
+
+    for (;;)
+    {
+        // phi = min delta of the children, delta = sum of their phi
+        phi = kInf;
+        delta = 0;
+        size_t best = 0;
+        uint32_t second = kInf;
+        for (size_t i = 0; i < children.size(); ++i)
+        {
+            const DfpnChild &c = children[i];
+            delta = Add(delta, c.phi);
+            if (c.delta < phi)
+            {
+                second = phi;
+                phi = c.delta;
+                best = i;
+            }
+            else if (c.delta < second)
+            {
+                second = c.delta;
+            }
+        }
+        if (phi >= thPhi || delta >= thDelta || s->aborted) break;
+
+        DfpnChild &c = children[best];
+        // the child may grow until it stops being the best choice (1 + epsilon trick against
+        // thrashing) or until this node's disproof number would reach its threshold
+        uint64_t childPhi = (uint64_t)thDelta - delta + c.phi;
+        uint32_t childTh = (second >= kInf) ? kInf : std::max(second + 1, second + second / 4);
+        uint32_t childDelta = std::min(thPhi, childTh);
+        PosMove m = c.move;
+        uint64_t childKey = c.key;
+        s->kernels->makeMove(pos, m);
+        uint32_t p, d;
+        Mid(s, pos, ply + 1, childKey, (uint32_t)std::min<uint64_t>(childPhi, kInf), childDelta, p, d);
+        s->kernels->unmakeMove(pos, m);
+        children[best].phi = p;
+        children[best].delta = d;
+    }
+
+    if (ply == 0 && phi == 0)
+    {
+        for (const DfpnChild &c : children)
+        {
+            if (c.delta == 0) { s->rootMove = c.move; s->rootHasMove = true; break; }
+        }
+    }
+    Store(s, key, phi, delta, s->nodes - nodesBefore);
+}
+
+// ---- public ----
+
+DfpnSolver* Dfpn_Create(int ttSizeMB)
+{
+    DfpnSolver* s = new DfpnSolver();
+    size_t entries = 2;
+    size_t wanted = ((size_t)(ttSizeMB > 0 ? ttSizeMB : 1) << 20) / sizeof(DfpnEntry);
+    while (entries * 2 <= wanted) entries *= 2;
+    s->tt.resize(entries);
+    s->ttMask = entries - 1;
+    s->countMemo.assign(kCountMemo, 0);
+    return s;
+}
+
+void Dfpn_Destroy(DfpnSolver* solver)
+{
+    delete solver;
+}
+
+void Dfpn_Clear(DfpnSolver* solver)
+{
+    std::fill(solver->tt.begin(), solver->tt.end(), DfpnEntry());
+    std::fill(solver->countMemo.begin(), solver->countMemo.end(), 0);
+}
+
+bool Dfpn_Solve(DfpnSolver* solver, const Position &rootPos, const DfpnLimits &limits, DfpnResult &out)
+{
+    DfpnSolver* s = solver;
+    out = DfpnResult();
+    s->kernels = &Position_GetKernels(rootPos.size);
+    s->limits = limits;
+    s->start = Clock::now();
+    s->nodes = 0;
+    s->aborted = false;
+    s->rootHasMove = false;
+
+    Position pos = rootPos;
+    if (!s->kernels->hasAnyMove(pos))
+    {
+        out.outcome = DFPN_LOSS;
+        return true;
+    }
+    uint32_t phi, delta;
+    Mid(s, pos, 0, Position_CanonicalKey(pos), kInf, kInf, phi, delta);
+
+    if (phi == 0) out.outcome = DFPN_WIN;
+    else if (delta == 0) out.outcome = DFPN_LOSS;
+    out.hasMove = s->rootHasMove;
+    out.move = s->rootMove;
+    out.nodes = s->nodes;
+    out.timeMs = std::chrono::duration<double, std::milli>(Clock::now() - s->start).count();
+    return out.outcome != DFPN_UNKNOWN;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+// Endgame solver: depth-first proof-number search (df-pn) that proves whether the side to move wins,
+// for positions late in the game where few empty squares are still reachable. It keeps its own
+// transposition table (proof and disproof numbers under the symmetry-canonical key) and is aware of
+// regions: once arrows split the board so that no region holds amazons of both sides, each side can
+// only count its own moves, and bounds on those counts often decide the position without search.
+//
+// The engine runs it on a separate thread beside the alpha-beta search (SearchLimits::solverNodes);
+// Amazon_Tools bench-endgame times it on a fixed suite of endgames.
+
+#include "position.h"
+#include <atomic>
+#include <cstdint>
+
+// positions with at most this many reachable empty squares are worth handing to the solver
+#define DFPN_MAX_EMPTY 35
+
+enum DfpnOutcome { DFPN_UNKNOWN = 0, DFPN_WIN, DFPN_LOSS };   // for the side to move
+
+struct DfpnLimits
+{
+    uint64_t maxNodes = 1000000;    // 0: no node limit
+    int timeMs = 0;                 // <= 0: no time limit
+    const std::atomic<bool>* stop = nullptr;   // polled with the limits, e.g. set when a search ends
+};
+
+struct DfpnResult
+{
+    DfpnOutcome outcome = DFPN_UNKNOWN;
+    bool hasMove = false;           // a winning move (DFPN_WIN only)
+    PosMove move = {};
+    uint64_t nodes = 0;             // positions expanded
+    double timeMs = 0.0;
+};
+
+// Board split into 8-connected regions of non-arrow squares (the only way an amazon can ever travel).
+// A region is shared when it holds amazons of both sides; empty squares of regions without amazons
+// are out of play.
+struct DfpnRegions
+{
+    int reachableEmpty = 0;         // empty squares in regions holding any amazon
+    int sharedEmpty = 0;            // empty squares in shared regions; 0 once the sides are separated
+    int ownEmpty[2] = {};           // empty squares in regions holding only white [0] / black [1] amazons
+};
+void Dfpn_AnalyzeRegions(const Position &pos, DfpnRegions &out);
+
+struct DfpnSolver;
+
+DfpnSolver* Dfpn_Create(int ttSizeMB = 32);
+void Dfpn_Destroy(DfpnSolver* solver);
+// forget all proofs (the table stays valid across positions and searches otherwise)
+void Dfpn_Clear(DfpnSolver* solver);
+
+// Proves or disproves a win for the side to move within 'limits'; false if neither was found.
+bool Dfpn_Solve(DfpnSolver* solver, const Position &pos, const DfpnLimits &limits, DfpnResult &out);
@@ -0,0 +1,950 @@
+#include "engine.h"
+#include "dfpn.h"
+#include "eval.h"
+#include "solved_table.h"
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#if ENGINE_STATS
+#define STAT(x) (x)
+#else
+#define STAT(x) ((void)0)
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+enum { TT_EXACT = 1, TT_LOWER = 2, TT_UPPER = 3 };
+
+// Lock-free TT slot shared by all search threads: 'data' packs the entry and 'check' holds
+// key ^ data, so a slot torn by concurrent writers fails validation instead of returning garbage.
+struct TTEntry
+{
+    std::atomic<uint64_t> check;
+    std::atomic<uint64_t> data;
+};
+
+struct TTData
+{
+    int score;
+    int depth;
+    int flag;       // 0 = empty slot
+    PosMove move;
+};
+
+static inline uint64_t PackTT(int score, int depth, int flag, const PosMove &m)
+{
+    return (uint64_t)(uint16_t)(int16_t)score | ((uint64_t)(uint8_t)depth << 16) | ((uint64_t)flag << 24)
+        | ((uint64_t)m.from << 32) | ((uint64_t)m.to << 40) | ((uint64_t)m.arrow << 48);
+}
+
+static inline TTData UnpackTT(uint64_t d)
+{
+    TTData t;
+    t.score = (int16_t)(uint16_t)(d & 0xFFFF);
+    t.depth = (int)((d >> 16) & 0xFF);
+    t.flag = (int)((d >> 24) & 0xFF);
+    t.move.from = (uint8_t)(d >> 32);
+    t.move.to = (uint8_t)(d >> 40);
+    t.move.arrow = (uint8_t)(d >> 48);
+    return t;
+}
+
+struct EvalCacheEntry
+{
+    uint64_t key;
+    int32_t score;
+    int32_t valid;
+};
+
+static const int kTimingSampleMask = 15;    // time every 16th movegen/eval call
+static const size_t kEvalCacheEntries = 1 << 18;
+static const uint64_t kCheckEvery = 255;    // nodes between time/stop checks
+
+// per-thread search state
+struct SearchThread
+{
+    int id = 0;
+    SearchStats stats;
+    uint64_t nodes = 0;
+    bool aborted = false;
+    unsigned timingTick = 0;
+    std::vector<EvalCacheEntry> evalCache;
+    std::vector<uint32_t> history;          // [from * POSITION_MAX_SQUARES + to]
+    std::vector<PosMove> moves[ENGINE_MAX_PLY + 1];
+    std::vector<int> order[ENGINE_MAX_PLY + 1];
+    std::vector<PosMove> selected;          // forward pruning scratch (SelectMoves)
+    std::vector<std::pair<int, int>> ranked;
+    std::vector<std::pair<int, int>> arrowRanked;
+#if ENGINE_INCREMENTAL_EVAL
+    // evaluation states along the current path: evalStates[p] belongs to the position at ply p for
+    // p <= evalTop; pathMove[p] leads from ply p to p + 1
+    std::unique_ptr<EvalState[]> evalStates;
+    PosMove pathMove[ENGINE_MAX_PLY + 1];
+    int evalTop = -1;
+#endif
+    PosMove pv[ENGINE_MAX_PLY + 1][ENGINE_MAX_PLY + 1];
+    int pvLength[ENGINE_MAX_PLY + 1];
+    // root move list with the scores of the last iteration (for ordering) and the best lines found
+    std::vector<PosMove> rootMoves;
+    std::vector<int> rootScores;
+    std::vector<SearchLine> lines;
+};
+
+struct Engine
+{
+    std::unique_ptr<TTEntry[]> tt;
+    size_t ttMask = 0;
+    std::vector<std::unique_ptr<SearchThread>> threads;
+    std::atomic<bool> stopRequested;        // Engine_Stop or a search limit
+    std::atomic<bool> helpersStop;          // the main thread finished its iterations
+
+    // per search
+    SearchLimits limits;
+    const PositionKernels* kernels = nullptr;   // specialised for the root's board size
+    EvalFunc evaluate = nullptr;
+    const EvalKernels* evalKernels = nullptr;
+    Clock::time_point start;
+    std::atomic<uint64_t> sharedNodes;      // approximate node count of all threads (for maxNodes)
+    const SolvedTable* solved = nullptr;
+    DfpnSolver* solver = nullptr;           // endgame solver, created on first use
+    std::atomic<bool> solverStop;
+};
+
+static inline bool SameMove(const PosMove &a, const PosMove &b)
+{
+    return a.from == b.from && a.to == b.to && a.arrow == b.arrow;
+}
+
+static inline double ElapsedMs(Clock::time_point since)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - since).count();
+}
+
+static void LowerThreadPriority()
+{
+#ifdef _WIN32
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+#endif
+}
+
+// ---- lifetime ----
+
+static SearchThread* GetThread(Engine* e, int id)
+{
+    while ((int)e->threads.size() <= id)
+    {
+        std::unique_ptr<SearchThread> t(new SearchThread());
+        t->id = (int)e->threads.size();
+        t->evalCache.assign(kEvalCacheEntries, EvalCacheEntry());
+        t->history.assign(POSITION_MAX_SQUARES * POSITION_MAX_SQUARES, 0u);
+#if ENGINE_INCREMENTAL_EVAL
+        t->evalStates.reset(new EvalState[ENGINE_MAX_PLY + 1]);
+#endif
+        e->threads.push_back(std::move(t));
+    }
+    return e->threads[id].get();
+}
+
+Engine* Engine_Create(int ttSizeMB)
+{
+    Engine* e = new Engine();
+    size_t entries = 1;
+    size_t wanted = ((size_t)(ttSizeMB > 0 ? ttSizeMB : 1) << 20) / sizeof(TTEntry);
+    while (entries * 2 <= wanted) entries *= 2;
+    {
+        TRACE_ZONE_ARG("tt allocate", entries);
+        e->tt.reset(new TTEntry[entries]);
+        e->ttMask = entries - 1;
+    }
+    e->stopRequested = false;
+    e->helpersStop = false;
+    e->sharedNodes = 0;
+    GetThread(e, 0);
+    Engine_Clear(e);
+    return e;
+}
+
+void Engine_Destroy(Engine* engine)
+{
+    if (engine->solver) Dfpn_Destroy(engine->solver);
+    delete engine;
+}
+
+void Engine_Clear(Engine* engine)
+{
+    TRACE_ZONE("tt clear");
+    for (size_t i = 0; i <= engine->ttMask; ++i)
+    {
+        engine->tt[i].check.store(0, std::memory_order_relaxed);
+        engine->tt[i].data.store(0, std::memory_order_relaxed);
+    }
+    for (auto &t : engine->threads)
+    {
+        std::fill(t->evalCache.begin(), t->evalCache.end(), EvalCacheEntry());
+        std::fill(t->history.begin(), t->history.end(), 0u);
+    }
+    if (engine->solver) Dfpn_Clear(engine->solver);
+}
+
+void Engine_Stop(Engine* engine)
+{
+    engine->stopRequested = true;
+}
+
+void Engine_SetSolvedTable(Engine* engine, const SolvedTable* table)
+{
+    engine->solved = table;
+}
+
+// ---- helpers with sampled timing ----
+
+static void GenerateMoves(Engine* e, SearchThread* t, const Position &pos, std::vector<PosMove> &out)
+{
+#if ENGINE_STATS
+    if ((++t->timingTick & kTimingSampleMask) == 0)
+    {
+        Clock::time_point t0 = Clock::now();
+        e->kernels->generateMoves(pos, out);
+        t->stats.movegenMs += ElapsedMs(t0) * (kTimingSampleMask + 1);
+        return;
+    }
+#endif
+    e->kernels->generateMoves(pos, out);
+}
+
+// The position at 'ply' on the current path, scored from the state of its parent (states of the
+// plies between the last valid one and 'ply' are derived first).
+static int EvaluateIncremental(Engine* e, SearchThread* t, const Position &pos, int ply)
+{
+#if ENGINE_INCREMENTAL_EVAL
+    while (t->evalTop < ply)
+    {
+        int p = t->evalTop;
+        e->evalKernels->update(t->evalStates[p], t->pathMove[p], t->evalStates[p + 1]);
+        t->evalTop = p + 1;
+    }
+    const EvalState &state = t->evalStates[ply];
+    if (!state.overflow) return e->evalKernels->score(state);
+#endif
+    (void)t;
+    (void)ply;
+    return e->evaluate(pos);
+}
+
+static int Evaluate(Engine* e, SearchThread* t, const Position &pos, int ply)
+{
+    STAT(++t->stats.evalCalls);
+    uint64_t key = pos.symHash[0];
+    EvalCacheEntry &slot = t->evalCache[key & (kEvalCacheEntries - 1)];
+    if (slot.valid && slot.key == key)
+    {
+        STAT(++t->stats.evalCacheHits);
+        return slot.score;
+    }
+    int score;
+#if ENGINE_STATS
+    if ((++t->timingTick & kTimingSampleMask) == 0)
+    {
+        Clock::time_point t0 = Clock::now();
+        score = EvaluateIncremental(e, t, pos, ply);
+        t->stats.evalMs += ElapsedMs(t0) * (kTimingSampleMask + 1);
+    }
+    else
+#endif
+    score = EvaluateIncremental(e, t, pos, ply);
+    slot.key = key;
+    slot.score = score;
+    slot.valid = 1;
+    return score;
+}
+
+static bool ShouldStop(Engine* e, SearchThread* t)
+{
+    uint64_t total = e->sharedNodes.fetch_add(kCheckEvery + 1, std::memory_order_relaxed) + kCheckEvery + 1;
+    if (e->stopRequested.load(std::memory_order_relaxed)) return true;
+    if (t->id != 0) return e->helpersStop.load(std::memory_order_relaxed);
+    if (e->limits.maxNodes && total >= e->limits.maxNodes) return true;
+    return e->limits.timeMs > 0 && ElapsedMs(e->start) >= e->limits.timeMs;
+}
+
+// mate scores are stored relative to the node, not the root
+static int ScoreToTT(int score, int ply)
+{
+    if (score > ENGINE_MATE - ENGINE_MAX_PLY) return score + ply;
+    if (score < -ENGINE_MATE + ENGINE_MAX_PLY) return score - ply;
+    return score;
+}
+
+static int ScoreFromTT(int score, int ply)
+{
+    if (score > ENGINE_MATE - ENGINE_MAX_PLY) return score - ply;
+    if (score < -ENGINE_MATE + ENGINE_MAX_PLY) return score + ply;
+    return score;
+}
+
+static void CountCutoff(SearchStats &st, size_t index)
+{
+    int bucket;
+    if (index < 4) bucket = (int)index;
+    else if (index < 8) bucket = 4;
+    else if (index < 16) bucket = 5;
+    else if (index < 64) bucket = 6;
+    else bucket = 7;
+    ++st.cutoffs;
+    ++st.cutoffAt[bucket];
+}
+
+// orders moves[ply] into order[ply]: 'first' (if any) then by history score
+static void OrderMoves(SearchThread* t, int ply, const PosMove* first)
+{
+    std::vector<PosMove> &moves = t->moves[ply];
+    std::vector<int> &order = t->order[ply];
+    order.resize(moves.size());
+    for (size_t i = 0; i < moves.size(); ++i) order[i] = (int)i;
+    const uint32_t* hist = t->history.data();
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b)
+    {
+        return hist[moves[a].from * POSITION_MAX_SQUARES + moves[a].to] > hist[moves[b].from * POSITION_MAX_SQUARES + moves[b].to];
+    });
+    if (first)
+    {
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            if (SameMove(moves[order[i]], *first))
+            {
+                std::rotate(order.begin(), order.begin() + i, order.begin() + i + 1);
+                break;
+            }
+        }
+    }
+}
+
+// ---- selective search ----
+
+// empty squares an amazon on 'sq' reaches in one queen move, 'vacated' counting as empty
+static int Mobility(const Position &pos, int sq, int vacated)
+{
+    static const int dr[8] = { -1, 1, 0, 0, -1, -1, 1, 1 };
+    static const int dc[8] = { 0, 0, -1, 1, -1, 1, -1, 1 };
+    int n = pos.size, count = 0;
+    for (int d = 0; d < 8; ++d)
+    {
+        for (int r = sq / n + dr[d], c = sq % n + dc[d]; r >= 0 && r < n && c >= 0 && c < n; r += dr[d], c += dc[d])
+        {
+            int to = r * n + c;
+            if (pos.cell[to] != CELL_EMPTY && to != vacated) break;
+            ++count;
+        }
+    }
+    return count;
+}
+
+// Forward pruning of moves[ply] (grouped by from/to, as the generator emits them): keeps the
+// keepDestinations destinations whose amazon gains the most mobility and, for each, the keepArrows
+// arrows on the squares most enemy amazons have a clear line to (own lines count against, lines of
+// adjacent amazons double). 'keep' (the TT move) always survives. Zero limits keep everything.
+static void SelectMoves(Engine* e, SearchThread* t, const Position &pos, int ply, const PosMove* keep)
+{
+    static const int dr[8] = { -1, 1, 0, 0, -1, -1, 1, 1 };
+    static const int dc[8] = { 0, 0, -1, 1, -1, 1, -1, 1 };
+    std::vector<PosMove> &moves = t->moves[ply];
+    std::vector<std::pair<int, int>> &ranked = t->ranked;
+    int keepDest = e->limits.keepDestinations, keepArrows = e->limits.keepArrows;
+    int n = pos.size;
+    int enemy = pos.blackToMove ? 0 : 1;
+
+    int lines[POSITION_MAX_SQUARES] = {};
+    for (int side = 0; side < 2; ++side)
+    {
+        for (int i = 0; i < POSITION_AMAZONS; ++i)
+        {
+            int sq = pos.amazon[side][i];
+            for (int d = 0; d < 8; ++d)
+            {
+                int w = side == enemy ? 2 : -2;
+                for (int r = sq / n + dr[d], c = sq % n + dc[d]; r >= 0 && r < n && c >= 0 && c < n; r += dr[d], c += dc[d])
+                {
+                    if (pos.cell[r * n + c] != CELL_EMPTY) break;
+                    lines[r * n + c] += w;
+                    w = side == enemy ? 1 : -1;
+                }
+            }
+        }
+    }
+
+    // destinations: (score, index of the group's first move), best first
+    ranked.clear();
+    const uint32_t* hist = t->history.data();
+    for (size_t i = 0; i < moves.size(); )
+    {
+        size_t j = i;
+        while (j < moves.size() && moves[j].from == moves[i].from && moves[j].to == moves[i].to) ++j;
+        int gain = Mobility(pos, moves[i].to, moves[i].from) - Mobility(pos, moves[i].from, -1);
+        // history breaks ties among equal gains
+        int h = (int)std::min<uint32_t>(hist[moves[i].from * POSITION_MAX_SQUARES + moves[i].to], 255);
+        ranked.push_back(std::make_pair(gain * 256 + h, (int)i));
+        i = j;
+    }
+    size_t destCount = ranked.size();
+    if (keepDest > 0 && (size_t)keepDest < destCount)
+    {
+        std::partial_sort(ranked.begin(), ranked.begin() + keepDest, ranked.end(),
+            [](const std::pair<int, int> &a, const std::pair<int, int> &b) { return a.first > b.first; });
+        destCount = (size_t)keepDest;
+    }
+
+    std::vector<PosMove> &selected = t->selected;
+    selected.clear();
+    bool keptTT = keep == nullptr;
+    std::vector<std::pair<int, int>> &arrows = t->arrowRanked;
+    for (size_t g = 0; g < destCount; ++g)
+    {
+        size_t first = (size_t)ranked[g].second, end = first;
+        while (end < moves.size() && moves[end].from == moves[first].from && moves[end].to == moves[first].to) ++end;
+        int to = moves[first].to;
+        arrows.clear();
+        for (size_t k = first; k < end; ++k)
+        {
+            int a = moves[k].arrow;
+            int dRow = a / n - to / n, dCol = a % n - to % n;
+            bool besideMover = dRow >= -1 && dRow <= 1 && dCol >= -1 && dCol <= 1;
+            arrows.push_back(std::make_pair(lines[a] - (besideMover ? 2 : 0), (int)k));
+        }
+        size_t arrowCount = arrows.size();
+        if (keepArrows > 0 && (size_t)keepArrows < arrowCount)
+        {
+            std::partial_sort(arrows.begin(), arrows.begin() + keepArrows, arrows.end(),
+                [](const std::pair<int, int> &a, const std::pair<int, int> &b) { return a.first > b.first; });
+            arrowCount = (size_t)keepArrows;
+        }
+        for (size_t k = 0; k < arrowCount; ++k)
+        {
+            const PosMove &m = moves[(size_t)arrows[k].second];
+            keptTT = keptTT || SameMove(m, *keep);
+            selected.push_back(m);
+        }
+    }
+    if (!keptTT)
+    {
+        for (const PosMove &m : moves) if (SameMove(m, *keep)) { selected.push_back(m); break; }
+    }
+    STAT(t->stats.pruned += moves.size() - selected.size());
+    moves.swap(selected);
+}
+
+// ---- transposition table ----
+
+// the slot of 'key' unpacked into 'out' (also on a miss, so collisions can be told from empty
+// slots); true if it holds 'key'
+static inline bool ProbeTT(Engine* e, uint64_t key, TTData &out)
+{
+    const TTEntry &slot = e->tt[key & e->ttMask];
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+    uint64_t check = slot.check.load(std::memory_order_relaxed);
+    out = UnpackTT(data);
+    return out.flag != 0 && (check ^ data) == key;
+}
+
+static inline void StoreTT(Engine* e, uint64_t key, uint64_t data)
+{
+    TTEntry &slot = e->tt[key & e->ttMask];
+    slot.data.store(data, std::memory_order_relaxed);
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+}
+
+bool Engine_ProbeTT(Engine* engine, uint64_t key, int &score, int &depth, PosMove &move)
+{
+    TTData tt;
+    if (!ProbeTT(engine, key, tt)) return false;
+    score = tt.score;
+    depth = tt.depth;
+    move = tt.move;
+    return true;
+}
+
+void Engine_StoreTT(Engine* engine, uint64_t key, int score, int depth, const PosMove &move)
+{
+    StoreTT(engine, key, PackTT(score, depth, TT_EXACT, move));
+}
+
+// ---- search ----
+
+// Records the move from 'ply' on the current path; evaluation states past 'ply' belonged to the
+// previous sibling and are dropped (unmake is just this pop).
+static inline void EnterChild(SearchThread* t, int ply, const PosMove &m)
+{
+#if ENGINE_INCREMENTAL_EVAL
+    t->pathMove[ply] = m;
+    if (t->evalTop > ply) t->evalTop = ply;
+#else
+    (void)t;
+    (void)ply;
+    (void)m;
+#endif
+}
+
+static int Negamax(Engine* e, SearchThread* t, Position &pos, int depth, int alpha, int beta, int ply)
+{
+    ++t->nodes;
+    SearchStats &st = t->stats;
+    STAT(++st.nodesAtPly[ply]);
+    if (ply > st.seldepth) st.seldepth = ply;
+    t->pvLength[ply] = ply;
+    if ((t->nodes & kCheckEvery) == 0 && ShouldStop(e, t)) t->aborted = true;
+    if (t->aborted) return 0;
+
+    if (depth <= 0 || ply >= ENGINE_MAX_PLY) return Evaluate(e, t, pos, ply);
+
+    // transposition table
+    uint64_t key = pos.symHash[0];
+    TTData tt;
+    bool ttHit = ProbeTT(e, key, tt);
+    STAT(++st.ttProbes);
+    if (ttHit)
+    {
+        STAT(++st.ttHits);
+        if (tt.depth >= depth)
+        {
+            int s = ScoreFromTT(tt.score, ply);
+            if (tt.flag == TT_EXACT) return s;
+            if (tt.flag == TT_LOWER && s >= beta) return s;
+            if (tt.flag == TT_UPPER && s <= alpha) return s;
+        }
+    }
+    else if (tt.flag) STAT(++st.ttCollisions);
+
+    GenerateMoves(e, t, pos, t->moves[ply]);
+    if (t->moves[ply].empty()) return -ENGINE_MATE + ply;  // side to move is stuck and loses
+    if (e->limits.keepDestinations > 0 || e->limits.keepArrows > 0) SelectMoves(e, t, pos, ply, ttHit ? &tt.move : nullptr);
+    OrderMoves(t, ply, ttHit ? &tt.move : nullptr);
+
+    int origAlpha = alpha;
+    int best = -ENGINE_MATE - 1;
+    int lmr = e->limits.lmrMoves;
+    PosMove bestMove = t->moves[ply][t->order[ply][0]];
+    for (size_t i = 0; i < t->order[ply].size(); ++i)
+    {
+        PosMove m = t->moves[ply][t->order[ply][i]];
+        EnterChild(t, ply, m);
+        e->kernels->makeMove(pos, m);
+        // late moves get a null-window search reduced by two plies (one ply flips the eval parity)
+        // first and the full one only if they beat alpha
+        int reduction = 0;
+        if (lmr > 0 && depth >= 4 && (int)i >= lmr) reduction = 2;
+        int score;
+        if (reduction)
+        {
+            STAT(++st.reductions);
+            score = -Negamax(e, t, pos, depth - 1 - reduction, -alpha - 1, -alpha, ply + 1);
+            if (score > alpha && !t->aborted)
+            {
+                STAT(++st.researches);
+                score = -Negamax(e, t, pos, depth - 1, -beta, -alpha, ply + 1);
+            }
+        }
+        else
+        {
+            score = -Negamax(e, t, pos, depth - 1, -beta, -alpha, ply + 1);
+        }
+        e->kernels->unmakeMove(pos, m);
+        if (t->aborted) return 0;
+        if (score > best)
+        {
+            best = score;
+            bestMove = m;
+            if (score > alpha)
+            {
+                alpha = score;
+                t->pv[ply][ply] = m;
+                for (int p = ply + 1; p < t->pvLength[ply + 1]; ++p) t->pv[ply][p] = t->pv[ply + 1][p];
+                t->pvLength[ply] = t->pvLength[ply + 1];
+            }
+        }
+        if (alpha >= beta)
+        {
+            STAT(CountCutoff(st, i));
+            t->history[m.from * POSITION_MAX_SQUARES + m.to] += (uint32_t)(depth * depth);
+            break;
+        }
+    }
+
+    // replace unless the slot holds a deeper result for the same position
+    if (!ttHit || depth >= tt.depth)
+    {
+        int flag = best <= origAlpha ? TT_UPPER : (best >= beta ? TT_LOWER : TT_EXACT);
+        StoreTT(e, key, PackTT(ScoreToTT(best, ply), depth, flag, bestMove));
+    }
+    return best;
+}
+
+// One iteration at the root: every root move is searched with a window that only admits scores
+// better than the current multiPV-th best, so the scores of the best 'multiPV' lines are exact.
+// Root moves are tried in order of their previous iteration's score (helpers rotate that order
+// to spread their work); with forward pruning, iterations after the first search only the best
+// keepDestinations * keepArrows of them. Returns false if the iteration was aborted.
+static bool SearchRoot(Engine* e, SearchThread* t, Position &pos, int depth, int multiPV)
+{
+    TRACE_ZONE_ARG("iteration", depth);
+    ++t->nodes;
+    STAT(++t->stats.nodesAtPly[0]);
+    size_t count = t->rootMoves.size();
+    std::vector<int> order(count);
+    for (size_t i = 0; i < count; ++i) order[i] = (int)i;
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return t->rootScores[a] > t->rootScores[b]; });
+    size_t searched = count;
+    size_t keep = (size_t)std::max(e->limits.keepDestinations, 0) * (size_t)std::max(e->limits.keepArrows, 0);
+    if (depth > 1 && keep > 0) searched = std::min(count, std::max(keep, (size_t)multiPV));
+    STAT(t->stats.pruned += count - searched);
+    if (t->id != 0 && searched > 1) std::rotate(order.begin(), order.begin() + (t->id * 7) % searched, order.begin() + searched);
+
+    std::vector<SearchLine> lines;
+    for (size_t i = 0; i < searched; ++i)
+    {
+        int idx = order[i];
+        TRACE_ZONE_ARG("root move", i);
+        PosMove m = t->rootMoves[idx];
+        int alpha = ((int)lines.size() < multiPV) ? -ENGINE_MATE - 1 : lines.back().score;
+        EnterChild(t, 0, m);
+        e->kernels->makeMove(pos, m);
+        int score = -Negamax(e, t, pos, depth - 1, -ENGINE_MATE - 1, -alpha, 1);
+        e->kernels->unmakeMove(pos, m);
+        if (t->aborted)
+        {
+            // keep what this iteration found so far only if there is nothing better
+            if (t->lines.empty()) t->lines = lines;
+            return false;
+        }
+        t->rootScores[idx] = score;
+        if (score <= alpha) continue;
+
+        SearchLine line;
+        line.score = score;
+        line.pv.push_back(m);
+        line.pv.insert(line.pv.end(), t->pv[1] + 1, t->pv[1] + t->pvLength[1]);
+        auto pos_it = std::find_if(lines.begin(), lines.end(), [&](const SearchLine &l) { return l.score < score; });
+        lines.insert(pos_it, line);
+        if ((int)lines.size() > multiPV) lines.pop_back();
+    }
+    t->lines = lines;
+    return true;
+}
+
+static void PrepareThread(Engine* e, SearchThread* t, const Position &pos)
+{
+    t->stats = SearchStats();
+    t->nodes = 0;
+    t->aborted = false;
+    t->lines.clear();
+    GenerateMoves(e, t, pos, t->rootMoves);
+    t->rootScores.assign(t->rootMoves.size(), 0);
+#if ENGINE_INCREMENTAL_EVAL
+    e->evalKernels->init(pos, t->evalStates[0]);
+    t->evalTop = 0;
+#endif
+}
+
+static void HelperLoop(Engine* e, SearchThread* t, Position pos, int maxDepth)
+{
+    Trace_SetThreadName("search helper");
+    if (e->limits.background) LowerThreadPriority();
+    for (int depth = 1 + (t->id & 1); depth <= maxDepth && !t->aborted; ++depth)
+        SearchRoot(e, t, pos, depth, e->limits.multiPV);
+}
+
+// Runs the endgame solver until it is done or the search ends; a proven win also ends the search.
+static void SolverLoop(Engine* e, Position pos, DfpnResult* result)
+{
+    if (e->limits.background) LowerThreadPriority();
+    Trace_SetThreadName("solver");
+    TRACE_ZONE("solver");
+    DfpnLimits limits;
+    limits.maxNodes = e->limits.solverNodes;
+    limits.stop = &e->solverStop;
+    if (Dfpn_Solve(e->solver, pos, limits, *result) && result->outcome == DFPN_WIN) e->stopRequested = true;
+}
+
+// Replaces the searched result with the solver's proof: the winning move alone, or the searched
+// lines all marked as lost.
+static void ApplySolverResult(const DfpnResult &solved, SearchResult &out)
+{
+    if (solved.outcome == DFPN_WIN && solved.hasMove)
+    {
+        SearchLine line;
+        line.score = ENGINE_PROVEN;
+        line.pv.push_back(solved.move);
+        out.lines.assign(1, line);
+    }
+    else if (solved.outcome == DFPN_LOSS && !out.lines.empty())
+    {
+        for (SearchLine &line : out.lines) line.score = -ENGINE_PROVEN;
+    }
+    else
+    {
+        return;
+    }
+    out.hasMove = true;
+    out.proven = true;
+    out.best = out.lines[0].pv[0];
+    out.score = out.lines[0].score;
+    out.pv = out.lines[0].pv;
+}
+
+static void FillResult(const SearchThread* t, int depth, SearchResult &out)
+{
+    out.lines = t->lines;
+    out.hasMove = true;
+    out.best = t->lines[0].pv[0];
+    out.score = t->lines[0].score;
+    out.pv = t->lines[0].pv;
+    out.stats.depth = depth;
+}
+
+static void SumStats(Engine* e, int threadCount, SearchStats &st)
+{
+    int depth = st.depth;
+    st = SearchStats();
+    st.depth = depth;
+    st.threads = threadCount;
+    for (int i = 0; i < threadCount; ++i)
+    {
+        const SearchStats &s = e->threads[i]->stats;
+        st.nodes += e->threads[i]->nodes;
+        st.seldepth = std::max(st.seldepth, s.seldepth);
+        st.ttProbes += s.ttProbes;
+        st.ttHits += s.ttHits;
+        st.ttCollisions += s.ttCollisions;
+        st.cutoffs += s.cutoffs;
+        for (int b = 0; b < ENGINE_CUTOFF_BUCKETS; ++b) st.cutoffAt[b] += s.cutoffAt[b];
+        for (int p = 0; p <= ENGINE_MAX_PLY; ++p) st.nodesAtPly[p] += s.nodesAtPly[p];
+        st.evalCalls += s.evalCalls;
+        st.evalCacheHits += s.evalCacheHits;
+        st.movegenMs += s.movegenMs;
+        st.evalMs += s.evalMs;
+        st.reductions += s.reductions;
+        st.researches += s.researches;
+        st.pruned += s.pruned;
+    }
+    st.timeMs = ElapsedMs(e->start);
+    st.nodesPerSecond = st.timeMs > 0.0 ? st.nodes * 1000.0 / st.timeMs : 0.0;
+    st.searchMs = std::max(0.0, st.timeMs * threadCount - st.movegenMs - st.evalMs);
+}
+
+// Answers a root found in the solved table: winning moves if it is won, otherwise every move (all
+// lose), each group best first by evaluation. A weak solve need not contain the losing alternatives
+// of a won position, so moves the table cannot label are left out. False if the table has no answer.
+static bool ProbeSolvedRoot(Engine* e, const Position &rootPos, SearchResult &out)
+{
+    bool win;
+    if (!SolvedTable_Probe(*e->solved, rootPos, win)) return false;
+    std::vector<PosMove> moves;
+    e->kernels->generateMoves(rootPos, moves);
+    std::vector<std::pair<int, PosMove>> ranked;   // (opponent's evaluation, move)
+    Position pos = rootPos;
+    for (const PosMove &m : moves)
+    {
+        e->kernels->makeMove(pos, m);
+        bool childWin;
+        bool stuck = !e->kernels->hasAnyMove(pos);
+        bool wins = stuck || (SolvedTable_Probe(*e->solved, pos, childWin) && !childWin);
+        // moves that leave the opponent stuck first, then by the opponent's evaluation
+        if (wins == win) ranked.push_back(std::make_pair(stuck ? -ENGINE_MATE : e->evaluate(pos), m));
+        e->kernels->unmakeMove(pos, m);
+    }
+    if (ranked.empty()) return false;   // table and position disagree; search instead
+    std::stable_sort(ranked.begin(), ranked.end(),
+        [](const std::pair<int, PosMove> &a, const std::pair<int, PosMove> &b) { return a.first < b.first; });
+    for (size_t i = 0; i < ranked.size() && (int)i < e->limits.multiPV; ++i)
+    {
+        SearchLine line;
+        line.score = win ? ENGINE_PROVEN : -ENGINE_PROVEN;
+        line.pv.push_back(ranked[i].second);
+        out.lines.push_back(line);
+    }
+    out.hasMove = true;
+    out.proven = true;
+    out.best = out.lines[0].pv[0];
+    out.score = out.lines[0].score;
+    out.pv = out.lines[0].pv;
+    out.stats.nodes = moves.size();
+    out.stats.timeMs = ElapsedMs(e->start);
+    if (e->limits.onProgress) e->limits.onProgress(e->limits.progressUser, out);
+    return true;
+}
+
+bool Engine_Search(Engine* engine, const Position &rootPos, const SearchLimits &limits, SearchResult &out)
+{
+    Engine* e = engine;
+    TRACE_ZONE("search");
+    out = SearchResult();
+    e->limits = limits;
+    e->limits.multiPV = std::max(1, limits.multiPV);
+    e->start = Clock::now();
+    e->stopRequested = false;
+    e->helpersStop = false;
+    e->sharedNodes = 0;
+    e->kernels = &Position_GetKernels(rootPos.size);
+    e->evaluate = Eval_GetTerritoryKernel(rootPos.size);
+    e->evalKernels = &Eval_GetIncrementalKernels(rootPos.size);
+    if (e->solved && ProbeSolvedRoot(e, rootPos, out)) return true;
+
+    int threadCount = std::max(1, std::min(limits.threads, 64));
+    int maxDepth = std::min(std::max(limits.maxDepth, 1), ENGINE_MAX_PLY);
+    for (int i = 0; i < threadCount; ++i) PrepareThread(e, GetThread(e, i), rootPos);
+    SearchThread* main = e->threads[0].get();
+    if (main->rootMoves.empty()) return false;
+
+#ifdef _WIN32
+    int oldPriority = GetThreadPriority(GetCurrentThread());
+#endif
+    if (limits.background) LowerThreadPriority();
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < threadCount; ++i)
+        helpers.emplace_back(HelperLoop, e, e->threads[i].get(), rootPos, maxDepth);
+    std::thread solverThread;
+    DfpnResult solved;
+    bool solverRan = false;
+    if (limits.solverNodes > 0)
+    {
+        DfpnRegions regions;
+        Dfpn_AnalyzeRegions(rootPos, regions);
+        if (regions.reachableEmpty <= DFPN_MAX_EMPTY)
+        {
+            if (!e->solver) e->solver = Dfpn_Create(32);
+            e->solverStop = false;
+            solverThread = std::thread(SolverLoop, e, rootPos, &solved);
+            solverRan = true;
+        }
+    }
+
+    Position pos = rootPos;
+    for (int depth = 1; depth <= maxDepth; ++depth)
+    {
+        bool complete = SearchRoot(e, main, pos, depth, e->limits.multiPV);
+        if (!complete)
+        {
+            // an interrupted first iteration still improves on having no move at all
+            if (!out.hasMove && !main->lines.empty()) FillResult(main, 0, out);
+            break;
+        }
+        FillResult(main, depth, out);
+        if (limits.onProgress)
+        {
+            // helpers are still running, so progress reports the main thread's counters and the
+            // shared node count only; the full sum is taken once they have stopped
+            int completed = out.stats.depth;
+            out.stats = main->stats;
+            out.stats.depth = completed;
+            out.stats.threads = threadCount;
+            out.stats.nodes = std::max(main->nodes, e->sharedNodes.load(std::memory_order_relaxed));
+            out.stats.timeMs = ElapsedMs(e->start);
+            out.stats.nodesPerSecond = out.stats.timeMs > 0.0 ? out.stats.nodes * 1000.0 / out.stats.timeMs : 0.0;
+            limits.onProgress(limits.progressUser, out);
+        }
+        int score = out.score;
+        if (score > ENGINE_MATE - ENGINE_MAX_PLY || score < -ENGINE_MATE + ENGINE_MAX_PLY) break; // decided
+        if (limits.timeMs > 0 && ElapsedMs(e->start) * 2 > limits.timeMs) break; // next iteration would not finish
+    }
+
+    e->helpersStop = true;
+    for (auto &h : helpers) h.join();
+    e->solverStop = true;
+    if (solverRan) solverThread.join();
+#ifdef _WIN32
+    if (limits.background) SetThreadPriority(GetCurrentThread(), oldPriority);
+#endif
+    SumStats(e, threadCount, out.stats);
+    if (solverRan)
+    {
+        out.stats.solverRan = true;
+        out.stats.solverOutcome = solved.outcome;
+        out.stats.solverNodes = solved.nodes;
+        out.stats.solverMs = solved.timeMs;
+        ApplySolverResult(solved, out);
+    }
+    return out.hasMove;
+}
+
+// ---- reporting ----
+
+std::string Engine_MoveToString(const Position &pos, const PosMove &m)
+{
+    char buf[32];
+    int n = pos.size;
+    snprintf(buf, sizeof(buf), "%c%d %c%d %c%d",
+        'A' + m.from % n, m.from / n + 1, 'A' + m.to % n, m.to / n + 1, 'A' + m.arrow % n, m.arrow / n + 1);
+    return buf;
+}
+
+static void AppendPv(const Position &pos, const std::vector<PosMove> &pv, std::string &out)
+{
+    out += "[";
+    for (size_t i = 0; i < pv.size(); ++i)
+    {
+        out += i ? ",\"" : "\"";
+        out += Engine_MoveToString(pos, pv[i]);
+        out += "\"";
+    }
+    out += "]";
+}
+
+void SearchResult_ToJson(const Position &pos, const SearchResult &r, std::string &out)
+{
+    const SearchStats &st = r.stats;
+    char buf[512];
+    out.clear();
+    snprintf(buf, sizeof(buf), "{\"bestmove\":\"%s\",\"score\":%d,\"proven\":%s,\"pv\":",
+        r.hasMove ? Engine_MoveToString(pos, r.best).c_str() : "", r.score, r.proven ? "true" : "false");
+    out += buf;
+    AppendPv(pos, r.pv, out);
+    out += ",\"multipv\":[";
+    for (size_t i = 0; i < r.lines.size(); ++i)
+    {
+        snprintf(buf, sizeof(buf), "%s{\"score\":%d,\"pv\":", i ? "," : "", r.lines[i].score);
+        out += buf;
+        AppendPv(pos, r.lines[i].pv, out);
+        out += "}";
+    }
+    snprintf(buf, sizeof(buf),
+        "],\"threads\":%d,\"nodes\":%llu,\"nps\":%.0f,\"time_ms\":%.2f,\"depth\":%d,\"seldepth\":%d,"
+        "\"tt\":{\"probes\":%llu,\"hits\":%llu,\"collisions\":%llu},",
+        st.threads, (unsigned long long)st.nodes, st.nodesPerSecond, st.timeMs, st.depth, st.seldepth,
+        (unsigned long long)st.ttProbes, (unsigned long long)st.ttHits, (unsigned long long)st.ttCollisions);
+    out += buf;
+
+    static const char* const kBuckets[ENGINE_CUTOFF_BUCKETS] = { "0", "1", "2", "3", "4-7", "8-15", "16-63", "64+" };
+    snprintf(buf, sizeof(buf), "\"cutoffs\":{\"total\":%llu,\"by_move_index\":{", (unsigned long long)st.cutoffs);
+    out += buf;
+    for (int i = 0; i < ENGINE_CUTOFF_BUCKETS; ++i)
+    {
+        snprintf(buf, sizeof(buf), "%s\"%s\":%llu", i ? "," : "", kBuckets[i], (unsigned long long)st.cutoffAt[i]);
+        out += buf;
+    }
+    out += "}},\"branching\":[";
+    for (int p = 0; p < ENGINE_MAX_PLY && st.nodesAtPly[p + 1] > 0; ++p)
+    {
+        snprintf(buf, sizeof(buf), "%s%.2f", p ? "," : "", (double)st.nodesAtPly[p + 1] / (double)st.nodesAtPly[p]);
+        out += buf;
+    }
+    snprintf(buf, sizeof(buf),
+        "],\"eval_cache\":{\"calls\":%llu,\"hits\":%llu,\"hit_rate\":%.4f},"
+        "\"time_split_ms\":{\"movegen\":%.2f,\"eval\":%.2f,\"search\":%.2f},",
+        (unsigned long long)st.evalCalls, (unsigned long long)st.evalCacheHits,
+        st.evalCalls ? (double)st.evalCacheHits / (double)st.evalCalls : 0.0,
+        st.movegenMs, st.evalMs, st.searchMs);
+    out += buf;
+    snprintf(buf, sizeof(buf), "\"selective\":{\"reductions\":%llu,\"researches\":%llu,\"pruned\":%llu},",
+        (unsigned long long)st.reductions, (unsigned long long)st.researches, (unsigned long long)st.pruned);
+    out += buf;
+    static const char* const kOutcome[3] = { "unknown", "win", "loss" };
+    snprintf(buf, sizeof(buf), "\"endgame\":{\"result\":\"%s\",\"nodes\":%llu,\"time_ms\":%.2f}}",
+        st.solverRan ? kOutcome[st.solverOutcome] : "off", (unsigned long long)st.solverNodes, st.solverMs);
+    out += buf;
+}
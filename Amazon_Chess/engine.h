@@ -0,0 +1,140 @@
+#pragma once
+
+// Game-tree search: iterative deepening negamax alpha-beta over Position with a transposition table,
+// an evaluation cache and history-heuristic move ordering. Every search fills a SearchStats record
+// that can be exported as one JSON object (SearchResult_ToJson).
+//
+// A search can report the best N root moves (multi-PV) and run on several threads: helper threads
+// search the same root with their own move ordering and share results through the lock-free
+// transposition table, which also persists across searches of the same Engine.
+//
+// An Engine given a solved-position table (solved_table.h) answers positions found in it without
+// searching: every root move it can label is reported as a proven win or loss. Late in the game the
+// df-pn endgame solver (dfpn.h) can run on its own thread beside the search; a proven win replaces
+// the searched move and ends the search.
+//
+// Selective search is opt-in per search (SearchLimits): late move reductions search moves after the
+// first few at a node to a lower depth and re-search those that beat alpha; forward pruning keeps
+// only the best amazon destinations of a node, ranked by the mobility the amazon gains, and the best
+// arrows of each, ranked by the enemy queen lines they cut. At the root the moves kept from the
+// second iteration on are the best by the previous iteration's scores.
+
+#include "position.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Statistics collection can be compiled out to measure its overhead (time the tools' search
+// command built with ENGINE_STATS=0 against the default build).
+#ifndef ENGINE_STATS
+#define ENGINE_STATS 1
+#endif
+
+// 1: leaf evaluations update the parent's distance layers (Eval_GetIncrementalKernels) instead of
+// recomputing them; scores and node counts are the same either way
+#ifndef ENGINE_INCREMENTAL_EVAL
+#define ENGINE_INCREMENTAL_EVAL 1
+#endif
+
+#define ENGINE_MAX_PLY 64
+#define ENGINE_MATE 30000
+#define ENGINE_PROVEN (ENGINE_MATE - ENGINE_MAX_PLY + 1)   // score of a table-proven win of unknown length
+#define ENGINE_CUTOFF_BUCKETS 8   // move index of beta cutoffs: 0,1,2,3,4-7,8-15,16-63,64+
+
+struct SearchResult;
+// called on the searching thread after every completed iteration
+typedef void (*SearchProgressCallback)(void* user, const SearchResult &progress);
+
+struct SearchLimits
+{
+    int maxDepth = ENGINE_MAX_PLY;
+    int timeMs = 1000;          // <= 0: no time limit (runs until Engine_Stop or maxDepth)
+    uint64_t maxNodes = 0;      // 0: no node limit
+    int multiPV = 1;            // number of best root moves to report
+    int threads = 1;            // search threads including the calling one
+    bool background = false;    // run search threads below normal priority (Windows)
+    SearchProgressCallback onProgress = nullptr;
+    void* progressUser = nullptr;
+    uint64_t solverNodes = 0;   // endgame solver budget once at most DFPN_MAX_EMPTY squares are reachable; 0: off
+    // selective search (0: off)
+    int lmrMoves = 0;           // moves searched at full depth at a node before later ones are reduced
+    int keepDestinations = 0;   // forward pruning: amazon destinations kept per node
+    int keepArrows = 0;         // arrows kept per kept destination
+};
+
+struct SearchStats
+{
+    uint64_t nodes = 0;
+    double timeMs = 0.0;
+    double nodesPerSecond = 0.0;
+    int depth = 0;              // last fully completed iteration
+    int seldepth = 0;           // deepest ply visited
+    uint64_t ttProbes = 0;
+    uint64_t ttHits = 0;
+    uint64_t ttCollisions = 0;  // probed slot held a different position
+    uint64_t cutoffs = 0;
+    uint64_t cutoffAt[ENGINE_CUTOFF_BUCKETS] = {};
+    uint64_t nodesAtPly[ENGINE_MAX_PLY + 1] = {};   // branching factor per ply = nodesAtPly[p+1] / nodesAtPly[p]
+    uint64_t evalCalls = 0;
+    uint64_t evalCacheHits = 0;
+    // sampled timers (every 16th call is timed and scaled), summed over search threads:
+    // search = timeMs * threads - movegen - eval
+    int threads = 1;
+    double movegenMs = 0.0;
+    double evalMs = 0.0;
+    double searchMs = 0.0;
+    // endgame solver beside the search (SearchLimits::solverNodes)
+    bool solverRan = false;
+    int solverOutcome = 0;      // DfpnOutcome
+    uint64_t solverNodes = 0;
+    double solverMs = 0.0;
+    // selective search
+    uint64_t reductions = 0;    // moves searched at reduced depth
+    uint64_t researches = 0;    // reduced moves that beat alpha and were searched again
+    uint64_t pruned = 0;        // moves dropped by forward pruning
+};
+
+struct SearchLine
+{
+    int score = 0;
+    std::vector<PosMove> pv;
+};
+
+struct SearchResult
+{
+    bool hasMove = false;
+    PosMove best = {};
+    int score = 0;              // side to move's point of view, EVAL_SQUARE units (see eval.h)
+    std::vector<PosMove> pv;
+    std::vector<SearchLine> lines;  // best first, up to multiPV entries (lines[0] is best/score/pv)
+    bool proven = false;        // solved table or endgame solver result: scores are +-ENGINE_PROVEN
+    SearchStats stats;
+};
+
+struct Engine;
+struct SolvedTable;
+
+Engine* Engine_Create(int ttSizeMB = 32);
+void Engine_Destroy(Engine* engine);
+// forget everything learned (TT, eval cache, history); e.g. for a new game
+void Engine_Clear(Engine* engine);
+
+// Solved table consulted at the root of every search (nullptr: none); it must stay open while the
+// engine searches and may only be changed between searches.
+void Engine_SetSolvedTable(Engine* engine, const SolvedTable* table);
+
+// Searches 'pos' within 'limits'. Returns false if the side to move has no move.
+bool Engine_Search(Engine* engine, const Position &pos, const SearchLimits &limits, SearchResult &out);
+// Asks a running Engine_Search (on another thread) to return as soon as possible.
+void Engine_Stop(Engine* engine);
+
+// Direct transposition table access (benchmarks, tools); not while the engine searches. Entries
+// stored here are exact scores as given, without the search's mate-distance adjustment.
+bool Engine_ProbeTT(Engine* engine, uint64_t key, int &score, int &depth, PosMove &move);
+void Engine_StoreTT(Engine* engine, uint64_t key, int score, int depth, const PosMove &move);
+
+// "D1 D7 G7" style move text (file letter + rank, as in .pbn records)
+std::string Engine_MoveToString(const Position &pos, const PosMove &m);
+// One JSON object with the result and all statistics of a search.
+void SearchResult_ToJson(const Position &pos, const SearchResult &result, std::string &out);
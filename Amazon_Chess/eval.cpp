@@ -0,0 +1,415 @@
+#include "eval.h"
+#include "bitboard.h"
+#include "board_geometry.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+static const uint8_t kUnreached = 0xFF;
+
+template <int N, bool Bits = (N >= EVAL_BITBOARD_MIN_SIDE)>
+struct EvalKernel;
+
+// breadth-first search over the compile-time ray tables (reference kernel, see EVAL_BITBOARD_MIN_SIDE)
+template <int N>
+struct EvalKernel<N, false>
+{
+    // queen-move distance from the amazons of 'side' to every square (kUnreached if blocked off)
+    static void QueenDistances(const Position &pos, int side, uint8_t* dist)
+    {
+        const BoardGeometry<N> &g = Geometry<N>::value;
+        memset(dist, kUnreached, N * N);
+        uint8_t frontier[N * N];
+        uint8_t next[N * N];
+        int count = 0;
+        for (int i = 0; i < POSITION_AMAZONS; ++i) frontier[count++] = pos.amazon[side][i];
+
+        for (uint8_t d = 1; count > 0; ++d)
+        {
+            int nextCount = 0;
+            for (int i = 0; i < count; ++i)
+            {
+                int from = frontier[i];
+                for (int dir = 0; dir < GEOMETRY_DIRS; ++dir)
+                {
+                    const uint8_t* ray = g.ray[from][dir];
+                    for (int k = 0, len = g.rayLen[from][dir]; k < len; ++k)
+                    {
+                        int sq = ray[k];
+                        if (pos.cell[sq] != CELL_EMPTY) break;
+                        // a square already reached at this distance does not stop the ray
+                        if (dist[sq] == kUnreached)
+                        {
+                            dist[sq] = d;
+                            next[nextCount++] = (uint8_t)sq;
+                        }
+                        else if (dist[sq] < d) break;
+                    }
+                }
+            }
+            memcpy(frontier, next, (size_t)nextCount);
+            count = nextCount;
+        }
+    }
+
+    static int Territory(const Position &pos)
+    {
+        uint8_t white[N * N], black[N * N];
+        QueenDistances(pos, 0, white);
+        QueenDistances(pos, 1, black);
+
+        int score = 0; // white's point of view
+        int tie = pos.blackToMove ? -EVAL_SQUARE / 2 : EVAL_SQUARE / 2;
+        for (int sq = 0; sq < N * N; ++sq)
+        {
+            if (pos.cell[sq] != CELL_EMPTY) continue;
+            if (white[sq] < black[sq]) score += EVAL_SQUARE;
+            else if (black[sq] < white[sq]) score -= EVAL_SQUARE;
+            else if (white[sq] != kUnreached) score += tie;
+        }
+        return pos.blackToMove ? -score : score;
+    }
+};
+
+// both sides' distance layers grow set-wise on bitboards in lockstep, so each empty
+// square is decided in the layer where the first side reaches it
+template <int N>
+struct EvalKernel<N, true>
+{
+    static int Territory(const Position &pos)
+    {
+        Bitboard<N> empty = Bitboard_Empty<N>();
+        for (int sq = 0; sq < N * N; ++sq)
+            if (pos.cell[sq] == CELL_EMPTY) Bitboard_Set(empty, sq);
+        Bitboard<N> frontier[2], reached[2], owned[2];
+        Bitboard<N> ties = Bitboard_Empty<N>();
+        for (int side = 0; side < 2; ++side)
+        {
+            frontier[side] = reached[side] = owned[side] = Bitboard_Empty<N>();
+            for (int i = 0; i < POSITION_AMAZONS; ++i) Bitboard_Set(frontier[side], pos.amazon[side][i]);
+        }
+        while (Bitboard_Any(frontier[0]) || Bitboard_Any(frontier[1]))
+        {
+            Bitboard<N> next[2];
+            for (int side = 0; side < 2; ++side)
+            {
+                next[side] = Bitboard_Any(frontier[side])
+                    ? Bitboard_AndNot(Bitboard_QueenTargets(frontier[side], empty), reached[side]) : Bitboard_Empty<N>();
+            }
+            owned[0] = owned[0] | Bitboard_AndNot(Bitboard_AndNot(next[0], reached[1]), next[1]);
+            owned[1] = owned[1] | Bitboard_AndNot(Bitboard_AndNot(next[1], reached[0]), next[0]);
+            ties = ties | (next[0] & next[1]);
+            for (int side = 0; side < 2; ++side)
+            {
+                reached[side] = reached[side] | next[side];
+                frontier[side] = next[side];
+            }
+        }
+
+        int tie = pos.blackToMove ? -EVAL_SQUARE / 2 : EVAL_SQUARE / 2;
+        int score = (Bitboard_Count(owned[0]) - Bitboard_Count(owned[1])) * EVAL_SQUARE + Bitboard_Count(ties) * tie;
+        return pos.blackToMove ? -score : score;
+    }
+};
+
+static const EvalFunc kTerritory[POSITION_MAX_SIDE - POSITION_MIN_SIDE + 1] = {
+    EvalKernel<4>::Territory, EvalKernel<5>::Territory, EvalKernel<6>::Territory, EvalKernel<7>::Territory,
+    EvalKernel<8>::Territory, EvalKernel<9>::Territory, EvalKernel<10>::Territory, EvalKernel<11>::Territory,
+    EvalKernel<12>::Territory, EvalKernel<13>::Territory, EvalKernel<14>::Territory, EvalKernel<15>::Territory,
+    EvalKernel<16>::Territory };
+
+EvalFunc Eval_GetTerritoryKernel(int size)
+{
+    if (size < POSITION_MIN_SIDE || size > POSITION_MAX_SIDE) size = 8;
+    return kTerritory[size - POSITION_MIN_SIDE];
+}
+
+int Eval_Territory(const Position &pos)
+{
+    return Eval_GetTerritoryKernel(pos.size)(pos);
+}
+
+// ---- incremental evaluation ----
+
+template <int N>
+struct IncrementalKernel
+{
+    typedef Bitboard<N> Board;
+
+    static Board Load(const uint64_t* w)
+    {
+        Board b;
+        memcpy(b.w, w, sizeof(b.w));
+        return b;
+    }
+    static void Store(uint64_t* w, const Board &b) { memcpy(w, b.w, sizeof(b.w)); }
+
+    // first layer of 'side' holding a square of 'squares'; the layer count if none is reached
+    static int Distance(const EvalState &s, int side, const Board &squares)
+    {
+        for (int d = 0; d < s.layers[side]; ++d)
+            if (Bitboard_Any(Load(s.within[side][d]) & squares)) return d;
+        return s.layers[side];
+    }
+
+    // the squares next to those of 'b'
+    static Board Neighbours(const Board &b)
+    {
+        const BitboardMasks<N> &m = BitboardMasks<N>::Get();
+        Board rows = b | Bitboard_Shift<N, N>(b) | Bitboard_Shift<N, -N>(b);
+        Board ring = rows | (Bitboard_Shift<N, 1>(rows) & m.notFirstCol) | (Bitboard_Shift<N, -1>(rows) & m.notLastCol);
+        return ring & m.board;
+    }
+
+    // recomputes the layers of 'side' after 'start' over s.empty (layers 0..start are kept)
+    static void Grow(EvalState &s, int side, int start)
+    {
+        Board empty = Load(s.empty);
+        Board reached = Load(s.within[side][start]);
+        Board frontier = start > 0 ? Bitboard_AndNot(reached, Load(s.within[side][start - 1])) : reached;
+        int d = start;
+        for (;;)
+        {
+            Board next = Bitboard_AndNot(Bitboard_QueenTargets(frontier, empty), reached);
+            if (!Bitboard_Any(next)) break;
+            if (d + 1 >= EVAL_MAX_LAYERS)
+            {
+                s.overflow = true;
+                break;
+            }
+            reached = reached | next;
+            Store(s.within[side][++d], reached);
+            frontier = next;
+        }
+        s.layers[side] = (uint8_t)(d + 1);
+    }
+
+    static void Init(const Position &pos, EvalState &out)
+    {
+        Board empty = Bitboard_Empty<N>();
+        for (int sq = 0; sq < N * N; ++sq)
+            if (pos.cell[sq] == CELL_EMPTY) Bitboard_Set(empty, sq);
+        Store(out.empty, empty);
+        out.blackToMove = pos.blackToMove;
+        out.overflow = false;
+        for (int side = 0; side < 2; ++side)
+        {
+            Board amazons = Bitboard_Empty<N>();
+            for (int i = 0; i < POSITION_AMAZONS; ++i) Bitboard_Set(amazons, pos.amazon[side][i]);
+            Store(out.within[side][0], amazons);
+            Grow(out, side, 0);
+        }
+    }
+
+    static void Verify(const EvalState &s)
+    {
+        EvalState full;
+        memcpy(full.empty, s.empty, sizeof(full.empty));
+        full.blackToMove = s.blackToMove;
+        full.overflow = false;
+        for (int side = 0; side < 2; ++side)
+        {
+            memcpy(full.within[side][0], s.within[side][0], sizeof(full.within[side][0]));
+            Grow(full, side, 0);
+            bool same = full.layers[side] == s.layers[side];
+            for (int d = 0; same && d < s.layers[side]; ++d)
+                same = memcmp(full.within[side][d], s.within[side][d], Board::kWords * sizeof(uint64_t)) == 0;
+            if (!same)
+            {
+                fprintf(stderr, "incremental eval: side %d layers differ from a full recomputation\n", side);
+                abort();
+            }
+        }
+    }
+
+    static void Update(const EvalState &parent, const PosMove &m, EvalState &out)
+    {
+        int mover = parent.blackToMove ? 1 : 0, other = 1 - mover;
+        Board empty = Load(parent.empty);
+        Bitboard_Set(empty, m.from);
+        empty.w[m.to >> 6] &= ~(1ull << (m.to & 63));
+        empty.w[m.arrow >> 6] &= ~(1ull << (m.arrow & 63));
+        Store(out.empty, empty);
+        out.blackToMove = !parent.blackToMove;
+        out.overflow = false;
+
+        Board amazons = Load(parent.within[mover][0]);
+        amazons.w[m.from >> 6] &= ~(1ull << (m.from & 63));
+        Bitboard_Set(amazons, m.to);
+        Store(out.within[mover][0], amazons);
+        Grow(out, mover, 0);
+
+        // no layer of the other side below the distances of the changed squares can change (a
+        // path through the vacated square enters it from a neighbour)
+        Board from = Bitboard_Empty<N>();
+        Bitboard_Set(from, m.from);
+        Board changed = Neighbours(from);
+        Bitboard_Set(changed, m.to);
+        Bitboard_Set(changed, m.arrow);
+        int first = parent.overflow ? 0 : Distance(parent, other, changed);
+        int keep = std::min(std::max(first, 1), (int)parent.layers[other]);
+        memcpy(out.within[other], parent.within[other], (size_t)keep * sizeof(out.within[other][0]));
+        if (first < parent.layers[other] || parent.overflow) Grow(out, other, keep - 1);
+        else out.layers[other] = parent.layers[other];
+#if EVAL_VERIFY_INCREMENTAL
+        Verify(out);
+#endif
+    }
+
+    // squares first reached in layers start.. (start >= 1) of the lockstep territory count of
+    // EvalKernel<N, true>, added to owned (white minus black) and ties; 'cumulative', if given,
+    // receives both running totals after every layer
+    static void Tally(const EvalState &s, int start, int &owned, int &ties, int (*cumulative)[2] = nullptr)
+    {
+        Board prev[2];
+        for (int side = 0; side < 2; ++side) prev[side] = Load(s.within[side][std::min(start - 1, std::max(s.layers[side] - 1, 0))]);
+        int layers = std::max(s.layers[0], s.layers[1]);
+        for (int d = start; d < layers; ++d)
+        {
+            Board cur[2];
+            for (int side = 0; side < 2; ++side) cur[side] = d < s.layers[side] ? Load(s.within[side][d]) : prev[side];
+            Board fresh0 = Bitboard_AndNot(cur[0], prev[0]), fresh1 = Bitboard_AndNot(cur[1], prev[1]);
+            owned += Bitboard_Count(Bitboard_AndNot(fresh0, cur[1])) - Bitboard_Count(Bitboard_AndNot(fresh1, cur[0]));
+            ties += Bitboard_Count(fresh0 & fresh1);
+            prev[0] = cur[0];
+            prev[1] = cur[1];
+            if (cumulative)
+            {
+                cumulative[d][0] = owned;
+                cumulative[d][1] = ties;
+            }
+        }
+    }
+
+    static int Finish(bool blackToMove, int owned, int ties)
+    {
+        int tie = blackToMove ? -EVAL_SQUARE / 2 : EVAL_SQUARE / 2;
+        int score = owned * EVAL_SQUARE + ties * tie;
+        return blackToMove ? -score : score;
+    }
+
+    static int Score(const EvalState &s)
+    {
+        int owned = 0, ties = 0;
+        Tally(s, 1, owned, ties);
+        return Finish(s.blackToMove, owned, ties);
+    }
+
+    // Update without the arrow: the amazon has moved, the same side is still to shoot
+    static void MoveAmazon(const EvalState &parent, int from, int to, EvalState &out)
+    {
+        int mover = parent.blackToMove ? 1 : 0, other = 1 - mover;
+        Board empty = Load(parent.empty);
+        Bitboard_Set(empty, from);
+        empty.w[to >> 6] &= ~(1ull << (to & 63));
+        Store(out.empty, empty);
+        out.blackToMove = parent.blackToMove;
+        out.overflow = false;
+
+        Board amazons = Load(parent.within[mover][0]);
+        amazons.w[from >> 6] &= ~(1ull << (from & 63));
+        Bitboard_Set(amazons, to);
+        Store(out.within[mover][0], amazons);
+        Grow(out, mover, 0);
+
+        Board vacated = Bitboard_Empty<N>();
+        Bitboard_Set(vacated, from);
+        Board changed = Neighbours(vacated);
+        Bitboard_Set(changed, to);
+        int first = parent.overflow ? 0 : Distance(parent, other, changed);
+        int keep = std::min(std::max(first, 1), (int)parent.layers[other]);
+        memcpy(out.within[other], parent.within[other], (size_t)keep * sizeof(out.within[other][0]));
+        if (first < parent.layers[other] || parent.overflow) Grow(out, other, keep - 1);
+        else out.layers[other] = parent.layers[other];
+    }
+
+    // score after 'mid' shoots at 'arrow', from the side to move after it. The arrow only blocks a
+    // square, so a side's layers below the arrow's distance from it stay mid's: they are read back,
+    // and only the layers from there on are grown. The squares decided before either side's first
+    // changed layer come from mid's running totals.
+    static int Shoot(const EvalState &mid, const int (*totals)[2], int arrow)
+    {
+        Board shot = Bitboard_Empty<N>();
+        Bitboard_Set(shot, arrow);
+        int first[2] = { Distance(mid, 0, shot), Distance(mid, 1, shot) };  // >= 1: no amazon there
+        int start = std::min(first[0], first[1]);
+        Board empty = Bitboard_AndNot(Load(mid.empty), shot);
+        Board reached[2], frontier[2];
+        for (int side = 0; side < 2; ++side)
+        {
+            reached[side] = Load(mid.within[side][start - 1]);
+            frontier[side] = start > 1 ? Bitboard_AndNot(reached[side], Load(mid.within[side][start - 2])) : reached[side];
+        }
+        int owned = totals[start - 1][0], ties = totals[start - 1][1];
+        for (int d = start; Bitboard_Any(frontier[0]) || Bitboard_Any(frontier[1]); ++d)
+        {
+            Board next[2];
+            for (int side = 0; side < 2; ++side)
+            {
+                if (d < first[side])
+                    next[side] = d < mid.layers[side] ? Bitboard_AndNot(Load(mid.within[side][d]), reached[side]) : Bitboard_Empty<N>();
+                else if (Bitboard_Any(frontier[side]))
+                    next[side] = Bitboard_AndNot(Bitboard_QueenTargets(frontier[side], empty), reached[side]);
+                else
+                    next[side] = Bitboard_Empty<N>();
+            }
+            owned += Bitboard_Count(Bitboard_AndNot(Bitboard_AndNot(next[0], reached[1]), next[1]))
+                - Bitboard_Count(Bitboard_AndNot(Bitboard_AndNot(next[1], reached[0]), next[0]));
+            ties += Bitboard_Count(next[0] & next[1]);
+            for (int side = 0; side < 2; ++side)
+            {
+                reached[side] = reached[side] | next[side];
+                frontier[side] = next[side];
+            }
+        }
+        return Finish(!mid.blackToMove, owned, ties);
+    }
+
+    static void Children(const Position &parent, const PosMove* moves, int count, int* scores)
+    {
+        std::unique_ptr<EvalState[]> states(new EvalState[2]);     // parent, after the amazon move
+        EvalState &root = states[0], &mid = states[1];
+        int totals[EVAL_MAX_LAYERS][2];     // mid's running totals per layer
+        Init(parent, root);
+        for (int i = 0; i < count; ++i)
+        {
+            const PosMove &m = moves[i];
+            if (i == 0 || m.from != moves[i - 1].from || m.to != moves[i - 1].to)
+            {
+                MoveAmazon(root, m.from, m.to, mid);
+                int owned = 0, ties = 0;
+                totals[0][0] = totals[0][1] = 0;
+                if (!mid.overflow) Tally(mid, 1, owned, ties, totals);
+            }
+            if (mid.overflow)
+            {
+                Position pos = parent;
+                Position_MakeMove(pos, m);
+                scores[i] = -EvalKernel<N>::Territory(pos);
+                continue;
+            }
+            scores[i] = -Shoot(mid, totals, m.arrow);
+        }
+    }
+};
+
+#define EVAL_KERNELS(n) { IncrementalKernel<n>::Init, IncrementalKernel<n>::Update, IncrementalKernel<n>::Score, \
+    IncrementalKernel<n>::Children }
+
+static const EvalKernels kIncremental[POSITION_MAX_SIDE - POSITION_MIN_SIDE + 1] = {
+    EVAL_KERNELS(4), EVAL_KERNELS(5), EVAL_KERNELS(6), EVAL_KERNELS(7), EVAL_KERNELS(8), EVAL_KERNELS(9),
+    EVAL_KERNELS(10), EVAL_KERNELS(11), EVAL_KERNELS(12), EVAL_KERNELS(13), EVAL_KERNELS(14), EVAL_KERNELS(15),
+    EVAL_KERNELS(16) };
+
+const EvalKernels& Eval_GetIncrementalKernels(int size)
+{
+    if (size < POSITION_MIN_SIDE || size > POSITION_MAX_SIDE) size = 8;
+    return kIncremental[size - POSITION_MIN_SIDE];
+}
+
+void Eval_Children(const Position &parent, const PosMove* moves, int count, int* scores)
+{
+    Eval_GetIncrementalKernels(parent.size).children(parent, moves, count, scores);
+}
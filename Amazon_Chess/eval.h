@@ -0,0 +1,63 @@
+#pragma once
+
+// Static evaluation for the engine: queen-distance territory. Every empty square belongs to the side
+// whose amazons reach it in fewer queen moves; ties go half to the side to move. Scores are in
+// hundredths of a square from the side to move's point of view.
+
+#include "position.h"
+
+#define EVAL_SQUARE 100
+// boards at least this large use the bitboard territory kernel, smaller ones the ray-table search;
+// the bitboard kernel is faster on every size, raise this to cross-check against the ray search
+#ifndef EVAL_BITBOARD_MIN_SIDE
+#define EVAL_BITBOARD_MIN_SIDE POSITION_MIN_SIDE
+#endif
+
+int Eval_Territory(const Position &pos);
+
+// Eval_Territory compiled for one board size (see PositionKernels); fetched once per search
+typedef int (*EvalFunc)(const Position &pos);
+EvalFunc Eval_GetTerritoryKernel(int size);
+
+// ---- incremental evaluation ----
+// An EvalState keeps the queen-distance layers of both sides for one position and is carried from a
+// position to its children. A move changes three squares; the first layer of the side not moving it
+// can change is bounded by their distances (a blocked square's own distance, and the smallest
+// distance next to the square the amazon left), so that side keeps its layers below the bound and
+// regrows the rest. The moving side's amazons changed, so its layers are rebuilt. Scores equal
+// Eval_Territory of the same position.
+
+#define EVAL_MAX_LAYERS 48      // distances beyond this (rare mazes) fall back to the full kernel
+// 1: every update is checked against a full recomputation and aborts on a difference (testing only)
+#ifndef EVAL_VERIFY_INCREMENTAL
+#define EVAL_VERIFY_INCREMENTAL 0
+#endif
+
+struct EvalState
+{
+    uint64_t empty[4];                          // empty squares (bitboard.h layout)
+    uint64_t within[2][EVAL_MAX_LAYERS][4];     // [side][d]: squares at queen distance <= d, d = 0 the amazons
+    uint8_t layers[2];                          // layers stored per side
+    bool blackToMove;
+    bool overflow;                              // a side needs more layers; score with Eval_Territory
+};
+
+struct EvalKernels
+{
+    void (*init)(const Position &pos, EvalState &out);
+    // out = the state after 'm' (legal in parent's position); parent and out may not alias
+    void (*update)(const EvalState &parent, const PosMove &m, EvalState &out);
+    int (*score)(const EvalState &state);       // not valid for overflowed states
+    // see Eval_Children
+    void (*children)(const Position &parent, const PosMove* moves, int count, int* scores);
+};
+const EvalKernels& Eval_GetIncrementalKernels(int size); // unsupported sizes get the 8x8 kernels
+
+// ---- batched child evaluation ----
+// Scores many children of one position at once, e.g. every move of one amazon for a hint heatmap.
+// scores[i] is the territory score after moves[i] (legal in 'parent') from the point of view of the
+// side that plays it, i.e. -Eval_Territory of the child. The parent's layers are built once; moves
+// of the same amazon to the same square share the layers after the amazon move, and each arrow then
+// regrows only the layers at and beyond its distance from either side. Keep such moves adjacent in
+// 'moves', as Position_GenerateMoves emits them.
+void Eval_Children(const Position &parent, const PosMove* moves, int count, int* scores);
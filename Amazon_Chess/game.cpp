@@ -1,52 +1,121 @@
 #include "game.h"
+#include "position.h"
+#include "reach.h"
+#include "trace.h"
 #include <algorithm>
 #include <d2d1.h>
 #include <windows.h>
 #include <mmsystem.h>
-#include <sstream>
 #include <vector>
-#include <string>
+#include <cstring>
+#include <cstdlib>
 
 #pragma comment(lib, "winmm")
 
 static std::vector<GamePiece> s_pieces;
 static int s_boardSize = 10;
+static PositionSetup s_setup;
 static bool s_aiIsBlack = true; // which color AI controls
 static bool s_blackToMove = true; // black moves first
 static bool s_opponentIsAI = true;
+static int s_aiDifficulty = 1;
 static std::vector<int> s_grid; // 0 empty, 1 piece, 2 arrow
-static std::vector<std::wstring> s_history; // textual history for UI
 static bool s_gameOver = false; // when true, no further moves allowed
 
-// New: Move struct and stacks for applied / undone moves
-struct MoveRecord { int fr, fc, tr, tc, ar, ac; bool isWhite; };
-static std::vector<MoveRecord> s_appliedMoves; // acts as a stack of applied moves
-static std::vector<MoveRecord> s_undoneMoves;  // stack of undone moves (for redo)
-
-// new: current applied moves count (kept in sync with s_appliedMoves.size())
+// The game line as one packed log of square indices, 3 bytes per move; the mover's colour follows
+// from the ply (black moves first). The first s_currentMoveIndex moves are on the board, the rest are
+// what redo replays; a new move drops them. Every move places an arrow, so a line never has more moves
+// than the board has squares and the log is reserved once, which keeps moves free of allocation.
+struct PackedMove { uint8_t from, to, arrow; };
+static std::vector<PackedMove> s_moveLog;
 static int s_currentMoveIndex = 0;
+
+// Notation is only needed for the rows the history window draws: it is formatted on first use into a
+// direct-mapped table indexed by ply, and a slot is reused while it still holds the same move.
+static const int kMoveTextSlots = 64;
+struct MoveTextSlot { int plyPlusOne; PackedMove move; wchar_t text[GAME_MOVE_TEXT_MAX]; };
+static MoveTextSlot s_moveText[kMoveTextSlots];
 // new: history changed callback
 static GameHistoryChangedCallback s_historyCb = nullptr;
+static GameEventCallback s_eventCb = nullptr;
+
+// Position checkpoints: a compact snapshot is kept every GAME_CHECKPOINT_INTERVAL moves of the
+// current line (s_checkpoints[k] = position after k * interval moves), so seeking through history
+// restores the nearest checkpoint and replays at most interval-1 moves instead of walking move by move.
+static const int kMaxBoardSquares = POSITION_MAX_SQUARES;
+struct PositionSnapshot
+{
+    unsigned char pieceSq[8];                          // square index of each s_pieces slot
+    unsigned char pieceCount;
+    unsigned char cells[kMaxBoardSquares];            // s_grid contents (0 empty, 1 piece, 2 arrow)
+};
+static std::vector<PositionSnapshot> s_checkpoints;
+
+// The board again as a Position, with every amazon's reach (reach.h) updated move by move, so
+// Game_CheckForWinner is a lookup instead of a search for a legal move. Rebuilt whenever the board
+// is set wholesale (new game, checkpoint restore).
+static Position s_position;
+static ReachState s_reach;
 
 static inline int Index(int r, int c) { return r * s_boardSize + c; }
 
-// helper: parse history entry of form "[W] C1 D1 C1"
-static bool ParseHistoryEntry(const std::wstring& entry, int &fromR, int &fromC, int &toR, int &toC, int &arrowR, int &arrowC)
-{
-    size_t pos = entry.find(L"] ");
-    if (pos == std::wstring::npos) return false;
-    std::wstring rest = entry.substr(pos + 2);
-    std::wstringstream ss(rest);
-    std::wstring a,b,c;
-    if (!(ss >> a >> b >> c)) return false;
-    if (a.size() < 2 || b.size() < 2 || c.size() < 2) return false;
-    fromC = a[0] - L'A';
-    fromR = _wtoi(a.substr(1).c_str()) - 1;
-    toC = b[0] - L'A';
-    toR = _wtoi(b.substr(1).c_str()) - 1;
-    arrowC = c[0] - L'A';
-    arrowR = _wtoi(c.substr(1).c_str()) - 1;
-    return true;
+static void NotifySeek()
+{
+    if (!s_eventCb) return;
+    GameEvent ev = {};
+    ev.type = GAME_EVENT_SEEK;
+    ev.moveIndex = s_currentMoveIndex;
+    s_eventCb(ev);
+}
+
+static void TakeSnapshot(PositionSnapshot &snap)
+{
+    memset(&snap, 0, sizeof(snap));
+    snap.pieceCount = (unsigned char)s_pieces.size();
+    for (size_t i = 0; i < s_pieces.size() && i < 8; ++i)
+        snap.pieceSq[i] = (unsigned char)Index(s_pieces[i].row, s_pieces[i].col);
+    for (int sq = 0; sq < (int)s_grid.size(); ++sq) snap.cells[sq] = (unsigned char)s_grid[sq];
+}
+
+static void BuildPosition(Position &out, bool blackToMove)
+{
+    uint8_t cells[POSITION_MAX_SQUARES] = {};
+    for (int i = 0; i < (int)s_grid.size() && i < POSITION_MAX_SQUARES; ++i)
+        if (s_grid[i] == 2) cells[i] = CELL_ARROW;
+    for (const auto &p : s_pieces)
+        cells[Index(p.row, p.col)] = p.isWhite ? CELL_WHITE : CELL_BLACK;
+    Position_SetFromCells(out, s_boardSize, cells, blackToMove);
+}
+
+static void SyncPosition(bool blackToMove)
+{
+    BuildPosition(s_position, blackToMove);
+    Reach_Init(s_position, s_reach);
+}
+
+static void TrackMove(const PackedMove &m)
+{
+    PosMove pm = { m.from, m.to, m.arrow };
+    Position_MakeMove(s_position, pm);
+    Reach_MakeMove(s_reach, s_position, pm);
+}
+
+static void UntrackMove(const PackedMove &m)
+{
+    PosMove pm = { m.from, m.to, m.arrow };
+    Position_UnmakeMove(s_position, pm);
+    Reach_UnmakeMove(s_reach, s_position, pm);
+}
+
+static void RestoreSnapshot(const PositionSnapshot &snap)
+{
+    // piece slots keep their order for the whole game, so only squares need restoring
+    for (int sq = 0; sq < (int)s_grid.size(); ++sq) s_grid[sq] = snap.cells[sq];
+    for (size_t i = 0; i < s_pieces.size() && i < snap.pieceCount; ++i)
+    {
+        s_pieces[i].row = snap.pieceSq[i] / s_boardSize;
+        s_pieces[i].col = snap.pieceSq[i] % s_boardSize;
+    }
 }
 
 // helper to setup initial pieces/grid for current board size and AI settings
@@ -54,63 +123,62 @@ static void ResetInitialSetup()
 {
     s_pieces.clear();
     s_grid.assign(s_boardSize * s_boardSize, 0);
-    // NOTE: do not clear s_history here; Game_Init handles history clearing
+    // NOTE: do not clear the move log here; Game_Init handles history clearing
 
-    auto add = [&](char file, int rank, bool white)
+    Position start;
+    Position_InitSetup(start, s_boardSize, s_setup);
+    for (int side = 0; side < 2; ++side)
     {
-        int col = (int)(file - 'A');
-        int row = rank - 1;
-        if (row < 0) row = 0;
-        if (row >= s_boardSize) row = s_boardSize - 1;
-        s_pieces.push_back({ row, col, white });
-        s_grid[Index(row,col)] = 1;
-    };
-
-    if (s_boardSize == 10)
-    {
-        add('D', 10, true);
-        add('G', 10, true);
-        add('A', 7, true);
-        add('J', 7, true);
-        add('D', 1, false);
-        add('G', 1, false);
-        add('A', 4, false);
-        add('J', 4, false);
-    }
-    else
-    {
-        add('C', 1, false);
-        add('F', 1, false);
-        add('A', 3, false);
-        add('H', 3, false);
-        add('C', 8, true);
-        add('F', 8, true);
-        add('A', 6, true);
-        add('H', 6, true);
+        for (int i = 0; i < POSITION_AMAZONS; ++i)
+        {
+            int sq = start.amazon[side][i];
+            s_pieces.push_back({ sq / s_boardSize, sq % s_boardSize, side == 0 });
+            s_grid[sq] = 1;
+        }
     }
+    SyncPosition(true);
 }
 
-void Game_Init(int boardSize, bool opponentIsAI, int aiDifficulty, bool aiFirst)
+void Game_Init(int boardSize, bool opponentIsAI, int aiDifficulty, bool aiFirst, const PositionSetup* setup)
 {
     s_pieces.clear();
-    s_boardSize = (boardSize == 8) ? 8 : 10;
+    s_setup = PositionSetup();
+    if (setup && setup->custom && Position_IsValidSetup(boardSize, *setup)) s_setup = *setup;
+    s_boardSize = (s_setup.custom || Position_HasStandardSetup(boardSize)) ? boardSize : 10;
     s_grid.assign(s_boardSize * s_boardSize, 0);
-    // Reset textual history when creating a new game
-    s_history.clear();
 
     s_opponentIsAI = opponentIsAI;
+    s_aiDifficulty = (aiDifficulty >= 0 && aiDifficulty <= 2) ? aiDifficulty : 1;
     bool blackIsAI = (opponentIsAI && aiFirst);
     s_aiIsBlack = blackIsAI;
     s_blackToMove = true; // black always starts
     s_gameOver = false;
 
-    // clear move stacks when initializing the board state
-    s_appliedMoves.clear();
-    s_undoneMoves.clear();
+    // clear the move log when initializing the board state (capacity is kept)
+    s_moveLog.clear();
+    s_moveLog.reserve(POSITION_MAX_SQUARES);
     s_currentMoveIndex = 0;
 
     ResetInitialSetup();
 
+    // checkpoint 0 is the initial setup
+    s_checkpoints.clear();
+    s_checkpoints.reserve(POSITION_MAX_SQUARES / GAME_CHECKPOINT_INTERVAL + 1);
+    s_checkpoints.emplace_back();
+    TakeSnapshot(s_checkpoints.back());
+
+    if (s_eventCb)
+    {
+        GameEvent ev = {};
+        ev.type = GAME_EVENT_NEW_GAME;
+        ev.boardSize = s_boardSize;
+        ev.opponentIsAI = opponentIsAI;
+        ev.aiFirst = aiFirst;
+        ev.aiDifficulty = s_aiDifficulty;
+        ev.setup = s_setup.custom ? &s_setup : nullptr;
+        s_eventCb(ev);
+    }
+
     // notify UI that history / state changed (board reset)
     if (s_historyCb) s_historyCb();
 }
@@ -141,6 +209,13 @@ void Game_DrawPieces(ID2D1HwndRenderTarget* rt, ID2D1SolidColorBrush* whiteBrush
 const std::vector<GamePiece>& Game_GetPieces() { return s_pieces; }
 int Game_GetBoardSize() { return s_boardSize; }
 
+void Game_GetSetup(PositionSetup &out) { out = s_setup; }
+
+void Game_GetPosition(Position &out)
+{
+    BuildPosition(out, s_blackToMove);
+}
+
 bool Game_IsBlackToMove() { return s_blackToMove; }
 void Game_ToggleTurn() { s_blackToMove = !s_blackToMove; }
 
@@ -202,46 +277,48 @@ std::vector<std::pair<int,int>> Game_GetLegalArrows(int fromRow, int fromCol, in
     return out;
 }
 
-// helper: apply a MoveRecord to the current board (used for redo)
-static void ApplyMoveRecordToBoard(const MoveRecord &m)
+// helper: apply a logged move to the current board (used for redo)
+static void ApplyLoggedMove(const PackedMove &m)
 {
     // find the piece at the from-square (should be present)
     for (auto &p : s_pieces)
     {
-        if (p.row == m.fr && p.col == m.fc && p.isWhite == m.isWhite)
+        if (Index(p.row, p.col) == m.from)
         {
             // move it
-            s_grid[Index(m.fr,m.fc)] = 0;
-            p.row = m.tr; p.col = m.tc;
-            s_grid[Index(m.tr,m.tc)] = 1;
-            s_grid[Index(m.ar,m.ac)] = 2; // place arrow
+            s_grid[m.from] = 0;
+            p.row = m.to / s_boardSize; p.col = m.to % s_boardSize;
+            s_grid[m.to] = 1;
+            s_grid[m.arrow] = 2; // place arrow
+            TrackMove(m);
             return;
         }
     }
 }
 
-// helper: undo a MoveRecord from the current board (used for undo)
-static void UndoMoveRecordFromBoard(const MoveRecord &m)
+// helper: undo a logged move from the current board (used for undo)
+static void UndoLoggedMove(const PackedMove &m)
 {
     // remove arrow
-    s_grid[Index(m.ar,m.ac)] = 0;
+    s_grid[m.arrow] = 0;
     // find the piece at the to-square (moved piece)
     for (auto &p : s_pieces)
     {
-        if (p.row == m.tr && p.col == m.tc && p.isWhite == m.isWhite)
+        if (Index(p.row, p.col) == m.to)
         {
             // move it back
-            s_grid[Index(m.tr,m.tc)] = 0;
-            p.row = m.fr; p.col = m.fc;
-            s_grid[Index(m.fr,m.fc)] = 1;
+            s_grid[m.to] = 0;
+            p.row = m.from / s_boardSize; p.col = m.from % s_boardSize;
+            s_grid[m.from] = 1;
+            UntrackMove(m);
             return;
         }
     }
 }
 
-void Game_MakeMove(int fromRow, int fromCol, int toRow, int toCol, int arrowRow, int arrowCol)
+// perform a move and record it in history without notifying the UI; returns false if no piece at from-square
+static bool ApplyMoveNoNotify(int fromRow, int fromCol, int toRow, int toCol, int arrowRow, int arrowCol)
 {
-    if (s_gameOver) return; // don't allow moves after game over
     for (auto &p : s_pieces)
     {
         if (p.row == fromRow && p.col == fromCol)
@@ -252,92 +329,196 @@ void Game_MakeMove(int fromRow, int fromCol, int toRow, int toCol, int arrowRow,
             s_grid[Index(toRow,toCol)] = 1;
             s_grid[Index(arrowRow,arrowCol)] = 2;
 
-            // compose history entry string
-            auto filecol = [](int col){ wchar_t buf[3]; buf[0] = L'A' + col; buf[1]=0; return std::wstring(buf); };
-            auto rank = [&](int row){ int r = row + 1; wchar_t buf[8]; swprintf_s(buf, L"%d", r); return std::wstring(buf); };
-            std::wstring entry;
-            entry += (p.isWhite?L"[W] ":L"[B] ");
-            entry += filecol(fromCol) + rank(fromRow) + L" ";
-            entry += filecol(toCol) + rank(toRow) + L" ";
-            entry += filecol(arrowCol) + rank(arrowRow);
-
-            // If we had undone moves (redo stack), a new move should clear future moves and redo stack
-            if (!s_undoneMoves.empty())
+            // a new move replaces any undone moves after the cursor
+            s_moveLog.resize((size_t)s_currentMoveIndex);
+            PackedMove pm = { (uint8_t)Index(fromRow, fromCol), (uint8_t)Index(toRow, toCol), (uint8_t)Index(arrowRow, arrowCol) };
+            s_moveLog.push_back(pm);
+            TrackMove(pm);
+            s_currentMoveIndex = (int)s_moveLog.size();
+
+            // checkpoints past the branch point belong to the discarded line
+            size_t validCheckpoints = (size_t)((s_currentMoveIndex - 1) / GAME_CHECKPOINT_INTERVAL) + 1;
+            if (s_checkpoints.size() > validCheckpoints) s_checkpoints.resize(validCheckpoints);
+            if (s_currentMoveIndex % GAME_CHECKPOINT_INTERVAL == 0 && (int)s_checkpoints.size() == s_currentMoveIndex / GAME_CHECKPOINT_INTERVAL)
             {
-                s_undoneMoves.clear();
+                s_checkpoints.emplace_back();
+                TakeSnapshot(s_checkpoints.back());
             }
-            // If textual history had entries beyond current index, truncate them
-            if (s_currentMoveIndex < (int)s_history.size())
+
+            Game_ToggleTurn();
+            if (s_eventCb)
             {
-                s_history.erase(s_history.begin() + s_currentMoveIndex, s_history.end());
+                GameEvent ev = {};
+                ev.type = GAME_EVENT_MOVE;
+                ev.fromRow = fromRow; ev.fromCol = fromCol;
+                ev.toRow = toRow; ev.toCol = toCol;
+                ev.arrowRow = arrowRow; ev.arrowCol = arrowCol;
+                ev.moveIndex = s_currentMoveIndex;
+                s_eventCb(ev);
             }
+            return true;
+        }
+    }
+    return false;
+}
 
-            // push to applied moves stack and textual history
-            MoveRecord mr = { fromRow, fromCol, toRow, toCol, arrowRow, arrowCol, p.isWhite };
-            s_appliedMoves.push_back(mr);
-            s_history.push_back(entry);
-            s_currentMoveIndex = (int)s_appliedMoves.size();
+void Game_MakeMove(int fromRow, int fromCol, int toRow, int toCol, int arrowRow, int arrowCol)
+{
+    if (s_gameOver) return; // don't allow moves after game over
+    if (ApplyMoveNoNotify(fromRow, fromCol, toRow, toCol, arrowRow, arrowCol))
+    {
+        // notify UI that history changed
+        if (s_historyCb) s_historyCb();
+    }
+}
 
-            Game_ToggleTurn();
+// helper: true if (tr,tc) is a queen move away from (fr,fc) over empty squares.
+// ignoreIdx is treated as empty (the square the amazon left when shooting its arrow).
+static bool IsQueenReachable(int fr, int fc, int tr, int tc, int ignoreIdx)
+{
+    int dr = tr - fr, dc = tc - fc;
+    if (dr == 0 && dc == 0) return false;
+    if (dr != 0 && dc != 0 && abs(dr) != abs(dc)) return false;
+    int sr = (dr > 0) - (dr < 0), sc = (dc > 0) - (dc < 0);
+    int rr = fr + sr, cc = fc + sc;
+    for (;;)
+    {
+        int idx = Index(rr, cc);
+        if (idx != ignoreIdx && s_grid[idx] != 0) return false;
+        if (rr == tr && cc == tc) return true;
+        rr += sr; cc += sc;
+    }
+}
 
-            // notify UI that history changed
-            if (s_historyCb) s_historyCb();
-            return;
+static bool InBoard(int r, int c) { return r >= 0 && c >= 0 && r < s_boardSize && c < s_boardSize; }
+
+bool Game_LoadMoves(const GameMoveInput* moves, int count, int* outBadLine)
+{
+    TRACE_ZONE_ARG("Game_LoadMoves", count);
+    if (outBadLine) *outBadLine = 0;
+    bool ok = true;
+    for (int i = 0; i < count; ++i)
+    {
+        const GameMoveInput &m = moves[i];
+        // validate with the same rules as Game_GetLegalMoves / Game_GetLegalArrows
+        bool legal = !s_gameOver
+            && InBoard(m.fromRow, m.fromCol) && InBoard(m.toRow, m.toCol) && InBoard(m.arrowRow, m.arrowCol);
+        if (legal)
+        {
+            const GamePiece* p = Game_GetPieceAt(m.fromRow, m.fromCol);
+            legal = p && (p->isWhite != s_blackToMove)
+                && IsQueenReachable(m.fromRow, m.fromCol, m.toRow, m.toCol, -1)
+                && IsQueenReachable(m.toRow, m.toCol, m.arrowRow, m.arrowCol, Index(m.fromRow, m.fromCol));
+        }
+        if (!legal)
+        {
+            if (outBadLine) *outBadLine = m.line;
+            ok = false;
+            break;
         }
+        ApplyMoveNoNotify(m.fromRow, m.fromCol, m.toRow, m.toCol, m.arrowRow, m.arrowCol);
     }
+
+    // one notification for the whole batch
+    if (s_historyCb) s_historyCb();
+    return ok;
 }
 
-const std::vector<std::wstring>& Game_GetHistory() { return s_history; }
+GameHistoryMove Game_GetHistoryMove(int index)
+{
+    const PackedMove &m = s_moveLog[(size_t)index];
+    GameHistoryMove out;
+    out.fromRow = m.from / s_boardSize; out.fromCol = m.from % s_boardSize;
+    out.toRow = m.to / s_boardSize; out.toCol = m.to % s_boardSize;
+    out.arrowRow = m.arrow / s_boardSize; out.arrowCol = m.arrow % s_boardSize;
+    out.isWhite = (index % 2) == 1;
+    return out;
+}
+
+GameHistoryView Game_GetHistory()
+{
+    GameHistoryView view;
+    view.count = (int)s_moveLog.size();
+    return view;
+}
+
+void Game_FormatMove(const GameHistoryMove &m, wchar_t (&out)[GAME_MOVE_TEXT_MAX])
+{
+    swprintf_s(out, L"[%lc] %lc%d %lc%d %lc%d", (wint_t)(m.isWhite ? L'W' : L'B'),
+        (wint_t)(L'A' + m.fromCol), m.fromRow + 1, (wint_t)(L'A' + m.toCol), m.toRow + 1,
+        (wint_t)(L'A' + m.arrowCol), m.arrowRow + 1);
+}
+
+const wchar_t* Game_GetMoveText(int index)
+{
+    if (index < 0 || index >= (int)s_moveLog.size()) return L"";
+    const PackedMove &m = s_moveLog[(size_t)index];
+    MoveTextSlot &slot = s_moveText[index % kMoveTextSlots];
+    if (slot.plyPlusOne != index + 1 || slot.move.from != m.from || slot.move.to != m.to || slot.move.arrow != m.arrow)
+    {
+        Game_FormatMove(Game_GetHistoryMove(index), slot.text);
+        slot.plyPlusOne = index + 1;
+        slot.move = m;
+    }
+    return slot.text;
+}
 
 bool Game_IsAIBlack() { return s_aiIsBlack; }
 bool Game_IsOpponentAI() { return s_opponentIsAI; }
+int Game_GetAIDifficulty() { return s_aiDifficulty; }
 
-// Rewind to keepMoves (keepMoves >= 0). If keepMoves == 0, restore initial setup.
-void Game_RewindToMoveCount(int keepMoves)
+// Seek to the position after moveIndex moves of the current line. Restores the nearest checkpoint
+// at or before the target and replays the remaining moves; short hops are walked directly.
+void Game_SeekToMove(int moveIndex)
 {
-    if (keepMoves < 0) keepMoves = 0;
-    if (keepMoves > (int)s_history.size()) keepMoves = (int)s_history.size();
+    int total = (int)s_moveLog.size();
+    if (moveIndex < 0) moveIndex = 0;
+    if (moveIndex > total) moveIndex = total;
+    int current = s_currentMoveIndex;
+    if (moveIndex == current) return;
+
+    int base = (moveIndex / GAME_CHECKPOINT_INTERVAL) * GAME_CHECKPOINT_INTERVAL;
+    bool useCheckpoint = (moveIndex / GAME_CHECKPOINT_INTERVAL) < (int)s_checkpoints.size()
+        && (moveIndex - base) < abs(moveIndex - current);
 
-    // If target is less than current, undo moves
-    while ((int)s_appliedMoves.size() > keepMoves)
+    if (!useCheckpoint)
     {
-        MoveRecord m = s_appliedMoves.back();
-        // undo on board
-        UndoMoveRecordFromBoard(m);
-        // record in undone stack for potential redo
-        s_undoneMoves.push_back(m);
-        s_appliedMoves.pop_back();
-        s_currentMoveIndex = (int)s_appliedMoves.size();
-        // flip turn back
-        Game_ToggleTurn();
+        for (int i = current - 1; i >= moveIndex; --i) UndoLoggedMove(s_moveLog[(size_t)i]);
+        for (int i = current; i < moveIndex; ++i) ApplyLoggedMove(s_moveLog[(size_t)i]);
     }
-
-    // If target is greater than current, redo moves if available
-    while ((int)s_appliedMoves.size() < keepMoves && !s_undoneMoves.empty())
+    else
     {
-        MoveRecord m = s_undoneMoves.back();
-        s_undoneMoves.pop_back();
-        ApplyMoveRecordToBoard(m);
-        s_appliedMoves.push_back(m);
-        s_currentMoveIndex = (int)s_appliedMoves.size();
-        // flip turn after reapplying
-        Game_ToggleTurn();
+        RestoreSnapshot(s_checkpoints[moveIndex / GAME_CHECKPOINT_INTERVAL]);
+        SyncPosition(base % 2 == 0);
+        for (int i = base; i < moveIndex; ++i) ApplyLoggedMove(s_moveLog[(size_t)i]);
     }
 
+    s_currentMoveIndex = moveIndex;
+    // black always moves first, so side to move follows from the move count
+    s_blackToMove = (s_currentMoveIndex % 2) == 0;
+    NotifySeek();
+}
+
+// Rewind to keepMoves (keepMoves >= 0). If keepMoves == 0, restore initial setup.
+void Game_RewindToMoveCount(int keepMoves)
+{
+    if (keepMoves < 0) keepMoves = 0;
+    if (keepMoves > (int)s_moveLog.size()) keepMoves = (int)s_moveLog.size();
+
+    Game_SeekToMove(keepMoves);
+
     // notify UI
     if (s_historyCb) s_historyCb();
 }
 
 void Game_RewindOneStep()
 {
-    if (s_appliedMoves.empty()) return;
+    if (s_currentMoveIndex == 0) return;
     // undo last move
-    MoveRecord m = s_appliedMoves.back();
-    UndoMoveRecordFromBoard(m);
-    s_appliedMoves.pop_back();
-    s_undoneMoves.push_back(m);
-    s_currentMoveIndex = (int)s_appliedMoves.size();
+    --s_currentMoveIndex;
+    UndoLoggedMove(s_moveLog[(size_t)s_currentMoveIndex]);
     Game_ToggleTurn();
+    NotifySeek();
 
     if (s_historyCb) s_historyCb();
 }
@@ -352,18 +533,8 @@ int Game_CheckForWinner()
     }
 
     bool blackToMove = s_blackToMove;
-    // for each piece of the side to move, check if any legal move exists and any arrow exists after that
-    for (const auto &p : s_pieces)
-    {
-        // skip pieces that don't belong to the side to move
-        if (p.isWhite == blackToMove) continue;
-        auto moves = Game_GetLegalMoves(p.row, p.col);
-        for (auto &mv : moves)
-        {
-            auto arrows = Game_GetLegalArrows(p.row, p.col, mv.first, mv.second);
-            if (!arrows.empty()) return 0; // found at least one full move
-        }
-    }
+    // an amazon that reaches any square has a full move (it can shoot back where it came from)
+    if (!s_gameOver && Reach_HasAnyMove(s_reach, blackToMove)) return 0;
     // no moves for side to move => they lose
     s_gameOver = true;
     if (blackToMove) return 1; // white wins
@@ -376,30 +547,31 @@ void Game_SetHistoryChangedCallback(GameHistoryChangedCallback cb)
     s_historyCb = cb;
 }
 
+void Game_SetEventCallback(GameEventCallback cb)
+{
+    s_eventCb = cb;
+}
+
 int Game_GetCurrentMoveIndex() { return s_currentMoveIndex; }
-int Game_GetTotalMoves() { return (int)s_history.size(); }
-bool Game_CanStepForward() { return !s_undoneMoves.empty(); }
+int Game_GetTotalMoves() { return (int)s_moveLog.size(); }
+bool Game_CanStepForward() { return s_currentMoveIndex < (int)s_moveLog.size(); }
 
 void Game_StepForward()
 {
-    if (s_undoneMoves.empty()) return;
-    MoveRecord m = s_undoneMoves.back();
-    s_undoneMoves.pop_back();
-    ApplyMoveRecordToBoard(m);
-    s_appliedMoves.push_back(m);
-    s_currentMoveIndex = (int)s_appliedMoves.size();
+    if (!Game_CanStepForward()) return;
+    ApplyLoggedMove(s_moveLog[(size_t)s_currentMoveIndex]);
+    ++s_currentMoveIndex;
     Game_ToggleTurn();
+    NotifySeek();
     if (s_historyCb) s_historyCb();
 }
 
 void Game_StepBackward()
 {
-    if (s_appliedMoves.empty()) return;
-    MoveRecord m = s_appliedMoves.back();
-    UndoMoveRecordFromBoard(m);
-    s_appliedMoves.pop_back();
-    s_undoneMoves.push_back(m);
-    s_currentMoveIndex = (int)s_appliedMoves.size();
+    if (s_currentMoveIndex == 0) return;
+    --s_currentMoveIndex;
+    UndoLoggedMove(s_moveLog[(size_t)s_currentMoveIndex]);
     Game_ToggleTurn();
+    NotifySeek();
     if (s_historyCb) s_historyCb();
 }
@@ -5,9 +5,15 @@
 #include <string>
 
 struct GamePiece { int row; int col; bool isWhite; };
+struct Position;
+struct PositionSetup;
 
-// Initialize game state for a new game
-void Game_Init(int boardSize, bool opponentIsAI, int aiDifficulty, bool aiFirst);
+// a position snapshot is kept every this many moves to make history seeking cheap
+#define GAME_CHECKPOINT_INTERVAL 8
+
+// Initialize game state for a new game. Sizes with a standard setup (Position_HasStandardSetup) start
+// from it unless a valid custom setup is given; other sizes need one and otherwise fall back to 10x10.
+void Game_Init(int boardSize, bool opponentIsAI, int aiDifficulty, bool aiFirst, const PositionSetup* setup = nullptr);
 
 // Draw pieces; renderer provides a render target and brushes
 // excludeRow/excludeCol if set will skip drawing the piece at that location (used for UI overlays)
@@ -16,6 +22,11 @@ void Game_DrawPieces(ID2D1HwndRenderTarget* rt, ID2D1SolidColorBrush* whiteBrush
 // Query pieces
 const std::vector<GamePiece>& Game_GetPieces();
 int Game_GetBoardSize();
+// initial amazon squares of the current game (custom false for the standard setup)
+void Game_GetSetup(PositionSetup &out);
+
+// current board as a portable Position (pieces, arrows, side to move), e.g. for position index lookups
+void Game_GetPosition(Position &out);
 
 // occupancy
 bool Game_IsOccupied(int row, int col); // piece or arrow
@@ -30,24 +41,70 @@ std::vector<std::pair<int,int>> Game_GetLegalArrows(int fromRow, int fromCol, in
 // make a move (assumes validity): move piece from->to and place arrow at arrowRow/arrowCol
 void Game_MakeMove(int fromRow, int fromCol, int toRow, int toCol, int arrowRow, int arrowCol);
 
+// one move of a game record; line is the 1-based source line used for error reporting (0 if unknown)
+struct GameMoveInput { int fromRow, fromCol, toRow, toCol, arrowRow, arrowCol; int line; };
+
+// Validate and apply a sequence of moves in one pass, notifying the history callback once at the end.
+// Each move is checked against the legal move/arrow rules for the side to move; loading stops at the
+// first illegal move (moves before it stay applied) and its line is written to outBadLine.
+// Returns true if every move was applied.
+bool Game_LoadMoves(const GameMoveInput* moves, int count, int* outBadLine = nullptr);
+inline bool Game_LoadMoves(const std::vector<GameMoveInput>& moves, int* outBadLine = nullptr)
+{
+    return Game_LoadMoves(moves.data(), (int)moves.size(), outBadLine);
+}
+
 // turn state
 bool Game_IsBlackToMove();
 void Game_ToggleTurn();
 
-// history access
-const std::vector<std::wstring>& Game_GetHistory();
+// History access. The game line is one packed move log; moves past Game_GetCurrentMoveIndex() are
+// the ones redo replays. Moves are decoded on access, so a view is valid until the log changes.
+struct GameHistoryMove { int fromRow, fromCol, toRow, toCol, arrowRow, arrowCol; bool isWhite; };
+GameHistoryMove Game_GetHistoryMove(int index);     // 0 <= index < Game_GetTotalMoves()
+
+// for (GameHistoryMove m : Game_GetHistory()) ...
+struct GameHistoryView
+{
+    struct Iterator
+    {
+        int index;
+        GameHistoryMove operator*() const { return Game_GetHistoryMove(index); }
+        Iterator& operator++() { ++index; return *this; }
+        bool operator!=(const Iterator &o) const { return index != o.index; }
+    };
+    int count;
+    Iterator begin() const { return { 0 }; }
+    Iterator end() const { return { count }; }
+    int size() const { return count; }
+    GameHistoryMove operator[](int index) const { return Game_GetHistoryMove(index); }
+};
+GameHistoryView Game_GetHistory();
+
+// move notation, e.g. "[B] D10 D4 G7"
+#define GAME_MOVE_TEXT_MAX 16
+void Game_FormatMove(const GameHistoryMove &m, wchar_t (&out)[GAME_MOVE_TEXT_MAX]);
+// Notation of move 'index', formatted on first use and cached for the rows on screen. The text stays
+// valid until the notation of another move is requested; "" for indices outside the log.
+const wchar_t* Game_GetMoveText(int index);
 
 // which side AI controls (if any)
 bool Game_IsAIBlack();
 
 // whether opponent is AI
 bool Game_IsOpponentAI();
+// difficulty chosen in Game_Init (0 easy, 1 intermediate, 2 expert)
+int Game_GetAIDifficulty();
 
 // Check end condition: returns 0 if no winner yet, 1 if White wins, 2 if Black wins
 int Game_CheckForWinner();
 
 // Rewind functions: set state to after first N moves (N >= 0). If N == 0, restores initial setup.
 void Game_RewindToMoveCount(int keepMoves);
+// Seek to the position after moveIndex moves of the current line (clamped to 0 .. total moves).
+// Restores the nearest stored checkpoint and replays at most GAME_CHECKPOINT_INTERVAL-1 moves.
+// Does not notify the history callback; Game_RewindToMoveCount is the notifying wrapper.
+void Game_SeekToMove(int moveIndex);
 // Rewind a single move (if any)
 void Game_RewindOneStep();
 
@@ -55,6 +112,21 @@ void Game_RewindOneStep();
 typedef void (*GameHistoryChangedCallback)();
 void Game_SetHistoryChangedCallback(GameHistoryChangedCallback cb);
 
+// Fine-grained state changes for persistence (autosave journal): a new game, a move appended to the
+// line (discarding any redo moves), or a jump to another point of the line (undo/redo/rewind/seek).
+// Called synchronously from the game functions, so handlers must be cheap.
+enum GameEventType { GAME_EVENT_NEW_GAME = 0, GAME_EVENT_MOVE, GAME_EVENT_SEEK };
+struct GameEvent
+{
+    GameEventType type;
+    int boardSize; bool opponentIsAI; bool aiFirst; int aiDifficulty;    // NEW_GAME
+    const PositionSetup* setup;                                          // NEW_GAME, null if standard
+    int fromRow, fromCol, toRow, toCol, arrowRow, arrowCol;              // MOVE
+    int moveIndex;                                                       // all: moves applied afterwards
+};
+typedef void (*GameEventCallback)(const GameEvent &ev);
+void Game_SetEventCallback(GameEventCallback cb);
+
 // New: current move index and stepping forward/back
 int Game_GetCurrentMoveIndex(); // number of moves currently applied (0 .. history.size())
 int Game_GetTotalMoves();
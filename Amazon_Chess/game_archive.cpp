@@ -0,0 +1,270 @@
+#include "game_archive.h"
+#include "byte_io.h"
+#include <cstring>
+
+static const char kFileMagic[4] = { 'A', 'M', 'Z', 'B' };
+static const char kIndexMagic[4] = { 'A', 'M', 'Z', 'I' };
+static const uint16_t kVersion = 1;
+static const int kTrailerSize = 24;
+
+static int Seek64(FILE* f, uint64_t pos, int whence)
+{
+#ifdef _WIN32
+    return _fseeki64(f, (long long)pos, whence);
+#else
+    return fseeko(f, (off_t)pos, whence);
+#endif
+}
+
+static uint64_t Tell64(FILE* f)
+{
+#ifdef _WIN32
+    return (uint64_t)_ftelli64(f);
+#else
+    return (uint64_t)ftello(f);
+#endif
+}
+
+
+bool Archive_Create(ArchiveWriter &w, const std::string &path)
+{
+    w.file = ByteIO_OpenFile(path, "wb");
+    if (!w.file) return false;
+    w.index.clear();
+    uint8_t hdr[8] = {};
+    memcpy(hdr, kFileMagic, 4);
+    ByteIO_PutU16(hdr + 4, kVersion);
+    if (fwrite(hdr, 1, sizeof(hdr), w.file) != sizeof(hdr)) { fclose(w.file); w.file = nullptr; return false; }
+    w.offset = sizeof(hdr);
+    return true;
+}
+
+void Archive_EncodeGame(const ArchiveGame &game, std::string &out)
+{
+    uint8_t rec[8] = {};
+    rec[0] = (uint8_t)game.boardSize;
+    rec[1] = (uint8_t)((game.opponentIsAI ? 1 : 0) | (game.aiFirst ? 2 : 0) | (game.setup.custom ? 4 : 0));
+    ByteIO_PutU32(rec + 4, (uint32_t)game.moves.size());
+    out.append((const char*)rec, sizeof(rec));
+    if (game.setup.custom) out.append((const char*)game.setup.square, sizeof(game.setup.square));
+    static_assert(sizeof(ArchiveMove) == 3, "moves are stored as packed 3-byte records");
+    if (!game.moves.empty()) out.append((const char*)game.moves.data(), game.moves.size() * sizeof(ArchiveMove));
+}
+
+size_t Archive_DecodeGame(const uint8_t* data, size_t size, ArchiveGame &out)
+{
+    if (size < 8) return 0;
+    size_t setupSize = (data[1] & 4) ? sizeof(out.setup.square) : 0;
+    uint64_t n = ByteIO_GetU32(data + 4);
+    uint64_t total = 8 + setupSize + n * sizeof(ArchiveMove);
+    if (total > size) return 0;
+    out.boardSize = data[0];
+    out.opponentIsAI = (data[1] & 1) != 0;
+    out.aiFirst = (data[1] & 2) != 0;
+    out.setup = PositionSetup();
+    if (setupSize)
+    {
+        memcpy(out.setup.square, data + 8, setupSize);
+        out.setup.custom = true;
+    }
+    out.moves.resize((size_t)n);
+    if (n) memcpy(out.moves.data(), data + 8 + setupSize, (size_t)n * sizeof(ArchiveMove));
+    return (size_t)total;
+}
+
+bool Archive_AppendGame(ArchiveWriter &w, const ArchiveGame &game)
+{
+    if (!w.file) return false;
+    std::string rec;
+    Archive_EncodeGame(game, rec);
+    if (fwrite(rec.data(), 1, rec.size(), w.file) != rec.size()) return false;
+    w.index.push_back(w.offset);
+    w.offset += rec.size();
+    return true;
+}
+
+bool Archive_Finish(ArchiveWriter &w)
+{
+    if (!w.file) return false;
+    bool ok = true;
+    uint64_t indexOffset = w.offset;
+    std::vector<uint8_t> buf(w.index.size() * 8 + kTrailerSize);
+    for (size_t i = 0; i < w.index.size(); ++i) ByteIO_PutU64(&buf[i * 8], w.index[i]);
+    uint8_t* t = &buf[w.index.size() * 8];
+    ByteIO_PutU64(t, indexOffset);
+    ByteIO_PutU64(t + 8, (uint64_t)w.index.size());
+    memcpy(t + 16, kIndexMagic, 4);
+    if (fwrite(buf.data(), 1, buf.size(), w.file) != buf.size()) ok = false;
+    if (fclose(w.file) != 0) ok = false;
+    w.file = nullptr;
+    return ok;
+}
+
+bool Archive_Open(ArchiveReader &r, const std::string &path)
+{
+    r.file = ByteIO_OpenFile(path, "rb");
+    if (!r.file) return false;
+    uint8_t hdr[8];
+    uint8_t t[kTrailerSize];
+    uint64_t fileSize = 0;
+    bool ok = fread(hdr, 1, sizeof(hdr), r.file) == sizeof(hdr)
+        && memcmp(hdr, kFileMagic, 4) == 0 && ByteIO_GetU16(hdr + 4) == kVersion
+        && Seek64(r.file, 0, SEEK_END) == 0;
+    if (ok)
+    {
+        // trailer is the last kTrailerSize bytes
+        fileSize = Tell64(r.file);
+        ok = fileSize >= sizeof(hdr) + kTrailerSize
+            && Seek64(r.file, fileSize - kTrailerSize, SEEK_SET) == 0
+            && fread(t, 1, sizeof(t), r.file) == sizeof(t) && memcmp(t + 16, kIndexMagic, 4) == 0;
+    }
+    if (ok)
+    {
+        // the index must fill exactly the space between the records and the trailer
+        r.indexOffset = ByteIO_GetU64(t);
+        r.gameCount = ByteIO_GetU64(t + 8);
+        uint64_t indexSpace = fileSize - kTrailerSize;
+        ok = r.indexOffset >= sizeof(hdr) && r.indexOffset <= indexSpace
+            && r.gameCount == (indexSpace - r.indexOffset) / 8 && (indexSpace - r.indexOffset) % 8 == 0;
+    }
+    if (ok)
+    {
+        std::vector<uint8_t> raw((size_t)r.gameCount * 8);
+        ok = Seek64(r.file, r.indexOffset, SEEK_SET) == 0
+            && (raw.empty() || fread(raw.data(), 1, raw.size(), r.file) == raw.size());
+        r.index.resize((size_t)r.gameCount);
+        for (size_t i = 0; ok && i < r.index.size(); ++i)
+        {
+            r.index[i] = ByteIO_GetU64(&raw[i * 8]);
+            ok = r.index[i] >= sizeof(hdr) && r.index[i] < r.indexOffset;
+        }
+    }
+    if (!ok) Archive_Close(r);
+    return ok;
+}
+
+bool Archive_ReadGame(ArchiveReader &r, uint64_t gameIndex, ArchiveGame &out)
+{
+    if (!r.file || gameIndex >= r.gameCount) return false;
+    uint8_t rec[8];
+    uint64_t pos = r.index[(size_t)gameIndex];
+    if (Seek64(r.file, pos, SEEK_SET) != 0) return false;
+    if (fread(rec, 1, sizeof(rec), r.file) != sizeof(rec)) return false;
+    pos += sizeof(rec);
+    out.boardSize = rec[0];
+    out.opponentIsAI = (rec[1] & 1) != 0;
+    out.aiFirst = (rec[1] & 2) != 0;
+    out.setup = PositionSetup();
+    if (rec[1] & 4)
+    {
+        if (fread(out.setup.square, 1, sizeof(out.setup.square), r.file) != sizeof(out.setup.square)) return false;
+        out.setup.custom = true;
+        pos += sizeof(out.setup.square);
+    }
+    // a damaged count must not size the move list past the records
+    uint32_t n = ByteIO_GetU32(rec + 4);
+    if (pos > r.indexOffset || (uint64_t)n * sizeof(ArchiveMove) > r.indexOffset - pos) return false;
+    out.moves.resize(n);
+    return n == 0 || fread(out.moves.data(), sizeof(ArchiveMove), n, r.file) == n;
+}
+
+void Archive_Close(ArchiveReader &r)
+{
+    if (r.file) fclose(r.file);
+    r.file = nullptr;
+    r.gameCount = 0;
+    r.indexOffset = 0;
+    r.index.clear();
+}
+
+// ---- .pbn conversion ----
+
+void Archive_AppendSquare(std::string &s, int sq, int boardSize)
+{
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%c%d", 'A' + sq % boardSize, sq / boardSize + 1);
+    s += buf;
+}
+
+void Archive_GameToPbn(const ArchiveGame &game, std::string &out)
+{
+    out = "\xEF\xBB\xBF";
+    char hdr[96];
+    snprintf(hdr, sizeof(hdr), "BoardSize:%d\r\nOpponentAI:%d\r\nAIFirst:%d\r\n",
+        game.boardSize, game.opponentIsAI ? 1 : 0, game.aiFirst ? 1 : 0);
+    out += hdr;
+    for (int side = 0; game.setup.custom && side < 2; ++side)
+    {
+        out += side == 0 ? "WhiteAmazons:" : "BlackAmazons:";
+        for (int i = 0; i < POSITION_AMAZONS; ++i)
+        {
+            out += ' ';
+            Archive_AppendSquare(out, game.setup.square[side][i], game.boardSize);
+        }
+        out += "\r\n";
+    }
+    out += "\r\n";
+    for (size_t i = 0; i < game.moves.size(); ++i)
+    {
+        const ArchiveMove &m = game.moves[i];
+        out += (i % 2 == 0) ? "[B] " : "[W] ";
+        Archive_AppendSquare(out, m.from, game.boardSize); out += ' ';
+        Archive_AppendSquare(out, m.to, game.boardSize); out += ' ';
+        Archive_AppendSquare(out, m.arrow, game.boardSize); out += "\r\n";
+    }
+}
+
+struct PbnToArchiveState
+{
+    ArchiveGame* game;
+    int badLine;
+};
+
+static bool OnPbnGameBegin(void* user, const PbnGameInfo &info)
+{
+    PbnToArchiveState* st = (PbnToArchiveState*)user;
+    if (info.gameIndex > 0) return false; // only the first record
+    st->game->boardSize = info.boardSize;
+    st->game->opponentIsAI = info.opponentIsAI;
+    st->game->aiFirst = info.aiFirst;
+    st->game->setup = info.setup;
+    return true;
+}
+
+static bool OnPbnMove(void* user, const PbnMove &mv)
+{
+    PbnToArchiveState* st = (PbnToArchiveState*)user;
+    ArchiveMove m;
+    if (!Archive_MoveFromPbn(mv, st->game->boardSize, m))
+    {
+        st->badLine = mv.line;
+        return false;
+    }
+    st->game->moves.push_back(m);
+    return true;
+}
+
+bool Archive_MoveFromPbn(const PbnMove &mv, int boardSize, ArchiveMove &out)
+{
+    auto on = [&](int r, int c) { return r >= 0 && c >= 0 && r < boardSize && c < boardSize; };
+    if (!on(mv.fromRow, mv.fromCol) || !on(mv.toRow, mv.toCol) || !on(mv.arrowRow, mv.arrowCol)) return false;
+    out.from = (uint8_t)(mv.fromRow * boardSize + mv.fromCol);
+    out.to = (uint8_t)(mv.toRow * boardSize + mv.toCol);
+    out.arrow = (uint8_t)(mv.arrowRow * boardSize + mv.arrowCol);
+    return true;
+}
+
+bool Archive_GameFromPbn(const char* data, size_t size, ArchiveGame &out, int* outBadLine)
+{
+    out = ArchiveGame();
+    PbnToArchiveState st = { &out, 0 };
+    PbnCallbacks cb;
+    cb.user = &st;
+    cb.onGameBegin = OnPbnGameBegin;
+    cb.onMove = OnPbnMove;
+    int errLine = 0;
+    Pbn_Parse(data, size, cb, &errLine);
+    if (st.badLine == 0) st.badLine = errLine;
+    if (outBadLine) *outBadLine = st.badLine;
+    return st.badLine == 0;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+// Compact binary game archive (.amzb) stored alongside the text .pbn format.
+//
+// Layout (all integers little-endian):
+//   file header   "AMZB" magic, u16 version, u16 reserved
+//   game records  u8 boardSize, u8 flags (bit0 OpponentAI, bit1 AIFirst, bit2 custom setup), u16 reserved,
+//                 u32 moveCount; with bit2 the 4 white then 4 black starting squares (1 byte each);
+//                 then moveCount moves of 3 bytes each: from, to, arrow square (row * boardSize + col)
+//   index         u64 file offset of every game record, in game order
+//   trailer       u64 index offset, u64 game count, "AMZI" magic, u32 reserved
+//
+// The trailer sits at a fixed distance from the end of the file, so any game is located in O(1)
+// without scanning the records before it. Black always moves first, so the side of each move
+// follows from its position in the record and is not stored.
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "pbn_parser.h"
+
+struct ArchiveMove { uint8_t from, to, arrow; };
+
+struct ArchiveGame
+{
+    int boardSize = 8;
+    bool opponentIsAI = true;
+    bool aiFirst = false;
+    PositionSetup setup;
+    std::vector<ArchiveMove> moves;
+};
+
+struct ArchiveWriter
+{
+    FILE* file = nullptr;
+    uint64_t offset = 0;
+    std::vector<uint64_t> index;
+};
+
+struct ArchiveReader
+{
+    FILE* file = nullptr;
+    uint64_t gameCount = 0;
+    uint64_t indexOffset = 0;
+    std::vector<uint64_t> index;
+};
+
+// Writing: create, append any number of games, then finish (writes index and trailer, closes file).
+bool Archive_Create(ArchiveWriter &w, const std::string &path);
+bool Archive_AppendGame(ArchiveWriter &w, const ArchiveGame &game);
+bool Archive_Finish(ArchiveWriter &w);
+
+// One game record exactly as the archive stores it, for sending records elsewhere (e.g. over a
+// socket): encode appends to 'out'; decode reads a record from the front of 'data' and returns its
+// size, or 0 if 'data' does not hold a whole record yet.
+void Archive_EncodeGame(const ArchiveGame &game, std::string &out);
+size_t Archive_DecodeGame(const uint8_t* data, size_t size, ArchiveGame &out);
+
+// Reading: open loads only the trailer and index; each game is then read with one seek.
+bool Archive_Open(ArchiveReader &r, const std::string &path);
+bool Archive_ReadGame(ArchiveReader &r, uint64_t gameIndex, ArchiveGame &out);
+void Archive_Close(ArchiveReader &r);
+
+// Conversion to and from .pbn text. Archive_GameToPbn produces exactly what SaveHistoryToFile writes
+// (UTF-8 with BOM, CRLF line endings), so .pbn -> .amzb -> .pbn round-trips losslessly.
+// Archive_GameFromPbn returns false on a malformed move line; outBadLine receives its 1-based line.
+void Archive_GameToPbn(const ArchiveGame &game, std::string &outUtf8);
+// Only the first record of a multi-game input is read; use Pbn_Parse with Archive_MoveFromPbn for the rest.
+bool Archive_GameFromPbn(const char* data, size_t size, ArchiveGame &out, int* outBadLine = nullptr);
+// Appends square 'sq' of a boardSize board in .pbn notation ("A1" is row 0, column 0).
+void Archive_AppendSquare(std::string &s, int sq, int boardSize);
+// Pack a parsed move; false if a square is off a boardSize board.
+bool Archive_MoveFromPbn(const PbnMove &mv, int boardSize, ArchiveMove &out);
@@ -0,0 +1,361 @@
+#include "journal.h"
+#include "mapped_file.h"
+#include "trace.h"
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#endif
+
+static const char kMagic[4] = { 'A', 'M', 'Z', 'J' };
+static const int kVersion = 1;
+static const size_t kHeaderSize = 8;
+static const size_t kRecordSize = 8;
+// the file is rewritten to just the live line once it holds this many records and mostly dead ones
+static const size_t kCompactMinRecords = 512;
+
+struct JournalRecord { uint8_t bytes[kRecordSize]; };
+
+// ---- records ----
+
+static uint8_t Checksum(const uint8_t* r)
+{
+    uint8_t h = 0xA5;
+    for (size_t i = 0; i + 1 < kRecordSize; ++i) h = (uint8_t)((h << 1 | h >> 7) ^ r[i]);
+    return h;
+}
+
+static void SealRecord(JournalRecord &rec, uint64_t number)
+{
+    rec.bytes[6] = (uint8_t)number;
+    rec.bytes[7] = Checksum(rec.bytes);
+}
+
+static int NewGameFlags(bool opponentIsAI, bool aiFirst, int aiDifficulty)
+{
+    return (opponentIsAI ? 1 : 0) | (aiFirst ? 2 : 0) | ((aiDifficulty + 1) & 3) << 2;
+}
+
+static JournalRecord MakeRecord(char type, int a, int b, int c, int value)
+{
+    JournalRecord rec = {};
+    rec.bytes[0] = (uint8_t)type;
+    rec.bytes[1] = (uint8_t)a;
+    rec.bytes[2] = (uint8_t)b;
+    rec.bytes[3] = (uint8_t)c;
+    rec.bytes[4] = (uint8_t)(value & 0xFF);
+    rec.bytes[5] = (uint8_t)((value >> 8) & 0xFF);
+    return rec;
+}
+
+// false (and 'st' unchanged) if the record does not describe a valid step from 'st'
+static bool ApplyRecord(JournalState &st, bool &haveGame, const uint8_t* r)
+{
+    int value = r[4] | (r[5] << 8);
+    switch (r[0])
+    {
+    case 'N':
+        if (r[1] < POSITION_MIN_SIDE || r[1] > POSITION_MAX_SIDE) return false;
+        st = JournalState();
+        st.boardSize = r[1];
+        st.opponentIsAI = (r[2] & 1) != 0;
+        st.aiFirst = (r[2] & 2) != 0;
+        st.aiDifficulty = (r[2] >> 2 & 3) != 0 ? (r[2] >> 2 & 3) - 1 : 1;
+        haveGame = true;
+        return true;
+    case 'P':
+    {
+        if (!haveGame || r[1] > 1 || !st.line.empty()) return false;
+        uint8_t* sq = st.setup.square[r[1]];
+        sq[0] = r[2]; sq[1] = r[3]; sq[2] = r[4]; sq[3] = r[5];
+        // white's record comes first, so the setup is complete with black's
+        st.setup.custom = r[1] == 1 && Position_IsValidSetup(st.boardSize, st.setup);
+        return true;
+    }
+    case 'M':
+    {
+        int squares = st.boardSize * st.boardSize;
+        if (!haveGame || r[1] >= squares || r[2] >= squares || r[3] >= squares) return false;
+        if (value != st.current + 1) return false;
+        st.line.resize(st.current);
+        JournalMove m = { r[1], r[2], r[3] };
+        st.line.push_back(m);
+        st.current = value;
+        return true;
+    }
+    case 'S':
+        if (!haveGame || value > (int)st.line.size()) return false;
+        st.current = value;
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void SetupRecords(const PositionSetup &setup, std::vector<JournalRecord> &out)
+{
+    for (int side = 0; setup.custom && side < 2; ++side)
+    {
+        const uint8_t* sq = setup.square[side];
+        out.push_back(MakeRecord('P', side, sq[0], sq[1], sq[2] | sq[3] << 8));
+    }
+}
+
+static void StateToRecords(const JournalState &st, std::vector<JournalRecord> &out)
+{
+    out.clear();
+    out.push_back(MakeRecord('N', st.boardSize, NewGameFlags(st.opponentIsAI, st.aiFirst, st.aiDifficulty), 0, 0));
+    SetupRecords(st.setup, out);
+    for (size_t i = 0; i < st.line.size(); ++i)
+        out.push_back(MakeRecord('M', st.line[i].from, st.line[i].to, st.line[i].arrow, (int)i + 1));
+    if (st.current != (int)st.line.size()) out.push_back(MakeRecord('S', 0, 0, 0, st.current));
+}
+
+// ---- file access (durable writes) ----
+
+#ifdef _WIN32
+typedef HANDLE JournalHandle;
+static const JournalHandle kNoHandle = INVALID_HANDLE_VALUE;
+
+static JournalHandle OpenJournal(const JournalPath &path, bool truncate)
+{
+    HANDLE h = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+        truncate ? CREATE_ALWAYS : OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h != INVALID_HANDLE_VALUE && !truncate) SetFilePointer(h, 0, nullptr, FILE_END);
+    return h;
+}
+
+static bool WriteJournal(JournalHandle h, const void* data, size_t size)
+{
+    DWORD written = 0;
+    return WriteFile(h, data, (DWORD)size, &written, nullptr) && written == (DWORD)size;
+}
+
+static bool SyncJournal(JournalHandle h) { return FlushFileBuffers(h) != 0; }
+static void CloseJournal(JournalHandle h) { CloseHandle(h); }
+
+static bool ReplaceJournal(const JournalPath &from, const JournalPath &to)
+{
+    return MoveFileExW(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+}
+#else
+typedef int JournalHandle;
+static const JournalHandle kNoHandle = -1;
+
+static JournalHandle OpenJournal(const JournalPath &path, bool truncate)
+{
+    return open(path.c_str(), O_WRONLY | O_CREAT | (truncate ? O_TRUNC : O_APPEND), 0644);
+}
+
+static bool WriteJournal(JournalHandle h, const void* data, size_t size)
+{
+    const char* p = (const char*)data;
+    while (size > 0)
+    {
+        ssize_t n = write(h, p, size);
+        if (n <= 0) return false;
+        p += n; size -= (size_t)n;
+    }
+    return true;
+}
+
+static bool SyncJournal(JournalHandle h) { return fsync(h) == 0; }
+static void CloseJournal(JournalHandle h) { close(h); }
+static bool ReplaceJournal(const JournalPath &from, const JournalPath &to) { return rename(from.c_str(), to.c_str()) == 0; }
+#endif
+
+// Writes 'st' as a complete journal next to 'path' and atomically moves it into place, so a crash
+// during compaction leaves either the old or the new journal.
+static bool RewriteJournal(const JournalPath &path, const JournalState* st, uint64_t &outRecords)
+{
+    std::vector<JournalRecord> recs;
+    if (st) StateToRecords(*st, recs);
+    for (size_t i = 0; i < recs.size(); ++i) SealRecord(recs[i], i);
+
+    JournalPath tmp = path;
+#ifdef _WIN32
+    tmp += L".tmp";
+#else
+    tmp += ".tmp";
+#endif
+    JournalHandle h = OpenJournal(tmp, true);
+    if (h == kNoHandle) return false;
+    uint8_t header[kHeaderSize] = {};
+    memcpy(header, kMagic, 4);
+    header[4] = (uint8_t)kVersion;
+    bool ok = WriteJournal(h, header, kHeaderSize);
+    if (ok && !recs.empty()) ok = WriteJournal(h, recs.data(), recs.size() * kRecordSize);
+    if (ok) ok = SyncJournal(h);
+    CloseJournal(h);
+    if (!ok || !ReplaceJournal(tmp, path)) return false;
+    outRecords = recs.size();
+    return true;
+}
+
+// ---- recovery ----
+
+bool Journal_Recover(const JournalPath &path, JournalState &out)
+{
+    TRACE_ZONE("Journal_Recover");
+    MappedFile mf;
+    if (!MappedFile_Open(mf, path)) return false;
+    const uint8_t* p = (const uint8_t*)mf.data;
+    bool haveGame = false;
+    JournalState st;
+    if (mf.size >= kHeaderSize && memcmp(p, kMagic, 4) == 0 && p[4] == kVersion)
+    {
+        size_t count = (mf.size - kHeaderSize) / kRecordSize;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const uint8_t* r = p + kHeaderSize + i * kRecordSize;
+            // stop at the first torn or corrupt record; everything before it is intact
+            if (r[7] != Checksum(r) || r[6] != (uint8_t)i) break;
+            if (!ApplyRecord(st, haveGame, r)) break;
+        }
+    }
+    MappedFile_Close(mf);
+    if (!haveGame) return false;
+    out = st;
+    return true;
+}
+
+void Journal_RestoreGame(const JournalState &state)
+{
+    Game_Init(state.boardSize, state.opponentIsAI, state.aiDifficulty, state.aiFirst, &state.setup);
+    std::vector<GameMoveInput> moves(state.line.size());
+    int n = state.boardSize;
+    for (size_t i = 0; i < state.line.size(); ++i)
+    {
+        const JournalMove &m = state.line[i];
+        moves[i] = { m.from / n, m.from % n, m.to / n, m.to % n, m.arrow / n, m.arrow % n, 0 };
+    }
+    // the whole line is applied, then the undone tail is moved back onto the redo stack
+    Game_LoadMoves(moves);
+    Game_RewindToMoveCount(state.current);
+}
+
+// ---- writer thread ----
+
+static std::mutex s_mutex;
+static std::condition_variable s_wake;
+static std::vector<JournalRecord> s_queue;   // guarded by s_mutex
+static bool s_stopRequested = false;          // guarded by s_mutex
+static std::thread s_writer;
+static bool s_running = false;
+
+// owned by the writer thread while it runs
+static JournalPath s_path;
+static JournalHandle s_handle = kNoHandle;
+static JournalState s_model;                 // state described by the file
+static bool s_modelHasGame = false;
+static uint64_t s_recordCount = 0;           // records in the file
+
+static void WriterLoop()
+{
+    Trace_SetThreadName("journal");
+    std::vector<JournalRecord> batch;
+    for (;;)
+    {
+        bool stop;
+        {
+            std::unique_lock<std::mutex> lock(s_mutex);
+            s_wake.wait(lock, [] { return !s_queue.empty() || s_stopRequested; });
+            batch.swap(s_queue);
+            stop = s_stopRequested;
+        }
+        if (!batch.empty() && s_handle != kNoHandle)
+        {
+            TRACE_ZONE_ARG("journal write", batch.size());
+            for (auto &rec : batch)
+            {
+                SealRecord(rec, s_recordCount++);
+                ApplyRecord(s_model, s_modelHasGame, rec.bytes);
+            }
+            // one write and one flush per batch; on failure journaling stops rather than corrupting
+            if (!WriteJournal(s_handle, batch.data(), batch.size() * kRecordSize) || !SyncJournal(s_handle))
+            {
+                CloseJournal(s_handle);
+                s_handle = kNoHandle;
+            }
+            batch.clear();
+
+            size_t live = s_model.line.size() + 2;
+            if (s_handle != kNoHandle && s_recordCount >= kCompactMinRecords && s_recordCount > 4 * live)
+            {
+                TRACE_ZONE("journal compact");
+                CloseJournal(s_handle);
+                uint64_t records = 0;
+                if (RewriteJournal(s_path, s_modelHasGame ? &s_model : nullptr, records)) s_recordCount = records;
+                s_handle = OpenJournal(s_path, false);
+            }
+        }
+        if (stop) break;
+    }
+}
+
+bool Journal_Start(const JournalPath &path, const JournalState* initial)
+{
+    Journal_Stop();
+    s_path = path;
+    s_model = initial ? *initial : JournalState();
+    s_modelHasGame = initial != nullptr;
+    uint64_t records = 0;
+    if (!RewriteJournal(s_path, initial, records)) return false;
+    s_recordCount = records;
+    s_handle = OpenJournal(s_path, false);
+    if (s_handle == kNoHandle) return false;
+    s_stopRequested = false;
+    s_writer = std::thread(WriterLoop);
+    s_running = true;
+    return true;
+}
+
+void Journal_OnGameEvent(const GameEvent &ev)
+{
+    if (!s_running) return;
+    JournalRecord recs[3];
+    int count = 1;
+    int n = Game_GetBoardSize();
+    switch (ev.type)
+    {
+    case GAME_EVENT_NEW_GAME:
+    {
+        recs[0] = MakeRecord('N', ev.boardSize, NewGameFlags(ev.opponentIsAI, ev.aiFirst, ev.aiDifficulty), 0, 0);
+        std::vector<JournalRecord> setup;
+        if (ev.setup) SetupRecords(*ev.setup, setup);
+        for (const auto &rec : setup) recs[count++] = rec;
+        break;
+    }
+    case GAME_EVENT_MOVE:
+        recs[0] = MakeRecord('M', ev.fromRow * n + ev.fromCol, ev.toRow * n + ev.toCol, ev.arrowRow * n + ev.arrowCol, ev.moveIndex);
+        break;
+    default:
+        recs[0] = MakeRecord('S', 0, 0, 0, ev.moveIndex);
+        break;
+    }
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        s_queue.insert(s_queue.end(), recs, recs + count);
+    }
+    s_wake.notify_one();
+}
+
+void Journal_Stop()
+{
+    if (!s_running) return;
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        s_stopRequested = true;
+    }
+    s_wake.notify_one();
+    s_writer.join();
+    s_running = false;
+    if (s_handle != kNoHandle) CloseJournal(s_handle);
+    s_handle = kNoHandle;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+// Crash-safe autosave journal for the game in progress.
+//
+// Every GameEvent (new game, move, jump within the line) becomes one fixed-size record that is queued
+// on the calling thread and appended, flushed to disk and periodically compacted by a background
+// writer thread. A torn or corrupt tail (crash mid-write) is detected by the per-record checksum and
+// ignored, so recovery always yields the state as of the last complete record.
+//
+// File layout: "AMZJ", u16 version, u16 reserved, then 8-byte records
+//   u8 type ('N' new game, 'P' setup, 'M' move, 'S' seek), u8 a, u8 b, u8 c, u16 value (little-endian),
+//   u8 sequence (low byte of the record number), u8 checksum
+//   'N': a = board size, b = flags (bit0 OpponentAI, bit1 AIFirst, bits 2-3 AI difficulty + 1;
+//        0 there means intermediate, for journals written before the difficulty was stored)
+//   'P': custom setup, one record per side right after 'N': a = side (0 white), b/c = first two
+//        starting squares, value = third | fourth << 8
+//   'M': a/b/c = from/to/arrow square (row * boardSize + col); value = moves applied afterwards
+//   'S': value = moves applied afterwards (the rest of the line stays on the redo stack)
+
+#include "game.h"
+#include "position.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+typedef std::wstring JournalPath;
+#else
+typedef std::string JournalPath;
+#endif
+
+struct JournalMove { uint8_t from, to, arrow; };
+
+// Game line described by a journal: all moves of the line (applied ones followed by the redo stack
+// in replay order) and how many of them are applied.
+struct JournalState
+{
+    int boardSize = 8;
+    bool opponentIsAI = true;
+    bool aiFirst = false;
+    int aiDifficulty = 1;                  // 0 easy, 1 intermediate, 2 expert
+    PositionSetup setup;                   // custom once both 'P' records gave a valid setup
+    std::vector<JournalMove> line;
+    int current = 0;
+};
+
+// Reads the journal at 'path'; false if it is missing or holds no game.
+bool Journal_Recover(const JournalPath &path, JournalState &out);
+// Rebuilds the game (including the redo stack) from a recovered state via Game_Init/Game_LoadMoves.
+void Journal_RestoreGame(const JournalState &state);
+
+// Starts journaling to 'path': the file is rewritten to hold exactly 'initial' (nullptr: empty) and
+// the writer thread is started. Install Journal_OnGameEvent with Game_SetEventCallback afterwards.
+bool Journal_Start(const JournalPath &path, const JournalState* initial);
+// Event hook; only queues the record (no I/O on the calling thread).
+void Journal_OnGameEvent(const GameEvent &ev);
+// Writes everything queued, stops the writer thread and closes the file.
+void Journal_Stop();
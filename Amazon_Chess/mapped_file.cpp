@@ -0,0 +1,69 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#include <windows.h>
+
+static bool MapHandle(MappedFile &m, HANDLE h)
+{
+    if (h == INVALID_HANDLE_VALUE) return false;
+    m.fileHandle = h;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(h, &size)) { MappedFile_Close(m); return false; }
+    m.size = (size_t)size.QuadPart;
+    if (m.size == 0) return true;
+    m.mappingHandle = CreateFileMappingW(h, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m.mappingHandle) { MappedFile_Close(m); return false; }
+    m.data = (const char*)MapViewOfFile(m.mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if (!m.data) { MappedFile_Close(m); return false; }
+    return true;
+}
+
+bool MappedFile_Open(MappedFile &m, const std::wstring &path)
+{
+    MappedFile_Close(m);
+    return MapHandle(m, CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr));
+}
+
+bool MappedFile_Open(MappedFile &m, const std::string &path)
+{
+    MappedFile_Close(m);
+    return MapHandle(m, CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr));
+}
+
+void MappedFile_Close(MappedFile &m)
+{
+    if (m.data) UnmapViewOfFile(m.data);
+    if (m.mappingHandle) CloseHandle(m.mappingHandle);
+    if (m.fileHandle && m.fileHandle != INVALID_HANDLE_VALUE) CloseHandle(m.fileHandle);
+    m.data = nullptr; m.size = 0; m.mappingHandle = nullptr; m.fileHandle = nullptr;
+}
+
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool MappedFile_Open(MappedFile &m, const std::string &path)
+{
+    MappedFile_Close(m);
+    m.fd = open(path.c_str(), O_RDONLY);
+    if (m.fd < 0) return false;
+    struct stat st;
+    if (fstat(m.fd, &st) != 0) { MappedFile_Close(m); return false; }
+    m.size = (size_t)st.st_size;
+    if (m.size == 0) return true;
+    void* p = mmap(nullptr, m.size, PROT_READ, MAP_SHARED, m.fd, 0);
+    if (p == MAP_FAILED) { m.size = 0; MappedFile_Close(m); return false; }
+    m.data = (const char*)p;
+    madvise(p, m.size, MADV_SEQUENTIAL);
+    return true;
+}
+
+void MappedFile_Close(MappedFile &m)
+{
+    if (m.data) munmap((void*)m.data, m.size);
+    if (m.fd >= 0) close(m.fd);
+    m.data = nullptr; m.size = 0; m.fd = -1;
+}
+#endif
@@ -0,0 +1,25 @@
+#pragma once
+
+// Read-only memory-mapped view of a whole file (CreateFileMapping on Windows, mmap elsewhere).
+// An empty file opens successfully with data == nullptr and size == 0.
+
+#include <cstddef>
+#include <string>
+
+struct MappedFile
+{
+    const char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+bool MappedFile_Open(MappedFile &m, const std::string &path);
+#ifdef _WIN32
+bool MappedFile_Open(MappedFile &m, const std::wstring &path);
+#endif
+void MappedFile_Close(MappedFile &m);
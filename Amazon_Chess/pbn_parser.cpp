@@ -0,0 +1,211 @@
+#include "pbn_parser.h"
+#include <cstring>
+
+static inline bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+static bool KeyEquals(const char* key, size_t len, const char* name)
+{
+    size_t n = strlen(name);
+    if (len != n) return false;
+    for (size_t i = 0; i < n; ++i)
+    {
+        char c = key[i];
+        if (c >= 'a' && c <= 'z') c = (char)(c - 'a' + 'A');
+        char d = name[i];
+        if (d >= 'a' && d <= 'z') d = (char)(d - 'a' + 'A');
+        if (c != d) return false;
+    }
+    return true;
+}
+
+static int ParseInt(const char* p, const char* end)
+{
+    bool neg = false;
+    if (p < end && (*p == '-' || *p == '+')) neg = (*p++ == '-');
+    int v = 0;
+    while (p < end && *p >= '0' && *p <= '9') v = v * 10 + (*p++ - '0');
+    return neg ? -v : v;
+}
+
+// "C8" -> row 7, col 2
+static inline bool ParseSquare(const char* &p, const char* end, int &row, int &col)
+{
+    while (p < end && IsSpace(*p)) ++p;
+    if (p >= end || *p < 'A' || *p > 'Z') return false;
+    col = *p++ - 'A';
+    int rank = 0, digits = 0;
+    while (p < end && *p >= '0' && *p <= '9' && digits < 3) { rank = rank * 10 + (*p++ - '0'); ++digits; }
+    if (digits == 0 || rank < 1) return false;
+    row = rank - 1;
+    return true;
+}
+
+bool Pbn_ParseMove(const char* text, size_t len, PbnMove &out)
+{
+    const char* end = text + len;
+    const char* p = (const char*)memchr(text, ']', len);
+    if (!p) return false;
+    ++p;
+    return ParseSquare(p, end, out.fromRow, out.fromCol)
+        && ParseSquare(p, end, out.toRow, out.toCol)
+        && ParseSquare(p, end, out.arrowRow, out.arrowCol);
+}
+
+// amazon squares of the header; they become square indices once the board size is known
+struct HeaderSetup
+{
+    bool given[2] = { false, false };
+    int row[2][POSITION_AMAZONS], col[2][POSITION_AMAZONS];
+};
+
+static void ParseAmazons(HeaderSetup &hs, int side, const char* p, const char* end)
+{
+    hs.given[side] = false;
+    for (int i = 0; i < POSITION_AMAZONS; ++i)
+        if (!ParseSquare(p, end, hs.row[side][i], hs.col[side][i])) return;
+    hs.given[side] = true;
+}
+
+// at the end of the header: custom setup if complete and valid, otherwise the board needs a standard one
+static void ResolveSetup(PbnGameInfo &info, const HeaderSetup &hs)
+{
+    PositionSetup &setup = info.setup;
+    setup = PositionSetup();
+    if (hs.given[0] && hs.given[1])
+    {
+        bool onBoard = true;
+        for (int side = 0; side < 2; ++side)
+        {
+            for (int i = 0; i < POSITION_AMAZONS; ++i)
+            {
+                int r = hs.row[side][i], c = hs.col[side][i];
+                if (r >= info.boardSize || c >= info.boardSize) onBoard = false;
+                else setup.square[side][i] = (uint8_t)(r * info.boardSize + c);
+            }
+        }
+        setup.custom = onBoard && Position_IsValidSetup(info.boardSize, setup);
+    }
+    if (!setup.custom)
+    {
+        setup = PositionSetup();
+        if (!Position_HasStandardSetup(info.boardSize)) info.boardSize = 8;
+    }
+}
+
+static void ApplyKnownField(PbnGameInfo &info, HeaderSetup &hs, const char* key, size_t keyLen, const char* val, const char* valEnd)
+{
+    if (KeyEquals(key, keyLen, "BoardSize"))
+    {
+        int v = ParseInt(val, valEnd);
+        if (v >= POSITION_MIN_SIDE && v <= POSITION_MAX_SIDE) info.boardSize = v;
+    }
+    else if (KeyEquals(key, keyLen, "WhiteAmazons")) ParseAmazons(hs, 0, val, valEnd);
+    else if (KeyEquals(key, keyLen, "BlackAmazons")) ParseAmazons(hs, 1, val, valEnd);
+    else if (KeyEquals(key, keyLen, "OpponentAI")) info.opponentIsAI = ParseInt(val, valEnd) != 0;
+    else if (KeyEquals(key, keyLen, "AIFirst")) info.aiFirst = ParseInt(val, valEnd) != 0;
+}
+
+bool Pbn_Parse(const char* data, size_t size, const PbnCallbacks &cb, int* outErrorLine)
+{
+    if (outErrorLine) *outErrorLine = 0;
+    const char* p = data;
+    const char* end = data + size;
+
+    enum { STATE_HEADER, STATE_MOVES } state = STATE_HEADER;
+    PbnGameInfo info;
+    HeaderSetup headerSetup;
+    int moveCount = 0;
+    bool gameOpen = false;   // onGameBegin delivered for the current game
+    bool anyContent = false; // current game has seen at least one non-blank line
+
+    auto beginGame = [&]() -> bool
+    {
+        gameOpen = true;
+        moveCount = 0;
+        ResolveSetup(info, headerSetup);
+        return !cb.onGameBegin || cb.onGameBegin(cb.user, info);
+    };
+    auto endGame = [&]()
+    {
+        if (gameOpen && cb.onGameEnd) cb.onGameEnd(cb.user, info, moveCount);
+        gameOpen = false;
+    };
+
+    for (int line = 1; p < end; ++line)
+    {
+        const char* eol = (const char*)memchr(p, '\n', (size_t)(end - p));
+        const char* lb = p;
+        const char* le = eol ? eol : end;
+        p = eol ? eol + 1 : end;
+
+        // a BOM starts a new concatenated record
+        bool bom = (le - lb >= 3 && (unsigned char)lb[0] == 0xEF && (unsigned char)lb[1] == 0xBB && (unsigned char)lb[2] == 0xBF);
+        if (bom) lb += 3;
+        while (lb < le && IsSpace(*lb)) ++lb;
+        while (le > lb && IsSpace(le[-1])) --le;
+
+        if (lb == le)
+        {
+            // blank line ends the header block
+            if (state == STATE_HEADER && anyContent)
+            {
+                state = STATE_MOVES;
+                if (!beginGame()) return false;
+            }
+            continue;
+        }
+
+        bool isMove = (*lb == '[');
+        if (!isMove && (state == STATE_MOVES || bom))
+        {
+            // header line after moves: next game in a concatenated file
+            if (state == STATE_MOVES || anyContent)
+            {
+                if (!gameOpen && !beginGame()) return false;
+                endGame();
+                int next = info.gameIndex + 1;
+                info = PbnGameInfo();
+                info.gameIndex = next;
+                headerSetup = HeaderSetup();
+            }
+            state = STATE_HEADER;
+            anyContent = false;
+        }
+        if (!anyContent) info.firstLine = line;
+        anyContent = true;
+
+        if (!isMove)
+        {
+            const char* colon = (const char*)memchr(lb, ':', (size_t)(le - lb));
+            if (!colon) continue; // tolerated like the old loader
+            const char* ke = colon;
+            while (ke > lb && IsSpace(ke[-1])) --ke;
+            const char* vb = colon + 1;
+            while (vb < le && IsSpace(*vb)) ++vb;
+            ApplyKnownField(info, headerSetup, lb, (size_t)(ke - lb), vb, le);
+            if (cb.onHeaderField && !cb.onHeaderField(cb.user, lb, (size_t)(ke - lb), vb, (size_t)(le - vb))) return false;
+            continue;
+        }
+
+        // move line; a record without header/blank separator starts its moves right away
+        if (state == STATE_HEADER)
+        {
+            state = STATE_MOVES;
+            if (!beginGame()) return false;
+        }
+        PbnMove mv;
+        if (!Pbn_ParseMove(lb, (size_t)(le - lb), mv))
+        {
+            if (outErrorLine) *outErrorLine = line;
+            return false;
+        }
+        mv.line = line;
+        ++moveCount;
+        if (cb.onMove && !cb.onMove(cb.user, mv)) return false;
+    }
+
+    // a trailing record with header only (no blank line / moves) is still a game
+    if (!gameOpen && anyContent && !beginGame()) return false;
+    endGame();
+    return true;
+}
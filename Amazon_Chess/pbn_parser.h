@@ -0,0 +1,53 @@
+#pragma once
+
+// Streaming parser for .pbn game records working directly on UTF-8 bytes (e.g. a MappedFile view).
+//
+// A record is an optional BOM, "Key:value" header lines, a blank line, then one move per line
+// in the form "[W] C8 G4 E2". Several records may be concatenated in one file: a header line
+// (or a BOM) after the moves of a game starts the next game. Nothing is allocated per line;
+// header keys/values are handed out as pointers into the input buffer.
+//
+// Boards without a standard setup (see Position_HasStandardSetup) need both "WhiteAmazons:" and
+// "BlackAmazons:" headers listing the four starting squares of each side, e.g. "WhiteAmazons: D10 G10 A7 J7";
+// on any board they replace the standard setup.
+
+#include "position.h"
+#include <cstddef>
+
+// known header fields of a game with the same defaults LoadGameFromFile has always used
+struct PbnGameInfo
+{
+    int boardSize = 8;          // only sizes the game supports are accepted; others keep the default
+    PositionSetup setup;        // custom when both amazon headers give valid squares for boardSize
+    bool opponentIsAI = true;
+    bool aiFirst = false;
+    int gameIndex = 0;          // 0-based position of the game in the input
+    int firstLine = 1;          // 1-based line where the game's record starts
+};
+
+// decoded move; squares are 0-based (row = rank - 1, col = file letter - 'A')
+struct PbnMove
+{
+    int fromRow, fromCol, toRow, toCol, arrowRow, arrowCol;
+    int line;                   // 1-based source line
+};
+
+// Callbacks return false to stop parsing early. Any of them may be null.
+struct PbnCallbacks
+{
+    void* user = nullptr;
+    // raw header field (key and value trimmed, not NUL-terminated)
+    bool (*onHeaderField)(void* user, const char* key, size_t keyLen, const char* value, size_t valueLen) = nullptr;
+    // header of a game is complete; moves of that game follow
+    bool (*onGameBegin)(void* user, const PbnGameInfo &info) = nullptr;
+    bool (*onMove)(void* user, const PbnMove &move) = nullptr;
+    // all moves of the game parsed (not called for a game cut short by an error or a callback)
+    void (*onGameEnd)(void* user, const PbnGameInfo &info, int moveCount) = nullptr;
+};
+
+// Parse size bytes at data. Returns false on the first malformed move line (its line number goes to
+// outErrorLine) or when a callback stops the parse (outErrorLine is 0 then).
+bool Pbn_Parse(const char* data, size_t size, const PbnCallbacks &cb, int* outErrorLine = nullptr);
+
+// Decode a single move entry such as "[B] A3 D3 E4" (len bytes, no line terminator).
+bool Pbn_ParseMove(const char* text, size_t len, PbnMove &out);
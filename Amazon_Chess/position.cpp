@@ -0,0 +1,315 @@
+#include "position.h"
+#include "board_geometry.h"
+#include <cstring>
+
+// ---- Zobrist keys ----
+
+// keys of the squares and sizes of boards up to 10x10 come first in the sequence, exactly as before
+// larger boards were supported, so existing position index files keep their keys
+static const int kLegacySide = 10;
+
+struct ZobristTables
+{
+    uint64_t cell[POSITION_MAX_SQUARES][4];   // index by CELL_* (CELL_EMPTY unused)
+    uint64_t blackToMove;
+    uint64_t size[POSITION_MAX_SIDE + 1];
+
+    ZobristTables()
+    {
+        uint64_t seed = 0x9E3779B97F4A7C15ull;
+        auto next = [&seed]()
+        {
+            // splitmix64: fixed sequence so keys are stable across runs and builds
+            uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        };
+        for (int sq = 0; sq < kLegacySide * kLegacySide; ++sq) for (auto &k : cell[sq]) k = next();
+        blackToMove = next();
+        for (int n = 0; n <= kLegacySide; ++n) size[n] = next();
+        for (int sq = kLegacySide * kLegacySide; sq < POSITION_MAX_SQUARES; ++sq) for (auto &k : cell[sq]) k = next();
+        for (int n = kLegacySide + 1; n <= POSITION_MAX_SIDE; ++n) size[n] = next();
+    }
+};
+
+static const ZobristTables &Zobrist()
+{
+    static const ZobristTables tables;
+    return tables;
+}
+
+// setup path: hashes through the symmetry maps of the size's kernels
+static void ToggleCell(Position &pos, int sq, int type)
+{
+    const ZobristTables &z = Zobrist();
+    const uint8_t* sym = Position_GetKernels(pos.size).sym;
+    int squares = pos.size * pos.size;
+    for (int s = 0; s < POSITION_SYMMETRIES; ++s) pos.symHash[s] ^= z.cell[sym[s * squares + sq]][type];
+}
+
+static inline void ToggleSide(Position &pos)
+{
+    uint64_t k = Zobrist().blackToMove;
+    for (int s = 0; s < POSITION_SYMMETRIES; ++s) pos.symHash[s] ^= k;
+}
+
+// ---- kernels for one board size ----
+
+template <int N>
+struct Kernel
+{
+    // the 8 symmetry keys of every square/cell type side by side, so a toggle is one linear pass
+    struct SymKeys { uint64_t key[N * N][4][POSITION_SYMMETRIES]; };
+
+    static const SymKeys &Keys()
+    {
+        static const SymKeys keys = BuildKeys();
+        return keys;
+    }
+
+    static SymKeys BuildKeys()
+    {
+        SymKeys k;
+        const ZobristTables &z = Zobrist();
+        for (int sq = 0; sq < N * N; ++sq)
+            for (int t = 0; t < 4; ++t)
+                for (int s = 0; s < POSITION_SYMMETRIES; ++s)
+                    k.key[sq][t][s] = z.cell[Symmetry<N>::value.sym[s][sq]][t];
+        return k;
+    }
+
+    static inline void Toggle(Position &pos, int sq, int type)
+    {
+        const uint64_t* k = Keys().key[sq][type];
+        for (int s = 0; s < POSITION_SYMMETRIES; ++s) pos.symHash[s] ^= k[s];
+    }
+
+    static void MakeMove(Position &pos, const PosMove &m)
+    {
+        int side = pos.blackToMove ? 1 : 0;
+        uint8_t piece = pos.cell[m.from];
+        for (auto &a : pos.amazon[side]) if (a == m.from) { a = m.to; break; }
+        Toggle(pos, m.from, piece);
+        pos.cell[m.from] = CELL_EMPTY;
+        pos.cell[m.to] = piece;
+        Toggle(pos, m.to, piece);
+        pos.cell[m.arrow] = CELL_ARROW;
+        Toggle(pos, m.arrow, CELL_ARROW);
+        pos.blackToMove = !pos.blackToMove;
+        ToggleSide(pos);
+    }
+
+    static void UnmakeMove(Position &pos, const PosMove &m)
+    {
+        pos.blackToMove = !pos.blackToMove;
+        ToggleSide(pos);
+        int side = pos.blackToMove ? 1 : 0;
+        uint8_t piece = pos.cell[m.to];
+        Toggle(pos, m.arrow, CELL_ARROW);
+        pos.cell[m.arrow] = CELL_EMPTY;
+        Toggle(pos, m.to, piece);
+        pos.cell[m.to] = CELL_EMPTY;
+        pos.cell[m.from] = piece;
+        Toggle(pos, m.from, piece);
+        for (auto &a : pos.amazon[side]) if (a == m.to) { a = m.from; break; }
+    }
+
+    static bool HasAnyMove(const Position &pos)
+    {
+        const BoardGeometry<N> &g = Geometry<N>::value;
+        int side = pos.blackToMove ? 1 : 0;
+        for (int i = 0; i < POSITION_AMAZONS; ++i)
+        {
+            // an amazon that can step anywhere can always shoot back at the square it left
+            int from = pos.amazon[side][i];
+            for (int d = 0; d < GEOMETRY_DIRS; ++d)
+                if (g.rayLen[from][d] && pos.cell[g.ray[from][d][0]] == CELL_EMPTY) return true;
+        }
+        return false;
+    }
+
+    // ray walks beat set-wise bitboard generation at every size: a bitboard needs a full queen fill
+    // per destination, the ray walk only touches the squares it emits
+    static void GenerateMoves(const Position &pos, std::vector<PosMove> &out)
+    {
+        const BoardGeometry<N> &g = Geometry<N>::value;
+        out.clear();
+        int side = pos.blackToMove ? 1 : 0;
+        uint8_t cell[N * N];
+        memcpy(cell, pos.cell, sizeof(cell));
+        for (int i = 0; i < POSITION_AMAZONS; ++i)
+        {
+            // with the moving amazon lifted off the board, its own square is a valid arrow target
+            // and no ray from 'to' can pass over 'to' itself, so both walks read the same cells
+            int from = pos.amazon[side][i];
+            uint8_t piece = cell[from];
+            cell[from] = CELL_EMPTY;
+            for (int d = 0; d < GEOMETRY_DIRS; ++d)
+            {
+                const uint8_t* ray = g.ray[from][d];
+                for (int k = 0, len = g.rayLen[from][d]; k < len && cell[ray[k]] == CELL_EMPTY; ++k)
+                {
+                    int to = ray[k];
+                    for (int e = 0; e < GEOMETRY_DIRS; ++e)
+                    {
+                        const uint8_t* shot = g.ray[to][e];
+                        for (int j = 0, shotLen = g.rayLen[to][e]; j < shotLen && cell[shot[j]] == CELL_EMPTY; ++j)
+                        {
+                            PosMove m = { (uint8_t)from, (uint8_t)to, shot[j] };
+                            out.push_back(m);
+                        }
+                    }
+                }
+            }
+            cell[from] = piece;
+        }
+    }
+};
+
+#define POSITION_KERNELS(n) { n, Kernel<n>::MakeMove, Kernel<n>::UnmakeMove, Kernel<n>::HasAnyMove, \
+    Kernel<n>::GenerateMoves, Symmetry<n>::value.sym[0] }
+
+static const PositionKernels kKernels[POSITION_MAX_SIDE - POSITION_MIN_SIDE + 1] = {
+    POSITION_KERNELS(4), POSITION_KERNELS(5), POSITION_KERNELS(6), POSITION_KERNELS(7),
+    POSITION_KERNELS(8), POSITION_KERNELS(9), POSITION_KERNELS(10), POSITION_KERNELS(11),
+    POSITION_KERNELS(12), POSITION_KERNELS(13), POSITION_KERNELS(14), POSITION_KERNELS(15),
+    POSITION_KERNELS(16) };
+
+const PositionKernels& Position_GetKernels(int size)
+{
+    if (size < POSITION_MIN_SIDE || size > POSITION_MAX_SIDE) size = 8;
+    return kKernels[size - POSITION_MIN_SIDE];
+}
+
+// ---- setup ----
+
+bool Position_HasStandardSetup(int size)
+{
+    return size >= 6 && size <= POSITION_MAX_SIDE && size % 2 == 0;
+}
+
+static void StandardSetup(int n, PositionSetup &setup)
+{
+    const int cols[POSITION_AMAZONS] = { n / 2 - 2, n / 2 + 1, 0, n - 1 };
+    const int rows[POSITION_AMAZONS] = { 0, 0, (n - 2) / 2 - 1, (n - 2) / 2 - 1 };
+    for (int i = 0; i < POSITION_AMAZONS; ++i)
+    {
+        setup.square[1][i] = (uint8_t)(rows[i] * n + cols[i]);
+        setup.square[0][i] = (uint8_t)((n - 1 - rows[i]) * n + cols[i]);
+    }
+}
+
+bool Position_IsValidSetup(int size, const PositionSetup &setup)
+{
+    if (size < POSITION_MIN_SIDE || size > POSITION_MAX_SIDE) return false;
+    const uint8_t* sq = &setup.square[0][0];
+    for (int i = 0; i < 2 * POSITION_AMAZONS; ++i)
+    {
+        if (sq[i] >= size * size) return false;
+        for (int j = 0; j < i; ++j) if (sq[j] == sq[i]) return false;
+    }
+    return true;
+}
+
+void Position_InitSetup(Position &pos, int size, const PositionSetup &setup)
+{
+    PositionSetup used = setup;
+    if (!setup.custom || !Position_IsValidSetup(size, setup))
+    {
+        if (!Position_HasStandardSetup(size)) size = 8;
+        StandardSetup(size, used);
+    }
+    pos.size = size;
+    pos.blackToMove = true;
+    memset(pos.cell, CELL_EMPTY, sizeof(pos.cell));
+    for (int s = 0; s < POSITION_SYMMETRIES; ++s) pos.symHash[s] = Zobrist().size[pos.size];
+    ToggleSide(pos);
+    for (int side = 0; side < 2; ++side)
+    {
+        for (int i = 0; i < POSITION_AMAZONS; ++i)
+        {
+            int sq = used.square[side][i];
+            pos.amazon[side][i] = (uint8_t)sq;
+            pos.cell[sq] = side == 0 ? CELL_WHITE : CELL_BLACK;
+            ToggleCell(pos, sq, pos.cell[sq]);
+        }
+    }
+}
+
+void Position_Init(Position &pos, int size)
+{
+    Position_InitSetup(pos, size, PositionSetup());
+}
+
+void Position_SetFromCells(Position &pos, int size, const uint8_t* cells, bool blackToMove)
+{
+    pos.size = (size >= POSITION_MIN_SIDE && size <= POSITION_MAX_SIDE) ? size : 8;
+    pos.blackToMove = blackToMove;
+    memset(pos.cell, CELL_EMPTY, sizeof(pos.cell));
+    memset(pos.amazon, 0, sizeof(pos.amazon));
+    for (int s = 0; s < POSITION_SYMMETRIES; ++s) pos.symHash[s] = Zobrist().size[pos.size];
+    if (blackToMove) ToggleSide(pos);
+
+    int count[2] = { 0, 0 };
+    for (int sq = 0; sq < pos.size * pos.size; ++sq)
+    {
+        uint8_t c = cells[sq];
+        if (c == CELL_EMPTY || c > CELL_ARROW) continue;
+        if (c != CELL_ARROW)
+        {
+            int side = (c == CELL_WHITE) ? 0 : 1;
+            if (count[side] == POSITION_AMAZONS) continue;
+            pos.amazon[side][count[side]++] = (uint8_t)sq;
+        }
+        pos.cell[sq] = c;
+        ToggleCell(pos, sq, c);
+    }
+}
+
+// ---- rules ----
+
+// true if 'to' is a queen move from 'from' over empty squares; 'ignore' counts as empty
+static bool QueenReachable(const Position &pos, int from, int to, int ignore)
+{
+    int n = pos.size;
+    int fr = from / n, fc = from % n, tr = to / n, tc = to % n;
+    int dr = tr - fr, dc = tc - fc;
+    if (dr == 0 && dc == 0) return false;
+    if (dr != 0 && dc != 0 && dr != dc && dr != -dc) return false;
+    int sr = (dr > 0) - (dr < 0), sc = (dc > 0) - (dc < 0);
+    int step = sr * n + sc;
+    for (int sq = from + step; ; sq += step)
+    {
+        if (sq != ignore && pos.cell[sq] != CELL_EMPTY) return false;
+        if (sq == to) return true;
+    }
+}
+
+bool Position_IsLegalMove(const Position &pos, const PosMove &m)
+{
+    int squares = pos.size * pos.size;
+    if (m.from >= squares || m.to >= squares || m.arrow >= squares) return false;
+    if (pos.cell[m.from] != (pos.blackToMove ? CELL_BLACK : CELL_WHITE)) return false;
+    return QueenReachable(pos, m.from, m.to, -1) && QueenReachable(pos, m.to, m.arrow, m.from);
+}
+
+void Position_MakeMove(Position &pos, const PosMove &m)
+{
+    Position_GetKernels(pos.size).makeMove(pos, m);
+}
+
+void Position_UnmakeMove(Position &pos, const PosMove &m)
+{
+    Position_GetKernels(pos.size).unmakeMove(pos, m);
+}
+
+bool Position_HasAnyMove(const Position &pos)
+{
+    return Position_GetKernels(pos.size).hasAnyMove(pos);
+}
+
+void Position_GenerateMoves(const Position &pos, std::vector<PosMove> &out)
+{
+    Position_GetKernels(pos.size).generateMoves(pos, out);
+}
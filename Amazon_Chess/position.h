@@ -0,0 +1,81 @@
+#pragma once
+
+// Portable Amazons position used by the headless tools (replay, indexing) independently of the
+// GUI game state in game.cpp. Squares are indexed row * size + col with the same row/col meaning
+// as GamePiece; the standard setups match the ones game.cpp creates. Boards up to 16x16 are
+// supported, so a square always fits in a byte.
+
+#include <cstdint>
+#include <vector>
+
+#define POSITION_MIN_SIDE 4
+#define POSITION_MAX_SIDE 16
+#define POSITION_MAX_SQUARES (POSITION_MAX_SIDE * POSITION_MAX_SIDE)
+#define POSITION_AMAZONS 4   // per side
+#define POSITION_SYMMETRIES 8
+
+enum { CELL_EMPTY = 0, CELL_WHITE = 1, CELL_BLACK = 2, CELL_ARROW = 3 };
+
+struct PosMove { uint8_t from, to, arrow; };
+
+// initial amazon squares; 'custom' false means the standard setup of the board size
+struct PositionSetup
+{
+    bool custom = false;
+    uint8_t square[2][POSITION_AMAZONS] = {};         // [0] white, [1] black
+};
+
+struct Position
+{
+    int size = 0;
+    bool blackToMove = true;                          // black always moves first
+    uint8_t cell[POSITION_MAX_SQUARES];
+    uint8_t amazon[2][POSITION_AMAZONS];              // [0] white, [1] black squares
+    // Zobrist hash of the position under each of the 8 board symmetries, kept up to date
+    // incrementally so the symmetry-canonical key is just the minimum
+    uint64_t symHash[POSITION_SYMMETRIES];
+};
+
+// The standard setup of an even size from 6 to 16: black's amazons on rank 1 (files size/2-1 and
+// size/2+2) and on both edge files of rank (size-2)/2, white's mirrored at the top; for 8x8 and
+// 10x10 this is the usual setup.
+bool Position_HasStandardSetup(int size);
+// standard setup (sizes without one fall back to 8 like Game_Init)
+void Position_Init(Position &pos, int size);
+// standard setup, or setup.custom's squares if they are valid for the size
+void Position_InitSetup(Position &pos, int size, const PositionSetup &setup);
+// custom squares lie on a size x size board (within POSITION_MIN/MAX_SIDE) and are all different
+bool Position_IsValidSetup(int size, const PositionSetup &setup);
+
+// rebuilds amazon lists and hashes from a cell array (CELL_* values, size*size entries); sizes
+// outside POSITION_MIN_SIDE..POSITION_MAX_SIDE fall back to 8
+void Position_SetFromCells(Position &pos, int size, const uint8_t* cells, bool blackToMove);
+
+// rules
+bool Position_IsLegalMove(const Position &pos, const PosMove &m);
+void Position_MakeMove(Position &pos, const PosMove &m);    // assumes legality
+void Position_UnmakeMove(Position &pos, const PosMove &m);  // reverses the last Position_MakeMove(m)
+bool Position_HasAnyMove(const Position &pos);              // side to move can make a full move
+void Position_GenerateMoves(const Position &pos, std::vector<PosMove> &out);
+
+// The rules above compiled separately for every board size, with the board geometry as compile-time
+// tables (board_geometry.h). Hot loops fetch the table once per game or search and call through it;
+// the Position_* functions look it up from pos.size on every call.
+struct PositionKernels
+{
+    int size;
+    void (*makeMove)(Position &pos, const PosMove &m);
+    void (*unmakeMove)(Position &pos, const PosMove &m);
+    bool (*hasAnyMove)(const Position &pos);
+    void (*generateMoves)(const Position &pos, std::vector<PosMove> &out);
+    const uint8_t* sym;     // [POSITION_SYMMETRIES][size * size] square maps of the board symmetries
+};
+const PositionKernels& Position_GetKernels(int size); // unsupported sizes get the 8x8 kernels
+
+// Zobrist key independent of the 8 board symmetries (rotations and reflections); includes side to move
+inline uint64_t Position_CanonicalKey(const Position &pos)
+{
+    uint64_t k = pos.symHash[0];
+    for (int i = 1; i < POSITION_SYMMETRIES; ++i) if (pos.symHash[i] < k) k = pos.symHash[i];
+    return k;
+}
@@ -0,0 +1,110 @@
+#include "position_index.h"
+#include "byte_io.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+static const char kMagic[4] = { 'A', 'M', 'Z', 'X' };
+static const size_t kHeaderSize = 32;
+
+static_assert(sizeof(PositionIndexEntry) == 16, "index records are stored as raw 16-byte structs");
+
+
+static bool EntryLess(const PositionIndexEntry &a, const PositionIndexEntry &b)
+{
+    if (a.key != b.key) return a.key < b.key;
+    if (a.game != b.game) return a.game < b.game;
+    return a.ply < b.ply;
+}
+
+bool PositionIndex_Write(const std::string &path, std::vector<PositionIndexEntry> &entries, uint64_t gameCount)
+{
+    std::sort(entries.begin(), entries.end(), EntryLess);
+
+    FILE* f = ByteIO_OpenFile(path, "wb");
+    if (!f) return false;
+
+    unsigned char header[kHeaderSize] = {};
+    memcpy(header, kMagic, 4);
+    ByteIO_PutU32(header + 4, POSITION_INDEX_VERSION);
+    ByteIO_PutU64(header + 8, entries.size());
+    ByteIO_PutU64(header + 16, gameCount);
+    bool ok = fwrite(header, 1, kHeaderSize, f) == kHeaderSize;
+    // records are written as-is; the index is only read back on little-endian hosts
+    if (ok && !entries.empty())
+        ok = fwrite(entries.data(), sizeof(PositionIndexEntry), entries.size(), f) == entries.size();
+    if (fclose(f) != 0) ok = false;
+    return ok;
+}
+
+static bool AttachMapping(PositionIndex &idx)
+{
+    const unsigned char* p = (const unsigned char*)idx.file.data;
+    if (idx.file.size < kHeaderSize || memcmp(p, kMagic, 4) != 0 || ByteIO_GetU32(p + 4) != POSITION_INDEX_VERSION)
+        return false;
+    uint64_t count = ByteIO_GetU64(p + 8);
+    if (count > (idx.file.size - kHeaderSize) / sizeof(PositionIndexEntry)) return false;
+    idx.entryCount = count;
+    idx.gameCount = ByteIO_GetU64(p + 16);
+    idx.entries = reinterpret_cast<const PositionIndexEntry*>(p + kHeaderSize);
+    return true;
+}
+
+bool PositionIndex_Open(PositionIndex &idx, const std::string &path)
+{
+    PositionIndex_Close(idx);
+    if (!MappedFile_Open(idx.file, path)) return false;
+    if (AttachMapping(idx)) return true;
+    PositionIndex_Close(idx);
+    return false;
+}
+
+#ifdef _WIN32
+bool PositionIndex_Open(PositionIndex &idx, const std::wstring &path)
+{
+    PositionIndex_Close(idx);
+    if (!MappedFile_Open(idx.file, path)) return false;
+    if (AttachMapping(idx)) return true;
+    PositionIndex_Close(idx);
+    return false;
+}
+#endif
+
+void PositionIndex_Close(PositionIndex &idx)
+{
+    MappedFile_Close(idx.file);
+    idx.entries = nullptr;
+    idx.entryCount = 0;
+    idx.gameCount = 0;
+}
+
+const PositionIndexEntry* PositionIndex_Find(const PositionIndex &idx, uint64_t key, size_t &outCount)
+{
+    outCount = 0;
+    if (!idx.entries) return nullptr;
+    const PositionIndexEntry* first = idx.entries;
+    const PositionIndexEntry* last = idx.entries + idx.entryCount;
+    const PositionIndexEntry* lo = std::lower_bound(first, last, key,
+        [](const PositionIndexEntry &e, uint64_t k) { return e.key < k; });
+    const PositionIndexEntry* hi = lo;
+    while (hi != last && hi->key == key) ++hi;
+    outCount = (size_t)(hi - lo);
+    return outCount ? lo : nullptr;
+}
+
+void PositionIndex_Summarize(const PositionIndexEntry* entries, size_t count, PositionIndexStats &out)
+{
+    out = PositionIndexStats();
+    for (size_t i = 0; i < count; ++i)
+    {
+        // a game never repeats a position (every move adds an arrow), but a corrupt archive could
+        if (i > 0 && entries[i].game == entries[i - 1].game) continue;
+        ++out.games;
+        switch (entries[i].result)
+        {
+        case GAME_RESULT_WHITE: ++out.whiteWins; break;
+        case GAME_RESULT_BLACK: ++out.blackWins; break;
+        default: ++out.unfinished; break;
+        }
+    }
+}
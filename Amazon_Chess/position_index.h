@@ -0,0 +1,57 @@
+#pragma once
+
+// Sorted index of archived positions: one record per (game, ply) keyed by the symmetry-canonical
+// Zobrist key of the position reached. The file is memory-mapped and searched in place, so a
+// lookup is a binary search regardless of how many positions were indexed.
+//
+// File layout (little-endian): header "AMZX", u32 version, u64 entryCount, u64 gameCount,
+// u64 reserved, then entryCount PositionIndexEntry records sorted by (key, game, ply).
+
+#include "mapped_file.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define POSITION_INDEX_VERSION 1
+
+// game results use the Game_CheckForWinner codes
+enum { GAME_RESULT_UNFINISHED = 0, GAME_RESULT_WHITE = 1, GAME_RESULT_BLACK = 2 };
+
+struct PositionIndexEntry
+{
+    uint64_t key;       // Position_CanonicalKey
+    uint32_t game;      // game number in the source archive
+    uint16_t ply;       // moves played before this position
+    uint8_t result;     // GAME_RESULT_* of that game
+    uint8_t boardSize;
+};
+
+struct PositionIndex
+{
+    MappedFile file;
+    const PositionIndexEntry* entries = nullptr;
+    uint64_t entryCount = 0;
+    uint64_t gameCount = 0;
+};
+
+struct PositionIndexStats
+{
+    uint32_t games = 0;
+    uint32_t whiteWins = 0;
+    uint32_t blackWins = 0;
+    uint32_t unfinished = 0;
+};
+
+// sorts 'entries' in place and writes the index file
+bool PositionIndex_Write(const std::string &path, std::vector<PositionIndexEntry> &entries, uint64_t gameCount);
+
+bool PositionIndex_Open(PositionIndex &idx, const std::string &path);
+#ifdef _WIN32
+bool PositionIndex_Open(PositionIndex &idx, const std::wstring &path);
+#endif
+void PositionIndex_Close(PositionIndex &idx);
+
+// contiguous run of entries with 'key' (nullptr when none)
+const PositionIndexEntry* PositionIndex_Find(const PositionIndex &idx, uint64_t key, size_t &outCount);
+// games and results behind a run returned by PositionIndex_Find
+void PositionIndex_Summarize(const PositionIndexEntry* entries, size_t count, PositionIndexStats &out);
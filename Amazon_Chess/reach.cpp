@@ -0,0 +1,136 @@
+#include "reach.h"
+#include "board_geometry.h"
+#include <cstring>
+
+template <int N>
+struct ReachKernel
+{
+    // empty squares from 'sq' along direction d, the first 'k' of them known to be empty
+    static inline int Walk(const Position &pos, int sq, int d, int k = 0)
+    {
+        const BoardGeometry<N> &g = Geometry<N>::value;
+        const uint8_t* ray = g.ray[sq][d];
+        int len = g.rayLen[sq][d];
+        while (k < len && pos.cell[ray[k]] == CELL_EMPTY) ++k;
+        return k;
+    }
+
+    // sets ray d of an amazon on 'sq' to 'len' squares, flipping only the squares that change
+    static inline void SetRay(ReachState &s, int side, int slot, int sq, int d, int len)
+    {
+        int old = s.rayLen[side][slot][d];
+        if (len == old) return;
+        const uint8_t* ray = Geometry<N>::value.ray[sq][d];
+        uint64_t* bits = s.reach[side][slot];
+        for (int k = len < old ? len : old, end = len < old ? old : len; k < end; ++k)
+            bits[ray[k] >> 6] ^= 1ull << (ray[k] & 63);
+        s.rayLen[side][slot][d] = (uint8_t)len;
+        s.mobility[side][slot] = (uint8_t)(s.mobility[side][slot] + len - old);
+        s.sideMobility[side] = (uint16_t)(s.sideMobility[side] + len - old);
+    }
+
+    // all rays of one amazon from scratch
+    static void Fill(ReachState &s, const Position &pos, int side, int slot)
+    {
+        int sq = pos.amazon[side][slot];
+        s.sideMobility[side] = (uint16_t)(s.sideMobility[side] - s.mobility[side][slot]);
+        memset(s.reach[side][slot], 0, sizeof(s.reach[side][slot]));
+        memset(s.rayLen[side][slot], 0, sizeof(s.rayLen[side][slot]));
+        s.mobility[side][slot] = 0;
+        for (int d = 0; d < GEOMETRY_DIRS; ++d) SetRay(s, side, slot, sq, d, Walk(pos, sq, d));
+    }
+
+    static void Init(const Position &pos, ReachState &out)
+    {
+        memset(&out, 0, sizeof(out));
+        for (int side = 0; side < 2; ++side)
+            for (int i = 0; i < POSITION_AMAZONS; ++i) Fill(out, pos, side, i);
+    }
+
+    // GEOMETRY_DIRS index of the line from 'a' through 'b' and b's distance along it (1 = adjacent);
+    // false if they do not share a row, column or diagonal
+    static inline bool Line(int a, int b, int &dir, int &dist)
+    {
+        // same direction order as MakeBoardGeometry: indexed by [row step + 1][col step + 1]
+        static const int8_t kDir[3][3] = { { 4, 0, 5 }, { 2, -1, 3 }, { 6, 1, 7 } };
+        int dr = b / N - a / N, dc = b % N - a % N;
+        int ar = dr < 0 ? -dr : dr, ac = dc < 0 ? -dc : dc;
+        if (ar != 0 && ac != 0 && ar != ac) return false;
+        dir = kDir[(dr > 0) - (dr < 0) + 1][(dc > 0) - (dc < 0) + 1];
+        dist = ar > ac ? ar : ac;
+        return dir >= 0;
+    }
+
+    // 'pos' already has the move's three squares changed; the amazon in 'moverSlot' of 'mover' is the
+    // one that moved
+    static void Update(ReachState &s, const Position &pos, int mover, int moverSlot, const PosMove &m)
+    {
+        const int changed[3] = { m.from, m.to, m.arrow };
+        Fill(s, pos, mover, moverSlot);
+        for (int side = 0; side < 2; ++side)
+        {
+            for (int i = 0; i < POSITION_AMAZONS; ++i)
+            {
+                if (side == mover && i == moverSlot) continue;
+                int sq = pos.amazon[side][i];
+                const uint8_t* len = s.rayLen[side][i];
+                // per ray, the nearest changed square up to the old blocker: the squares before it are
+                // still empty, so the walk resumes there; squares past the blocker change nothing
+                int from[GEOMETRY_DIRS];
+                unsigned dirs = 0;
+                for (int c = 0; c < 3; ++c)
+                {
+                    int d, dist;
+                    if (!Line(sq, changed[c], d, dist) || dist > len[d] + 1) continue;
+                    if (!(dirs & (1 << d)) || dist - 1 < from[d]) from[d] = dist - 1;
+                    dirs |= 1 << d;
+                }
+                for (int d = 0; dirs; ++d, dirs >>= 1)
+                    if (dirs & 1) SetRay(s, side, i, sq, d, Walk(pos, sq, d, from[d]));
+            }
+        }
+    }
+
+    static void MakeMove(ReachState &s, const Position &pos, const PosMove &m)
+    {
+        int mover = pos.blackToMove ? 0 : 1;
+        for (int i = 0; i < POSITION_AMAZONS; ++i)
+            if (pos.amazon[mover][i] == m.to) { Update(s, pos, mover, i, m); return; }
+    }
+
+    static void UnmakeMove(ReachState &s, const Position &pos, const PosMove &m)
+    {
+        int mover = pos.blackToMove ? 1 : 0;
+        for (int i = 0; i < POSITION_AMAZONS; ++i)
+            if (pos.amazon[mover][i] == m.from) { Update(s, pos, mover, i, m); return; }
+    }
+};
+
+#define REACH_KERNELS(n) { n, ReachKernel<n>::Init, ReachKernel<n>::MakeMove, ReachKernel<n>::UnmakeMove }
+
+static const ReachKernels kReachKernels[POSITION_MAX_SIDE - POSITION_MIN_SIDE + 1] = {
+    REACH_KERNELS(4), REACH_KERNELS(5), REACH_KERNELS(6), REACH_KERNELS(7),
+    REACH_KERNELS(8), REACH_KERNELS(9), REACH_KERNELS(10), REACH_KERNELS(11),
+    REACH_KERNELS(12), REACH_KERNELS(13), REACH_KERNELS(14), REACH_KERNELS(15),
+    REACH_KERNELS(16) };
+
+const ReachKernels& Reach_GetKernels(int size)
+{
+    if (size < POSITION_MIN_SIDE || size > POSITION_MAX_SIDE) size = 8;
+    return kReachKernels[size - POSITION_MIN_SIDE];
+}
+
+void Reach_Init(const Position &pos, ReachState &out)
+{
+    Reach_GetKernels(pos.size).init(pos, out);
+}
+
+void Reach_MakeMove(ReachState &s, const Position &pos, const PosMove &m)
+{
+    Reach_GetKernels(pos.size).makeMove(s, pos, m);
+}
+
+void Reach_UnmakeMove(ReachState &s, const Position &pos, const PosMove &m)
+{
+    Reach_GetKernels(pos.size).unmakeMove(s, pos, m);
+}
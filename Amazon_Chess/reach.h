@@ -0,0 +1,48 @@
+#pragma once
+
+// The squares every amazon reaches in one queen move, kept up to date across moves. A move changes
+// three squares (from, to and the arrow), so an update walks the moved amazon's rays again plus the
+// rays of other amazons that pass through one of those squares; every other ray carries over.
+//
+// A side can make a full move exactly when one of its amazons reaches any square (it can step there
+// and shoot back at the square it left), so the end of the game is a lookup of the side's mobility.
+// Amazons are identified by their Position::amazon slot, which make/unmake keep across moves.
+
+#include "position.h"
+
+#define REACH_WORDS (POSITION_MAX_SQUARES / 64)
+
+struct ReachState
+{
+    uint64_t reach[2][POSITION_AMAZONS][REACH_WORDS];   // bit sq of word sq / 64; [0] white, [1] black
+    uint8_t rayLen[2][POSITION_AMAZONS][8];             // empty squares along each GEOMETRY_DIRS ray
+    uint8_t mobility[2][POSITION_AMAZONS];              // squares in reach
+    uint16_t sideMobility[2];
+};
+
+// Compiled per board size like PositionKernels. makeMove/unmakeMove are called right after
+// Position_MakeMove / Position_UnmakeMove of the same move, with the resulting position.
+struct ReachKernels
+{
+    int size;
+    void (*init)(const Position &pos, ReachState &out);
+    void (*makeMove)(ReachState &s, const Position &pos, const PosMove &m);
+    void (*unmakeMove)(ReachState &s, const Position &pos, const PosMove &m);
+};
+const ReachKernels& Reach_GetKernels(int size);    // unsupported sizes get the 8x8 kernels
+
+void Reach_Init(const Position &pos, ReachState &out);
+void Reach_MakeMove(ReachState &s, const Position &pos, const PosMove &m);
+void Reach_UnmakeMove(ReachState &s, const Position &pos, const PosMove &m);
+
+// the side (true for black) can make a full move
+inline bool Reach_HasAnyMove(const ReachState &s, bool black)
+{
+    return s.sideMobility[black ? 1 : 0] != 0;
+}
+
+// amazon 'slot' of 'side' reaches square 'sq'
+inline bool Reach_Test(const ReachState &s, int side, int slot, int sq)
+{
+    return (s.reach[side][slot][sq >> 6] >> (sq & 63)) & 1;
+}
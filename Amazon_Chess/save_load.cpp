@@ -1,15 +1,18 @@
 #include "save_load.h"
 #include "game.h"
+#include "mapped_file.h"
+#include "pbn_parser.h"
+#include "trace.h"
 #include <windows.h>
 #include <fstream>
 #include <sstream>
 
 bool SaveHistoryToFile(const std::wstring &path)
 {
+    TRACE_ZONE("SaveHistoryToFile");
     HANDLE h = CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
     if (h == INVALID_HANDLE_VALUE) return false;
 
-    const auto &hist = Game_GetHistory();
     // write as UTF-8 with BOM
     const unsigned char bom[] = {0xEF,0xBB,0xBF};
     DWORD written = 0;
@@ -20,6 +23,19 @@ bool SaveHistoryToFile(const std::wstring &path)
     hdr << L"BoardSize:" << Game_GetBoardSize() << L"\r\n";
     hdr << L"OpponentAI:" << (Game_IsOpponentAI() ? 1 : 0) << L"\r\n";
     hdr << L"AIFirst:" << (Game_IsAIBlack() ? 1 : 0) << L"\r\n";
+    PositionSetup setup;
+    Game_GetSetup(setup);
+    if (setup.custom)
+    {
+        const int n = Game_GetBoardSize();
+        for (int side = 0; side < 2; ++side)
+        {
+            hdr << (side == 0 ? L"WhiteAmazons:" : L"BlackAmazons:");
+            for (int i = 0; i < POSITION_AMAZONS; ++i)
+                hdr << L" " << (wchar_t)(L'A' + setup.square[side][i] % n) << (setup.square[side][i] / n + 1);
+            hdr << L"\r\n";
+        }
+    }
     std::wstring hdrw = hdr.str();
     int hdrlen = WideCharToMultiByte(CP_UTF8, 0, hdrw.c_str(), (int)hdrw.size(), nullptr, 0, nullptr, nullptr);
     if (hdrlen > 0)
@@ -30,96 +46,65 @@ bool SaveHistoryToFile(const std::wstring &path)
         WriteFile(h, utf.data(), (DWORD)utf.size(), &written, nullptr);
     }
 
-    for (const auto &s : hist)
+    for (GameHistoryMove m : Game_GetHistory())
     {
-        int len = WideCharToMultiByte(CP_UTF8, 0, s.c_str(), (int)s.size(), nullptr, 0, nullptr, nullptr);
-        if (len > 0)
-        {
-            std::string utf8; utf8.resize(len);
-            WideCharToMultiByte(CP_UTF8, 0, s.c_str(), (int)s.size(), &utf8[0], len, nullptr, nullptr);
-            utf8 += "\r\n";
-            WriteFile(h, utf8.data(), (DWORD)utf8.size(), &written, nullptr);
-        }
+        wchar_t text[GAME_MOVE_TEXT_MAX];
+        Game_FormatMove(m, text);
+        // notation is ASCII, so each character is one UTF-8 byte
+        char line[GAME_MOVE_TEXT_MAX + 2];
+        int len = 0;
+        for (; text[len]; ++len) line[len] = (char)text[len];
+        line[len++] = '\r';
+        line[len++] = '\n';
+        WriteFile(h, line, (DWORD)len, &written, nullptr);
     }
     CloseHandle(h);
     return true;
 }
 
-static std::wstring Trim(const std::wstring &s)
+struct LoadState
+{
+    std::vector<GameMoveInput>* moves;
+    PbnGameInfo info;
+};
+
+static bool OnLoadGameBegin(void* user, const PbnGameInfo &info)
 {
-    size_t a = 0; while (a < s.size() && iswspace(s[a])) ++a;
-    size_t b = s.size(); while (b>0 && iswspace(s[b-1])) --b;
-    if (b<=a) return L"";
-    return s.substr(a, b-a);
+    LoadState* st = (LoadState*)user;
+    if (info.gameIndex > 0) return false; // a collection file loads its first game
+    st->info = info;
+    return true;
 }
 
-bool LoadHistoryFromFile(const std::wstring &path, std::vector<std::wstring> &outLines, int &outBoardSize, bool &outOpponentIsAI, bool &outAIIsFirst)
+static bool OnLoadMove(void* user, const PbnMove &mv)
 {
-    outLines.clear();
-    outBoardSize = 8; outOpponentIsAI = true; outAIIsFirst = false; // defaults
+    LoadState* st = (LoadState*)user;
+    GameMoveInput m = { mv.fromRow, mv.fromCol, mv.toRow, mv.toCol, mv.arrowRow, mv.arrowCol, mv.line };
+    st->moves->push_back(m);
+    return true;
+}
 
-    HANDLE h = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
-    if (h == INVALID_HANDLE_VALUE) return false;
-    DWORD size = GetFileSize(h, nullptr);
-    if (size == INVALID_FILE_SIZE) { CloseHandle(h); return false; }
-    std::string buf; buf.resize(size);
-    DWORD read = 0;
-    if (!ReadFile(h, &buf[0], size, &read, nullptr)) { CloseHandle(h); return false; }
-    CloseHandle(h);
-    size_t pos = 0;
-    // handle BOM
-    if (read >= 3 && (unsigned char)buf[0] == 0xEF && (unsigned char)buf[1] == 0xBB && (unsigned char)buf[2] == 0xBF) pos = 3;
+bool LoadGameFromFile(const std::wstring &path, std::vector<GameMoveInput> &outMoves, int &outBoardSize, bool &outOpponentIsAI, bool &outAIIsFirst, int *outBadLine, PositionSetup *outSetup)
+{
+    TRACE_ZONE("LoadGameFromFile");
+    outMoves.clear();
+    if (outBadLine) *outBadLine = 0;
 
-    // read UTF-8 content into wstring lines
-    std::vector<std::wstring> lines;
-    while (pos < read)
-    {
-        size_t eol = buf.find('\n', pos);
-        size_t len = (eol == std::string::npos) ? (read - pos) : (eol - pos);
-        // trim CR
-        if (len > 0 && buf[pos + len - 1] == '\r') --len;
-        int wlen = MultiByteToWideChar(CP_UTF8, 0, &buf[pos], (int)len, nullptr, 0);
-        std::wstring w;
-        if (wlen > 0)
-        {
-            w.resize(wlen);
-            MultiByteToWideChar(CP_UTF8, 0, &buf[pos], (int)len, &w[0], wlen);
-        }
-        else w = L"";
-        lines.push_back(w);
-        if (eol == std::string::npos) break;
-        pos = eol + 1;
-    }
+    MappedFile file;
+    if (!MappedFile_Open(file, path)) return false;
 
-    // parse header until blank line encountered
-    size_t i = 0;
-    for (; i < lines.size(); ++i)
-    {
-        std::wstring t = Trim(lines[i]);
-        if (t.empty()) { ++i; break; }
-        // header entries: key:value
-        size_t colon = t.find(L':');
-        if (colon == std::wstring::npos) continue;
-        std::wstring key = Trim(t.substr(0, colon));
-        std::wstring val = Trim(t.substr(colon+1));
-        if (_wcsicmp(key.c_str(), L"BoardSize") == 0)
-        {
-            int v = _wtoi(val.c_str()); if (v==8||v==10) outBoardSize = v;
-        }
-        else if (_wcsicmp(key.c_str(), L"OpponentAI") == 0)
-        {
-            outOpponentIsAI = (val == L"1" || _wtoi(val.c_str()) != 0);
-        }
-        else if (_wcsicmp(key.c_str(), L"AIFirst") == 0)
-        {
-            outAIIsFirst = (val == L"1" || _wtoi(val.c_str()) != 0);
-        }
-    }
+    LoadState st;
+    st.moves = &outMoves;
+    PbnCallbacks cb;
+    cb.user = &st;
+    cb.onGameBegin = OnLoadGameBegin;
+    cb.onMove = OnLoadMove;
+    Pbn_Parse(file.data, file.size, cb, outBadLine);
+    MappedFile_Close(file);
 
-    // remaining lines are history entries
-    for (size_t j = i; j < lines.size(); ++j)
-    {
-        outLines.push_back(lines[j]);
-    }
+    outBoardSize = st.info.boardSize;
+    outOpponentIsAI = st.info.opponentIsAI;
+    outAIIsFirst = st.info.aiFirst;
+    if (outSetup) *outSetup = st.info.setup;
     return true;
 }
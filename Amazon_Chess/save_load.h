@@ -3,9 +3,14 @@
 #include <string>
 #include <vector>
 
+struct GameMoveInput;
+struct PositionSetup;
+
 // Save the full history to the given path (UTF-16 path). Returns true on success.
 bool SaveHistoryToFile(const std::wstring &path);
 
-// Load history from file into memory (returns lines) and optionally parsed header values.
-// Returns true on success and fills outLines. Header values are only set if present in file.
-bool LoadHistoryFromFile(const std::wstring &path, std::vector<std::wstring> &outLines, int &outBoardSize, bool &outOpponentIsAI, bool &outAIIsFirst);
+// Load the first game of a .pbn file (memory-mapped, parsed in place) as a list of moves with their
+// file line numbers, plus header values (defaults: 8x8, opponent AI, AI not first, standard setup).
+// Returns false only if the file cannot be read. A malformed move line ends the list early and its
+// line number goes to outBadLine (0 when every line parsed); moves are not validated here.
+bool LoadGameFromFile(const std::wstring &path, std::vector<GameMoveInput> &outMoves, int &outBoardSize, bool &outOpponentIsAI, bool &outAIIsFirst, int *outBadLine = nullptr, PositionSetup *outSetup = nullptr);
@@ -0,0 +1,230 @@
+#include "solved_table.h"
+#include "byte_io.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+static const char kMagic[4] = { 'A', 'M', 'Z', 'S' };
+static const size_t kHeaderSize = 32;
+static const int kMaxRecordBits = 57;   // a record is read with one unaligned 64-bit load
+
+
+// ---- codes ----
+
+// C(n, k) for n <= 36, k <= 4
+struct Binomials
+{
+    uint64_t c[SOLVED_TABLE_MAX_SIDE * SOLVED_TABLE_MAX_SIDE + 1][POSITION_AMAZONS + 1];
+
+    Binomials()
+    {
+        for (int n = 0; n <= SOLVED_TABLE_MAX_SIDE * SOLVED_TABLE_MAX_SIDE; ++n)
+            for (int k = 0; k <= POSITION_AMAZONS; ++k)
+                c[n][k] = (k == 0) ? 1 : (n == 0 ? 0 : c[n - 1][k - 1] + c[n - 1][k]);
+    }
+};
+
+static const Binomials &Binom()
+{
+    static const Binomials b;
+    return b;
+}
+
+int SolvedTable_CodeBits(int size)
+{
+    if (size < POSITION_MIN_SIDE || size > SOLVED_TABLE_MAX_SIDE) return 0;
+    int squares = size * size;
+    uint64_t sets = Binom().c[squares][POSITION_AMAZONS] * Binom().c[squares - POSITION_AMAZONS][POSITION_AMAZONS];
+    int bits = 0;
+    while (bits < 64 && (1ull << bits) < sets) ++bits;
+    return bits + squares - 2 * POSITION_AMAZONS;
+}
+
+// code of the cells as seen through one symmetry map (sym[square] = mapped square)
+static uint64_t CodeOf(const uint8_t* cell, int squares, const uint8_t* sym)
+{
+    uint8_t mapped[SOLVED_TABLE_MAX_SIDE * SOLVED_TABLE_MAX_SIDE];
+    for (int sq = 0; sq < squares; ++sq) mapped[sym[sq]] = cell[sq];
+    const Binomials &b = Binom();
+    uint64_t rankWhite = 0, rankBlack = 0, arrows = 0;
+    int whites = 0, blacks = 0;
+    for (int sq = 0; sq < squares; ++sq)
+    {
+        switch (mapped[sq])
+        {
+        case CELL_WHITE: rankWhite += b.c[sq][++whites]; break;
+        case CELL_BLACK: rankBlack += b.c[sq - whites][++blacks]; break;
+        case CELL_ARROW: arrows |= 1ull << (sq - whites - blacks); break;
+        default: break;
+        }
+    }
+    uint64_t blackSets = b.c[squares - POSITION_AMAZONS][POSITION_AMAZONS];
+    return (rankWhite * blackSets + rankBlack) << (squares - 2 * POSITION_AMAZONS) | arrows;
+}
+
+bool SolvedTable_Code(const Position &pos, uint64_t &out)
+{
+    if (pos.size < POSITION_MIN_SIDE || pos.size > SOLVED_TABLE_MAX_SIDE) return false;
+    int squares = pos.size * pos.size;
+    int count[4] = {};
+    for (int sq = 0; sq < squares; ++sq) ++count[pos.cell[sq]];
+    if (count[CELL_WHITE] != POSITION_AMAZONS || count[CELL_BLACK] != POSITION_AMAZONS) return false;
+    // the orientation with the smallest symmetric Zobrist key (see Position_CanonicalKey); mirrored
+    // positions share the same eight keys, so they pick the same orientation without eight codes
+    int best = 0;
+    for (int s = 1; s < POSITION_SYMMETRIES; ++s) if (pos.symHash[s] < pos.symHash[best]) best = s;
+    out = CodeOf(pos.cell, squares, Position_GetKernels(pos.size).sym + best * squares);
+    return true;
+}
+
+// ---- writing ----
+
+bool SolvedTable_Write(const std::string &path, int boardSize, std::vector<uint64_t> &entries)
+{
+    int codeBits = SolvedTable_CodeBits(boardSize);
+    if (codeBits == 0 || entries.size() > 0xFFFFFFFFull) return false;
+    std::sort(entries.begin(), entries.end());
+
+    // 8 to 16 records per bucket keeps the bucket starts near 3 bits per record; a bucket needs at
+    // least enough top bits that a record still fits one 64-bit load
+    int bucketBits = 0;
+    while (bucketBits < 31 && (16ull << bucketBits) < entries.size()) ++bucketBits;
+    bucketBits = std::min(std::max(bucketBits, codeBits + 1 - kMaxRecordBits), codeBits);
+    int lowBits = codeBits - bucketBits;
+    int recordBits = lowBits + 1;
+
+    FILE* f = ByteIO_OpenFile(path, "wb");
+    if (!f) return false;
+
+    unsigned char header[kHeaderSize] = {};
+    memcpy(header, kMagic, 4);
+    ByteIO_PutU32(header + 4, SOLVED_TABLE_VERSION);
+    header[8] = (unsigned char)boardSize;
+    header[9] = (unsigned char)bucketBits;
+    header[10] = (unsigned char)lowBits;
+    ByteIO_PutU64(header + 16, entries.size());
+    bool ok = fwrite(header, 1, kHeaderSize, f) == kHeaderSize;
+
+    size_t bucketCount = ((size_t)1 << bucketBits) + 1;
+    std::vector<unsigned char> buckets(bucketCount * 4);
+    size_t e = 0;
+    for (size_t b = 0; b < bucketCount; ++b)
+    {
+        while (e < entries.size() && (entries[e] >> (lowBits + 1)) < b) ++e;
+        ByteIO_PutU32(&buckets[b * 4], (uint32_t)e);
+    }
+    if (ok) ok = fwrite(buckets.data(), 1, buckets.size(), f) == buckets.size();
+
+    // records are packed LSB first and streamed out in chunks; 8 zero bytes of padding follow.
+    // Fewer than 8 bits stay behind after each flush, so a record always fits the accumulator.
+    std::vector<unsigned char> chunk;
+    uint64_t acc = 0;
+    int accBits = 0;
+    uint64_t lowMask = lowBits ? (~0ull >> (64 - lowBits)) : 0;
+    for (size_t i = 0; ok && i < entries.size(); ++i)
+    {
+        uint64_t code = entries[i] >> 1;
+        acc |= ((code & lowMask) | (entries[i] & 1) << lowBits) << accBits;
+        accBits += recordBits;
+        for (; accBits >= 8; accBits -= 8, acc >>= 8) chunk.push_back((unsigned char)acc);
+        if (chunk.size() >= (1u << 20))
+        {
+            ok = fwrite(chunk.data(), 1, chunk.size(), f) == chunk.size();
+            chunk.clear();
+        }
+    }
+    if (accBits > 0) chunk.push_back((unsigned char)acc);
+    chunk.insert(chunk.end(), 8, 0);
+    if (ok) ok = fwrite(chunk.data(), 1, chunk.size(), f) == chunk.size();
+    if (fclose(f) != 0) ok = false;
+    return ok;
+}
+
+// ---- reading ----
+
+static bool AttachMapping(SolvedTable &t)
+{
+    const unsigned char* p = (const unsigned char*)t.file.data;
+    if (t.file.size < kHeaderSize || memcmp(p, kMagic, 4) != 0 || ByteIO_GetU32(p + 4) != SOLVED_TABLE_VERSION)
+        return false;
+    int size = p[8], bucketBits = p[9], lowBits = p[10];
+    int codeBits = SolvedTable_CodeBits(size);
+    if (codeBits == 0 || bucketBits + lowBits != codeBits || bucketBits > 31 || lowBits + 1 > kMaxRecordBits) return false;
+    uint64_t count = ByteIO_GetU64(p + 16);
+    uint64_t bucketBytes = (((uint64_t)1 << bucketBits) + 1) * 4;
+    uint64_t recordBytes = (count * (uint64_t)(lowBits + 1) + 7) / 8 + 8;
+    if (kHeaderSize + bucketBytes + recordBytes > t.file.size) return false;
+    t.boardSize = size;
+    t.bucketBits = bucketBits;
+    t.lowBits = lowBits;
+    t.entryCount = count;
+    t.buckets = reinterpret_cast<const uint32_t*>(p + kHeaderSize);
+    t.records = p + kHeaderSize + bucketBytes;
+    return true;
+}
+
+bool SolvedTable_Open(SolvedTable &t, const std::string &path)
+{
+    SolvedTable_Close(t);
+    if (!MappedFile_Open(t.file, path)) return false;
+    if (AttachMapping(t)) return true;
+    SolvedTable_Close(t);
+    return false;
+}
+
+#ifdef _WIN32
+bool SolvedTable_Open(SolvedTable &t, const std::wstring &path)
+{
+    SolvedTable_Close(t);
+    if (!MappedFile_Open(t.file, path)) return false;
+    if (AttachMapping(t)) return true;
+    SolvedTable_Close(t);
+    return false;
+}
+#endif
+
+void SolvedTable_Close(SolvedTable &t)
+{
+    MappedFile_Close(t.file);
+    t.boardSize = 0;
+    t.entryCount = 0;
+    t.buckets = nullptr;
+    t.records = nullptr;
+}
+
+static inline uint64_t ReadRecord(const SolvedTable &t, uint64_t index)
+{
+    uint64_t bit = index * (uint64_t)(t.lowBits + 1);
+    uint64_t word;
+    memcpy(&word, t.records + (bit >> 3), 8);   // little-endian hosts, like the position index
+    return (word >> (bit & 7)) & (~0ull >> (63 - t.lowBits));
+}
+
+bool SolvedTable_Probe(const SolvedTable &t, const Position &pos, bool &outWin)
+{
+    uint64_t code;
+    if (!t.records || pos.size != t.boardSize || !SolvedTable_Code(pos, code)) return false;
+    // black moves first and every move adds an arrow, so the arrow count fixes the side to move
+    int arrows = 0;
+    for (int sq = 0; sq < pos.size * pos.size; ++sq) arrows += pos.cell[sq] == CELL_ARROW;
+    if (pos.blackToMove != (arrows % 2 == 0)) return false;
+
+    uint64_t lowMask = t.lowBits ? (~0ull >> (64 - t.lowBits)) : 0;
+    uint64_t low = code & lowMask;
+    uint64_t bucket = code >> t.lowBits;
+    uint64_t lo = t.buckets[bucket], hi = t.buckets[bucket + 1];
+    while (lo < hi)
+    {
+        uint64_t mid = lo + (hi - lo) / 2;
+        uint64_t rec = ReadRecord(t, mid);
+        uint64_t recLow = rec & lowMask;
+        if (recLow == low)
+        {
+            outWin = (rec >> t.lowBits) & 1;
+            return true;
+        }
+        if (recLow < low) lo = mid + 1;
+        else hi = mid;
+    }
+    return false;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+// Table of solved small-board positions (.amzs), written by Amazon_Tools solve and memory-mapped by
+// the engine for perfect play on 5x5 and 6x6 boards.
+//
+// A position is stored under an exact symmetry-canonical code: the ranks of the white and black
+// amazon sets (combinatorial number system) followed by one bit per remaining square for arrows,
+// read in the board orientation whose symmetric Zobrist key is smallest (so tables stay tied to the
+// Zobrist keys, like the position index). That needs 44 bits on 5x5 and 59 bits on 6x6, so boards
+// up to SOLVED_TABLE_MAX_SIDE fit in 64 bits. The side to move is not stored: black moves first and
+// every move adds an arrow, so it follows from the arrow count.
+//
+// File layout (little-endian): header "AMZS", u32 version, u8 boardSize, u8 bucketBits, u8 lowBits,
+// u8 reserved, u32 reserved, u64 entryCount, u64 reserved; then 2^bucketBits + 1 u32 bucket starts;
+// then entryCount packed records of lowBits + 1 bits (low bits of the code, then 1 if the side to
+// move wins), sorted by code. The top bucketBits of a code select its bucket, so a lookup is a
+// binary search over the few records of one bucket.
+
+#include "mapped_file.h"
+#include "position.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define SOLVED_TABLE_VERSION 1
+#define SOLVED_TABLE_MAX_SIDE 6
+
+struct SolvedTable
+{
+    MappedFile file;
+    int boardSize = 0;
+    int bucketBits = 0;
+    int lowBits = 0;
+    uint64_t entryCount = 0;
+    const uint32_t* buckets = nullptr;
+    const uint8_t* records = nullptr;
+};
+
+// number of bits of a code for 'size' (0 if the board is too large for the table)
+int SolvedTable_CodeBits(int size);
+// canonical code of a position; false if the board is too large or the amazon count is wrong
+bool SolvedTable_Code(const Position &pos, uint64_t &out);
+
+// Sorts 'entries' (code << 1 | 1 if the side to move wins, codes unique) in place and writes the table file.
+bool SolvedTable_Write(const std::string &path, int boardSize, std::vector<uint64_t> &entries);
+
+bool SolvedTable_Open(SolvedTable &t, const std::string &path);
+#ifdef _WIN32
+bool SolvedTable_Open(SolvedTable &t, const std::wstring &path);
+#endif
+void SolvedTable_Close(SolvedTable &t);
+
+// true if the position is in the table; outWin tells whether the side to move wins
+bool SolvedTable_Probe(const SolvedTable &t, const Position &pos, bool &outWin);
@@ -0,0 +1,173 @@
+#include "trace.h"
+#include "byte_io.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if TRACE_ENABLED
+
+std::atomic<bool> g_traceRecording(false);
+
+struct TraceEvent
+{
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+    int64_t arg;
+};
+
+// Written only by its owning thread; 'head' counts every event ever recorded, so the ring holds
+// events head - TRACE_RING_EVENTS .. head - 1.
+struct TraceRing
+{
+    TraceEvent events[TRACE_RING_EVENTS];
+    std::atomic<uint64_t> head{ 0 };
+    const char* threadName = nullptr;
+    bool inUse = false;         // owned by a live thread (guarded by s_lock)
+};
+
+static std::mutex s_lock;       // guards s_rings, inUse and the start point
+static std::vector<std::unique_ptr<TraceRing>> s_rings;
+static uint64_t s_startTicks = 0;
+static std::chrono::steady_clock::time_point s_startTime;
+static thread_local TraceRing* t_ring = nullptr;
+
+// gives the thread's ring back when the thread exits
+struct TraceRingRelease
+{
+    bool armed = false;
+    ~TraceRingRelease()
+    {
+        if (!armed || !t_ring) return;
+        std::lock_guard<std::mutex> guard(s_lock);
+        t_ring->inUse = false;
+        t_ring = nullptr;
+    }
+};
+static thread_local TraceRingRelease t_release;
+
+static TraceRing* AcquireRing()
+{
+    std::lock_guard<std::mutex> guard(s_lock);
+    TraceRing* ring = nullptr;
+    for (auto &r : s_rings) if (!r->inUse) { ring = r.get(); break; }
+    if (!ring)
+    {
+        s_rings.emplace_back(new TraceRing());
+        ring = s_rings.back().get();
+    }
+    ring->inUse = true;
+    ring->threadName = nullptr;
+    t_ring = ring;
+    t_release.armed = true;
+    return ring;
+}
+
+void Trace_Record(const char* name, uint64_t start, uint64_t end, int64_t arg)
+{
+    TraceRing* ring = t_ring ? t_ring : AcquireRing();
+    uint64_t h = ring->head.load(std::memory_order_relaxed);
+    TraceEvent &e = ring->events[h & (TRACE_RING_EVENTS - 1)];
+    e.name = name;
+    e.start = start;
+    e.end = end;
+    e.arg = arg;
+    ring->head.store(h + 1, std::memory_order_release);
+}
+
+void Trace_Start()
+{
+    std::lock_guard<std::mutex> guard(s_lock);
+    if (g_traceRecording.load()) return;
+    s_startTicks = Trace_Now();
+    s_startTime = std::chrono::steady_clock::now();
+    g_traceRecording = true;
+}
+
+void Trace_Stop() { g_traceRecording = false; }
+bool Trace_IsRecording() { return g_traceRecording.load(); }
+
+void Trace_SetThreadName(const char* name)
+{
+    TraceRing* ring = t_ring ? t_ring : AcquireRing();
+    std::lock_guard<std::mutex> guard(s_lock);
+    ring->threadName = name;
+}
+
+void Trace_ToJson(std::string &out)
+{
+    // Recording pauses for the copy. A thread already past its check may still store one event, at
+    // the slot after its newest, which is the oldest one of a full ring; that slot is left out.
+    bool was = g_traceRecording.exchange(false);
+    std::lock_guard<std::mutex> guard(s_lock);
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - s_startTime).count();
+    uint64_t ticks = Trace_Now() - s_startTicks;
+    double ticksPerUs = us > 0.0 && ticks > 0 ? ticks / us : 1.0;
+
+    out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    char buf[256];
+    bool first = true;
+    for (size_t t = 0; t < s_rings.size(); ++t)
+    {
+        const TraceRing &ring = *s_rings[t];
+        if (ring.threadName)
+        {
+            snprintf(buf, sizeof(buf), "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",", t + 1, ring.threadName);
+            out += buf;
+            first = false;
+        }
+        uint64_t head = ring.head.load(std::memory_order_acquire);
+        uint64_t from = head > TRACE_RING_EVENTS - 1 ? head - (TRACE_RING_EVENTS - 1) : 0;
+        for (uint64_t i = from; i < head; ++i)
+        {
+            const TraceEvent &e = ring.events[i & (TRACE_RING_EVENTS - 1)];
+            if (e.start < s_startTicks || e.end < e.start) continue;   // from before this recording
+            int n = snprintf(buf, sizeof(buf), "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f",
+                first ? "" : ",", e.name, t + 1, (e.start - s_startTicks) / ticksPerUs, (e.end - e.start) / ticksPerUs);
+            if (e.arg != INT64_MIN && n > 0 && n < (int)sizeof(buf))
+                snprintf(buf + n, sizeof(buf) - n, ",\"args\":{\"value\":%lld}", (long long)e.arg);
+            out += buf;
+            out += "}";
+            first = false;
+        }
+    }
+    out += "\n]}\n";
+    g_traceRecording = was;
+}
+
+#else
+
+void Trace_Start() {}
+void Trace_Stop() {}
+bool Trace_IsRecording() { return false; }
+void Trace_SetThreadName(const char*) {}
+void Trace_ToJson(std::string &out) { out = "{\"traceEvents\":[]}\n"; }
+
+#endif
+
+static bool WriteTrace(FILE* f)
+{
+    if (!f) return false;
+    std::string json;
+    Trace_ToJson(json);
+    bool ok = fwrite(json.data(), 1, json.size(), f) == json.size();
+    return fclose(f) == 0 && ok;
+}
+
+bool Trace_Dump(const std::string &path)
+{
+    FILE* f = ByteIO_OpenFile(path, "wb");
+    return WriteTrace(f);
+}
+
+#ifdef _WIN32
+bool Trace_Dump(const std::wstring &path)
+{
+    FILE* f = nullptr;
+    if (_wfopen_s(&f, path.c_str(), L"wb") != 0) f = nullptr;
+    return WriteTrace(f);
+}
+#endif
@@ -0,0 +1,93 @@
+#pragma once
+
+// Timeline recorder for finding stutters: scoped zones in the search, the board's paint and click
+// handlers and the save/load paths, written on demand as Chrome trace JSON (chrome://tracing or
+// ui.perfetto.dev).
+//
+// Every thread records into its own ring of the last TRACE_RING_EVENTS zones; recording takes no
+// lock and costs two timestamp reads and one 32-byte store per zone. Rings of exited threads are
+// handed to new ones, so the short-lived search helpers do not grow memory. Zones are only
+// recorded between Trace_Start and Trace_Stop; a dump pauses recording while it copies the rings.
+//
+// Built with TRACE_ENABLED 0 the zone macros compile to nothing.
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+#define TRACE_RING_EVENTS (1 << 15)     // per thread; a power of two
+
+void Trace_Start();
+void Trace_Stop();
+bool Trace_IsRecording();
+// name of the calling thread in dumps (a string literal or other storage that stays valid)
+void Trace_SetThreadName(const char* name);
+// the recorded zones as Chrome trace JSON ("X" events, microseconds since Trace_Start)
+void Trace_ToJson(std::string &out);
+bool Trace_Dump(const std::string &path);
+#ifdef _WIN32
+bool Trace_Dump(const std::wstring &path);
+#endif
+
+#if TRACE_ENABLED
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define TRACE_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TRACE_TSC 1
+#else
+#include <chrono>
+#define TRACE_TSC 0
+#endif
+
+extern std::atomic<bool> g_traceRecording;
+
+// timestamp in ticks (the time stamp counter where there is one; converted when dumping)
+static inline uint64_t Trace_Now()
+{
+#if TRACE_TSC
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+// 'name' must outlive the dump (string literals); 'arg' is shown as args.value unless INT64_MIN
+void Trace_Record(const char* name, uint64_t start, uint64_t end, int64_t arg);
+
+struct TraceZone
+{
+    const char* name;
+    uint64_t start;
+    int64_t arg;
+
+    explicit TraceZone(const char* zoneName, int64_t value = INT64_MIN) : name(zoneName), start(0), arg(value)
+    {
+        if (g_traceRecording.load(std::memory_order_relaxed)) start = Trace_Now();
+    }
+    ~TraceZone()
+    {
+        if (start && g_traceRecording.load(std::memory_order_relaxed)) Trace_Record(name, start, Trace_Now(), arg);
+    }
+    TraceZone(const TraceZone &) = delete;
+    TraceZone &operator=(const TraceZone &) = delete;
+};
+
+#define TRACE_JOIN2(a, b) a##b
+#define TRACE_JOIN(a, b) TRACE_JOIN2(a, b)
+// times the rest of the enclosing scope
+#define TRACE_ZONE(name) TraceZone TRACE_JOIN(traceZone_, __LINE__)(name)
+#define TRACE_ZONE_ARG(name, value) TraceZone TRACE_JOIN(traceZone_, __LINE__)(name, (int64_t)(value))
+
+#else
+
+#define TRACE_ZONE(name) ((void)0)
+#define TRACE_ZONE_ARG(name, value) ((void)0)
+
+#endif
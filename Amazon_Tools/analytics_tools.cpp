@@ -0,0 +1,417 @@
+// analytics_tools.cpp : statistics over whole game collections. Inputs (.amzb archives or .pbn files)
+// are cut into tasks for a thread pool: a slice of an archive's games, or one .pbn file. Each worker
+// replays its games with the position kernels into an aggregate of its own, and the aggregates are
+// summed once at the end, so workers share nothing while they run.
+
+#include "tools.h"
+#include "engine.h"
+#include "game_archive.h"
+#include "mapped_file.h"
+#include "position.h"
+#include "position_index.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+static const uint64_t kArchiveSlice = 512;     // games per task
+
+struct SizeStats
+{
+    uint64_t games;
+    uint64_t results[3];                            // by GAME_RESULT_*
+    uint64_t illegal;                               // replay stopped at an illegal move (unfinished)
+    uint64_t moves;
+    uint64_t lengths[POSITION_MAX_SQUARES + 1];     // games by number of moves replayed
+    uint64_t arrows[POSITION_MAX_SQUARES];          // arrows shot onto each square
+    uint64_t amazonTo[POSITION_MAX_SQUARES];        // amazon moves ending on each square
+};
+
+struct OpeningStats
+{
+    uint64_t games = 0;
+    uint64_t results[3] = {};
+};
+
+// Opening lines are keyed by board size, setup and the moves so far: one byte for the size, one
+// for the custom flag, the eight setup squares if custom, then three bytes per move.
+struct AnalyticsAggregate
+{
+    SizeStats sizes[POSITION_MAX_SIDE + 1];
+    std::unordered_map<std::string, OpeningStats> openings;
+    uint64_t badRecords;                            // .pbn games dropped by a malformed move line
+};
+
+static void AnalyzeGame(AnalyticsAggregate &a, const ArchiveGame &game, int openingPlies)
+{
+    Position pos;
+    Position_InitSetup(pos, game.boardSize, game.setup);
+    const PositionKernels &k = Position_GetKernels(pos.size);
+    SizeStats &s = a.sizes[pos.size];
+
+    size_t played = 0;
+    bool legal = true;
+    for (; played < game.moves.size(); ++played)
+    {
+        const ArchiveMove &am = game.moves[played];
+        PosMove m = { am.from, am.to, am.arrow };
+        if (!Position_IsLegalMove(pos, m)) { legal = false; break; }
+        k.makeMove(pos, m);
+        ++s.arrows[m.arrow];
+        ++s.amazonTo[m.to];
+    }
+    int result = GAME_RESULT_UNFINISHED;
+    if (legal && !k.hasAnyMove(pos)) result = pos.blackToMove ? GAME_RESULT_WHITE : GAME_RESULT_BLACK;
+    ++s.games;
+    ++s.results[result];
+    s.illegal += legal ? 0 : 1;
+    s.moves += played;
+    ++s.lengths[played];
+
+    std::string key;
+    key += (char)pos.size;
+    key += (char)(game.setup.custom ? 1 : 0);
+    if (game.setup.custom) key.append((const char*)&game.setup.square[0][0], sizeof(game.setup.square));
+    for (size_t ply = 0; ply < played && (int)ply < openingPlies; ++ply)
+    {
+        key.append((const char*)&game.moves[ply], sizeof(ArchiveMove));
+        OpeningStats &o = a.openings[key];
+        ++o.games;
+        ++o.results[result];
+    }
+}
+
+static void Merge(AnalyticsAggregate &into, const AnalyticsAggregate &from)
+{
+    // every SizeStats field is a uint64_t counter
+    const size_t words = sizeof(SizeStats) / sizeof(uint64_t);
+    for (int n = 0; n <= POSITION_MAX_SIDE; ++n)
+    {
+        const uint64_t* src = (const uint64_t*)&from.sizes[n];
+        uint64_t* dst = (uint64_t*)&into.sizes[n];
+        for (size_t i = 0; i < words; ++i) dst[i] += src[i];
+    }
+    for (const auto &kv : from.openings)
+    {
+        OpeningStats &o = into.openings[kv.first];
+        o.games += kv.second.games;
+        for (int r = 0; r < 3; ++r) o.results[r] += kv.second.results[r];
+    }
+    into.badRecords += from.badRecords;
+}
+
+// ---- .pbn input ----
+
+struct PbnAnalyzeState
+{
+    AnalyticsAggregate* aggregate;
+    int openingPlies;
+    ArchiveGame game;
+    bool badMove;
+};
+
+static bool OnAnalyzeGameBegin(void* user, const PbnGameInfo &info)
+{
+    PbnAnalyzeState* st = (PbnAnalyzeState*)user;
+    st->game.boardSize = info.boardSize;
+    st->game.opponentIsAI = info.opponentIsAI;
+    st->game.aiFirst = info.aiFirst;
+    st->game.setup = info.setup;
+    st->game.moves.clear();
+    return true;
+}
+
+static bool OnAnalyzeMove(void* user, const PbnMove &mv)
+{
+    PbnAnalyzeState* st = (PbnAnalyzeState*)user;
+    ArchiveMove m;
+    if (!Archive_MoveFromPbn(mv, st->game.boardSize, m))
+    {
+        st->badMove = true;
+        return false;
+    }
+    st->game.moves.push_back(m);
+    return true;
+}
+
+static void OnAnalyzeGameEnd(void* user, const PbnGameInfo &, int)
+{
+    PbnAnalyzeState* st = (PbnAnalyzeState*)user;
+    AnalyzeGame(*st->aggregate, st->game, st->openingPlies);
+}
+
+static void AnalyzePbn(AnalyticsAggregate &a, const MappedFile &file, int openingPlies)
+{
+    PbnAnalyzeState st;
+    st.aggregate = &a;
+    st.openingPlies = openingPlies;
+    st.badMove = false;
+    PbnCallbacks cb;
+    cb.user = &st;
+    cb.onGameBegin = OnAnalyzeGameBegin;
+    cb.onMove = OnAnalyzeMove;
+    cb.onGameEnd = OnAnalyzeGameEnd;
+    int errLine = 0;
+    // parsing stops at the first malformed move; the games before it are counted
+    if (!Pbn_Parse(file.data, file.size, cb, &errLine) || st.badMove) ++a.badRecords;
+}
+
+// ---- reports ----
+
+// 'key' as an OpeningStats key: setup ("standard" or the eight squares) and the moves in notation
+static void DescribeOpening(const std::string &key, std::string &setup, std::string &line, int &plies)
+{
+    const uint8_t* k = (const uint8_t*)key.data();
+    int size = k[0];
+    size_t at = 2;
+    PositionSetup ps;
+    setup = "standard";
+    if (k[1])
+    {
+        ps.custom = true;
+        memcpy(ps.square, k + 2, sizeof(ps.square));
+        at += sizeof(ps.square);
+        setup.clear();
+        for (int i = 0; i < 2 * POSITION_AMAZONS; ++i)
+        {
+            if (i) setup += ' ';
+            Archive_AppendSquare(setup, (&ps.square[0][0])[i], size);
+        }
+    }
+    Position pos;
+    Position_InitSetup(pos, size, ps);
+    line.clear();
+    plies = 0;
+    for (; at + sizeof(ArchiveMove) <= key.size(); at += sizeof(ArchiveMove), ++plies)
+    {
+        PosMove m = { k[at], k[at + 1], k[at + 2] };
+        line += (plies ? " / " : "") + Engine_MoveToString(pos, m);
+        Position_MakeMove(pos, m);
+    }
+}
+
+static bool WriteOpeningsCsv(const std::string &path, const AnalyticsAggregate &a, uint64_t minGames)
+{
+    struct Row { std::string setup, line; int size, plies; const OpeningStats* stats; };
+    std::vector<Row> rows;
+    for (const auto &kv : a.openings)
+    {
+        if (kv.second.games < minGames) continue;
+        Row r;
+        r.size = (uint8_t)kv.first[0];
+        r.stats = &kv.second;
+        DescribeOpening(kv.first, r.setup, r.line, r.plies);
+        rows.push_back(r);
+    }
+    std::sort(rows.begin(), rows.end(), [](const Row &x, const Row &y) {
+        if (x.size != y.size) return x.size < y.size;
+        if (x.setup != y.setup) return x.setup < y.setup;
+        if (x.plies != y.plies) return x.plies < y.plies;
+        if (x.stats->games != y.stats->games) return x.stats->games > y.stats->games;
+        return x.line < y.line;
+    });
+    std::string out = "size,setup,plies,line,games,black_wins,white_wins,unfinished,black_win_rate\n";
+    char buf[160];
+    for (const Row &r : rows)
+    {
+        const OpeningStats &o = *r.stats;
+        uint64_t decided = o.results[GAME_RESULT_BLACK] + o.results[GAME_RESULT_WHITE];
+        snprintf(buf, sizeof(buf), "%d,%s,%d,%s,%llu,%llu,%llu,%llu,%.4f\n", r.size, r.setup.c_str(), r.plies,
+            r.line.c_str(), (unsigned long long)o.games, (unsigned long long)o.results[GAME_RESULT_BLACK],
+            (unsigned long long)o.results[GAME_RESULT_WHITE], (unsigned long long)o.results[GAME_RESULT_UNFINISHED],
+            decided ? (double)o.results[GAME_RESULT_BLACK] / decided : 0.0);
+        out += buf;
+    }
+    return Tool_WriteFile(path.c_str(), out);
+}
+
+static bool WriteHeatmapCsv(const std::string &path, const AnalyticsAggregate &a)
+{
+    std::string out = "size,square,row,col,arrows,amazon_moves\n";
+    char buf[96];
+    for (int n = POSITION_MIN_SIDE; n <= POSITION_MAX_SIDE; ++n)
+    {
+        const SizeStats &s = a.sizes[n];
+        if (!s.games) continue;
+        for (int sq = 0; sq < n * n; ++sq)
+        {
+            std::string name;
+            Archive_AppendSquare(name, sq, n);
+            snprintf(buf, sizeof(buf), "%d,%s,%d,%d,%llu,%llu\n", n, name.c_str(), sq / n, sq % n,
+                (unsigned long long)s.arrows[sq], (unsigned long long)s.amazonTo[sq]);
+            out += buf;
+        }
+    }
+    return Tool_WriteFile(path.c_str(), out);
+}
+
+static bool WriteLengthsCsv(const std::string &path, const AnalyticsAggregate &a)
+{
+    std::string out = "size,moves,games\n";
+    char buf[64];
+    for (int n = POSITION_MIN_SIDE; n <= POSITION_MAX_SIDE; ++n)
+    {
+        const SizeStats &s = a.sizes[n];
+        for (int len = 0; len <= n * n; ++len)
+        {
+            if (!s.lengths[len]) continue;
+            snprintf(buf, sizeof(buf), "%d,%d,%llu\n", n, len, (unsigned long long)s.lengths[len]);
+            out += buf;
+        }
+    }
+    return Tool_WriteFile(path.c_str(), out);
+}
+
+static void AppendGrid(std::string &out, const uint64_t* counts, int n)
+{
+    char buf[32];
+    out += "[";
+    for (int r = 0; r < n; ++r)
+    {
+        out += r ? ",[" : "[";
+        for (int c = 0; c < n; ++c)
+        {
+            snprintf(buf, sizeof(buf), c ? ",%llu" : "%llu", (unsigned long long)counts[r * n + c]);
+            out += buf;
+        }
+        out += "]";
+    }
+    out += "]";
+}
+
+static bool WriteSummaryJson(const std::string &path, const AnalyticsAggregate &a, int threads, double seconds)
+{
+    uint64_t games = 0, moves = 0;
+    for (const SizeStats &s : a.sizes) { games += s.games; moves += s.moves; }
+    char buf[256];
+    snprintf(buf, sizeof(buf), "{\"games\":%llu,\"moves\":%llu,\"badRecords\":%llu,\"threads\":%d,\"seconds\":%.3f,"
+        "\"gamesPerSecond\":%.0f,\"sizes\":[", (unsigned long long)games, (unsigned long long)moves,
+        (unsigned long long)a.badRecords, threads, seconds, seconds > 0 ? games / seconds : 0.0);
+    std::string out = buf;
+    bool first = true;
+    for (int n = POSITION_MIN_SIDE; n <= POSITION_MAX_SIDE; ++n)
+    {
+        const SizeStats &s = a.sizes[n];
+        if (!s.games) continue;
+        snprintf(buf, sizeof(buf), "%s\n{\"size\":%d,\"games\":%llu,\"blackWins\":%llu,\"whiteWins\":%llu,"
+            "\"unfinished\":%llu,\"illegal\":%llu,\"meanMoves\":%.2f,\"arrows\":", first ? "" : ",", n,
+            (unsigned long long)s.games, (unsigned long long)s.results[GAME_RESULT_BLACK],
+            (unsigned long long)s.results[GAME_RESULT_WHITE], (unsigned long long)s.results[GAME_RESULT_UNFINISHED],
+            (unsigned long long)s.illegal, (double)s.moves / s.games);
+        out += buf;
+        AppendGrid(out, s.arrows, n);
+        out += ",\"amazonMoves\":";
+        AppendGrid(out, s.amazonTo, n);
+        out += "}";
+        first = false;
+    }
+    out += "\n]}\n";
+    return Tool_WriteFile(path.c_str(), out);
+}
+
+// analyze <outPrefix> <threads|0> <openingPlies>[:minGames] <in.amzb|in.pbn>...
+// Writes <outPrefix>.json (totals, results, heatmaps per board size), <outPrefix>-openings.csv,
+// <outPrefix>-heatmap.csv and <outPrefix>-lengths.csv.
+int Tool_Analyze(int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        fprintf(stderr, "usage: analyze <outPrefix> <threads|0> <openingPlies>[:minGames] <in.amzb|in.pbn>...\n");
+        return 1;
+    }
+    std::string prefix = argv[0];
+    int threads = atoi(argv[1]);
+    if (threads <= 0) threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    int openingPlies = atoi(argv[2]);
+    const char* colon = strchr(argv[2], ':');
+    uint64_t minGames = colon ? strtoull(colon + 1, nullptr, 10) : 1;
+
+    // map every input before starting: archives by their game index, anything else as .pbn text
+    struct Input { MappedFile file; std::vector<uint64_t> index; bool archive; };
+    std::vector<std::unique_ptr<Input>> inputs;
+    for (int i = 3; i < argc; ++i)
+    {
+        std::unique_ptr<Input> in(new Input());
+        ArchiveReader r;
+        in->archive = Archive_Open(r, argv[i]);
+        if (in->archive)
+        {
+            in->index = r.index;
+            Archive_Close(r);
+        }
+        if (!MappedFile_Open(in->file, std::string(argv[i])))
+        {
+            fprintf(stderr, "%s: cannot read\n", argv[i]);
+            for (auto &p : inputs) MappedFile_Close(p->file);
+            return 1;
+        }
+        inputs.push_back(std::move(in));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::unique_ptr<AnalyticsAggregate>> perWorker;
+    for (int t = 0; t < threads; ++t) perWorker.emplace_back(new AnalyticsAggregate());   // zeroed
+    std::atomic<uint64_t> decodeErrors(0);
+    ThreadPool* pool = ThreadPool_Create(threads);
+    for (auto &p : inputs)
+    {
+        const Input* in = p.get();
+        if (!in->archive)
+        {
+            ThreadPool_Submit(pool, [&perWorker, in, openingPlies](int worker) {
+                AnalyzePbn(*perWorker[(size_t)worker], in->file, openingPlies);
+            });
+            continue;
+        }
+        for (uint64_t first = 0; first < in->index.size(); first += kArchiveSlice)
+        {
+            uint64_t last = std::min<uint64_t>(first + kArchiveSlice, in->index.size());
+            ThreadPool_Submit(pool, [&perWorker, &decodeErrors, in, first, last, openingPlies](int worker) {
+                AnalyticsAggregate &a = *perWorker[(size_t)worker];
+                const uint8_t* data = (const uint8_t*)in->file.data;
+                ArchiveGame game;
+                for (uint64_t g = first; g < last; ++g)
+                {
+                    uint64_t at = in->index[(size_t)g];
+                    if (at >= in->file.size || !Archive_DecodeGame(data + at, (size_t)(in->file.size - at), game))
+                    {
+                        decodeErrors.fetch_add(1);
+                        continue;
+                    }
+                    AnalyzeGame(a, game, openingPlies);
+                }
+            });
+        }
+    }
+    ThreadPool_Destroy(pool);     // runs every task, then joins
+
+    AnalyticsAggregate &total = *perWorker[0];
+    for (size_t t = 1; t < perWorker.size(); ++t) Merge(total, *perWorker[t]);
+    total.badRecords += decodeErrors.load();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (auto &p : inputs) MappedFile_Close(p->file);
+
+    bool ok = WriteSummaryJson(prefix + ".json", total, threads, seconds)
+        && WriteOpeningsCsv(prefix + "-openings.csv", total, minGames)
+        && WriteHeatmapCsv(prefix + "-heatmap.csv", total)
+        && WriteLengthsCsv(prefix + "-lengths.csv", total);
+    if (!ok)
+    {
+        fprintf(stderr, "cannot write reports %s*\n", prefix.c_str());
+        return 1;
+    }
+    uint64_t games = 0, moves = 0;
+    for (const SizeStats &s : total.sizes) { games += s.games; moves += s.moves; }
+    printf("%llu games, %llu moves with %d threads in %.2f s: %.0f games/s, %.1f M moves/s; %llu bad records\n",
+        (unsigned long long)games, (unsigned long long)moves, threads, seconds, games / std::max(seconds, 1e-9),
+        moves / std::max(seconds, 1e-9) / 1e6, (unsigned long long)total.badRecords);
+    return total.badRecords ? 2 : 0;
+}
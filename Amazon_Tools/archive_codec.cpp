@@ -0,0 +1,549 @@
+#include "archive_codec.h"
+#include "board_geometry.h"
+#include "byte_io.h"
+#include "position.h"
+#include <cstring>
+
+static const char kFileMagic[4] = { 'A', 'M', 'Z', 'C' };
+static const char kTrailerMagic[4] = { 'A', 'M', 'Z', 'K' };
+static const int kHeaderSize = 8;
+static const int kBlockHeaderSize = 12;
+static const int kTrailerSize = 32;
+
+
+// ---- range coder (carry-propagating, 32-bit range, as in LZMA) ----
+
+struct RangeEncoder
+{
+    std::string* out;
+    uint64_t low = 0;
+    uint32_t range = 0xFFFFFFFFu;
+    uint8_t cache = 0;
+    uint64_t cacheSize = 1;
+
+    explicit RangeEncoder(std::string &o) : out(&o) {}
+
+    void ShiftLow()
+    {
+        if ((uint32_t)low < 0xFF000000u || (low >> 32) != 0)
+        {
+            uint8_t carry = (uint8_t)(low >> 32);
+            uint8_t temp = cache;
+            do
+            {
+                out->push_back((char)(uint8_t)(temp + carry));
+                temp = 0xFF;
+            } while (--cacheSize != 0);
+            cache = (uint8_t)(low >> 24);
+        }
+        ++cacheSize;
+        low = (low & 0x00FFFFFFu) << 8;
+    }
+
+    // total at most 1 << 16, so range / total keeps at least 8 bits
+    void Encode(uint32_t cum, uint32_t freq, uint32_t total)
+    {
+        uint32_t r = range / total;
+        low += (uint64_t)r * cum;
+        range = r * freq;
+        while (range < (1u << 24)) { range <<= 8; ShiftLow(); }
+    }
+
+    void Flush() { for (int i = 0; i < 5; ++i) ShiftLow(); }
+};
+
+struct RangeDecoder
+{
+    const uint8_t* p;
+    const uint8_t* end;
+    uint32_t range = 0xFFFFFFFFu;
+    uint32_t code = 0;
+    uint32_t step = 0;
+    bool overrun = false;
+
+    RangeDecoder(const uint8_t* data, size_t size) : p(data), end(data + size)
+    {
+        for (int i = 0; i < 5; ++i) code = (code << 8) | Next();
+    }
+
+    uint8_t Next()
+    {
+        if (p < end) return *p++;
+        overrun = true;
+        return 0;
+    }
+
+    uint32_t GetFreq(uint32_t total)
+    {
+        step = range / total;
+        uint32_t v = code / step;
+        return v < total ? v : total - 1;
+    }
+
+    void Decode(uint32_t cum, uint32_t freq)
+    {
+        code -= step * cum;
+        range = step * freq;
+        while (range < (1u << 24)) { range <<= 8; code = (code << 8) | Next(); }
+    }
+};
+
+// ---- adaptive frequency models over up to 16 symbols ----
+
+static const int kModelSymbols = 16;
+static const uint32_t kModelStep = 24;
+static const uint32_t kModelLimit = 1u << 13;
+
+struct Model
+{
+    uint16_t freq[kModelSymbols];
+    uint32_t total;
+    int symbols;
+
+    void Init(int n)
+    {
+        symbols = n;
+        for (int i = 0; i < kModelSymbols; ++i) freq[i] = i < n ? 1 : 0;
+        total = (uint32_t)n;
+    }
+
+    void Update(int s)
+    {
+        freq[s] = (uint16_t)(freq[s] + kModelStep);
+        total += kModelStep;
+        if (total <= kModelLimit) return;
+        total = 0;
+        for (int i = 0; i < symbols; ++i)
+        {
+            freq[i] = (uint16_t)((freq[i] + 1) >> 1);
+            total += freq[i];
+        }
+    }
+};
+
+// Only the symbols in 'mask' are possible; a lone possible symbol is implied and takes no bits.
+static void EncodeSymbol(RangeEncoder &rc, Model &m, uint32_t mask, int s)
+{
+    if (mask & (mask - 1))
+    {
+        // branch-free sums: which symbols are open is close to random from move to move
+        uint32_t cum = 0, total = 0;
+        for (int i = 0; i < m.symbols; ++i)
+        {
+            uint32_t f = m.freq[i] & (0u - ((mask >> i) & 1));
+            cum += f & (0u - (uint32_t)(i < s));
+            total += f;
+        }
+        rc.Encode(cum, m.freq[s], total);
+    }
+    m.Update(s);
+}
+
+static int DecodeSymbol(RangeDecoder &rc, Model &m, uint32_t mask)
+{
+    int s = 0;
+    if (mask & (mask - 1))
+    {
+        uint32_t open[kModelSymbols], total = 0;
+        for (int i = 0; i < m.symbols; ++i)
+        {
+            open[i] = m.freq[i] & (0u - ((mask >> i) & 1));
+            total += open[i];
+        }
+        uint32_t f = rc.GetFreq(total), cum = 0;
+        while (f >= cum + open[s]) cum += open[s++];
+        rc.Decode(cum, open[s]);
+    }
+    else
+    {
+        while (!((mask >> s) & 1)) ++s;
+    }
+    m.Update(s);
+    return s;
+}
+
+static void EncodeUniform(RangeEncoder &rc, uint32_t v, uint32_t count) { rc.Encode(v, 1, count); }
+
+static uint32_t DecodeUniform(RangeDecoder &rc, uint32_t count)
+{
+    uint32_t v = rc.GetFreq(count);
+    rc.Decode(v, 1);
+    return v;
+}
+
+// ---- games ----
+
+// symbols of the amazon model after the four slots
+enum { SLOT_END = POSITION_AMAZONS, SLOT_RAW, SLOT_SYMBOLS };
+
+struct CodecModels
+{
+    Model size, flags, slot, moveDir, moveDist[8], arrowDir, arrowDist[8];
+
+    CodecModels()
+    {
+        size.Init(POSITION_MAX_SIDE - POSITION_MIN_SIDE + 1);
+        flags.Init(8);
+        slot.Init(SLOT_SYMBOLS);
+        moveDir.Init(8);
+        arrowDir.Init(8);
+        for (int d = 0; d < 8; ++d)
+        {
+            moveDist[d].Init(POSITION_MAX_SIDE - 1);
+            arrowDist[d].Init(POSITION_MAX_SIDE - 1);
+        }
+    }
+};
+
+// Directions are coded in circular order (N, NE, E, SE, S, SW, W, NW) so that (arrow direction -
+// move direction) & 7 is the turn between them; kGeometryDir maps them to GEOMETRY_DIRS rays.
+static const int kGeometryDir[8] = { 0, 5, 3, 7, 1, 6, 2, 4 };
+
+// escape for a game whose next move is illegal: its remaining moves as raw squares
+static void EncodeRawMoves(RangeEncoder &rc, const ArchiveGame &g, size_t ply)
+{
+    uint32_t rest = (uint32_t)(g.moves.size() - ply);
+    for (int b = 0; b < 4; ++b) EncodeUniform(rc, (rest >> (8 * b)) & 0xFF, 256);
+    for (size_t i = ply; i < g.moves.size(); ++i)
+    {
+        EncodeUniform(rc, g.moves[i].from, 256);
+        EncodeUniform(rc, g.moves[i].to, 256);
+        EncodeUniform(rc, g.moves[i].arrow, 256);
+    }
+}
+
+static bool DecodeRawMoves(RangeDecoder &rc, ArchiveGame &g)
+{
+    uint32_t rest = 0;
+    for (int b = 0; b < 4; ++b) rest |= DecodeUniform(rc, 256) << (8 * b);
+    if (rest > (1u << 24) || rc.overrun) return false;
+    for (uint32_t i = 0; i < rest && !rc.overrun; ++i)
+    {
+        ArchiveMove am;
+        am.from = (uint8_t)DecodeUniform(rc, 256);
+        am.to = (uint8_t)DecodeUniform(rc, 256);
+        am.arrow = (uint8_t)DecodeUniform(rc, 256);
+        g.moves.push_back(am);
+    }
+    return !rc.overrun;
+}
+
+template <int N>
+struct CodecKernel
+{
+    // circular directions in which the square next to 'sq' is empty ('vacated' counting as empty)
+    static inline uint32_t OpenDirs(const Position &pos, int sq, int vacated)
+    {
+        const BoardGeometry<N> &geo = Geometry<N>::value;
+        uint32_t open = 0;
+        for (int d = 0; d < 8; ++d)
+        {
+            int g = kGeometryDir[d];
+            if (geo.rayLen[sq][g] && (pos.cell[geo.ray[sq][g][0]] == CELL_EMPTY || geo.ray[sq][g][0] == vacated))
+                open |= 1u << d;
+        }
+        return open;
+    }
+
+    // empty squares from 'sq' along circular direction d; only the chosen ray is ever walked
+    static inline int Walk(const Position &pos, int sq, int d, int vacated)
+    {
+        const BoardGeometry<N> &geo = Geometry<N>::value;
+        const uint8_t* ray = geo.ray[sq][kGeometryDir[d]];
+        int k = 0, end = geo.rayLen[sq][kGeometryDir[d]];
+        while (k < end && (pos.cell[ray[k]] == CELL_EMPTY || ray[k] == vacated)) ++k;
+        return k;
+    }
+
+    // slots of the side to move whose amazon can step somewhere (and so has a full move)
+    static inline uint32_t MovableSlots(const Position &pos)
+    {
+        const BoardGeometry<N> &geo = Geometry<N>::value;
+        const uint8_t* amazons = pos.amazon[pos.blackToMove ? 1 : 0];
+        uint32_t mask = 0;
+        for (int i = 0; i < POSITION_AMAZONS; ++i)
+        {
+            int sq = amazons[i];
+            for (int d = 0; d < GEOMETRY_DIRS; ++d)
+                if (geo.rayLen[sq][d] && pos.cell[geo.ray[sq][d][0]] == CELL_EMPTY) { mask |= 1u << i; break; }
+        }
+        return mask;
+    }
+
+    // circular direction and distance of a queen move (the squares are known to share a line)
+    static inline void Line(int from, int to, int &dir, int &dist)
+    {
+        static const int kIndex[3][3] = { { 7, 0, 1 }, { 6, -1, 2 }, { 5, 4, 3 } };
+        int dr = to / N - from / N, dc = to % N - from % N;
+        dir = kIndex[(dr > 0) - (dr < 0) + 1][(dc > 0) - (dc < 0) + 1];
+        int ar = dr < 0 ? -dr : dr, ac = dc < 0 ? -dc : dc;
+        dist = ar > ac ? ar : ac;
+    }
+
+    // the open directions as seen from direction 'base' (bit r = direction base + r)
+    static inline uint32_t Rotate(uint32_t open, int base)
+    {
+        return ((open >> base) | (open << (8 - base))) & 0xFF;
+    }
+
+    static void EncodeMoves(RangeEncoder &rc, CodecModels &m, Position &pos, const ArchiveGame &g)
+    {
+        const PositionKernels &k = Position_GetKernels(N);
+        for (size_t ply = 0; ; ++ply)
+        {
+            uint32_t slots = MovableSlots(pos) | 1u << SLOT_END | 1u << SLOT_RAW;
+            if (ply == g.moves.size())
+            {
+                EncodeSymbol(rc, m.slot, slots, SLOT_END);
+                return;
+            }
+            PosMove mv = { g.moves[ply].from, g.moves[ply].to, g.moves[ply].arrow };
+            int side = pos.blackToMove ? 1 : 0, slot = -1;
+            for (int i = 0; i < POSITION_AMAZONS; ++i) if (pos.amazon[side][i] == mv.from) slot = i;
+            if (slot < 0 || !Position_IsLegalMove(pos, mv))
+            {
+                EncodeSymbol(rc, m.slot, slots, SLOT_RAW);
+                EncodeRawMoves(rc, g, ply);
+                return;
+            }
+            EncodeSymbol(rc, m.slot, slots, slot);
+
+            int dir, dist, arrowDir, arrowDist;
+            Line(mv.from, mv.to, dir, dist);
+            EncodeSymbol(rc, m.moveDir, OpenDirs(pos, mv.from, -1), dir);
+            EncodeSymbol(rc, m.moveDist[dir], (1u << Walk(pos, mv.from, dir, -1)) - 1, dist - 1);
+
+            Line(mv.to, mv.arrow, arrowDir, arrowDist);
+            int turn = (arrowDir - dir) & 7;
+            EncodeSymbol(rc, m.arrowDir, Rotate(OpenDirs(pos, mv.to, mv.from), dir), turn);
+            EncodeSymbol(rc, m.arrowDist[turn], (1u << Walk(pos, mv.to, arrowDir, mv.from)) - 1, arrowDist - 1);
+            k.makeMove(pos, mv);
+        }
+    }
+
+    static bool DecodeMoves(RangeDecoder &rc, CodecModels &m, Position &pos, ArchiveGame &g)
+    {
+        const PositionKernels &k = Position_GetKernels(N);
+        const BoardGeometry<N> &geo = Geometry<N>::value;
+        for (;;)
+        {
+            // every move fills a square, so even a damaged stream ends once the board is full
+            if (rc.overrun) return false;
+            int slot = DecodeSymbol(rc, m.slot, MovableSlots(pos) | 1u << SLOT_END | 1u << SLOT_RAW);
+            if (slot == SLOT_END) return true;
+            if (slot == SLOT_RAW) return DecodeRawMoves(rc, g);
+
+            PosMove mv;
+            mv.from = pos.amazon[pos.blackToMove ? 1 : 0][slot];
+            int dir = DecodeSymbol(rc, m.moveDir, OpenDirs(pos, mv.from, -1));
+            int dist = 1 + DecodeSymbol(rc, m.moveDist[dir], (1u << Walk(pos, mv.from, dir, -1)) - 1);
+            mv.to = geo.ray[mv.from][kGeometryDir[dir]][dist - 1];
+
+            int turn = DecodeSymbol(rc, m.arrowDir, Rotate(OpenDirs(pos, mv.to, mv.from), dir));
+            int arrowDir = (dir + turn) & 7;
+            int arrowDist = 1 + DecodeSymbol(rc, m.arrowDist[turn], (1u << Walk(pos, mv.to, arrowDir, mv.from)) - 1);
+            mv.arrow = geo.ray[mv.to][kGeometryDir[arrowDir]][arrowDist - 1];
+
+            ArchiveMove am = { mv.from, mv.to, mv.arrow };
+            g.moves.push_back(am);
+            k.makeMove(pos, mv);
+        }
+    }
+};
+
+struct CodecKernels
+{
+    void (*encodeMoves)(RangeEncoder &rc, CodecModels &m, Position &pos, const ArchiveGame &g);
+    bool (*decodeMoves)(RangeDecoder &rc, CodecModels &m, Position &pos, ArchiveGame &g);
+};
+
+#define CODEC_KERNELS(n) { CodecKernel<n>::EncodeMoves, CodecKernel<n>::DecodeMoves }
+
+static const CodecKernels kCodecKernels[POSITION_MAX_SIDE - POSITION_MIN_SIDE + 1] = {
+    CODEC_KERNELS(4), CODEC_KERNELS(5), CODEC_KERNELS(6), CODEC_KERNELS(7),
+    CODEC_KERNELS(8), CODEC_KERNELS(9), CODEC_KERNELS(10), CODEC_KERNELS(11),
+    CODEC_KERNELS(12), CODEC_KERNELS(13), CODEC_KERNELS(14), CODEC_KERNELS(15),
+    CODEC_KERNELS(16) };
+
+static bool EncodeGame(RangeEncoder &rc, CodecModels &m, const ArchiveGame &g)
+{
+    int n = g.boardSize;
+    if (n < POSITION_MIN_SIDE || n > POSITION_MAX_SIDE) return false;
+    if (g.setup.custom && !Position_IsValidSetup(n, g.setup)) return false;
+    EncodeSymbol(rc, m.size, 0xFFFF, n - POSITION_MIN_SIDE);
+    int flags = (g.opponentIsAI ? 1 : 0) | (g.aiFirst ? 2 : 0) | (g.setup.custom ? 4 : 0);
+    EncodeSymbol(rc, m.flags, 0xFF, flags);
+    if (g.setup.custom)
+        for (int i = 0; i < 2 * POSITION_AMAZONS; ++i) EncodeUniform(rc, (&g.setup.square[0][0])[i], (uint32_t)(n * n));
+
+    // replayed on the board Position_InitSetup builds, as every other consumer of the archive does
+    Position pos;
+    Position_InitSetup(pos, n, g.setup);
+    kCodecKernels[pos.size - POSITION_MIN_SIDE].encodeMoves(rc, m, pos, g);
+    return true;
+}
+
+static bool DecodeGame(RangeDecoder &rc, CodecModels &m, ArchiveGame &g)
+{
+    int n = POSITION_MIN_SIDE + DecodeSymbol(rc, m.size, 0xFFFF);
+    int flags = DecodeSymbol(rc, m.flags, 0xFF);
+    g.boardSize = n;
+    g.opponentIsAI = (flags & 1) != 0;
+    g.aiFirst = (flags & 2) != 0;
+    g.setup = PositionSetup();
+    g.setup.custom = (flags & 4) != 0;
+    if (g.setup.custom)
+        for (int i = 0; i < 2 * POSITION_AMAZONS; ++i) (&g.setup.square[0][0])[i] = (uint8_t)DecodeUniform(rc, (uint32_t)(n * n));
+    g.moves.clear();
+    if (g.setup.custom && !Position_IsValidSetup(n, g.setup)) return false;
+
+    Position pos;
+    Position_InitSetup(pos, n, g.setup);
+    return kCodecKernels[pos.size - POSITION_MIN_SIDE].decodeMoves(rc, m, pos, g);
+}
+
+bool Codec_EncodeBlock(const ArchiveGame* games, size_t count, std::string &out)
+{
+    size_t start = out.size();
+    RangeEncoder rc(out);
+    CodecModels models;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!EncodeGame(rc, models, games[i]))
+        {
+            out.resize(start);
+            return false;
+        }
+    }
+    rc.Flush();
+    return true;
+}
+
+bool Codec_DecodeBlock(const uint8_t* data, size_t size, size_t count, std::vector<ArchiveGame> &out)
+{
+    // games are appended one at a time, so a damaged count runs out of payload instead of memory
+    out.clear();
+    RangeDecoder rc(data, size);
+    CodecModels models;
+    for (size_t i = 0; i < count && !rc.overrun; ++i)
+    {
+        out.emplace_back();
+        if (!DecodeGame(rc, models, out.back())) return false;
+    }
+    return !rc.overrun && out.size() == count;
+}
+
+// ---- files ----
+
+uint32_t Codec_Crc32(const uint8_t* data, size_t size)
+{
+    struct Table
+    {
+        uint32_t v[256];
+        Table()
+        {
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                v[i] = c;
+            }
+        }
+    };
+    static const Table table;
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) crc = table.v[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+bool CodecWriter_Create(CodecWriter &w, const std::string &path)
+{
+    w.file = ByteIO_OpenFile(path, "wb");
+    if (!w.file) return false;
+    w.index.clear();
+    w.games = 0;
+    uint8_t hdr[kHeaderSize] = {};
+    memcpy(hdr, kFileMagic, 4);
+    ByteIO_PutU16(hdr + 4, ARCHIVE_CODEC_VERSION);
+    if (fwrite(hdr, 1, sizeof(hdr), w.file) != sizeof(hdr)) { fclose(w.file); w.file = nullptr; return false; }
+    w.offset = sizeof(hdr);
+    return true;
+}
+
+bool CodecWriter_AppendBlock(CodecWriter &w, const std::string &payload, uint32_t games)
+{
+    if (!w.file) return false;
+    uint8_t hdr[kBlockHeaderSize];
+    ByteIO_PutU32(hdr, games);
+    ByteIO_PutU32(hdr + 4, (uint32_t)payload.size());
+    ByteIO_PutU32(hdr + 8, Codec_Crc32((const uint8_t*)payload.data(), payload.size()));
+    if (fwrite(hdr, 1, sizeof(hdr), w.file) != sizeof(hdr)
+        || fwrite(payload.data(), 1, payload.size(), w.file) != payload.size()) return false;
+    w.index.push_back(w.offset);
+    w.index.push_back(w.games);
+    w.offset += sizeof(hdr) + payload.size();
+    w.games += games;
+    return true;
+}
+
+bool CodecWriter_Finish(CodecWriter &w)
+{
+    if (!w.file) return false;
+    std::vector<uint8_t> tail(w.index.size() * 8 + kTrailerSize);
+    for (size_t i = 0; i < w.index.size(); ++i) ByteIO_PutU64(&tail[i * 8], w.index[i]);
+    uint8_t* t = &tail[w.index.size() * 8];
+    ByteIO_PutU64(t, w.offset);
+    ByteIO_PutU64(t + 8, w.index.size() / 2);
+    ByteIO_PutU64(t + 16, w.games);
+    memcpy(t + 24, kTrailerMagic, 4);
+    bool ok = fwrite(tail.data(), 1, tail.size(), w.file) == tail.size();
+    ok = (fclose(w.file) == 0) && ok;
+    w.file = nullptr;
+    return ok;
+}
+
+bool CodecReader_Open(CodecReader &r, const std::string &path)
+{
+    r.blocks.clear();
+    r.gameCount = 0;
+    if (!MappedFile_Open(r.file, path)) return false;
+    const uint8_t* d = (const uint8_t*)r.file.data;
+    size_t size = r.file.size;
+    bool ok = size >= (size_t)(kHeaderSize + kTrailerSize) && memcmp(d, kFileMagic, 4) == 0
+        && ByteIO_GetU16(d + 4) == ARCHIVE_CODEC_VERSION && memcmp(d + size - kTrailerSize + 24, kTrailerMagic, 4) == 0;
+    if (ok)
+    {
+        const uint8_t* t = d + size - kTrailerSize;
+        uint64_t indexOffset = ByteIO_GetU64(t), blocks = ByteIO_GetU64(t + 8);
+        r.gameCount = ByteIO_GetU64(t + 16);
+        // the index fills the space before the trailer, and the blocks count the games in order
+        ok = indexOffset <= size - kTrailerSize && blocks == (size - kTrailerSize - indexOffset) / 16
+            && (size - kTrailerSize - indexOffset) % 16 == 0;
+        uint64_t games = 0;
+        for (uint64_t b = 0; ok && b < blocks; ++b)
+        {
+            uint64_t at = ByteIO_GetU64(d + indexOffset + b * 16);
+            ok = at >= (uint64_t)kHeaderSize && at + kBlockHeaderSize <= indexOffset;
+            if (!ok) break;
+            CodecBlock blk;
+            blk.firstGame = ByteIO_GetU64(d + indexOffset + b * 16 + 8);
+            blk.games = ByteIO_GetU32(d + at);
+            blk.size = ByteIO_GetU32(d + at + 4);
+            blk.crc = ByteIO_GetU32(d + at + 8);
+            blk.payload = d + at + kBlockHeaderSize;
+            ok = at + kBlockHeaderSize + blk.size <= indexOffset && blk.firstGame == games;
+            games += blk.games;
+            r.blocks.push_back(blk);
+        }
+        ok = ok && games == r.gameCount;
+    }
+    if (!ok) CodecReader_Close(r);
+    return ok;
+}
+
+void CodecReader_Close(CodecReader &r)
+{
+    MappedFile_Close(r.file);
+    r.blocks.clear();
+    r.gameCount = 0;
+}
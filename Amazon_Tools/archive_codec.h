@@ -0,0 +1,76 @@
+#pragma once
+
+// Entropy-coded game archive (.amzc) for cold storage of large game collections.
+//
+// Moves are not stored as squares but as choices the rules leave open: which of the side's movable
+// amazons moved, the direction and distance of its queen move among the open rays, and the arrow's
+// direction (relative to the move) and distance among the rays open from the destination. That is
+// the move's rank in the generator's ray order, split into parts so each part gets its own adaptive
+// frequency model (distances per direction, arrow distances per relative direction). The parts are
+// range coded; impossible choices get no probability, so a forced move costs nothing and a game's
+// end is one symbol. Games with an illegal move fall back to raw squares from that move on.
+//
+// Games are coded in blocks with fresh models, so every block decodes on its own and blocks can be
+// decoded in parallel. Each payload carries a CRC-32, checked before it is decoded, because a
+// flipped bit inside it would otherwise still decode to (different) legal games.
+//
+// Layout (little-endian):
+//   header   "AMZC", u16 version, u16 reserved
+//   blocks   u32 games, u32 payload bytes, u32 payload CRC-32 (IEEE), payload
+//   index    per block: u64 file offset, u64 index of its first game
+//   trailer  u64 index offset, u64 block count, u64 game count, "AMZK", u32 reserved
+
+#include "game_archive.h"
+#include "mapped_file.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define ARCHIVE_CODEC_VERSION 2
+
+// Codes 'count' games as one block payload, appended to 'out'. False if a game has a board size
+// or custom setup the position kernels cannot replay (it must stay in .amzb then).
+bool Codec_EncodeBlock(const ArchiveGame* games, size_t count, std::string &out);
+// CRC-32 (IEEE 802.3, as zlib computes it) of a block payload.
+uint32_t Codec_Crc32(const uint8_t* data, size_t size);
+// Decodes a block payload of 'count' games into 'out' (replacing its contents); false if damaged.
+bool Codec_DecodeBlock(const uint8_t* data, size_t size, size_t count, std::vector<ArchiveGame> &out);
+
+struct CodecWriter
+{
+    FILE* file = nullptr;
+    uint64_t offset = 0;
+    uint64_t games = 0;
+    std::vector<uint64_t> index;    // offset, first game per block
+};
+
+bool CodecWriter_Create(CodecWriter &w, const std::string &path);
+bool CodecWriter_AppendBlock(CodecWriter &w, const std::string &payload, uint32_t games);
+// writes index and trailer and closes the file
+bool CodecWriter_Finish(CodecWriter &w);
+
+struct CodecBlock
+{
+    uint64_t firstGame;
+    uint32_t games;
+    const uint8_t* payload;     // inside the mapping
+    uint32_t size;
+    uint32_t crc;
+};
+
+struct CodecReader
+{
+    MappedFile file;
+    uint64_t gameCount = 0;
+    std::vector<CodecBlock> blocks;
+};
+
+// maps the file and reads the block table; blocks are then decoded straight from the mapping
+bool CodecReader_Open(CodecReader &r, const std::string &path);
+void CodecReader_Close(CodecReader &r);
+inline bool CodecReader_ReadBlock(const CodecReader &r, size_t block, std::vector<ArchiveGame> &out)
+{
+    const CodecBlock &b = r.blocks[block];
+    return Codec_Crc32(b.payload, b.size) == b.crc && Codec_DecodeBlock(b.payload, b.size, b.games, out);
+}
@@ -0,0 +1,220 @@
+// archive_tools.cpp : converters between .pbn game records and the binary .amzb archive.
+//
+
+#include "tools.h"
+#include "game_archive.h"
+#include "mapped_file.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+struct PackState
+{
+    ArchiveWriter* writer;
+    ArchiveGame game;
+    int badLine;
+    bool writeError;
+    int games;
+};
+
+static bool OnPackGameBegin(void* user, const PbnGameInfo &info)
+{
+    PackState* st = (PackState*)user;
+    st->game = ArchiveGame();
+    st->game.boardSize = info.boardSize;
+    st->game.opponentIsAI = info.opponentIsAI;
+    st->game.aiFirst = info.aiFirst;
+    st->game.setup = info.setup;
+    return true;
+}
+
+static bool OnPackMove(void* user, const PbnMove &mv)
+{
+    PackState* st = (PackState*)user;
+    ArchiveMove m;
+    if (!Archive_MoveFromPbn(mv, st->game.boardSize, m))
+    {
+        st->badLine = mv.line;
+        return false;
+    }
+    st->game.moves.push_back(m);
+    return true;
+}
+
+static void OnPackGameEnd(void* user, const PbnGameInfo &, int)
+{
+    PackState* st = (PackState*)user;
+    if (!Archive_AppendGame(*st->writer, st->game)) st->writeError = true;
+    else ++st->games;
+}
+
+// pbn2bin <out.amzb> <in.pbn>...   (each input may hold several concatenated games)
+int Tool_PbnToArchive(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: pbn2bin <out.amzb> <in.pbn>...\n");
+        return 1;
+    }
+    ArchiveWriter w;
+    if (!Archive_Create(w, argv[0]))
+    {
+        fprintf(stderr, "cannot create %s\n", argv[0]);
+        return 1;
+    }
+    int failed = 0, games = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        MappedFile file;
+        if (!MappedFile_Open(file, std::string(argv[i])))
+        {
+            fprintf(stderr, "%s: cannot read\n", argv[i]);
+            ++failed;
+            continue;
+        }
+        PackState st;
+        st.writer = &w;
+        st.badLine = 0;
+        st.writeError = false;
+        st.games = 0;
+        PbnCallbacks cb;
+        cb.user = &st;
+        cb.onGameBegin = OnPackGameBegin;
+        cb.onMove = OnPackMove;
+        cb.onGameEnd = OnPackGameEnd;
+        int errLine = 0;
+        Pbn_Parse(file.data, file.size, cb, &errLine);
+        MappedFile_Close(file);
+        if (st.badLine == 0) st.badLine = errLine;
+        games += st.games;
+        if (st.writeError)
+        {
+            fprintf(stderr, "write error\n");
+            Archive_Finish(w);
+            return 1;
+        }
+        if (st.badLine)
+        {
+            // games before the bad line are kept; the damaged one is dropped
+            fprintf(stderr, "%s:%d: malformed move\n", argv[i], st.badLine);
+            ++failed;
+        }
+    }
+    if (!Archive_Finish(w))
+    {
+        fprintf(stderr, "write error\n");
+        return 1;
+    }
+    printf("%d games written, %d inputs with errors\n", games, failed);
+    return failed ? 2 : 0;
+}
+
+// bin2pbn <in.amzb> <game index> <out.pbn>
+int Tool_ArchiveToPbn(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: bin2pbn <in.amzb> <game index> <out.pbn>\n");
+        return 1;
+    }
+    ArchiveReader r;
+    if (!Archive_Open(r, argv[0]))
+    {
+        fprintf(stderr, "%s: not a game archive\n", argv[0]);
+        return 1;
+    }
+    ArchiveGame game;
+    uint64_t idx = strtoull(argv[1], nullptr, 10);
+    bool ok = Archive_ReadGame(r, idx, game);
+    Archive_Close(r);
+    if (!ok)
+    {
+        fprintf(stderr, "game %s not found\n", argv[1]);
+        return 1;
+    }
+    std::string text;
+    Archive_GameToPbn(game, text);
+    if (!Tool_WriteFile(argv[2], text))
+    {
+        fprintf(stderr, "cannot write %s\n", argv[2]);
+        return 1;
+    }
+    return 0;
+}
+
+// archive-info <in.amzb>
+int Tool_ArchiveInfo(int argc, char** argv)
+{
+    if (argc < 1)
+    {
+        fprintf(stderr, "usage: archive-info <in.amzb>\n");
+        return 1;
+    }
+    ArchiveReader r;
+    if (!Archive_Open(r, argv[0]))
+    {
+        fprintf(stderr, "%s: not a game archive\n", argv[0]);
+        return 1;
+    }
+    uint64_t moves = 0;
+    ArchiveGame game;
+    for (uint64_t i = 0; i < r.gameCount; ++i)
+    {
+        if (Archive_ReadGame(r, i, game)) moves += game.moves.size();
+    }
+    printf("games: %llu  moves: %llu\n", (unsigned long long)r.gameCount, (unsigned long long)moves);
+    Archive_Close(r);
+    return 0;
+}
+
+static bool OnCountMove(void* user, const PbnMove &mv)
+{
+    // touch the decoded squares so the parse cannot be optimised away
+    *(unsigned long long*)user += (unsigned long long)(mv.fromRow + mv.toCol + mv.arrowRow + 1);
+    return true;
+}
+
+static void OnCountGame(void* user, const PbnGameInfo &, int)
+{
+    *((unsigned long long*)user + 1) += 1;
+}
+
+// pbn-bench <in.pbn> [passes]
+int Tool_PbnBench(int argc, char** argv)
+{
+    if (argc < 1)
+    {
+        fprintf(stderr, "usage: pbn-bench <in.pbn> [passes]\n");
+        return 1;
+    }
+    int passes = (argc > 1) ? atoi(argv[1]) : 5;
+    if (passes <= 0) passes = 1;
+    MappedFile file;
+    if (!MappedFile_Open(file, std::string(argv[0])))
+    {
+        fprintf(stderr, "%s: cannot read\n", argv[0]);
+        return 1;
+    }
+    unsigned long long counters[2] = { 0, 0 };
+    PbnCallbacks cb;
+    cb.user = counters;
+    cb.onMove = OnCountMove;
+    cb.onGameEnd = OnCountGame;
+    int errLine = 0;
+    bool ok = true;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < passes && ok; ++i) ok = Pbn_Parse(file.data, file.size, cb, &errLine);
+    auto t1 = std::chrono::steady_clock::now();
+    double sec = std::chrono::duration<double>(t1 - t0).count();
+    double mb = (double)file.size * passes / (1024.0 * 1024.0);
+    MappedFile_Close(file);
+    if (!ok)
+    {
+        fprintf(stderr, "%s:%d: malformed move\n", argv[0], errLine);
+        return 2;
+    }
+    printf("%llu games per pass, %.1f MB parsed in %.3f s: %.1f MB/s\n",
+        counters[1] / passes, mb, sec, sec > 0 ? mb / sec : 0.0);
+    return 0;
+}
@@ -0,0 +1,64 @@
+// bench_board.cpp : move generation and evaluation throughput versus board size.
+//
+
+#include "tools.h"
+#include "eval.h"
+#include "position.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+struct BoardBench
+{
+    long long positions = 0, moves = 0;
+    double genNs = 0.0, evalNs = 0.0;
+    long long evalSum = 0;   // identical for every evaluator build (see EVAL_BITBOARD_MIN_SIDE)
+};
+
+// random playouts from the standard setup; every position reached is generated and evaluated once
+static void BenchSize(int size, int games, std::mt19937 &rng, BoardBench &out)
+{
+    const PositionKernels &k = Position_GetKernels(size);
+    EvalFunc evaluate = Eval_GetTerritoryKernel(size);
+    std::vector<PosMove> list;
+    for (int g = 0; g < games; ++g)
+    {
+        Position pos;
+        Position_Init(pos, size);
+        for (;;)
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            k.generateMoves(pos, list);
+            auto t1 = std::chrono::steady_clock::now();
+            out.evalSum += evaluate(pos);
+            auto t2 = std::chrono::steady_clock::now();
+            out.genNs += std::chrono::duration<double, std::nano>(t1 - t0).count();
+            out.evalNs += std::chrono::duration<double, std::nano>(t2 - t1).count();
+            ++out.positions;
+            out.moves += (long long)list.size();
+            if (list.empty()) break;
+            k.makeMove(pos, list[rng() % list.size()]);
+        }
+    }
+}
+
+int Tool_BenchBoard(int argc, char** argv)
+{
+    int games = (argc > 0) ? atoi(argv[0]) : 20;
+    if (games <= 0) games = 1;
+
+    std::mt19937 rng(12345);
+    printf("games per size: %d\n", games);
+    printf("size  positions  avg moves  movegen Mmoves/s  eval k/s  eval sum\n");
+    for (int size = POSITION_MIN_SIDE; size <= POSITION_MAX_SIDE; ++size)
+    {
+        if (!Position_HasStandardSetup(size)) continue;
+        BoardBench b;
+        BenchSize(size, games, rng, b);
+        printf("%4d  %9lld  %9.1f  %16.1f  %8.1f  %lld\n", size, b.positions, (double)b.moves / b.positions,
+            b.genNs > 0 ? b.moves * 1e3 / b.genNs : 0.0, b.evalNs > 0 ? b.positions * 1e6 / b.evalNs : 0.0, b.evalSum);
+    }
+    return 0;
+}
@@ -0,0 +1,88 @@
+// bench_endgame.cpp : df-pn endgame solver times on a fixed suite of 10x10 endgames.
+//
+// The suite is generated, not stored: games from the standard setup where each side plays the best
+// of a few random moves by the territory evaluation, stopped at the first position with at most
+// 'empty' reachable empty squares. The generator is seeded, so every run sees the same positions.
+
+#include "tools.h"
+#include "dfpn.h"
+#include "engine.h"
+#include "eval.h"
+#include "position.h"
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+static bool NextEndgame(std::mt19937 &rng, int maxEmpty, Position &out, int &ply)
+{
+    const PositionKernels &k = Position_GetKernels(10);
+    EvalFunc evaluate = Eval_GetTerritoryKernel(10);
+    std::vector<PosMove> moves;
+    Position pos;
+    Position_Init(pos, 10);
+    for (ply = 0; ; ++ply)
+    {
+        DfpnRegions regions;
+        Dfpn_AnalyzeRegions(pos, regions);
+        if (regions.reachableEmpty <= maxEmpty)
+        {
+            out = pos;
+            return true;
+        }
+        k.generateMoves(pos, moves);
+        if (moves.empty()) return false;
+        // best of four random candidates for the mover (lowest score for the opponent)
+        PosMove best = moves[rng() % moves.size()];
+        int bestScore = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            PosMove m = (i == 0) ? best : moves[rng() % moves.size()];
+            k.makeMove(pos, m);
+            int score = evaluate(pos);
+            k.unmakeMove(pos, m);
+            if (i == 0 || score < bestScore) { best = m; bestScore = score; }
+        }
+        k.makeMove(pos, best);
+    }
+}
+
+int Tool_BenchEndgame(int argc, char** argv)
+{
+    int count = (argc > 0) ? atoi(argv[0]) : 20;
+    uint64_t maxNodes = (argc > 1) ? strtoull(argv[1], nullptr, 10) : 2000000;
+    int maxEmpty = (argc > 2) ? atoi(argv[2]) : 30;
+    if (count <= 0) count = 1;
+
+    std::mt19937 rng(2024);
+    DfpnSolver* solver = Dfpn_Create(256);
+    DfpnLimits limits;
+    limits.maxNodes = maxNodes;
+    printf("suite: %d endgames with <= %d reachable empty squares, %llu node budget\n", count, maxEmpty,
+        (unsigned long long)maxNodes);
+    printf("  #  ply  empty  shared  result   nodes       ms  move\n");
+    int solved = 0;
+    uint64_t totalNodes = 0;
+    double totalMs = 0.0;
+    for (int i = 0; i < count; )
+    {
+        Position pos;
+        int ply;
+        if (!NextEndgame(rng, maxEmpty, pos, ply)) continue;
+        DfpnRegions regions;
+        Dfpn_AnalyzeRegions(pos, regions);
+        Dfpn_Clear(solver);
+        DfpnResult r;
+        if (Dfpn_Solve(solver, pos, limits, r)) ++solved;
+        totalNodes += r.nodes;
+        totalMs += r.timeMs;
+        static const char* const kOutcome[3] = { "unknown", "win", "loss" };
+        printf("%3d  %3d  %5d  %6d  %-7s  %8llu  %7.1f  %s\n", i, ply, regions.reachableEmpty, regions.sharedEmpty,
+            kOutcome[r.outcome], (unsigned long long)r.nodes, r.timeMs, r.hasMove ? Engine_MoveToString(pos, r.move).c_str() : "");
+        ++i;
+    }
+    printf("solved %d/%d  nodes %llu  time %.1f ms  %.0f kN/s\n", solved, count, (unsigned long long)totalNodes,
+        totalMs, totalMs > 0 ? totalNodes / totalMs : 0.0);
+    Dfpn_Destroy(solver);
+    return 0;
+}
@@ -0,0 +1,183 @@
+// bench_eval.cpp : incremental territory evaluation (eval.h) against full recomputation.
+//
+// Builds a corpus of positions from engine self-play games, then evaluates every child of every
+// corpus position twice: by making the move and running the full territory kernel, and by updating
+// the parent's EvalState with the move. Both passes must agree on every score. A third pass scores
+// the same children with Eval_Children, once per position and once per amazon (the batch the GUI's
+// hint heatmap asks for), and reports the slowest amazon.
+
+#include "tools.h"
+#include "engine.h"
+#include "eval.h"
+#include "position.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+// self-play games from short random openings; every position before a move is kept
+static void BuildCorpus(int games, int size, uint64_t nodes, std::vector<Position> &out)
+{
+    std::mt19937 rng(4242);
+    Engine* engine = Engine_Create(16);
+    std::vector<PosMove> moves;
+    for (int g = 0; g < games; ++g)
+    {
+        Position pos;
+        Position_Init(pos, size);
+        Engine_Clear(engine);
+        for (int ply = 0; ; ++ply)
+        {
+            Position_GenerateMoves(pos, moves);
+            if (moves.empty()) break;
+            out.push_back(pos);
+            PosMove m;
+            if (ply < 4)
+            {
+                m = moves[rng() % moves.size()];
+            }
+            else
+            {
+                SearchLimits limits;
+                limits.timeMs = 0;
+                limits.maxNodes = nodes;
+                SearchResult result;
+                if (!Engine_Search(engine, pos, limits, result) || !result.hasMove) break;
+                m = result.best;
+            }
+            Position_MakeMove(pos, m);
+        }
+    }
+    Engine_Destroy(engine);
+}
+
+static double MsSince(std::chrono::steady_clock::time_point t)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count();
+}
+
+// bench-eval [games] [size] [nodes]
+int Tool_BenchEval(int argc, char** argv)
+{
+    int games = (argc > 0) ? atoi(argv[0]) : 8;
+    int size = (argc > 1) ? atoi(argv[1]) : 10;
+    uint64_t nodes = (argc > 2) ? strtoull(argv[2], nullptr, 10) : 5000;
+    if (games <= 0) games = 1;
+    if (!Position_HasStandardSetup(size))
+    {
+        fprintf(stderr, "no standard setup for size %d\n", size);
+        return 1;
+    }
+
+    std::vector<Position> corpus;
+    BuildCorpus(games, size, nodes, corpus);
+    const PositionKernels &k = Position_GetKernels(size);
+    EvalFunc full = Eval_GetTerritoryKernel(size);
+    const EvalKernels &inc = Eval_GetIncrementalKernels(size);
+
+    std::vector<std::vector<PosMove>> children(corpus.size());
+    uint64_t evals = 0;
+    for (size_t i = 0; i < corpus.size(); ++i)
+    {
+        k.generateMoves(corpus[i], children[i]);
+        evals += children[i].size();
+    }
+    printf("%d games, %zu positions, %llu child evaluations per pass\n", games, corpus.size(), (unsigned long long)evals);
+
+    std::unique_ptr<EvalState> parent(new EvalState()), child(new EvalState());
+    long long fullSum = 0, incSum = 0;
+    uint64_t mismatches = 0, overflows = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < corpus.size(); ++i)
+    {
+        Position pos = corpus[i];
+        for (const PosMove &m : children[i])
+        {
+            k.makeMove(pos, m);
+            fullSum += full(pos);
+            k.unmakeMove(pos, m);
+        }
+    }
+    double fullMs = MsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < corpus.size(); ++i)
+    {
+        inc.init(corpus[i], *parent);
+        for (const PosMove &m : children[i])
+        {
+            inc.update(*parent, m, *child);
+            if (child->overflow)
+            {
+                // rare; keeps the sums comparable
+                ++overflows;
+                Position pos = corpus[i];
+                k.makeMove(pos, m);
+                incSum += full(pos);
+                continue;
+            }
+            incSum += inc.score(*child);
+        }
+    }
+    double incMs = MsSince(start);
+
+    // batched scores are from the side making the move, the negated child scores
+    std::vector<int> scores;
+    long long batchSum = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < corpus.size(); ++i)
+    {
+        scores.resize(children[i].size());
+        inc.children(corpus[i], children[i].data(), (int)children[i].size(), scores.data());
+        for (int s : scores) batchSum -= s;
+    }
+    double batchMs = MsSince(start);
+
+    double amazonMs = 0.0, slowestMs = 0.0;
+    uint64_t amazons = 0;
+    for (size_t i = 0; i < corpus.size(); ++i)
+    {
+        const std::vector<PosMove> &moves = children[i];
+        for (size_t first = 0, last; first < moves.size(); first = last)
+        {
+            for (last = first; last < moves.size() && moves[last].from == moves[first].from; ++last) {}
+            auto t = std::chrono::steady_clock::now();
+            inc.children(corpus[i], &moves[first], (int)(last - first), scores.data());
+            double ms = MsSince(t);
+            amazonMs += ms;
+            slowestMs = std::max(slowestMs, ms);
+            ++amazons;
+        }
+    }
+
+    // separate pass so the timings above do not include the check
+    for (size_t i = 0; i < corpus.size(); ++i)
+    {
+        Position pos = corpus[i];
+        inc.init(pos, *parent);
+        scores.resize(children[i].size());
+        inc.children(pos, children[i].data(), (int)children[i].size(), scores.data());
+        for (size_t j = 0; j < children[i].size(); ++j)
+        {
+            const PosMove &m = children[i][j];
+            inc.update(*parent, m, *child);
+            k.makeMove(pos, m);
+            int expected = full(pos);
+            if (!child->overflow && inc.score(*child) != expected) ++mismatches;
+            if (scores[j] != -expected) ++mismatches;
+            k.unmakeMove(pos, m);
+        }
+    }
+
+    printf("full recomputation: %10.0f evals/s (%.1f ms)\n", evals * 1000.0 / fullMs, fullMs);
+    printf("incremental:        %10.0f evals/s (%.1f ms, %.2fx)\n", evals * 1000.0 / incMs, incMs, fullMs / incMs);
+    printf("batched:            %10.0f evals/s (%.1f ms, %.2fx)\n", evals * 1000.0 / batchMs, batchMs, fullMs / batchMs);
+    printf("per amazon:         %.3f ms mean, %.3f ms slowest over %llu amazons\n", amazonMs / std::max<uint64_t>(amazons, 1),
+        slowestMs, (unsigned long long)amazons);
+    printf("score sums %lld / %lld / %lld, mismatches %llu, overflows %llu\n", fullSum, incSum, batchSum,
+        (unsigned long long)mismatches, (unsigned long long)overflows);
+    return (mismatches == 0 && fullSum == incSum && fullSum == batchSum) ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+// bench_seek.cpp : random history seeks on long games, checkpointed seek vs. move-by-move walk.
+//
+
+#include "tools.h"
+#include "game.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// play random legal moves on a 10x10 board until the side to move is stuck
+static int PlayRandomGame(std::mt19937 &rng)
+{
+    Game_Init(10, false, 1, false);
+    for (;;)
+    {
+        bool blackToMove = Game_IsBlackToMove();
+        std::vector<GamePiece> mine;
+        for (const auto &p : Game_GetPieces()) if (p.isWhite != blackToMove) mine.push_back(p);
+        std::shuffle(mine.begin(), mine.end(), rng);
+        bool moved = false;
+        for (const auto &p : mine)
+        {
+            auto moves = Game_GetLegalMoves(p.row, p.col);
+            std::shuffle(moves.begin(), moves.end(), rng);
+            for (const auto &mv : moves)
+            {
+                auto arrows = Game_GetLegalArrows(p.row, p.col, mv.first, mv.second);
+                if (arrows.empty()) continue;
+                const auto &a = arrows[rng() % arrows.size()];
+                Game_MakeMove(p.row, p.col, mv.first, mv.second, a.first, a.second);
+                moved = true;
+                break;
+            }
+            if (moved) break;
+        }
+        if (!moved) break;
+    }
+    return Game_GetTotalMoves();
+}
+
+// reference: step through the move log one move at a time
+static void WalkToMove(int target)
+{
+    while (Game_GetCurrentMoveIndex() > target) Game_StepBackward();
+    while (Game_GetCurrentMoveIndex() < target && Game_CanStepForward()) Game_StepForward();
+}
+
+static unsigned long long PositionChecksum()
+{
+    unsigned long long h = Game_IsBlackToMove() ? 1 : 0;
+    int n = Game_GetBoardSize();
+    for (int r = 0; r < n; ++r)
+        for (int c = 0; c < n; ++c)
+            h = h * 31 + (Game_IsOccupied(r, c) ? (Game_GetPieceAt(r, c) ? 2 : 1) : 0);
+    return h;
+}
+
+int Tool_BenchSeek(int argc, char** argv)
+{
+    int games = (argc > 0) ? atoi(argv[0]) : 20;
+    int seeks = (argc > 1) ? atoi(argv[1]) : 20000;
+    if (games <= 0) games = 1;
+    if (seeks <= 0) seeks = 1;
+
+    std::mt19937 rng(12345);
+    double walkNs = 0.0, seekNs = 0.0;
+    long long totalMoves = 0, mismatches = 0;
+    for (int g = 0; g < games; ++g)
+    {
+        int moves = PlayRandomGame(rng);
+        totalMoves += moves;
+        std::vector<int> targets(seeks);
+        for (auto &t : targets) t = (int)(rng() % (moves + 1));
+
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < seeks; ++i) WalkToMove(targets[i]);
+        auto t1 = std::chrono::steady_clock::now();
+        Game_SeekToMove(moves);
+        auto t2 = std::chrono::steady_clock::now();
+        for (int i = 0; i < seeks; ++i) Game_SeekToMove(targets[i]);
+        auto t3 = std::chrono::steady_clock::now();
+
+        // verify a sample of seeks against the reference walk
+        for (int i = 0; i < seeks && i < 1000; ++i)
+        {
+            WalkToMove(targets[i]);
+            unsigned long long expected = PositionChecksum();
+            Game_SeekToMove(moves - targets[i]);
+            Game_SeekToMove(targets[i]);
+            if (PositionChecksum() != expected) ++mismatches;
+        }
+        walkNs += std::chrono::duration<double, std::nano>(t1 - t0).count();
+        seekNs += std::chrono::duration<double, std::nano>(t3 - t2).count();
+    }
+
+    double n = (double)games * seeks;
+    printf("games: %d  avg length: %.1f moves  checkpoint interval: %d\n", games, (double)totalMoves / games, GAME_CHECKPOINT_INTERVAL);
+    printf("walk  : %10.1f ns/seek\n", walkNs / n);
+    printf("seek  : %10.1f ns/seek  (%.1fx)\n", seekNs / n, seekNs > 0 ? walkNs / seekNs : 0.0);
+    printf("position mismatches: %lld\n", mismatches);
+    return mismatches == 0 ? 0 : 2;
+}
@@ -0,0 +1,140 @@
+// bench_sessions.cpp : memory per live server session (session_store.h), and eviction round trips.
+//
+// Fills a store with sessions at different points of random 10x10 games (a few hundred generated
+// games are replayed into all sessions), reports the store's own byte count and the growth of the
+// process's resident memory per session, then evicts every session to disk and reloads it,
+// checking that each comes back in the same position.
+
+#include "tools.h"
+#include "position.h"
+#include "session_store.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi")
+#else
+#include <unistd.h>
+#endif
+
+// current resident memory of the process (0 if unknown)
+static uint64_t ResidentBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return pmc.WorkingSetSize;
+    return 0;
+#else
+    unsigned long long total = 0, resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    if (fscanf(f, "%llu %llu", &total, &resident) != 2) resident = 0;
+    fclose(f);
+    return resident * (uint64_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+static double MsSince(std::chrono::steady_clock::time_point t)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count();
+}
+
+// sum of the canonical keys of every session's position; equal sums mean nothing was lost
+static uint64_t Checksum(SessionStore* store, const std::vector<uint32_t> &ids)
+{
+    uint64_t sum = 0;
+    Position pos;
+    for (uint32_t id : ids)
+    {
+        CompactSession* s = SessionStore_Get(store, id);
+        if (!s) return 0;
+        Session_GetPosition(s, pos);
+        sum += Position_CanonicalKey(pos);
+    }
+    return sum;
+}
+
+// bench-sessions [sessions] [evict.file]
+int Tool_BenchSessions(int argc, char** argv)
+{
+    int count = (argc > 0) ? atoi(argv[0]) : 100000;
+    const char* evictPath = (argc > 1) ? argv[1] : nullptr;
+    if (count <= 0) count = 1;
+    const int kGames = 256;
+
+    // random games, each cut at a random length, and the position sum they should give
+    std::mt19937 rng(2024);
+    std::vector<std::vector<PosMove>> games(kGames);
+    std::vector<uint64_t> keys(kGames);
+    std::vector<PosMove> moves;
+    uint64_t totalMoves = 0;
+    for (int g = 0; g < kGames; ++g)
+    {
+        Position pos;
+        Position_Init(pos, 10);
+        int length = (int)(rng() % 81);
+        for (int ply = 0; ply < length; ++ply)
+        {
+            Position_GenerateMoves(pos, moves);
+            if (moves.empty()) break;
+            PosMove m = moves[rng() % moves.size()];
+            Position_MakeMove(pos, m);
+            games[(size_t)g].push_back(m);
+        }
+        keys[(size_t)g] = Position_CanonicalKey(pos);
+    }
+    uint64_t expected = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        expected += keys[(size_t)(i % kGames)];
+        totalMoves += games[(size_t)(i % kGames)].size();
+    }
+
+    uint64_t resident0 = ResidentBytes();
+    SessionStore* store = SessionStore_Create(evictPath);
+    std::vector<uint32_t> ids;
+    ids.reserve((size_t)count);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i)
+    {
+        uint32_t id = SessionStore_New(store, 10, SESSION_AI_WHITE);
+        CompactSession* s = SessionStore_Get(store, id);
+        for (const PosMove &m : games[(size_t)(i % kGames)]) Session_MakeMove(store, s, m);
+        ids.push_back(id);
+    }
+    double buildMs = MsSince(start);
+    uint64_t resident1 = ResidentBytes();
+    SessionStoreStats st;
+    SessionStore_GetStats(store, st);
+    // the id list of this benchmark is not part of the store
+    uint64_t residentDelta = resident1 > resident0 ? resident1 - resident0 - ids.capacity() * sizeof(uint32_t) : 0;
+    printf("%d sessions, %.1f moves on average, created in %.0f ms\n", count, (double)totalMoves / count, buildMs);
+    printf("bytes per live session: %.1f in use, %.1f reserved, %.1f resident\n", (double)st.bytesInUse / count,
+        (double)st.bytesReserved / count, (double)residentDelta / count);
+    bool ok = Checksum(store, ids) == expected;
+    printf("positions %s\n", ok ? "ok" : "MISMATCH");
+
+    if (evictPath)
+    {
+        start = std::chrono::steady_clock::now();
+        int evicted = SessionStore_EvictIdle(store, 0);
+        double evictMs = MsSince(start);
+        SessionStore_GetStats(store, st);
+        printf("evicted %d sessions in %.0f ms (%.2f us each), file %.1f MB, %.1f bytes per session left in memory\n",
+            evicted, evictMs, evictMs * 1000.0 / std::max(evicted, 1), st.diskBytes / 1048576.0, (double)st.bytesInUse / count);
+        start = std::chrono::steady_clock::now();
+        bool reloaded = Checksum(store, ids) == expected;
+        double reloadMs = MsSince(start);
+        SessionStore_GetStats(store, st);
+        printf("reloaded %llu sessions in %.0f ms (%.2f us each), positions %s\n", (unsigned long long)st.reloads, reloadMs,
+            reloadMs * 1000.0 / std::max<uint64_t>(st.reloads, 1), reloaded ? "ok" : "MISMATCH");
+        ok = ok && reloaded;
+    }
+    for (uint32_t id : ids) SessionStore_Close(store, id);
+    SessionStore_Destroy(store);
+    return ok ? 0 : 1;
+}
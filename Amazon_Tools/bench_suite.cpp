@@ -0,0 +1,597 @@
+// bench_suite.cpp : one microbenchmark per engine hot path over a fixed corpus of game positions,
+// written as JSON and compared against a stored baseline.
+//
+// The corpus is every position of the games in an .amzb archive, or by default of 24 seeded random
+// 10x10 games (moves picked from the generator's list in sorted order, so the corpus does not
+// change when a generator does). Each benchmark times only its own calls, runs 'reps' passes
+// over the corpus and keeps the fastest; its checksum shows whether the code under test still
+// computes the same thing. A baseline is an earlier output file: a benchmark more than the
+// threshold slower than its baseline is a regression and makes the command fail, as does a
+// baseline from a different corpus or one in which no benchmark is found.
+
+#include "tools.h"
+#include "engine.h"
+#include "eval.h"
+#include "game.h"
+#include "game_archive.h"
+#include "position.h"
+#include "reach.h"
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+struct SuiteCorpus
+{
+    std::vector<ArchiveGame> games;
+    std::vector<Position> positions;        // every non-final position of every game
+    std::vector<PosMove> played;            // the move played from each position
+    std::vector<std::string> pbn;           // each game as .pbn text
+    std::vector<uint64_t> keys;             // keys of the children of every position, for the TT
+};
+
+struct SuiteResult
+{
+    const char* name;
+    double nsPerOp;
+    uint64_t ops;
+    uint64_t checksum;
+};
+
+static double NsSince(Clock::time_point t)
+{
+    return std::chrono::duration<double, std::nano>(Clock::now() - t).count();
+}
+
+static void BuildRandomGames(std::vector<ArchiveGame> &out)
+{
+    std::mt19937 rng(2025);
+    std::vector<PosMove> moves;
+    for (int g = 0; g < 24; ++g)
+    {
+        ArchiveGame game;
+        game.boardSize = 10;
+        Position pos;
+        Position_Init(pos, 10);
+        for (;;)
+        {
+            Position_GenerateMoves(pos, moves);
+            if (moves.empty()) break;
+            std::sort(moves.begin(), moves.end(), [](const PosMove &a, const PosMove &b) {
+                return (a.from << 16 | a.to << 8 | a.arrow) < (b.from << 16 | b.to << 8 | b.arrow); });
+            PosMove m = moves[rng() % moves.size()];
+            Position_MakeMove(pos, m);
+            game.moves.push_back({ m.from, m.to, m.arrow });
+        }
+        out.push_back(game);
+    }
+}
+
+static bool BuildCorpus(const char* archivePath, SuiteCorpus &c)
+{
+    if (archivePath)
+    {
+        ArchiveReader r;
+        if (!Archive_Open(r, archivePath))
+        {
+            fprintf(stderr, "cannot open %s\n", archivePath);
+            return false;
+        }
+        ArchiveGame game;
+        for (uint64_t i = 0; Archive_ReadGame(r, i, game); ++i) c.games.push_back(game);
+        Archive_Close(r);
+    }
+    else
+    {
+        BuildRandomGames(c.games);
+    }
+    std::vector<PosMove> moves;
+    for (const ArchiveGame &game : c.games)
+    {
+        Position pos;
+        Position_InitSetup(pos, game.boardSize, game.setup);
+        for (const ArchiveMove &am : game.moves)
+        {
+            PosMove m = { am.from, am.to, am.arrow };
+            c.positions.push_back(pos);
+            c.played.push_back(m);
+            Position_GenerateMoves(pos, moves);
+            for (const PosMove &child : moves)
+            {
+                Position_MakeMove(pos, child);
+                c.keys.push_back(pos.symHash[0]);
+                Position_UnmakeMove(pos, child);
+            }
+            Position_MakeMove(pos, m);
+        }
+        c.pbn.emplace_back();
+        Archive_GameToPbn(game, c.pbn.back());
+    }
+    return !c.positions.empty();
+}
+
+// ---- benchmarks: one pass over the corpus, returning the nanoseconds spent in the timed calls ----
+
+typedef double (*SuiteBench)(const SuiteCorpus &c, uint64_t &ops, uint64_t &checksum);
+
+// Loads each game into the game module and visits its positions in order; 'visit' times its calls.
+template <typename Visit>
+static double ForEachGamePosition(const SuiteCorpus &c, Visit visit)
+{
+    double ns = 0.0;
+    std::vector<GameMoveInput> input;
+    for (const ArchiveGame &game : c.games)
+    {
+        int n = game.boardSize;
+        input.clear();
+        for (const ArchiveMove &m : game.moves)
+            input.push_back({ m.from / n, m.from % n, m.to / n, m.to % n, m.arrow / n, m.arrow % n, 0 });
+        Game_Init(n, false, 1, false, &game.setup);
+        if (!Game_LoadMoves(input)) continue;
+        for (int ply = 0; ply < (int)game.moves.size(); ++ply)
+        {
+            Game_SeekToMove(ply);
+            ns += visit();
+        }
+    }
+    return ns;
+}
+
+static double BenchGameLegalMoves(const SuiteCorpus &c, uint64_t &ops, uint64_t &checksum)
+{
+    return ForEachGamePosition(c, [&]() {
+        std::vector<GamePiece> pieces = Game_GetPieces();
+        bool black = Game_IsBlackToMove();
+        Clock::time_point t0 = Clock::now();
+        for (const GamePiece &p : pieces)
+        {
+            if (p.isWhite == black) continue;
+            checksum += Game_GetLegalMoves(p.row, p.col).size();
+            ++ops;
+        }
+        return NsSince(t0);
+    });
+}
+
+static double BenchGameLegalArrows(const SuiteCorpus &c, uint64_t &ops, uint64_t &checksum)
+{
+    return ForEachGamePosition(c, [&]() {
+        std::vector<GamePiece> pieces = Game_GetPieces();
+        bool black = Game_IsBlackToMove();
+        double ns = 0.0;
+        for (const GamePiece &p : pieces)
+        {
+            if (p.isWhite == black) continue;
+            std::vector<std::pair<int, int>> targets = Game_GetLegalMoves(p.row, p.col);
+            Clock::time_point t0 = Clock::now();
+            for (const auto &t : targets) checksum += Game_GetLegalArrows(p.row, p.col, t.first, t.second).size();
+            ns += NsSince(t0);
+            ops += targets.size();
+        }
+        return ns;
+    });
+}
+
+static double BenchGameCheckWinner(const SuiteCorpus &c, uint64_t &ops, uint64_t &checksum)
+{
+    return ForEachGamePosition(c, [&]() {
+        Clock::time_point t0 = Clock::now();
+        checksum += (uint64_t)Game_CheckForWinner();
+        ++ops;
+        return NsSince(t0);
+    });
+}
+
+static double BenchGenerateMoves(const SuiteCorpus &c, uint64_t &ops, uint64_t &checksum)
+{
+    std::vector<PosMove> moves;
+    Clock::time_point t0 = Clock::now();
+    for (const Position &pos : c.positions)
+    {
+        Position_GetKernels(pos.size).generateMoves(pos, moves);
+        checksum += moves.size();
+    }
+    ops += c.positions.size();
+    return NsSince(t0);
+}
+
+static double BenchMakeUnmake(const SuiteCorpus &c, uint64_t &ops, uint64_t &checksum)
+{
+    std::vector<PosMove> moves;
+    double ns = 0.0;
+    for (Position pos : c.positions)
+    {
+        const PositionKernels &k = Position_GetKernels(pos.size);
+        k.generateMoves(pos, moves);
+        Clock::time_point t0 = Clock::now();
+        for (const PosMove &m : moves)
+        {
+            k.makeMove(pos, m);
+            checksum ^= pos.symHash[0];
+            k.unmakeMove(pos, m);
+        }
+        ns += NsSince(t0);
+        ops += moves.size();
+    }
+    return ns;
+}
+
+// make/unmake with the reach sets (reach.h) updated alongside; minus make_unmake, the cost of reach
+static double BenchReachUpdate(const SuiteCorpus &c, uint64_t &ops, uint64_t &checksum)
+{
+    std::vector<PosMove> moves;
+    ReachState reach;
+    double ns = 0.0;
+    for (Position pos : c.positions)
+    {
+        const PositionKernels &k = Position_GetKernels(pos.size);
+        const ReachKernels &r = Reach_GetKernels(pos.size);
+        k.generateMoves(pos, moves);
+        r.init(pos, reach);
+        Clock::time_point t0 = Clock::now();
+        for (const PosMove &m : moves)
+        {
+            k.makeMove(pos, m);
+            r.makeMove(reach, pos, m);
+            checksum += reach.sideMobility[0] + reach.sideMobility[1];
+            k.unmakeMove(pos, m);
+            r.unmakeMove(reach, pos, m);
+        }
+        ns += NsSince(t0);
+        ops += moves.size();
+    }
+    return ns;
+}
+
+// full Zobrist computation (all 8 symmetries) from a cell array; make/unmake updates them instead
+static double BenchZobristRebuild(const SuiteCorpus &c, uint64_t &ops, uint64_t &checksum)
+{
+    Position out;
+    Clock::time_point t0 = Clock::now();
+    for (const Position &pos : c.positions)
+    {
+        Position_SetFromCells(out, pos.size, pos.cell, pos.blackToMove);
+        checksum += Position_CanonicalKey(out);
+    }
+    ops += c.positions.size();
+    return NsSince(t0);
+}
+
+// the scalar breadth-first flood fill of both sides' queen distances (Eval_Territory)
+static double BenchFloodFill(const SuiteCorpus &c, uint64_t &ops, uint64_t &checksum)
+{
+    Clock::time_point t0 = Clock::now();
+    for (const Position &pos : c.positions) checksum += (uint64_t)Eval_Territory(pos);
+    ops += c.positions.size();
+    return NsSince(t0);
+}
+
+static double BenchEvaluate(const SuiteCorpus &c, uint64_t &ops, uint64_t &checksum)
+{
+    Clock::time_point t0 = Clock::now();
+    for (const Position &pos : c.positions) checksum += (uint64_t)Eval_GetTerritoryKernel(pos.size)(pos);
+    ops += c.positions.size();
+    return NsSince(t0);
+}
+
+// derive the state of the next position from this one's and score it (Eval_GetIncrementalKernels)
+static double BenchEvalIncremental(const SuiteCorpus &c, uint64_t &ops, uint64_t &checksum)
+{
+    std::unique_ptr<EvalState[]> states(new EvalState[2]);
+    double ns = 0.0;
+    for (size_t i = 0; i < c.positions.size(); ++i)
+    {
+        const EvalKernels &k = Eval_GetIncrementalKernels(c.positions[i].size);
+        k.init(c.positions[i], states[0]);
+        Clock::time_point t0 = Clock::now();
+        k.update(states[0], c.played[i], states[1]);
+        checksum += (uint64_t)k.score(states[1]);
+        ns += NsSince(t0);
+        ++ops;
+    }
+    return ns;
+}
+
+// every move of the amazon that played, scored in one batch (Eval_Children, the hint heatmap's call)
+static double BenchEvalChildren(const SuiteCorpus &c, uint64_t &ops, uint64_t &checksum)
+{
+    std::vector<PosMove> moves, amazon;
+    std::vector<int> scores;
+    double ns = 0.0;
+    for (size_t i = 0; i < c.positions.size(); ++i)
+    {
+        Position_GetKernels(c.positions[i].size).generateMoves(c.positions[i], moves);
+        amazon.clear();
+        for (const PosMove &m : moves) if (m.from == c.played[i].from) amazon.push_back(m);
+        scores.resize(amazon.size());
+        Clock::time_point t0 = Clock::now();
+        Eval_Children(c.positions[i], amazon.data(), (int)amazon.size(), scores.data());
+        ns += NsSince(t0);
+        for (int v : scores) checksum += (uint64_t)v;
+        ops += amazon.size();
+    }
+    return ns;
+}
+
+static Engine* s_ttEngine = nullptr;
+
+static double BenchTTStore(const SuiteCorpus &c, uint64_t &ops, uint64_t &checksum)
+{
+    Clock::time_point t0 = Clock::now();
+    for (size_t i = 0; i < c.keys.size(); ++i)
+    {
+        PosMove m = { (uint8_t)i, (uint8_t)(i >> 8), (uint8_t)(i >> 16) };
+        Engine_StoreTT(s_ttEngine, c.keys[i], (int)(i & 1023), (int)(i & 31), m);
+    }
+    ops += c.keys.size();
+    checksum += c.keys.size();
+    return NsSince(t0);
+}
+
+// probes the keys stored by tt_store: hits, and misses where later keys took the slot
+static double BenchTTProbe(const SuiteCorpus &c, uint64_t &ops, uint64_t &checksum)
+{
+    int score, depth;
+    PosMove m;
+    Clock::time_point t0 = Clock::now();
+    for (uint64_t key : c.keys)
+        if (Engine_ProbeTT(s_ttEngine, key, score, depth, m)) checksum += (uint64_t)(score + depth);
+    ops += c.keys.size();
+    return NsSince(t0);
+}
+
+static double BenchPbnSerialise(const SuiteCorpus &c, uint64_t &ops, uint64_t &checksum)
+{
+    std::string text;
+    Clock::time_point t0 = Clock::now();
+    for (const ArchiveGame &game : c.games)
+    {
+        Archive_GameToPbn(game, text);
+        checksum += text.size();
+    }
+    ops += c.games.size();
+    return NsSince(t0);
+}
+
+static double BenchPbnParse(const SuiteCorpus &c, uint64_t &ops, uint64_t &checksum)
+{
+    ArchiveGame game;
+    Clock::time_point t0 = Clock::now();
+    for (const std::string &text : c.pbn)
+        if (Archive_GameFromPbn(text.data(), text.size(), game)) checksum += game.moves.size();
+    ops += c.pbn.size();
+    return NsSince(t0);
+}
+
+// an empty zone recorded per key while tracing (nothing at all when built with TRACE_ENABLED 0)
+static double BenchTraceZone(const SuiteCorpus &c, uint64_t &ops, uint64_t &checksum)
+{
+    Trace_Start();
+    Clock::time_point t0 = Clock::now();
+    for (size_t i = 0; i < c.keys.size(); ++i)
+    {
+        TRACE_ZONE_ARG("bench", i);
+    }
+    double ns = NsSince(t0);
+    Trace_Stop();
+    ops += c.keys.size();
+    checksum += c.keys.size();
+    return ns;
+}
+
+struct SuiteCase
+{
+    const char* name;
+    SuiteBench run;
+    const char* unit;       // what one operation is
+};
+
+static const SuiteCase s_cases[] = {
+    { "game_legal_moves",  BenchGameLegalMoves,  "Game_GetLegalMoves call" },
+    { "game_legal_arrows", BenchGameLegalArrows, "Game_GetLegalArrows call" },
+    { "game_check_winner", BenchGameCheckWinner, "Game_CheckForWinner call" },
+    { "generate_moves",    BenchGenerateMoves,   "position (all moves)" },
+    { "make_unmake",       BenchMakeUnmake,      "move made and taken back, Zobrist updates included" },
+    { "reach_update",      BenchReachUpdate,     "move made and taken back, reach sets updated" },
+    { "zobrist_rebuild",   BenchZobristRebuild,  "position hashed from scratch" },
+    { "flood_fill",        BenchFloodFill,       "position (Eval_Territory)" },
+    { "evaluate",          BenchEvaluate,        "position (territory kernel)" },
+    { "eval_incremental",  BenchEvalIncremental, "incremental update and score" },
+    { "eval_children",     BenchEvalChildren,    "child scored in one amazon's batch" },
+    { "tt_store",          BenchTTStore,         "store" },
+    { "tt_probe",          BenchTTProbe,         "probe" },
+    { "pbn_serialise",     BenchPbnSerialise,    "game" },
+    { "pbn_parse",         BenchPbnParse,        "game" },
+    { "trace_zone",        BenchTraceZone,       "zone recorded" },
+};
+
+// Baselines are read back with a small key scanner rather than a JSON parser; whitespace around
+// ':' and ',' is allowed, so a file re-serialised by another tool still matches.
+
+static size_t SkipSpace(const std::string &json, size_t at)
+{
+    while (at < json.size() && (json[at] == ' ' || json[at] == '\t' || json[at] == '\r' || json[at] == '\n')) ++at;
+    return at;
+}
+
+// position of the value of the next "key" in [from, end), or npos
+static size_t FindValue(const std::string &json, const char* key, size_t from, size_t end)
+{
+    std::string tag = std::string("\"") + key + "\"";
+    for (size_t at = json.find(tag, from); at < end; at = json.find(tag, at + 1))
+    {
+        size_t colon = SkipSpace(json, at + tag.size());
+        if (colon < end && json[colon] == ':') return SkipSpace(json, colon + 1);
+    }
+    return std::string::npos;
+}
+
+static bool NumberValue(const std::string &json, const char* key, size_t from, size_t end, double &out)
+{
+    size_t at = FindValue(json, key, from, end);
+    if (at == std::string::npos) return false;
+    char* stop = nullptr;
+    out = strtod(json.c_str() + at, &stop);
+    return stop != json.c_str() + at;
+}
+
+static bool StringValue(const std::string &json, const char* key, size_t from, size_t end, std::string &out)
+{
+    size_t at = FindValue(json, key, from, end);
+    if (at == std::string::npos || json[at] != '"') return false;
+    size_t close = json.find('"', at + 1);
+    if (close == std::string::npos || close > end) return false;
+    out = json.substr(at + 1, close - at - 1);
+    return true;
+}
+
+// the result object of benchmark 'name' as [from, end); false if the baseline has none
+static bool FindBaselineResult(const std::string &json, const char* name, size_t &from, size_t &end)
+{
+    size_t len = strlen(name);
+    for (size_t at = FindValue(json, "name", 0, json.size()); at != std::string::npos;
+        at = FindValue(json, "name", at, json.size()))
+    {
+        if (json.compare(at, len + 2, std::string("\"") + name + "\"") == 0)
+        {
+            from = json.rfind('{', at);
+            end = json.find('}', at);
+            return from != std::string::npos && end != std::string::npos;
+        }
+    }
+    return false;
+}
+
+// ns_per_op and checksum of 'name' in a suite JSON file; false if absent
+static bool FindBaseline(const std::string &json, const char* name, double &nsPerOp, std::string &checksum)
+{
+    size_t from = 0, end = 0;
+    if (!FindBaselineResult(json, name, from, end)) return false;
+    if (!StringValue(json, "checksum", from, end, checksum)) checksum.clear();
+    return NumberValue(json, "ns_per_op", from, end, nsPerOp) && nsPerOp > 0.0;
+}
+
+// whether the baseline was measured on a corpus of the same size
+static bool SameBaselineCorpus(const std::string &json, const SuiteCorpus &corpus)
+{
+    size_t from = FindValue(json, "corpus", 0, json.size());
+    size_t end = from == std::string::npos ? from : json.find('}', from);
+    double games = 0, positions = 0, keys = 0;
+    return end != std::string::npos && NumberValue(json, "games", from, end, games)
+        && NumberValue(json, "positions", from, end, positions) && NumberValue(json, "keys", from, end, keys)
+        && games == (double)corpus.games.size() && positions == (double)corpus.positions.size()
+        && keys == (double)corpus.keys.size();
+}
+
+// bench-suite [out.json|-] [baseline.json|-] [threshold%] [corpus.amzb|-] [reps]
+int Tool_BenchSuite(int argc, char** argv)
+{
+    const char* outPath = (argc > 0 && strcmp(argv[0], "-") != 0) ? argv[0] : nullptr;
+    const char* basePath = (argc > 1 && strcmp(argv[1], "-") != 0) ? argv[1] : nullptr;
+    double threshold = (argc > 2) ? atof(argv[2]) : 10.0;
+    const char* corpusPath = (argc > 3 && strcmp(argv[3], "-") != 0) ? argv[3] : nullptr;
+    int reps = (argc > 4) ? std::max(atoi(argv[4]), 1) : 5;
+
+    std::string baseline;
+    if (basePath && !Tool_ReadFile(basePath, baseline))
+    {
+        fprintf(stderr, "cannot read baseline %s\n", basePath);
+        return 1;
+    }
+    SuiteCorpus corpus;
+    if (!BuildCorpus(corpusPath, corpus))
+    {
+        fprintf(stderr, "empty corpus\n");
+        return 1;
+    }
+    if (basePath && !SameBaselineCorpus(baseline, corpus))
+    {
+        fprintf(stderr, "baseline %s was measured on a different corpus\n", basePath);
+        return 1;
+    }
+    s_ttEngine = Engine_Create(16);
+    printf("corpus: %zu games, %zu positions, %zu child keys; best of %d passes\n", corpus.games.size(),
+        corpus.positions.size(), corpus.keys.size(), reps);
+    printf("%-18s %12s %12s %8s  %s\n", "benchmark", "ns/op", "baseline", "change", "");
+
+    // passes go round all benchmarks, so a burst of load on the machine costs each one pass at most
+    std::vector<SuiteResult> results;
+    for (const SuiteCase &sc : s_cases) results.push_back({ sc.name, 0.0, 0, 0 });
+    for (int i = 0; i < reps; ++i)
+    {
+        for (size_t k = 0; k < results.size(); ++k)
+        {
+            SuiteResult &r = results[k];
+            uint64_t ops = 0, checksum = 0;
+            double ns = s_cases[k].run(corpus, ops, checksum);
+            double perOp = ops ? ns / ops : 0.0;
+            if (i == 0 || perOp < r.nsPerOp) r.nsPerOp = perOp;
+            r.ops = ops;
+            r.checksum = checksum;
+        }
+    }
+
+    int regressions = 0, missing = 0;
+    for (size_t k = 0; k < results.size(); ++k)
+    {
+        const SuiteResult &r = results[k];
+        double base = 0.0;
+        std::string baseSum;
+        char sum[20];
+        snprintf(sum, sizeof(sum), "%016llx", (unsigned long long)r.checksum);
+        if (basePath && FindBaseline(baseline, r.name, base, baseSum))
+        {
+            double change = 100.0 * (r.nsPerOp - base) / base;
+            bool regressed = change > threshold;
+            regressions += regressed;
+            const char* note = regressed ? "REGRESSION" : (change < -threshold ? "faster" : "");
+            if (!baseSum.empty() && baseSum != sum)
+                note = regressed ? "REGRESSION, output changed" : "output changed";
+            printf("%-18s %12.1f %12.1f %+7.1f%%  %s\n", r.name, r.nsPerOp, base, change, note);
+        }
+        else
+        {
+            missing += basePath ? 1 : 0;
+            printf("%-18s %12.1f %12s %8s  %s\n", r.name, r.nsPerOp, "-", "", basePath ? "not in baseline" : s_cases[k].unit);
+        }
+    }
+    Engine_Destroy(s_ttEngine);
+    s_ttEngine = nullptr;
+
+    std::string json;
+    char buf[256];
+    snprintf(buf, sizeof(buf), "{\"suite\":1,\"corpus\":{\"games\":%zu,\"positions\":%zu,\"keys\":%zu},\"reps\":%d,\"results\":[",
+        corpus.games.size(), corpus.positions.size(), corpus.keys.size(), reps);
+    json += buf;
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const SuiteResult &r = results[i];
+        snprintf(buf, sizeof(buf), "%s\n{\"name\":\"%s\",\"ns_per_op\":%.2f,\"ops\":%llu,\"checksum\":\"%016llx\"}",
+            i ? "," : "", r.name, r.nsPerOp, (unsigned long long)r.ops, (unsigned long long)r.checksum);
+        json += buf;
+    }
+    json += "\n]}\n";
+    if (outPath && !Tool_WriteFile(outPath, json))
+    {
+        fprintf(stderr, "cannot write %s\n", outPath);
+        return 1;
+    }
+    if (!outPath) fputs(json.c_str(), stdout);
+    if (regressions) printf("%d benchmark(s) more than %.0f%% slower than the baseline\n", regressions, threshold);
+    if (missing) printf("%d benchmark(s) not in the baseline\n", missing);
+    // a baseline that matches nothing would otherwise pass every regression check
+    if (basePath && missing == (int)results.size())
+    {
+        fprintf(stderr, "baseline %s has none of the benchmarks\n", basePath);
+        return 1;
+    }
+    return regressions ? 1 : 0;
+}
@@ -0,0 +1,289 @@
+// codec_tools.cpp : packing .amzb archives into entropy-coded .amzc files and back, and measuring
+// the codec. Blocks are encoded and decoded on a thread pool, one task per block.
+
+#include "tools.h"
+#include "archive_codec.h"
+#include "game_archive.h"
+#include "mapped_file.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const size_t kDefaultBlockGames = 4096;
+
+static int ThreadCount(const char* arg)
+{
+    int threads = arg ? atoi(arg) : 0;
+    return threads > 0 ? threads : (int)std::max(1u, std::thread::hardware_concurrency());
+}
+
+// every game of an .amzb archive; reports errors itself
+static bool LoadArchiveGames(const char* path, std::vector<ArchiveGame> &out, uint64_t* fileSize = nullptr)
+{
+    ArchiveReader r;
+    if (!Archive_Open(r, path))
+    {
+        fprintf(stderr, "%s: not a game archive\n", path);
+        return false;
+    }
+    std::vector<uint64_t> index = r.index;
+    Archive_Close(r);
+    MappedFile file;
+    if (!MappedFile_Open(file, std::string(path)))
+    {
+        fprintf(stderr, "%s: cannot read\n", path);
+        return false;
+    }
+    const uint8_t* data = (const uint8_t*)file.data;
+    out.resize(index.size());
+    bool ok = true;
+    for (size_t i = 0; ok && i < index.size(); ++i)
+        ok = index[i] < file.size && Archive_DecodeGame(data + index[i], (size_t)(file.size - index[i]), out[i]) != 0;
+    if (fileSize) *fileSize = file.size;
+    MappedFile_Close(file);
+    if (!ok) fprintf(stderr, "%s: damaged game record\n", path);
+    return ok;
+}
+
+// one payload per block of 'blockGames' games; false (with the first failing game) if a game cannot be coded
+static bool EncodeBlocks(const std::vector<ArchiveGame> &games, size_t blockGames, int threads,
+    std::vector<std::string> &payloads)
+{
+    size_t blocks = (games.size() + blockGames - 1) / blockGames;
+    payloads.assign(blocks, std::string());
+    std::atomic<size_t> failed(games.size());
+    ThreadPool* pool = ThreadPool_Create(threads);
+    for (size_t b = 0; b < blocks; ++b)
+    {
+        ThreadPool_Submit(pool, [&games, &payloads, &failed, b, blockGames](int) {
+            size_t first = b * blockGames, count = std::min(blockGames, games.size() - first);
+            if (Codec_EncodeBlock(&games[first], count, payloads[b])) return;
+            // the block is dropped, so find the game that failed for the message
+            for (size_t g = first; g < first + count; ++g)
+            {
+                std::string scratch;
+                if (Codec_EncodeBlock(&games[g], 1, scratch)) continue;
+                size_t seen = failed.load();
+                while (g < seen && !failed.compare_exchange_weak(seen, g)) {}
+                break;
+            }
+        });
+    }
+    ThreadPool_Destroy(pool);
+    if (failed.load() == games.size()) return true;
+    fprintf(stderr, "game %llu: board size or custom setup the codec cannot replay\n", (unsigned long long)failed.load());
+    return false;
+}
+
+// every block of an open reader, decoded in parallel into one vector per block
+static bool DecodeBlocks(const CodecReader &r, int threads, std::vector<std::vector<ArchiveGame>> &out)
+{
+    out.assign(r.blocks.size(), std::vector<ArchiveGame>());
+    std::atomic<bool> ok(true);
+    ThreadPool* pool = ThreadPool_Create(threads);
+    for (size_t b = 0; b < r.blocks.size(); ++b)
+    {
+        ThreadPool_Submit(pool, [&r, &out, &ok, b](int) {
+            if (!CodecReader_ReadBlock(r, b, out[b])) ok.store(false);
+        });
+    }
+    ThreadPool_Destroy(pool);
+    return ok.load();
+}
+
+static bool SameGame(const ArchiveGame &a, const ArchiveGame &b)
+{
+    if (a.boardSize != b.boardSize || a.opponentIsAI != b.opponentIsAI || a.aiFirst != b.aiFirst
+        || a.setup.custom != b.setup.custom || a.moves.size() != b.moves.size()) return false;
+    if (a.setup.custom && memcmp(a.setup.square, b.setup.square, sizeof(a.setup.square)) != 0) return false;
+    for (size_t i = 0; i < a.moves.size(); ++i)
+    {
+        if (a.moves[i].from != b.moves[i].from || a.moves[i].to != b.moves[i].to
+            || a.moves[i].arrow != b.moves[i].arrow) return false;
+    }
+    return true;
+}
+
+// Damaged copies of a coded file at 'path' must be rejected by open or decode rather than abort: a
+// block game count raised by 2^30, a changed total game count, a moved first block and a flipped
+// bit in the first payload byte.
+static bool RejectsDamage(const std::string &path, int threads)
+{
+    std::string coded;
+    if (!Tool_ReadFile(path.c_str(), coded) || coded.size() < 48) return false;
+    size_t trailer = coded.size() - 32;
+    size_t indexOffset = 0;
+    for (int i = 7; i >= 0; --i) indexOffset = (indexOffset << 8) | (uint8_t)coded[trailer + i];
+    const size_t flips[][2] = { { 11, 6 }, { trailer + 16, 0 }, { indexOffset, 3 }, { 20, 2 } };
+    bool rejected = true;
+    for (const auto &flip : flips)
+    {
+        std::string damaged = coded;
+        damaged[flip[0]] = (char)(damaged[flip[0]] ^ (1 << flip[1]));
+        CodecReader r;
+        std::vector<std::vector<ArchiveGame>> blocks;
+        if (!Tool_WriteFile(path.c_str(), damaged)) return false;
+        if (!CodecReader_Open(r, path)) continue;
+        rejected = rejected && !DecodeBlocks(r, threads, blocks);
+        CodecReader_Close(r);
+    }
+    return rejected;
+}
+
+// amzc-pack <out.amzc> <in.amzb> [gamesPerBlock] [threads]
+int Tool_CodecPack(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: amzc-pack <out.amzc> <in.amzb> [gamesPerBlock] [threads]\n");
+        return 1;
+    }
+    size_t blockGames = argc > 2 && atoi(argv[2]) > 0 ? (size_t)atoi(argv[2]) : kDefaultBlockGames;
+    int threads = ThreadCount(argc > 3 ? argv[3] : nullptr);
+    std::vector<ArchiveGame> games;
+    uint64_t inSize = 0;
+    if (!LoadArchiveGames(argv[1], games, &inSize)) return 1;
+    std::vector<std::string> payloads;
+    if (!EncodeBlocks(games, blockGames, threads, payloads)) return 1;
+
+    CodecWriter w;
+    bool ok = CodecWriter_Create(w, argv[0]);
+    for (size_t b = 0; ok && b < payloads.size(); ++b)
+        ok = CodecWriter_AppendBlock(w, payloads[b], (uint32_t)std::min(blockGames, games.size() - b * blockGames));
+    ok = CodecWriter_Finish(w) && ok;
+    if (!ok)
+    {
+        fprintf(stderr, "%s: cannot write\n", argv[0]);
+        return 1;
+    }
+    printf("%llu games in %llu blocks: %llu -> %llu bytes\n", (unsigned long long)games.size(),
+        (unsigned long long)payloads.size(), (unsigned long long)inSize, (unsigned long long)w.offset);
+    return 0;
+}
+
+// amzc-unpack <in.amzc> <out.amzb> [threads]
+int Tool_CodecUnpack(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: amzc-unpack <in.amzc> <out.amzb> [threads]\n");
+        return 1;
+    }
+    CodecReader r;
+    if (!CodecReader_Open(r, argv[0]))
+    {
+        fprintf(stderr, "%s: not a coded archive\n", argv[0]);
+        return 1;
+    }
+    std::vector<std::vector<ArchiveGame>> blocks;
+    bool decoded = DecodeBlocks(r, ThreadCount(argc > 2 ? argv[2] : nullptr), blocks);
+    CodecReader_Close(r);
+    if (!decoded)
+    {
+        fprintf(stderr, "%s: damaged block\n", argv[0]);
+        return 1;
+    }
+    ArchiveWriter w;
+    bool ok = Archive_Create(w, argv[1]);
+    uint64_t games = 0;
+    for (size_t b = 0; ok && b < blocks.size(); ++b)
+        for (size_t g = 0; ok && g < blocks[b].size(); ++g, ++games) ok = Archive_AppendGame(w, blocks[b][g]);
+    ok = Archive_Finish(w) && ok;
+    if (!ok)
+    {
+        fprintf(stderr, "%s: cannot write\n", argv[1]);
+        return 1;
+    }
+    printf("%llu games\n", (unsigned long long)games);
+    return 0;
+}
+
+// bench-codec <in.amzb> [threads] [gamesPerBlock] [out.pbn]
+// Sizes of the games as .pbn text, .amzb and .amzc, coding speed, a round-trip check and a check that
+// damaged headers are rejected. The .pbn text of all games can be written out to compare
+// general-purpose compressors against.
+int Tool_BenchCodec(int argc, char** argv)
+{
+    if (argc < 1)
+    {
+        fprintf(stderr, "usage: bench-codec <in.amzb> [threads] [gamesPerBlock] [out.pbn]\n");
+        return 1;
+    }
+    int threads = ThreadCount(argc > 1 ? argv[1] : nullptr);
+    size_t blockGames = argc > 2 && atoi(argv[2]) > 0 ? (size_t)atoi(argv[2]) : kDefaultBlockGames;
+    std::vector<ArchiveGame> games;
+    uint64_t amzbSize = 0;
+    if (!LoadArchiveGames(argv[0], games, &amzbSize)) return 1;
+
+    uint64_t moves = 0, pbnSize = 0;
+    std::string pbn, text;
+    for (const ArchiveGame &g : games)
+    {
+        moves += g.moves.size();
+        Archive_GameToPbn(g, text);
+        pbnSize += text.size();
+        if (argc > 3) pbn += text;
+    }
+    if (argc > 3 && !Tool_WriteFile(argv[3], pbn))
+    {
+        fprintf(stderr, "%s: cannot write\n", argv[3]);
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::string> payloads;
+    if (!EncodeBlocks(games, blockGames, threads, payloads)) return 1;
+    double encodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // decode through a real file, as amzc-unpack does
+    std::string path = std::string(argv[0]) + ".bench.amzc";
+    CodecWriter w;
+    bool ok = CodecWriter_Create(w, path);
+    for (size_t b = 0; ok && b < payloads.size(); ++b)
+        ok = CodecWriter_AppendBlock(w, payloads[b], (uint32_t)std::min(blockGames, games.size() - b * blockGames));
+    ok = CodecWriter_Finish(w) && ok;
+    CodecReader r;
+    if (!ok || !CodecReader_Open(r, path))
+    {
+        fprintf(stderr, "%s: cannot write\n", path.c_str());
+        remove(path.c_str());
+        return 1;
+    }
+    std::vector<std::vector<ArchiveGame>> blocks;
+    start = std::chrono::steady_clock::now();
+    bool decoded = DecodeBlocks(r, threads, blocks);
+    double decodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    CodecReader_Close(r);
+    bool rejected = payloads.empty() || RejectsDamage(path, threads);
+    remove(path.c_str());
+
+    size_t mismatches = 0, g = 0;
+    for (const auto &block : blocks)
+        for (const ArchiveGame &game : block) mismatches += g < games.size() && SameGame(game, games[g++]) ? 0 : 1;
+    mismatches += games.size() - g;
+
+    double mb = 1024.0 * 1024.0;
+    printf("%llu games, %llu moves, %llu blocks of %llu, %d threads\n", (unsigned long long)games.size(),
+        (unsigned long long)moves, (unsigned long long)payloads.size(), (unsigned long long)blockGames, threads);
+    printf("  .pbn   %10llu bytes\n", (unsigned long long)pbnSize);
+    printf("  .amzb  %10llu bytes  %5.1fx smaller than .pbn\n", (unsigned long long)amzbSize,
+        (double)pbnSize / std::max<uint64_t>(amzbSize, 1));
+    printf("  .amzc  %10llu bytes  %5.1fx smaller than .pbn, %.1fx than .amzb, %.2f bits/move\n",
+        (unsigned long long)w.offset, (double)pbnSize / std::max<uint64_t>(w.offset, 1),
+        (double)amzbSize / std::max<uint64_t>(w.offset, 1), 8.0 * w.offset / std::max<uint64_t>(moves, 1));
+    printf("  encode %.3f s: %.0f games/s, %.1f M moves/s\n", encodeSeconds,
+        games.size() / std::max(encodeSeconds, 1e-9), moves / std::max(encodeSeconds, 1e-9) / 1e6);
+    printf("  decode %.3f s: %.0f games/s, %.1f M moves/s, %.1f MB/s of .pbn\n", decodeSeconds,
+        games.size() / std::max(decodeSeconds, 1e-9), moves / std::max(decodeSeconds, 1e-9) / 1e6,
+        pbnSize / mb / std::max(decodeSeconds, 1e-9));
+    printf("  round trip: %s, damaged headers: %s\n", decoded && mismatches == 0 ? "ok" : "MISMATCH",
+        rejected ? "rejected" : "ACCEPTED");
+    return decoded && mismatches == 0 && rejected ? 0 : 2;
+}
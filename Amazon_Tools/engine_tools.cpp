@@ -0,0 +1,80 @@
+// engine_tools.cpp : run the search engine on positions from game records.
+//
+
+#include "tools.h"
+#include "engine.h"
+#include "position.h"
+#include "solved_table.h"
+#include "trace.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// search <game.pbn> [ply] [ms] [depth] [threads] [multipv] [solved.amzs|-] [solverNodes] [lmr,dest,arrows|-]   prints one JSON object per search
+int Tool_Search(int argc, char** argv)
+{
+    if (argc < 1)
+    {
+        fprintf(stderr, "usage: search <game.pbn> [ply] [ms] [depth] [threads] [multipv] [solved.amzs|-] [solverNodes] [lmr,dest,arrows|-]\n");
+        return 1;
+    }
+    Position pos;
+    if (!Tool_LoadPbnPosition(argv[0], (argc > 1) ? atoi(argv[1]) : -1, pos)) return 1;
+
+    SearchLimits limits;
+    if (argc > 2) limits.timeMs = atoi(argv[2]);
+    if (argc > 3) limits.maxDepth = atoi(argv[3]);
+    if (argc > 4) limits.threads = atoi(argv[4]);
+    if (argc > 5) limits.multiPV = atoi(argv[5]);
+    if (argc > 7) limits.solverNodes = strtoull(argv[7], nullptr, 10);
+    if (argc > 8 && !Tool_ParseSelective(argv[8], limits)) return 1;
+
+    SolvedTable table;
+    if (argc > 6 && strcmp(argv[6], "-") != 0 && !SolvedTable_Open(table, argv[6]))
+    {
+        fprintf(stderr, "cannot open %s\n", argv[6]);
+        return 1;
+    }
+
+    Engine* engine = Engine_Create();
+    if (table.records) Engine_SetSolvedTable(engine, &table);
+    SearchResult result;
+    Engine_Search(engine, pos, limits, result);
+    std::string json;
+    SearchResult_ToJson(pos, result, json);
+    printf("%s\n", json.c_str());
+    Engine_Destroy(engine);
+    SolvedTable_Close(table);
+    return result.hasMove ? 0 : 2;
+}
+
+// trace-search <game.pbn> <out.json> [ply] [ms] [threads]   one search recorded as a Chrome trace
+int Tool_TraceSearch(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: trace-search <game.pbn> <out.json> [ply] [ms] [threads]\n");
+        return 1;
+    }
+    Position pos;
+    if (!Tool_LoadPbnPosition(argv[0], (argc > 2) ? atoi(argv[2]) : -1, pos)) return 1;
+    SearchLimits limits;
+    limits.timeMs = (argc > 3) ? atoi(argv[3]) : 1000;
+    if (argc > 4) limits.threads = atoi(argv[4]);
+
+    Trace_SetThreadName("main");
+    Trace_Start();
+    Engine* engine = Engine_Create();
+    SearchResult result;
+    Engine_Search(engine, pos, limits, result);
+    Engine_Destroy(engine);
+    Trace_Stop();
+    if (!Trace_Dump(std::string(argv[1])))
+    {
+        fprintf(stderr, "cannot write %s\n", argv[1]);
+        return 1;
+    }
+    printf("depth %d, %llu nodes; trace in %s\n", result.stats.depth, (unsigned long long)result.stats.nodes, argv[1]);
+    return 0;
+}
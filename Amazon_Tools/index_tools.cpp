@@ -0,0 +1,124 @@
+// index_tools.cpp : build and query the position index (.amzx) over a binary game archive.
+//
+
+#include "tools.h"
+#include "game_archive.h"
+#include "position.h"
+#include "position_index.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+static PosMove ToPosMove(const ArchiveMove &m)
+{
+    PosMove pm = { m.from, m.to, m.arrow };
+    return pm;
+}
+
+// Replays 'game' and appends one entry per position reached. Replay stops at the first illegal
+// move; such games and games that were saved mid-play are recorded as unfinished.
+static void IndexGame(const ArchiveGame &game, uint32_t gameId, std::vector<PositionIndexEntry> &out)
+{
+    Position pos;
+    Position_InitSetup(pos, game.boardSize, game.setup);
+    size_t first = out.size();
+    bool complete = true;
+    for (size_t ply = 0; ; ++ply)
+    {
+        PositionIndexEntry e;
+        e.key = Position_CanonicalKey(pos);
+        e.game = gameId;
+        e.ply = (uint16_t)ply;
+        e.result = GAME_RESULT_UNFINISHED;
+        e.boardSize = (uint8_t)pos.size;
+        out.push_back(e);
+        if (ply == game.moves.size()) break;
+        PosMove m = ToPosMove(game.moves[ply]);
+        if (!Position_IsLegalMove(pos, m)) { complete = false; break; }
+        Position_MakeMove(pos, m);
+    }
+    uint8_t result = GAME_RESULT_UNFINISHED;
+    if (complete && !Position_HasAnyMove(pos))
+        result = pos.blackToMove ? GAME_RESULT_WHITE : GAME_RESULT_BLACK;
+    for (size_t i = first; i < out.size(); ++i) out[i].result = result;
+}
+
+// index-build <out.amzx> <in.amzb>
+int Tool_IndexBuild(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: index-build <out.amzx> <in.amzb>\n");
+        return 1;
+    }
+    ArchiveReader r;
+    if (!Archive_Open(r, argv[1]))
+    {
+        fprintf(stderr, "cannot open archive %s\n", argv[1]);
+        return 1;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<PositionIndexEntry> entries;
+    ArchiveGame game;
+    for (uint64_t i = 0; i < r.gameCount; ++i)
+    {
+        if (!Archive_ReadGame(r, i, game))
+        {
+            fprintf(stderr, "cannot read game %llu\n", (unsigned long long)i);
+            Archive_Close(r);
+            return 1;
+        }
+        IndexGame(game, (uint32_t)i, entries);
+    }
+    uint64_t games = r.gameCount;
+    Archive_Close(r);
+
+    auto t1 = std::chrono::steady_clock::now();
+    if (!PositionIndex_Write(argv[0], entries, games))
+    {
+        fprintf(stderr, "cannot write %s\n", argv[0]);
+        return 1;
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    printf("%llu games, %llu positions (replay %.2f s, sort+write %.2f s)\n",
+        (unsigned long long)games, (unsigned long long)entries.size(),
+        std::chrono::duration<double>(t1 - t0).count(), std::chrono::duration<double>(t2 - t1).count());
+    return 0;
+}
+
+// index-query <index.amzx> <game.pbn> [ply]   (position after 'ply' moves, default: the last one)
+int Tool_IndexQuery(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: index-query <index.amzx> <game.pbn> [ply]\n");
+        return 1;
+    }
+    Position pos;
+    if (!Tool_LoadPbnPosition(argv[1], (argc > 2) ? atoi(argv[2]) : -1, pos)) return 1;
+
+    PositionIndex idx;
+    if (!PositionIndex_Open(idx, std::string(argv[0])))
+    {
+        fprintf(stderr, "cannot open index %s\n", argv[0]);
+        return 1;
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    size_t count = 0;
+    const PositionIndexEntry* hits = PositionIndex_Find(idx, Position_CanonicalKey(pos), count);
+    PositionIndexStats stats;
+    PositionIndex_Summarize(hits, count, stats);
+    auto t1 = std::chrono::steady_clock::now();
+
+    printf("%u games reach this position (white %u, black %u, unfinished %u) in %.3f ms over %llu positions\n",
+        stats.games, stats.whiteWins, stats.blackWins, stats.unfinished,
+        std::chrono::duration<double, std::milli>(t1 - t0).count(), (unsigned long long)idx.entryCount);
+    for (size_t i = 0; i < count && i < 20; ++i)
+        printf("  game %u ply %u\n", hits[i].game, hits[i].ply);
+    if (count > 20) printf("  ...\n");
+    PositionIndex_Close(idx);
+    return 0;
+}
@@ -0,0 +1,680 @@
+// match_tools.cpp : engine-vs-engine matches for tuning and book building, played locally or spread
+// over worker processes on other machines, and self-play games sampled into training shards
+// (training_shards.h).
+//
+// A match is a list of game jobs: a random opening of a few plies from a seeded generator and the
+// search limits of each colour. Every opening is played twice with the colours of the two engine
+// configurations A and B swapped. Searches are single-threaded and start from a cleared engine;
+// node-limited ones give the same game wherever and however often a job is played, so a local
+// match and a distributed one with the same arguments write identical archives. Time-limited
+// configurations (for comparing search features at equal time) do not repeat exactly.
+//
+// Distributed protocol (frames of net.h, integers little-endian):
+//   worker -> coordinator  HELLO   u32 protocol version
+//   coordinator -> worker  JOB     u32 job id, black then white: u64 nodes, u32 depth, u32 ms, u32 lmr,
+//                                  u32 destinations, u32 arrows; opening as an archive game record
+//                                  (game_archive.h)
+//   worker -> coordinator  RESULT  u32 job id, u64 nodes searched, black then white: u32 searches,
+//                                  u32 sum of completed depths; the whole game as a record
+//   coordinator -> worker  DONE    no payload; the worker exits
+// Each worker thread holds its own connection and one job at a time. The coordinator hands a job
+// back to the queue when its connection drops or it has been out longer than the job timeout; the
+// first valid result of a job is kept and later ones are ignored.
+
+#include "tools.h"
+#include "engine.h"
+#include "game_archive.h"
+#include "net.h"
+#include "position.h"
+#include "position_index.h"
+#include "training_shards.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum { MSG_HELLO = 1, MSG_JOB = 2, MSG_RESULT = 3, MSG_DONE = 4 };
+static const uint32_t kProtocolVersion = 2;
+static const int kOpeningPlies = 4;
+
+struct MatchConfig
+{
+    uint64_t nodes = 20000;     // per move, unless timeMs is set
+    int timeMs = 0;
+    int depth = ENGINE_MAX_PLY;
+    // selective search (SearchLimits)
+    int lmrMoves = 0;
+    int keepDestinations = 0;
+    int keepArrows = 0;
+};
+
+struct MatchJob
+{
+    uint32_t id = 0;
+    bool aIsBlack = true;
+    MatchConfig side[2];        // [0] white, [1] black, as in Position::amazon
+    ArchiveGame opening;
+};
+
+struct MatchResult
+{
+    bool done = false;
+    ArchiveGame game;
+    uint64_t nodes = 0;
+    uint32_t searches[2] = {};  // [0] white, [1] black
+    uint32_t depthSum[2] = {};  // completed iterations summed over the searches
+    std::vector<int> scores;    // of each engine move, for the side that made it
+};
+
+// "<nodes>" or "<ms>ms", then optionally ":depth" and ":lmr,destinations,arrows"
+static bool ParseConfig(const char* text, MatchConfig &out)
+{
+    char* end = nullptr;
+    uint64_t budget = strtoull(text, &end, 10);
+    if (end == text || budget == 0) return false;
+    if (strncmp(end, "ms", 2) == 0)
+    {
+        out.timeMs = (int)budget;
+        end += 2;
+    }
+    else
+    {
+        out.nodes = budget;
+    }
+    if (*end == ':') out.depth = (int)strtol(end + 1, &end, 10);
+    if (*end == ':')
+    {
+        SearchLimits limits;
+        if (!Tool_ParseSelective(end + 1, limits)) return false;
+        out.lmrMoves = limits.lmrMoves;
+        out.keepDestinations = limits.keepDestinations;
+        out.keepArrows = limits.keepArrows;
+    }
+    else if (*end != 0)
+    {
+        return false;
+    }
+    return out.depth > 0;
+}
+
+// Paired: job pairs share a random opening; job 2k gives A black, job 2k+1 gives A white.
+// Otherwise every job gets its own opening (self-play, where A and B are the same).
+static void BuildJobs(int games, int size, const MatchConfig &a, const MatchConfig &b, uint32_t seed, bool paired,
+    std::vector<MatchJob> &out)
+{
+    std::mt19937 rng(seed);
+    std::vector<PosMove> moves;
+    out.resize((size_t)games);
+    for (int i = 0; i < games; ++i)
+    {
+        MatchJob &job = out[(size_t)i];
+        job.id = (uint32_t)i;
+        job.aIsBlack = (i % 2) == 0;
+        job.side[1] = job.aIsBlack ? a : b;
+        job.side[0] = job.aIsBlack ? b : a;
+        if (paired && i % 2 == 1)
+        {
+            job.opening = out[(size_t)i - 1].opening;
+            continue;
+        }
+        job.opening = ArchiveGame();
+        job.opening.boardSize = size;
+        Position pos;
+        Position_Init(pos, size);
+        for (int ply = 0; ply < kOpeningPlies; ++ply)
+        {
+            Position_GenerateMoves(pos, moves);
+            if (moves.empty()) break;
+            PosMove m = moves[rng() % moves.size()];
+            Position_MakeMove(pos, m);
+            job.opening.moves.push_back({ m.from, m.to, m.arrow });
+        }
+    }
+}
+
+// Plays the job's opening and then engine moves until the side to move is stuck.
+static void PlayJob(Engine* engine, const MatchJob &job, MatchResult &out)
+{
+    out = MatchResult();
+    ArchiveGame &game = out.game;
+    game = job.opening;
+    Position pos;
+    Position_InitSetup(pos, game.boardSize, game.setup);
+    for (const ArchiveMove &am : game.moves)
+    {
+        PosMove m = { am.from, am.to, am.arrow };
+        Position_MakeMove(pos, m);
+    }
+    Engine_Clear(engine);
+    for (;;)
+    {
+        int side = pos.blackToMove ? 1 : 0;
+        const MatchConfig &c = job.side[side];
+        SearchLimits limits;
+        limits.timeMs = c.timeMs;
+        limits.maxNodes = c.timeMs > 0 ? 0 : c.nodes;
+        limits.maxDepth = c.depth;
+        limits.lmrMoves = c.lmrMoves;
+        limits.keepDestinations = c.keepDestinations;
+        limits.keepArrows = c.keepArrows;
+        SearchResult result;
+        if (!Engine_Search(engine, pos, limits, result) || !result.hasMove) break;
+        out.nodes += result.stats.nodes;
+        ++out.searches[side];
+        out.depthSum[side] += (uint32_t)result.stats.depth;
+        out.scores.push_back(result.score);
+        Position_MakeMove(pos, result.best);
+        game.moves.push_back({ result.best.from, result.best.to, result.best.arrow });
+    }
+}
+
+// A result is accepted only if it continues the job's opening with legal moves to a finished game.
+static bool IsValidResult(const MatchJob &job, const ArchiveGame &game)
+{
+    const ArchiveGame &o = job.opening;
+    if (game.boardSize != o.boardSize || game.setup.custom != o.setup.custom || game.moves.size() < o.moves.size())
+        return false;
+    if (!o.moves.empty() && memcmp(game.moves.data(), o.moves.data(), o.moves.size() * sizeof(ArchiveMove)) != 0)
+        return false;
+    Position pos;
+    Position_InitSetup(pos, game.boardSize, game.setup);
+    for (const ArchiveMove &am : game.moves)
+    {
+        PosMove m = { am.from, am.to, am.arrow };
+        if (!Position_IsLegalMove(pos, m)) return false;
+        Position_MakeMove(pos, m);
+    }
+    return !Position_HasAnyMove(pos);
+}
+
+// the side to move when the game ends has lost; black moves first
+static bool BlackWon(const ArchiveGame &game)
+{
+    return (game.moves.size() % 2) == 1;
+}
+
+static bool WriteMatch(const char* path, const std::vector<MatchJob> &jobs, const std::vector<MatchResult> &results,
+    double seconds)
+{
+    ArchiveWriter w;
+    if (!Archive_Create(w, path))
+    {
+        fprintf(stderr, "cannot create %s\n", path);
+        return false;
+    }
+    int winsA = 0, blackWins = 0;
+    uint64_t moves = 0, nodes = 0;
+    uint64_t searches[2] = {}, depthSum[2] = {};   // [0] A, [1] B
+    bool ok = true;
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        const ArchiveGame &g = results[i].game;
+        ok = ok && Archive_AppendGame(w, g);
+        if (BlackWon(g)) ++blackWins;
+        if (BlackWon(g) == jobs[i].aIsBlack) ++winsA;
+        moves += g.moves.size();
+        nodes += results[i].nodes;
+        for (int side = 0; side < 2; ++side)
+        {
+            int engine = ((side == 1) == jobs[i].aIsBlack) ? 0 : 1;
+            searches[engine] += results[i].searches[side];
+            depthSum[engine] += results[i].depthSum[side];
+        }
+    }
+    ok = Archive_Finish(w) && ok;
+    if (!ok)
+    {
+        fprintf(stderr, "write error on %s\n", path);
+        return false;
+    }
+    int games = (int)jobs.size();
+    printf("%d games, %llu moves, %llu nodes in %.1f s\n", games, (unsigned long long)moves, (unsigned long long)nodes, seconds);
+    printf("A %d - B %d  (black won %d)\n", winsA, games - winsA, blackWins);
+    printf("average depth: A %.2f, B %.2f\n", searches[0] ? (double)depthSum[0] / searches[0] : 0.0,
+        searches[1] ? (double)depthSum[1] / searches[1] : 0.0);
+    return true;
+}
+
+static double SecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static const char* Arg(int argc, char** argv, int i)
+{
+    return (i < argc) ? argv[i] : nullptr;
+}
+
+// arguments shared by match and match-coord; null pointers take the defaults
+static bool ParseMatchArgs(int games, const char* size, const char* a, const char* b, const char* seed,
+    std::vector<MatchJob> &jobs)
+{
+    int boardSize = size ? atoi(size) : 10;
+    MatchConfig ca, cb;
+    if ((a && !ParseConfig(a, ca)) || (b && !ParseConfig(b, cb)))
+    {
+        fprintf(stderr, "engine configs are <nodes>|<ms>ms[:depth[:lmr,destinations,arrows]]\n");
+        return false;
+    }
+    if (games <= 0 || boardSize < POSITION_MIN_SIDE || boardSize > POSITION_MAX_SIDE)
+    {
+        fprintf(stderr, "bad game count or board size\n");
+        return false;
+    }
+    BuildJobs(games, boardSize, ca, cb, seed ? (uint32_t)strtoul(seed, nullptr, 10) : 1, true, jobs);
+    return true;
+}
+
+// match <out.amzb> <games> [size] [A] [B] [threads] [seed]
+int Tool_Match(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: match <out.amzb> <games> [size] [A] [B] [threads] [seed]\n"
+            "  engine configs: <nodes>|<ms>ms[:depth[:lmr,destinations,arrows]]\n");
+        return 1;
+    }
+    std::vector<MatchJob> jobs;
+    if (!ParseMatchArgs(atoi(argv[1]), Arg(argc, argv, 2), Arg(argc, argv, 3), Arg(argc, argv, 4), Arg(argc, argv, 6), jobs))
+        return 1;
+    int threads = (argc > 5) ? atoi(argv[5]) : (int)std::thread::hardware_concurrency();
+    if (threads < 1) threads = 1;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<MatchResult> results(jobs.size());
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&]() {
+            Engine* engine = Engine_Create(16);
+            for (size_t i; (i = next.fetch_add(1)) < jobs.size(); )
+            {
+                PlayJob(engine, jobs[i], results[i]);
+                results[i].done = true;
+            }
+            Engine_Destroy(engine);
+        });
+    }
+    for (auto &w : workers) w.join();
+    return WriteMatch(argv[0], jobs, results, SecondsSince(start)) ? 0 : 1;
+}
+
+// ---- self-play ----
+
+// Samples of a finished self-play game: the position before every engine move, with its score and
+// the move played, labelled with the game's result; 'every' > 1 keeps one in 'every' (from an
+// offset that varies by game).
+static void SampleGame(const MatchJob &job, const MatchResult &result, int every, std::vector<TrainingSample> &out)
+{
+    out.clear();
+    const ArchiveGame &game = result.game;
+    uint8_t winner = BlackWon(game) ? GAME_RESULT_BLACK : GAME_RESULT_WHITE;
+    Position pos;
+    Position_InitSetup(pos, game.boardSize, game.setup);
+    size_t opening = job.opening.moves.size();
+    for (size_t i = 0; i < game.moves.size(); ++i)
+    {
+        PosMove m = { game.moves[i].from, game.moves[i].to, game.moves[i].arrow };
+        size_t k = i - opening;     // engine move number
+        if (i >= opening && (k + job.id) % (size_t)every == 0)
+        {
+            TrainingSample s;
+            TrainingSample_FromPosition(pos, s);
+            s.result = winner;
+            s.score = (int16_t)std::max(-32767, std::min(32767, result.scores[k]));
+            s.best = m;
+            out.push_back(s);
+        }
+        Position_MakeMove(pos, m);
+    }
+}
+
+// selfplay <prefix> <games> [size] [engine] [threads] [seed] [every] [shardRecords]
+int Tool_SelfPlay(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: selfplay <prefix> <games> [size] [engine] [threads] [seed] [every] [shardRecords]\n"
+            "  engine: <nodes>|<ms>ms[:depth[:lmr,destinations,arrows]]\n");
+        return 1;
+    }
+    int games = atoi(argv[1]);
+    int size = (argc > 2) ? atoi(argv[2]) : 10;
+    MatchConfig config;
+    if (argc > 3 && !ParseConfig(argv[3], config))
+    {
+        fprintf(stderr, "engine config is <nodes>|<ms>ms[:depth[:lmr,destinations,arrows]]\n");
+        return 1;
+    }
+    int threads = (argc > 4) ? atoi(argv[4]) : (int)std::thread::hardware_concurrency();
+    uint32_t seed = (argc > 5) ? (uint32_t)strtoul(argv[5], nullptr, 10) : 1;
+    int every = (argc > 6) ? std::max(atoi(argv[6]), 1) : 1;
+    uint32_t perShard = (argc > 7) ? (uint32_t)strtoul(argv[7], nullptr, 10) : (1u << 20);
+    if (games <= 0 || size < POSITION_MIN_SIDE || size > POSITION_MAX_SIDE)
+    {
+        fprintf(stderr, "bad game count or board size\n");
+        return 1;
+    }
+    if (threads < 1) threads = 1;
+    std::vector<MatchJob> jobs;
+    BuildJobs(games, size, config, config, seed, false, jobs);
+    TrainingWriter* writer = TrainingWriter_Create(argv[0], size, perShard);
+    if (!writer) return 1;
+
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<size_t> next(0);
+    std::atomic<uint64_t> nodes(0), writeMicros(0);
+    std::atomic<bool> failed(false);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&]() {
+            Engine* engine = Engine_Create(16);
+            MatchResult result;
+            std::vector<TrainingSample> samples;
+            for (size_t i; !failed && (i = next.fetch_add(1)) < jobs.size(); )
+            {
+                PlayJob(engine, jobs[i], result);
+                nodes += result.nodes;
+                SampleGame(jobs[i], result, every, samples);
+                auto t0 = std::chrono::steady_clock::now();
+                if (!TrainingWriter_Add(writer, samples.data(), samples.size())) failed = true;
+                writeMicros += (uint64_t)(SecondsSince(t0) * 1e6);
+            }
+            Engine_Destroy(engine);
+        });
+    }
+    for (auto &w : workers) w.join();
+    uint64_t records = 0;
+    uint32_t shards = 0;
+    bool ok = TrainingWriter_Finish(writer, &records, &shards) && !failed;
+    double seconds = SecondsSince(start);
+    if (!ok)
+    {
+        fprintf(stderr, "write error on %s\n", argv[0]);
+        return 1;
+    }
+    printf("%d games, %llu nodes, %llu samples in %u shards (%.1f MB) in %.1f s: %.0f samples/s\n", games,
+        (unsigned long long)nodes.load(), (unsigned long long)records, shards,
+        records * TrainingSample_RecordSize(size) / 1048576.0, seconds, records / std::max(seconds, 1e-9));
+    // time the self-play threads spent handing samples to the writer, packing and shard writes included
+    printf("writer: %.3f%% of thread time\n", 100.0 * writeMicros.load() / 1e6 / std::max(seconds * threads, 1e-9));
+    return 0;
+}
+
+// ---- coordinator ----
+
+struct WorkerConn
+{
+    NetSocket socket = NET_INVALID;
+    NetFrameReader reader;
+    bool greeted = false;
+    int job = -1;                                   // job out on this connection, -1: idle
+    std::chrono::steady_clock::time_point since;    // when it was handed out
+    int completed = 0;
+};
+
+static void EncodeJob(const MatchJob &job, std::string &out)
+{
+    out.clear();
+    Net_PutU32(out, job.id);
+    for (int s = 1; s >= 0; --s)
+    {
+        const MatchConfig &c = job.side[s];
+        Net_PutU64(out, c.nodes);
+        Net_PutU32(out, (uint32_t)c.depth);
+        Net_PutU32(out, (uint32_t)c.timeMs);
+        Net_PutU32(out, (uint32_t)c.lmrMoves);
+        Net_PutU32(out, (uint32_t)c.keepDestinations);
+        Net_PutU32(out, (uint32_t)c.keepArrows);
+    }
+    Archive_EncodeGame(job.opening, out);
+}
+
+static const size_t kJobConfigBytes = 8 + 5 * 4;
+
+static bool DecodeJob(const std::string &payload, MatchJob &out)
+{
+    const uint8_t* p = (const uint8_t*)payload.data();
+    size_t used = 4 + 2 * kJobConfigBytes;
+    if (payload.size() < used) return false;
+    out.id = Net_GetU32(p);
+    for (int s = 1; s >= 0; --s)
+    {
+        const uint8_t* c = p + 4 + (size_t)(1 - s) * kJobConfigBytes;
+        MatchConfig &config = out.side[s];
+        config.nodes = Net_GetU64(c);
+        config.depth = (int)Net_GetU32(c + 8);
+        config.timeMs = (int)Net_GetU32(c + 12);
+        config.lmrMoves = (int)Net_GetU32(c + 16);
+        config.keepDestinations = (int)Net_GetU32(c + 20);
+        config.keepArrows = (int)Net_GetU32(c + 24);
+    }
+    return Archive_DecodeGame(p + used, payload.size() - used, out.opening) == payload.size() - used;
+}
+
+// match-coord <out.amzb> <games> <port> [size] [A] [B] [seed] [timeoutS]
+int Tool_MatchCoordinator(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: match-coord <out.amzb> <games> <port> [size] [A] [B] [seed] [timeoutS]\n"
+            "  engine configs: <nodes>|<ms>ms[:depth[:lmr,destinations,arrows]]\n");
+        return 1;
+    }
+    std::vector<MatchJob> jobs;
+    if (!ParseMatchArgs(atoi(argv[1]), Arg(argc, argv, 3), Arg(argc, argv, 4), Arg(argc, argv, 5), Arg(argc, argv, 6), jobs))
+        return 1;
+    int timeoutS = (argc > 7) ? atoi(argv[7]) : 600;
+    if (!Net_Startup()) return 1;
+    NetSocket listener = Net_Listen(atoi(argv[2]));
+    if (listener == NET_INVALID)
+    {
+        fprintf(stderr, "cannot listen on port %s\n", argv[2]);
+        return 1;
+    }
+    printf("coordinator: %zu jobs on port %s\n", jobs.size(), argv[2]);
+    fflush(stdout);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<MatchResult> results(jobs.size());
+    std::deque<int> pending;
+    for (size_t i = 0; i < jobs.size(); ++i) pending.push_back((int)i);
+    std::vector<WorkerConn> conns;
+    size_t doneCount = 0;
+    int reassigned = 0, rejected = 0, duplicates = 0;
+    std::string frame;
+
+    auto dropConn = [&](size_t c, const char* why) {
+        WorkerConn &w = conns[c];
+        if (w.job >= 0 && !results[(size_t)w.job].done)
+        {
+            pending.push_front(w.job);
+            ++reassigned;
+        }
+        printf("worker %d dropped (%s)%s\n", (int)w.socket, why, w.job >= 0 ? ", job requeued" : "");
+        Net_Close(w.socket);
+        conns.erase(conns.begin() + (ptrdiff_t)c);
+    };
+
+    while (doneCount < jobs.size())
+    {
+        // jobs out too long go back to the queue; their connection may still deliver first
+        auto now = std::chrono::steady_clock::now();
+        for (WorkerConn &w : conns)
+        {
+            if (w.job >= 0 && !results[(size_t)w.job].done && now - w.since > std::chrono::seconds(timeoutS))
+            {
+                bool queued = false;
+                for (int j : pending) queued = queued || j == w.job;
+                if (!queued)
+                {
+                    pending.push_back(w.job);
+                    ++reassigned;
+                    w.since = now;
+                }
+            }
+        }
+        // hand out work to idle connections
+        for (WorkerConn &w : conns)
+        {
+            if (!w.greeted || w.job >= 0) continue;
+            while (!pending.empty() && results[(size_t)pending.front()].done) pending.pop_front();
+            if (pending.empty()) break;
+            w.job = pending.front();
+            pending.pop_front();
+            w.since = now;
+            EncodeJob(jobs[(size_t)w.job], frame);
+            Net_SendFrame(w.socket, MSG_JOB, frame);    // a failed send shows up as a closed connection
+        }
+
+        std::vector<NetSocket> sockets(1, listener);
+        for (const WorkerConn &w : conns) sockets.push_back(w.socket);
+        int ready = Net_WaitReadable(sockets.data(), (int)sockets.size(), 1000);
+        if (ready < 0) continue;
+        if (ready == 0)
+        {
+            WorkerConn w;
+            w.socket = Net_Accept(listener);
+            if (w.socket != NET_INVALID) conns.push_back(w);
+            continue;
+        }
+        size_t c = (size_t)ready - 1;
+        if (!NetFrameReader_Fill(conns[c].reader, conns[c].socket))
+        {
+            dropConn(c, "closed");
+            continue;
+        }
+        uint8_t type;
+        std::string payload;
+        bool malformed = false, drop = false;
+        while (!drop && NetFrameReader_Next(conns[c].reader, type, payload, malformed))
+        {
+            WorkerConn &w = conns[c];
+            const uint8_t* p = (const uint8_t*)payload.data();
+            if (type == MSG_HELLO)
+            {
+                drop = payload.size() != 4 || Net_GetU32(p) != kProtocolVersion;
+                w.greeted = !drop;
+                continue;
+            }
+            const size_t kResultHeader = 12 + 4 * 4;
+            if (type != MSG_RESULT || payload.size() < kResultHeader)
+            {
+                drop = true;
+                continue;
+            }
+            uint32_t id = Net_GetU32(p);
+            ArchiveGame game;
+            bool valid = id < jobs.size()
+                && Archive_DecodeGame(p + kResultHeader, payload.size() - kResultHeader, game) == payload.size() - kResultHeader
+                && IsValidResult(jobs[id], game);
+            if ((int)id == w.job) w.job = -1;
+            if (!valid)
+            {
+                // the job stays in play; requeue it unless someone else has it
+                ++rejected;
+                if (id < jobs.size() && !results[id].done) pending.push_front((int)id);
+                continue;
+            }
+            if (results[id].done)
+            {
+                ++duplicates;
+                continue;
+            }
+            results[id].done = true;
+            results[id].game = game;
+            results[id].nodes = Net_GetU64(p + 4);
+            for (int s = 1; s >= 0; --s)
+            {
+                results[id].searches[s] = Net_GetU32(p + 12 + (1 - s) * 8);
+                results[id].depthSum[s] = Net_GetU32(p + 16 + (1 - s) * 8);
+            }
+            ++w.completed;
+            ++doneCount;
+            printf("job %u done (%zu/%zu), %zu moves, %s won\n", id, doneCount, jobs.size(), game.moves.size(),
+                BlackWon(game) == jobs[id].aIsBlack ? "A" : "B");
+            fflush(stdout);
+        }
+        if (drop || malformed) dropConn(c, "protocol error");
+    }
+
+    for (WorkerConn &w : conns)
+    {
+        Net_SendFrame(w.socket, MSG_DONE, std::string());
+        Net_Close(w.socket);
+    }
+    Net_Close(listener);
+    printf("reassigned %d, rejected %d, duplicate results %d\n", reassigned, rejected, duplicates);
+    return WriteMatch(argv[0], jobs, results, SecondsSince(start)) ? 0 : 1;
+}
+
+// ---- worker ----
+
+static void WorkerThread(const char* host, int port, int index, std::atomic<int> &played)
+{
+    NetSocket s = NET_INVALID;
+    // the coordinator may still be starting up
+    for (int attempt = 0; attempt < 50 && s == NET_INVALID; ++attempt)
+    {
+        s = Net_Connect(host, port);
+        if (s == NET_INVALID) std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+    if (s == NET_INVALID)
+    {
+        fprintf(stderr, "worker %d: cannot connect to %s:%d\n", index, host, port);
+        return;
+    }
+    std::string payload;
+    Net_PutU32(payload, kProtocolVersion);
+    Engine* engine = Engine_Create(16);
+    uint8_t type;
+    bool ok = Net_SendFrame(s, MSG_HELLO, payload);
+    while (ok && Net_RecvFrame(s, type, payload) && type == MSG_JOB)
+    {
+        MatchJob job;
+        if (!DecodeJob(payload, job)) break;
+        MatchResult result;
+        PlayJob(engine, job, result);
+        payload.clear();
+        Net_PutU32(payload, job.id);
+        Net_PutU64(payload, result.nodes);
+        for (int s = 1; s >= 0; --s)
+        {
+            Net_PutU32(payload, result.searches[s]);
+            Net_PutU32(payload, result.depthSum[s]);
+        }
+        Archive_EncodeGame(result.game, payload);
+        ok = Net_SendFrame(s, MSG_RESULT, payload);
+        ++played;
+    }
+    Engine_Destroy(engine);
+    Net_Close(s);
+}
+
+// match-worker <host> <port> [threads]   plays jobs until the coordinator is done
+int Tool_MatchWorker(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: match-worker <host> <port> [threads]\n");
+        return 1;
+    }
+    int threads = (argc > 2) ? atoi(argv[2]) : (int)std::thread::hardware_concurrency();
+    if (threads < 1) threads = 1;
+    if (!Net_Startup()) return 1;
+    std::atomic<int> played(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+        workers.emplace_back(WorkerThread, argv[0], atoi(argv[1]), t, std::ref(played));
+    for (auto &w : workers) w.join();
+    printf("worker: played %d games\n", played.load());
+    return 0;
+}
@@ -0,0 +1,229 @@
+#include "net.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32")
+#else
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+const NetSocket NET_INVALID = (NetSocket)INVALID_SOCKET;
+#else
+const NetSocket NET_INVALID = -1;
+#endif
+
+bool Net_Startup()
+{
+#ifdef _WIN32
+    WSADATA wsa;
+    return WSAStartup(MAKEWORD(2, 2), &wsa) == 0;
+#else
+    return true;
+#endif
+}
+
+static void SetNoDelay(NetSocket s)
+{
+    int one = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one));
+}
+
+NetSocket Net_Listen(int port, bool loopbackOnly)
+{
+    NetSocket s = (NetSocket)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == NET_INVALID) return NET_INVALID;
+    int one = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char*)&one, sizeof(one));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(loopbackOnly ? INADDR_LOOPBACK : INADDR_ANY);
+    addr.sin_port = htons((unsigned short)port);
+    if (bind(s, (const sockaddr*)&addr, sizeof(addr)) != 0 || listen(s, SOMAXCONN) != 0)
+    {
+        Net_Close(s);
+        return NET_INVALID;
+    }
+    return s;
+}
+
+NetSocket Net_Accept(NetSocket listener)
+{
+    NetSocket s = (NetSocket)accept(listener, nullptr, nullptr);
+    if (s != NET_INVALID) SetNoDelay(s);
+    return s;
+}
+
+NetSocket Net_Connect(const char* host, int port)
+{
+    char service[16];
+    snprintf(service, sizeof(service), "%d", port);
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* list = nullptr;
+    if (getaddrinfo(host, service, &hints, &list) != 0) return NET_INVALID;
+    NetSocket s = NET_INVALID;
+    for (addrinfo* a = list; a && s == NET_INVALID; a = a->ai_next)
+    {
+        s = (NetSocket)socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (s == NET_INVALID) continue;
+        if (connect(s, a->ai_addr, (int)a->ai_addrlen) != 0)
+        {
+            Net_Close(s);
+            s = NET_INVALID;
+        }
+    }
+    freeaddrinfo(list);
+    if (s != NET_INVALID) SetNoDelay(s);
+    return s;
+}
+
+void Net_Close(NetSocket s)
+{
+    if (s == NET_INVALID) return;
+#ifdef _WIN32
+    closesocket(s);
+#else
+    close(s);
+#endif
+}
+
+bool Net_SendAll(NetSocket s, const void* data, size_t size)
+{
+    const char* p = (const char*)data;
+    while (size > 0)
+    {
+        int chunk = size > (1u << 30) ? (1 << 30) : (int)size;
+#ifdef _WIN32
+        int sent = send(s, p, chunk, 0);
+#else
+        int sent = (int)send(s, p, (size_t)chunk, MSG_NOSIGNAL);   // a closed peer is an error, not SIGPIPE
+#endif
+        if (sent <= 0) return false;
+        p += sent;
+        size -= (size_t)sent;
+    }
+    return true;
+}
+
+int Net_Recv(NetSocket s, void* buf, size_t size)
+{
+    int chunk = size > (1u << 30) ? (1 << 30) : (int)size;
+    return (int)recv(s, (char*)buf, chunk, 0);
+}
+
+int Net_Poll(const NetSocket* sockets, int count, int timeoutMs, uint8_t* readable)
+{
+#ifdef _WIN32
+    std::vector<WSAPOLLFD> fds((size_t)count);
+#else
+    std::vector<pollfd> fds((size_t)count);
+#endif
+    for (int i = 0; i < count; ++i)
+    {
+        fds[(size_t)i].fd = sockets[i];
+        fds[(size_t)i].events = POLLIN;
+        fds[(size_t)i].revents = 0;
+    }
+#ifdef _WIN32
+    int ready = WSAPoll(fds.data(), (ULONG)count, timeoutMs);
+#else
+    int ready = poll(fds.data(), (nfds_t)count, timeoutMs);
+#endif
+    for (int i = 0; i < count; ++i)
+        readable[i] = ready > 0 && (fds[(size_t)i].revents & (POLLIN | POLLHUP | POLLERR | POLLNVAL)) != 0;
+    return ready;
+}
+
+int Net_WaitReadable(const NetSocket* sockets, int count, int timeoutMs)
+{
+    std::vector<uint8_t> readable((size_t)count);
+    if (count <= 0 || Net_Poll(sockets, count, timeoutMs, readable.data()) <= 0) return -1;
+    for (int i = 0; i < count; ++i)
+        if (readable[(size_t)i]) return i;
+    return -1;
+}
+
+// ---- frames ----
+
+void Net_PutU32(std::string &out, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i) out += (char)(uint8_t)(v >> (8 * i));
+}
+
+void Net_PutU64(std::string &out, uint64_t v)
+{
+    for (int i = 0; i < 8; ++i) out += (char)(uint8_t)(v >> (8 * i));
+}
+
+uint32_t Net_GetU32(const uint8_t* p)
+{
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; --i) v = (v << 8) | p[i];
+    return v;
+}
+
+uint64_t Net_GetU64(const uint8_t* p)
+{
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+    return v;
+}
+
+bool Net_SendFrame(NetSocket s, uint8_t type, const std::string &payload)
+{
+    std::string frame;
+    frame.reserve(5 + payload.size());
+    Net_PutU32(frame, (uint32_t)(payload.size() + 1));
+    frame += (char)type;
+    frame += payload;
+    return Net_SendAll(s, frame.data(), frame.size());
+}
+
+bool Net_RecvFrame(NetSocket s, uint8_t &type, std::string &payload)
+{
+    NetFrameReader r;
+    bool malformed = false;
+    while (!NetFrameReader_Next(r, type, payload, malformed))
+    {
+        if (malformed || !NetFrameReader_Fill(r, s)) return false;
+    }
+    return true;
+}
+
+bool NetFrameReader_Fill(NetFrameReader &r, NetSocket s)
+{
+    char buf[65536];
+    int got = Net_Recv(s, buf, sizeof(buf));
+    if (got <= 0) return false;
+    r.buffer.append(buf, (size_t)got);
+    return true;
+}
+
+bool NetFrameReader_Next(NetFrameReader &r, uint8_t &type, std::string &payload, bool &malformed)
+{
+    malformed = false;
+    if (r.buffer.size() < 5) return false;
+    uint32_t length = Net_GetU32((const uint8_t*)r.buffer.data());
+    if (length == 0 || length > NET_MAX_FRAME)
+    {
+        malformed = true;
+        return false;
+    }
+    if (r.buffer.size() < 4 + (size_t)length) return false;
+    type = (uint8_t)r.buffer[4];
+    payload.assign(r.buffer, 5, length - 1);
+    r.buffer.erase(0, 4 + (size_t)length);
+    return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+// Minimal blocking TCP sockets for the tools (Winsock on Windows, BSD sockets elsewhere), plus the
+// length-prefixed frames the distributed commands exchange: u32 length (little-endian, counting the
+// type byte and payload), u8 type, payload.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+typedef uintptr_t NetSocket;
+#else
+typedef int NetSocket;
+#endif
+extern const NetSocket NET_INVALID;
+
+bool Net_Startup();                                     // once per process (WSAStartup)
+NetSocket Net_Listen(int port, bool loopbackOnly = false);  // NET_INVALID on failure
+NetSocket Net_Accept(NetSocket listener);
+NetSocket Net_Connect(const char* host, int port);      // host name or address
+void Net_Close(NetSocket s);
+
+bool Net_SendAll(NetSocket s, const void* data, size_t size);
+// bytes received (> 0), 0 when the peer closed the connection, < 0 on error
+int Net_Recv(NetSocket s, void* buf, size_t size);
+// waits until one of 'sockets' is readable; returns its index, -1 on timeout or error
+int Net_WaitReadable(const NetSocket* sockets, int count, int timeoutMs);
+// Waits until any of 'sockets' is readable (a closed or failed connection counts as readable) and
+// sets readable[i] for each; returns the number ready, 0 on timeout, < 0 on error. poll-based, so
+// not limited to FD_SETSIZE sockets.
+int Net_Poll(const NetSocket* sockets, int count, int timeoutMs, uint8_t* readable);
+
+// frames
+#define NET_MAX_FRAME (1u << 24)
+bool Net_SendFrame(NetSocket s, uint8_t type, const std::string &payload);
+// Blocks until a whole frame arrived; false if the connection closed or sent a malformed frame.
+bool Net_RecvFrame(NetSocket s, uint8_t &type, std::string &payload);
+
+// Buffers bytes of one connection as they arrive and cuts them into frames (for select loops).
+struct NetFrameReader
+{
+    std::string buffer;
+};
+// Reads what is available (call when the socket is readable); false if the peer closed or failed.
+bool NetFrameReader_Fill(NetFrameReader &r, NetSocket s);
+// Takes the next complete frame off the buffer; false if none is complete yet. 'malformed' is set
+// when the buffer starts with an impossible frame length.
+bool NetFrameReader_Next(NetFrameReader &r, uint8_t &type, std::string &payload, bool &malformed);
+
+// little-endian helpers for frame payloads
+void Net_PutU32(std::string &out, uint32_t v);
+void Net_PutU64(std::string &out, uint64_t v);
+uint32_t Net_GetU32(const uint8_t* p);
+uint64_t Net_GetU64(const uint8_t* p);
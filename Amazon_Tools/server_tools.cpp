@@ -0,0 +1,744 @@
+// server_tools.cpp : host many human-vs-AI games from one process, and a load generator for it.
+//
+// serve listens on a loopback TCP port for newline-delimited JSON requests. Every request is one
+// flat JSON object with an "op" and an optional numeric "id" that is echoed in its response line;
+// a connection may drive any number of sessions and receives responses as they complete, which for
+// "ai" requests need not be in request order:
+//   {"op":"new","size":10,"ai":"white"}          -> {"id":..,"ok":true,"session":7}
+//   {"op":"move","session":7,"move":"D1 D7 G7"}  -> {"id":..,"ok":true,"ply":1,"winner":null}
+//   {"op":"ai","session":7,"ms":50}              -> {"id":..,"ok":true,"move":"G10 G3 D3","score":..,"depth":..,..}
+//   {"op":"undo","session":7,"count":2}          -> {"id":..,"ok":true,"ply":..}
+//   {"op":"state","session":7} / {"op":"close","session":7} / {"op":"stats"} / {"op":"shutdown"}
+// Failures answer {"id":..,"ok":false,"error":"..."}. "ai" plays an engine move for the side to
+// move; "move" is refused while it is the AI's turn or a search for the session is pending.
+//
+// One I/O thread parses requests and applies the cheap ones at once; "ai" requests go to a
+// work-stealing thread pool (thread_pool.h) with one Engine per pool thread. The time budget of a
+// request ("ms", capped by the server) counts from its arrival, so time spent queued is taken off
+// the search. Latency from arrival to response is recorded per request kind and reported as
+// p50/p99 by "stats" and when the server stops.
+
+#include "tools.h"
+#include "engine.h"
+#include "game_archive.h"
+#include "net.h"
+#include "pbn_parser.h"
+#include "position.h"
+#include "session_store.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static double MsSince(Clock::time_point t)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - t).count();
+}
+
+// ---- flat JSON objects ----
+
+struct JsonField
+{
+    std::string key;
+    std::string value;          // unescaped string, or the literal text of a number/true/false/null
+    bool isString;
+};
+
+static const char* SkipSpace(const char* p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) ++p;
+    return p;
+}
+
+static const char* ParseString(const char* p, const char* end, std::string &out)
+{
+    out.clear();
+    if (p >= end || *p != '"') return nullptr;
+    for (++p; p < end && *p != '"'; ++p)
+    {
+        if (*p != '\\')
+        {
+            out += *p;
+            continue;
+        }
+        if (++p >= end) return nullptr;
+        switch (*p)
+        {
+        case 'n': out += '\n'; break;
+        case 't': out += '\t'; break;
+        case 'r': out += '\r'; break;
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'u':
+            // only ASCII is meaningful in requests; anything else becomes '?'
+            if (end - p < 5) return nullptr;
+            {
+                unsigned code = (unsigned)strtoul(std::string(p + 1, 4).c_str(), nullptr, 16);
+                out += code < 128 ? (char)code : '?';
+            }
+            p += 4;
+            break;
+        default: out += *p; break;
+        }
+    }
+    return (p < end) ? p + 1 : nullptr;
+}
+
+// One object of string, number, true/false/null members; nested values are not accepted.
+static bool ParseFlatJson(const char* p, const char* end, std::vector<JsonField> &out)
+{
+    out.clear();
+    p = SkipSpace(p, end);
+    if (p >= end || *p != '{') return false;
+    p = SkipSpace(p + 1, end);
+    if (p < end && *p == '}') return SkipSpace(p + 1, end) == end;
+    for (;;)
+    {
+        JsonField f;
+        p = ParseString(SkipSpace(p, end), end, f.key);
+        if (!p) return false;
+        p = SkipSpace(p, end);
+        if (p >= end || *p != ':') return false;
+        p = SkipSpace(p + 1, end);
+        if (p >= end) return false;
+        f.isString = *p == '"';
+        if (f.isString)
+        {
+            p = ParseString(p, end, f.value);
+            if (!p) return false;
+        }
+        else
+        {
+            const char* start = p;
+            while (p < end && *p != ',' && *p != '}' && *p != ' ' && *p != '\t') ++p;
+            f.value.assign(start, p);
+            if (f.value.empty() || f.value[0] == '{' || f.value[0] == '[') return false;
+        }
+        out.push_back(f);
+        p = SkipSpace(p, end);
+        if (p < end && *p == ',') { ++p; continue; }
+        if (p < end && *p == '}') return SkipSpace(p + 1, end) == end;
+        return false;
+    }
+}
+
+static const JsonField* JsonFind(const std::vector<JsonField> &fields, const char* key)
+{
+    for (const JsonField &f : fields)
+        if (f.key == key) return &f;
+    return nullptr;
+}
+
+static long long JsonInt(const std::vector<JsonField> &fields, const char* key, long long fallback)
+{
+    const JsonField* f = JsonFind(fields, key);
+    return (f && !f->isString) ? strtoll(f->value.c_str(), nullptr, 10) : fallback;
+}
+
+static std::string JsonString(const std::vector<JsonField> &fields, const char* key)
+{
+    const JsonField* f = JsonFind(fields, key);
+    return (f && f->isString) ? f->value : std::string();
+}
+
+// ---- latency records ----
+
+// A fixed histogram of 5%-wide buckets from 10 us up, so a long-running server keeps constant memory
+// per log; percentiles are reported as the middle of their bucket (within 2.5%), the maximum exactly.
+static const int kLatencyBuckets = 400;
+static const double kLatencyMinMs = 0.01;
+static const double kLatencyGrowth = 1.05;
+
+struct LatencyLog
+{
+    std::mutex lock;
+    uint64_t count = 0;
+    double maxMs = 0.0;
+    uint64_t buckets[kLatencyBuckets] = {};
+};
+
+static void Latency_Add(LatencyLog &log, double ms)
+{
+    int b = ms > kLatencyMinMs ? (int)(std::log(ms / kLatencyMinMs) / std::log(kLatencyGrowth)) : 0;
+    b = std::min(b, kLatencyBuckets - 1);
+    std::lock_guard<std::mutex> guard(log.lock);
+    ++log.buckets[b];
+    ++log.count;
+    log.maxMs = std::max(log.maxMs, ms);
+}
+
+// {"count":..,"p50":..,"p99":..,"max":..} in milliseconds
+static std::string Latency_Json(LatencyLog &log)
+{
+    uint64_t buckets[kLatencyBuckets];
+    uint64_t count;
+    double maxMs;
+    {
+        std::lock_guard<std::mutex> guard(log.lock);
+        memcpy(buckets, log.buckets, sizeof(buckets));
+        count = log.count;
+        maxMs = log.maxMs;
+    }
+    // the sample of rank q * count, as when indexing the sorted samples
+    auto at = [&](double q) {
+        if (count == 0) return 0.0;
+        uint64_t rank = std::min(count - 1, (uint64_t)(q * count)), seen = 0;
+        int b = 0;
+        while (seen + buckets[b] <= rank) seen += buckets[b++];
+        return std::min(maxMs, kLatencyMinMs * std::pow(kLatencyGrowth, b + 0.5));
+    };
+    char buf[160];
+    snprintf(buf, sizeof(buf), "{\"count\":%llu,\"p50\":%.2f,\"p99\":%.2f,\"max\":%.2f}", (unsigned long long)count,
+        at(0.50), at(0.99), maxMs);
+    return buf;
+}
+
+// ---- server ----
+
+struct ServerConn
+{
+    NetSocket socket = NET_INVALID;
+    std::string inbox;
+    std::mutex sendLock;
+    bool closed = false;            // set under sendLock before the socket is closed
+};
+
+struct Server
+{
+    ThreadPool* pool = nullptr;
+    std::vector<Engine*> engines;   // one per pool thread
+    int defaultMs = 100;
+    int maxMs = 5000;
+    SessionStore* store = nullptr;  // sessions (session_store.h), guarded by storeLock
+    std::mutex storeLock;
+    uint32_t idleSeconds = 0;       // evict sessions idle this long; 0: never
+    std::vector<std::shared_ptr<ServerConn>> conns;                          // I/O thread only
+    LatencyLog aiLatency;           // "ai": arrival to response
+    LatencyLog opLatency;           // all other requests
+    std::atomic<uint64_t> requests{ 0 };
+    std::atomic<int> searching{ 0 };  // "ai" requests submitted and not yet answered
+    bool stopping = false;
+};
+
+static void Send(ServerConn &c, const std::string &line)
+{
+    std::lock_guard<std::mutex> guard(c.sendLock);
+    if (!c.closed && !Net_SendAll(c.socket, line.data(), line.size())) c.closed = true;
+}
+
+static std::string ReplyHead(long long id)
+{
+    char buf[48];
+    snprintf(buf, sizeof(buf), "{\"id\":%lld,\"ok\":true", id);
+    return buf;
+}
+
+static std::string ErrorLine(long long id, const char* error)
+{
+    char buf[160];
+    snprintf(buf, sizeof(buf), "{\"id\":%lld,\"ok\":false,\"error\":\"%s\"}\n", id, error);
+    return buf;
+}
+
+// "white"/"black" once the side to move is stuck, else null
+static const char* WinnerJson(const Position &pos)
+{
+    if (Position_HasAnyMove(pos)) return "null";
+    return pos.blackToMove ? "\"white\"" : "\"black\"";
+}
+
+static bool ParseMoveText(const std::string &text, int size, PosMove &out)
+{
+    // the record form without its "[W]"/"[B]" side tag
+    std::string line = "[] " + text;
+    PbnMove pm;
+    ArchiveMove am;
+    if (!Pbn_ParseMove(line.data(), line.size(), pm) || !Archive_MoveFromPbn(pm, size, am)) return false;
+    out = { am.from, am.to, am.arrow };
+    return true;
+}
+
+static void RunAiRequest(Server* server, int worker, uint32_t session, std::shared_ptr<ServerConn> conn,
+    long long id, int budgetMs, uint64_t nodes, Clock::time_point arrived)
+{
+    // a busy session is neither closed nor evicted, so it is still there afterwards
+    Position pos;
+    {
+        std::lock_guard<std::mutex> guard(server->storeLock);
+        Session_GetPosition(SessionStore_Get(server->store, session), pos);
+    }
+    double queuedMs = MsSince(arrived);
+    SearchLimits limits;
+    limits.timeMs = std::max(1, budgetMs - (int)queuedMs);
+    limits.maxNodes = nodes;
+    limits.threads = 1;
+    SearchResult result;
+    Engine_Search(server->engines[(size_t)worker], pos, limits, result);
+    if (!result.hasMove)
+    {
+        // a search cut off before its first root move still has to answer with a legal move
+        std::vector<PosMove> moves;
+        Position_GenerateMoves(pos, moves);
+        result.best = moves[0];
+    }
+    std::string text = Engine_MoveToString(pos, result.best);
+    Position_MakeMove(pos, result.best);
+    int ply;
+    bool stored;
+    {
+        std::lock_guard<std::mutex> guard(server->storeLock);
+        CompactSession* s = SessionStore_Get(server->store, session);
+        stored = Session_MakeMove(server->store, s, result.best);
+        s->flags &= ~SESSION_BUSY;
+        ply = s->moveCount;
+    }
+    if (!stored)
+    {
+        Send(*conn, ErrorLine(id, "out of memory"));
+        server->searching.fetch_sub(1);
+        return;
+    }
+    char buf[256];
+    snprintf(buf, sizeof(buf), ",\"move\":\"%s\",\"score\":%d,\"depth\":%d,\"nodes\":%llu,\"queuedMs\":%.2f,\"searchMs\":%.2f,\"ply\":%d,\"winner\":%s}\n",
+        text.c_str(), result.score, result.stats.depth, (unsigned long long)result.stats.nodes, queuedMs,
+        result.stats.timeMs, ply, WinnerJson(pos));
+    Send(*conn, ReplyHead(id) + buf);
+    Latency_Add(server->aiLatency, MsSince(arrived));
+    server->searching.fetch_sub(1);
+}
+
+static std::string StatsJson(Server* server, long long id)
+{
+    SessionStoreStats st;
+    {
+        std::lock_guard<std::mutex> guard(server->storeLock);
+        SessionStore_GetStats(server->store, st);
+    }
+    char buf[512];
+    snprintf(buf, sizeof(buf), ",\"sessions\":%llu,\"evicted\":%llu,\"sessionBytes\":%llu,\"evictions\":%llu,\"reloads\":%llu,"
+        "\"connections\":%zu,\"threads\":%d,\"queued\":%zu,\"steals\":%llu,\"requests\":%llu",
+        (unsigned long long)st.live, (unsigned long long)st.evicted, (unsigned long long)st.bytesReserved,
+        (unsigned long long)st.evictions, (unsigned long long)st.reloads, server->conns.size(), ThreadPool_Threads(server->pool),
+        ThreadPool_Queued(server->pool), (unsigned long long)ThreadPool_Steals(server->pool), (unsigned long long)server->requests.load());
+    return ReplyHead(id) + buf + ",\"ai\":" + Latency_Json(server->aiLatency) + ",\"other\":" + Latency_Json(server->opLatency) + "}\n";
+}
+
+// Handles one request line on the I/O thread; "ai" requests are handed to the pool.
+static void HandleRequest(Server* server, const std::shared_ptr<ServerConn> &conn, const char* text, size_t len)
+{
+    Clock::time_point arrived = Clock::now();
+    server->requests.fetch_add(1, std::memory_order_relaxed);
+    std::vector<JsonField> req;
+    if (!ParseFlatJson(text, text + len, req))
+    {
+        Send(*conn, ErrorLine(0, "malformed request"));
+        return;
+    }
+    long long id = JsonInt(req, "id", 0);
+    std::string op = JsonString(req, "op");
+    if (op == "stats")
+    {
+        Send(*conn, StatsJson(server, id));
+        return;
+    }
+    if (op == "shutdown")
+    {
+        server->stopping = true;
+        Send(*conn, ReplyHead(id) + "}\n");
+        return;
+    }
+
+    char buf[256];
+    const char* error = nullptr;
+    std::string reply;
+    std::unique_lock<std::mutex> guard(server->storeLock);
+    uint32_t session = (uint32_t)JsonInt(req, "session", 0);
+    CompactSession* s = (op == "new") ? nullptr : SessionStore_Get(server->store, session);
+    Position pos;
+    if (s) Session_GetPosition(s, pos);
+    bool busy = s && (s->flags & SESSION_BUSY);
+    if (op == "new")
+    {
+        std::string ai = JsonString(req, "ai");
+        int flags = (ai == "black") ? SESSION_AI_BLACK : (ai == "none") ? 0 : SESSION_AI_WHITE;
+        session = SessionStore_New(server->store, (int)JsonInt(req, "size", 10), flags);
+        if (!session) error = "unsupported board size";
+        else
+        {
+            snprintf(buf, sizeof(buf), ",\"session\":%u}\n", session);
+            reply = ReplyHead(id) + buf;
+        }
+    }
+    else if (!s) error = op.empty() ? "missing op" : "unknown session";
+    else if (op == "close")
+    {
+        if (busy) error = "search pending";
+        else
+        {
+            SessionStore_Close(server->store, session);
+            reply = ReplyHead(id) + "}\n";
+        }
+    }
+    else if (op == "state")
+    {
+        reply = ReplyHead(id);
+        snprintf(buf, sizeof(buf), ",\"size\":%d,\"ply\":%d,\"toMove\":\"%s\",\"busy\":%s,\"winner\":%s,\"moves\":[",
+            s->size, s->moveCount, pos.blackToMove ? "black" : "white", busy ? "true" : "false", WinnerJson(pos));
+        reply += buf;
+        for (int i = 0; i < s->moveCount; ++i)
+        {
+            reply += i ? ",\"" : "\"";
+            reply += Engine_MoveToString(pos, Session_GetMove(s, i));
+            reply += "\"";
+        }
+        reply += "]}\n";
+    }
+    else if (busy) error = "search pending";
+    else if (op == "move")
+    {
+        PosMove m;
+        int aiFlag = pos.blackToMove ? SESSION_AI_BLACK : SESSION_AI_WHITE;
+        if (s->flags & aiFlag) error = "not your turn";
+        else if (!ParseMoveText(JsonString(req, "move"), s->size, m) || !Position_IsLegalMove(pos, m)) error = "illegal move";
+        else if (!Session_MakeMove(server->store, s, m)) error = "out of memory";
+        else
+        {
+            Position_MakeMove(pos, m);
+            snprintf(buf, sizeof(buf), ",\"ply\":%d,\"winner\":%s}\n", s->moveCount, WinnerJson(pos));
+            reply = ReplyHead(id) + buf;
+        }
+    }
+    else if (op == "undo")
+    {
+        long long count = std::min((long long)s->moveCount, std::max(0LL, JsonInt(req, "count", 1)));
+        for (long long i = 0; i < count; ++i) Session_UnmakeMove(s);
+        snprintf(buf, sizeof(buf), ",\"ply\":%d}\n", s->moveCount);
+        reply = ReplyHead(id) + buf;
+    }
+    else if (op == "ai")
+    {
+        if (!Position_HasAnyMove(pos)) error = "game over";
+        else
+        {
+            s->flags |= SESSION_BUSY;
+            guard.unlock();
+            server->searching.fetch_add(1);
+            int budget = (int)std::min<long long>(server->maxMs, std::max(1LL, JsonInt(req, "ms", server->defaultMs)));
+            uint64_t nodes = (uint64_t)std::max(0LL, JsonInt(req, "nodes", 0));
+            ThreadPool_Submit(server->pool, [server, session, conn, id, budget, nodes, arrived](int worker) {
+                RunAiRequest(server, worker, session, conn, id, budget, nodes, arrived);
+            });
+            return;
+        }
+    }
+    else error = "unknown op";
+
+    guard.unlock();
+    Send(*conn, error ? ErrorLine(id, error) : reply);
+    Latency_Add(server->opLatency, MsSince(arrived));
+}
+
+static void CloseConn(ServerConn &c)
+{
+    std::lock_guard<std::mutex> guard(c.sendLock);
+    c.closed = true;
+    Net_Close(c.socket);
+}
+
+// serve <port> [threads] [defaultMs] [maxMs] [seconds] [evict.file] [idleS]
+int Tool_Serve(int argc, char** argv)
+{
+    if (argc < 1)
+    {
+        fprintf(stderr, "usage: serve <port> [threads] [defaultMs] [maxMs] [seconds] [evict.file] [idleS]\n");
+        return 1;
+    }
+    int threads = (argc > 1) ? atoi(argv[1]) : (int)std::thread::hardware_concurrency();
+    Server server;
+    if (argc > 2) server.defaultMs = std::max(1, atoi(argv[2]));
+    if (argc > 3) server.maxMs = std::max(1, atoi(argv[3]));
+    int seconds = (argc > 4) ? atoi(argv[4]) : 0;
+    const char* evictPath = (argc > 5) ? argv[5] : nullptr;
+    server.idleSeconds = (argc > 6) ? (uint32_t)std::max(1, atoi(argv[6])) : 60;
+    if (threads < 1) threads = 1;
+    if (!Net_Startup()) return 1;
+    NetSocket listener = Net_Listen(atoi(argv[0]), true);
+    if (listener == NET_INVALID)
+    {
+        fprintf(stderr, "cannot listen on port %s\n", argv[0]);
+        return 1;
+    }
+    server.store = SessionStore_Create(evictPath);
+    for (int i = 0; i < threads; ++i) server.engines.push_back(Engine_Create(16));
+    server.pool = ThreadPool_Create(threads);
+    printf("serving on 127.0.0.1:%s with %d search threads\n", argv[0], threads);
+    fflush(stdout);
+
+    Clock::time_point start = Clock::now(), lastEviction = start;
+    std::vector<NetSocket> sockets;
+    std::vector<uint8_t> readable;
+    char buf[65536];
+    while (!server.stopping && (seconds <= 0 || MsSince(start) < seconds * 1000.0))
+    {
+        if (evictPath && MsSince(lastEviction) >= 1000.0)
+        {
+            lastEviction = Clock::now();
+            std::lock_guard<std::mutex> guard(server.storeLock);
+            SessionStore_EvictIdle(server.store, server.idleSeconds);
+        }
+        sockets.assign(1, listener);
+        for (const auto &c : server.conns) sockets.push_back(c->socket);
+        readable.resize(sockets.size());
+        if (Net_Poll(sockets.data(), (int)sockets.size(), 200, readable.data()) <= 0) continue;
+        // existing connections first; a new one joins at the end and is polled from the next round
+        size_t kept = 0;
+        for (size_t i = 0; i < server.conns.size(); ++i)
+        {
+            std::shared_ptr<ServerConn> c = server.conns[i];
+            bool alive = true;
+            if (readable[i + 1])
+            {
+                int got = Net_Recv(c->socket, buf, sizeof(buf));
+                if (got <= 0) alive = false;
+                else
+                {
+                    c->inbox.append(buf, (size_t)got);
+                    size_t begin = 0, nl;
+                    while ((nl = c->inbox.find('\n', begin)) != std::string::npos)
+                    {
+                        if (nl > begin) HandleRequest(&server, c, c->inbox.data() + begin, nl - begin);
+                        begin = nl + 1;
+                    }
+                    c->inbox.erase(0, begin);
+                    if (c->inbox.size() > 65536) alive = false;   // no request is that long
+                }
+            }
+            if (alive) server.conns[kept++] = c;
+            else CloseConn(*c);
+        }
+        server.conns.resize(kept);
+        // take every connection waiting in the backlog, so a burst of clients is not left to overflow it
+        for (bool waiting = readable[0] != 0; waiting; waiting = Net_WaitReadable(&listener, 1, 0) == 0)
+        {
+            auto c = std::make_shared<ServerConn>();
+            c->socket = Net_Accept(listener);
+            if (c->socket == NET_INVALID) break;
+            server.conns.push_back(c);
+        }
+    }
+
+    Net_Close(listener);
+    // pending searches still answer
+    while (server.searching.load() > 0) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    std::string stats = StatsJson(&server, 0);
+    ThreadPool_Destroy(server.pool);
+    for (const auto &c : server.conns) CloseConn(*c);
+    server.conns.clear();
+    for (Engine* e : server.engines) Engine_Destroy(e);
+    SessionStore_Destroy(server.store);
+    printf("%s", stats.c_str());
+    return 0;
+}
+
+// ---- load generator ----
+
+// One simulated player: plays black against the AI with random legal moves, game after game.
+struct LoadClient
+{
+    NetSocket socket = NET_INVALID;
+    std::string inbox;
+    uint32_t session = 0;
+    Position pos;
+    char waiting = 0;               // op of the request in flight: 'n'ew, 'm'ove, 'a'i, 'c'lose; 0 none
+    Clock::time_point sentAt;
+};
+
+// serve-load <host> <port> [clients] [seconds] [ms] [size]
+int Tool_ServeLoad(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: serve-load <host> <port> [clients] [seconds] [ms] [size]\n");
+        return 1;
+    }
+    int clients = (argc > 2) ? std::max(1, atoi(argv[2])) : 100;
+    int seconds = (argc > 3) ? std::max(1, atoi(argv[3])) : 10;
+    int budgetMs = (argc > 4) ? std::max(1, atoi(argv[4])) : 50;
+    int size = (argc > 5) ? atoi(argv[5]) : 10;
+    if (!Net_Startup()) return 1;
+
+    std::vector<LoadClient> load((size_t)clients);
+    for (LoadClient &c : load)
+    {
+        c.socket = Net_Connect(argv[0], atoi(argv[1]));
+        if (c.socket == NET_INVALID)
+        {
+            fprintf(stderr, "cannot connect to %s:%s\n", argv[0], argv[1]);
+            return 1;
+        }
+    }
+    printf("%d clients, %d s, %d ms per AI move, %dx%d\n", clients, seconds, budgetMs, size, size);
+    fflush(stdout);
+
+    std::mt19937 rng(7);
+    std::vector<PosMove> moves;
+    LatencyLog aiLatency, moveLatency;
+    uint64_t games = 0, errors = 0;
+    char line[256];
+    auto send = [&](LoadClient &c, char op, const char* text) {
+        c.waiting = op;
+        c.sentAt = Clock::now();
+        if (!Net_SendAll(c.socket, text, strlen(text))) ++errors;
+    };
+    auto startGame = [&](LoadClient &c) {
+        snprintf(line, sizeof(line), "{\"op\":\"new\",\"size\":%d,\"ai\":\"white\"}\n", size);
+        send(c, 'n', line);
+    };
+    // the client's turn: a random move, or close the game if black is stuck
+    auto playHuman = [&](LoadClient &c) {
+        Position_GenerateMoves(c.pos, moves);
+        if (moves.empty())
+        {
+            snprintf(line, sizeof(line), "{\"op\":\"close\",\"session\":%u}\n", c.session);
+            send(c, 'c', line);
+            return;
+        }
+        PosMove m = moves[rng() % moves.size()];
+        snprintf(line, sizeof(line), "{\"op\":\"move\",\"session\":%u,\"move\":\"%s\"}\n", c.session,
+            Engine_MoveToString(c.pos, m).c_str());
+        Position_MakeMove(c.pos, m);
+        send(c, 'm', line);
+    };
+
+    Clock::time_point start = Clock::now();
+    for (LoadClient &c : load) startGame(c);
+    std::vector<NetSocket> sockets((size_t)clients);
+    std::vector<uint8_t> readable((size_t)clients);
+    char buf[65536];
+    std::vector<JsonField> reply;
+    for (;;)
+    {
+        bool running = MsSince(start) < seconds * 1000.0;
+        size_t inFlight = 0;
+        for (size_t i = 0; i < load.size(); ++i)
+        {
+            sockets[i] = load[i].socket;
+            if (load[i].waiting) ++inFlight;
+        }
+        if (!running && inFlight == 0) break;
+        if (!running && MsSince(start) > seconds * 1000.0 + 30000.0) break;     // server stopped answering
+        if (Net_Poll(sockets.data(), clients, 200, readable.data()) <= 0) continue;
+        for (size_t i = 0; i < load.size(); ++i)
+        {
+            if (!readable[i]) continue;
+            LoadClient &c = load[i];
+            int got = Net_Recv(c.socket, buf, sizeof(buf));
+            if (got <= 0)
+            {
+                fprintf(stderr, "server closed the connection\n");
+                return 1;
+            }
+            c.inbox.append(buf, (size_t)got);
+            size_t nl;
+            while ((nl = c.inbox.find('\n')) != std::string::npos)
+            {
+                bool ok = ParseFlatJson(c.inbox.data(), c.inbox.data() + nl, reply) && JsonFind(reply, "ok")
+                    && JsonFind(reply, "ok")->value == "true";
+                c.inbox.erase(0, nl + 1);
+                char op = c.waiting;
+                double ms = MsSince(c.sentAt);
+                c.waiting = 0;
+                if (!ok)
+                {
+                    ++errors;
+                    if (running) startGame(c);
+                    continue;
+                }
+                const JsonField* winner = JsonFind(reply, "winner");
+                bool over = winner && winner->isString;
+                if (op == 'n')
+                {
+                    c.session = (uint32_t)JsonInt(reply, "session", 0);
+                    Position_Init(c.pos, size);
+                    if (running) playHuman(c);
+                }
+                else if (op == 'm')
+                {
+                    Latency_Add(moveLatency, ms);
+                    if (over)
+                    {
+                        snprintf(line, sizeof(line), "{\"op\":\"close\",\"session\":%u}\n", c.session);
+                        send(c, 'c', line);
+                    }
+                    else
+                    {
+                        snprintf(line, sizeof(line), "{\"op\":\"ai\",\"session\":%u,\"ms\":%d}\n", c.session, budgetMs);
+                        send(c, 'a', line);
+                    }
+                }
+                else if (op == 'a')
+                {
+                    Latency_Add(aiLatency, ms);
+                    PosMove m;
+                    if (!ParseMoveText(JsonString(reply, "move"), size, m) || !Position_IsLegalMove(c.pos, m))
+                    {
+                        ++errors;
+                        if (running) startGame(c);
+                        continue;
+                    }
+                    Position_MakeMove(c.pos, m);
+                    if (running || over) playHuman(c);
+                }
+                else if (op == 'c')
+                {
+                    if (c.session) ++games;
+                    c.session = 0;
+                    if (running) startGame(c);
+                }
+                if (!running && !c.waiting && c.session)
+                {
+                    // time is up: leave no unfinished game behind on the server
+                    snprintf(line, sizeof(line), "{\"op\":\"close\",\"session\":%u}\n", c.session);
+                    send(c, 'c', line);
+                    c.session = 0;
+                }
+            }
+        }
+    }
+    double elapsed = MsSince(start) / 1000.0;
+
+    // the server's own view, over the first connection
+    std::string stats;
+    const char* request = "{\"op\":\"stats\"}\n";
+    if (Net_SendAll(load[0].socket, request, strlen(request)))
+    {
+        load[0].inbox.clear();
+        while (load[0].inbox.find('\n') == std::string::npos)
+        {
+            int got = Net_Recv(load[0].socket, buf, sizeof(buf));
+            if (got <= 0) break;
+            load[0].inbox.append(buf, (size_t)got);
+        }
+        stats = load[0].inbox;
+    }
+    for (LoadClient &c : load) Net_Close(c.socket);
+
+    std::string aiJson = Latency_Json(aiLatency), moveJson = Latency_Json(moveLatency);
+    printf("%llu games finished, %zu AI moves (%.1f/s), %llu errors in %.1f s\n", (unsigned long long)games,
+        (size_t)aiLatency.count, aiLatency.count / elapsed, (unsigned long long)errors, elapsed);
+    printf("client round trip ms  ai %s\n                      move %s\n", aiJson.c_str(), moveJson.c_str());
+    printf("server %s", stats.c_str());
+    return errors ? 2 : 0;
+}
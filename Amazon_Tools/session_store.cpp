@@ -0,0 +1,458 @@
+#include "session_store.h"
+#include "byte_io.h"
+#include "game_archive.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static_assert(sizeof(CompactSession) <= 64, "a session record fills at most one cache line");
+static_assert(sizeof(ArchiveMove) == 3, "the move log packs 3-byte moves");
+
+static const size_t kSlabBlock = 64 * 1024;
+// move log block sizes in moves, growing by about half each step
+static const int kLogMoves[] = { 8, 16, 24, 32, 48, 64, 96, 128, 192, 256 };
+static const int kLogClasses = (int)(sizeof(kLogMoves) / sizeof(kLogMoves[0]));
+static const uint64_t kNoRecord = (1ull << 56) - 1;
+static const uint32_t kIndexBits = 24;                  // id = generation << 24 | (table index + 1)
+static const uint64_t kCompactMinBytes = 64ull << 20;   // eviction file size before stale records are dropped
+
+// ---- slabs: fixed-size slots carved from 64 KB blocks, free slots linked through their first bytes ----
+
+struct Slab
+{
+    size_t slotSize = 0;
+    std::vector<uint8_t*> blocks;
+    uint8_t* freeList = nullptr;
+    uint64_t used = 0;
+};
+
+static void* Slab_Alloc(Slab &slab)
+{
+    if (!slab.freeList)
+    {
+        uint8_t* block = (uint8_t*)malloc(kSlabBlock);
+        if (!block) return nullptr;
+        slab.blocks.push_back(block);
+        for (size_t i = kSlabBlock / slab.slotSize; i-- > 0; )
+        {
+            uint8_t* slot = block + i * slab.slotSize;
+            memcpy(slot, &slab.freeList, sizeof(slab.freeList));
+            slab.freeList = slot;
+        }
+    }
+    uint8_t* slot = slab.freeList;
+    memcpy(&slab.freeList, slot, sizeof(slab.freeList));
+    ++slab.used;
+    return slot;
+}
+
+static void Slab_Free(Slab &slab, void* p)
+{
+    memcpy(p, &slab.freeList, sizeof(slab.freeList));
+    slab.freeList = (uint8_t*)p;
+    --slab.used;
+}
+
+static void Slab_Release(Slab &slab)
+{
+    for (uint8_t* b : slab.blocks) free(b);
+    slab.blocks.clear();
+    slab.freeList = nullptr;
+    slab.used = 0;
+}
+
+// ---- store ----
+
+// a table entry is free (live null, no record), in memory (live set) or evicted (record set)
+struct SessionEntry
+{
+    CompactSession* live;
+    uint64_t diskOffset : 56;
+    uint64_t generation : 8;
+};
+
+struct SessionStore
+{
+    Slab records;
+    Slab logs[kLogClasses];
+    std::vector<SessionEntry> entries;
+    std::vector<uint32_t> freeEntries;
+    std::string path;
+    FILE* file = nullptr;
+    uint64_t fileSize = 0;
+    uint64_t diskLive = 0;          // bytes of the records still referenced
+    uint64_t live = 0, evicted = 0, evictions = 0, reloads = 0;
+    std::chrono::steady_clock::time_point start;
+};
+
+static uint32_t Now(const SessionStore* store)
+{
+    return (uint32_t)std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - store->start).count();
+}
+
+static bool SeekTo(FILE* f, uint64_t offset)
+{
+#ifdef _WIN32
+    return _fseeki64(f, (long long)offset, SEEK_SET) == 0;
+#else
+    return fseeko(f, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+// size of the archive game record starting with these 8 header bytes (no custom setup)
+static uint64_t RecordBytes(const uint8_t* head)
+{
+    uint64_t moveCount = head[4] | (head[5] << 8) | (head[6] << 16) | ((uint64_t)head[7] << 24);
+    return 8 + moveCount * sizeof(ArchiveMove);
+}
+
+static int LogCapacity(const CompactSession* s)
+{
+    return s->log ? kLogMoves[s->logClass] : 0;
+}
+
+static void FreeSession(SessionStore* store, CompactSession* s)
+{
+    if (s->log) Slab_Free(store->logs[s->logClass], s->log);
+    Slab_Free(store->records, s);
+}
+
+static SessionEntry* FindEntry(SessionStore* store, uint32_t id)
+{
+    uint32_t index = (id & ((1u << kIndexBits) - 1)) - 1;
+    if (index >= store->entries.size()) return nullptr;
+    SessionEntry &e = store->entries[index];
+    if (e.generation != (id >> kIndexBits) || (!e.live && e.diskOffset == kNoRecord)) return nullptr;
+    return &e;
+}
+
+static void FromPosition(CompactSession* s, const Position &pos, int flags)
+{
+    memset(s, 0, sizeof(*s));
+    for (int sq = 0; sq < pos.size * pos.size; ++sq)
+        if (pos.cell[sq] == CELL_ARROW) s->arrows[sq >> 6] |= 1ull << (sq & 63);
+    memcpy(s->amazon, pos.amazon, sizeof(s->amazon));
+    s->size = (uint8_t)pos.size;
+    s->flags = (uint8_t)((flags & ~SESSION_BLACK_TO_MOVE) | (pos.blackToMove ? SESSION_BLACK_TO_MOVE : 0));
+}
+
+SessionStore* SessionStore_Create(const char* evictPath)
+{
+    SessionStore* store = new SessionStore();
+    store->records.slotSize = 64;
+    for (int c = 0; c < kLogClasses; ++c) store->logs[c].slotSize = (size_t)kLogMoves[c] * sizeof(ArchiveMove);
+    store->start = std::chrono::steady_clock::now();
+    if (evictPath)
+    {
+        store->path = evictPath;
+        store->file = ByteIO_OpenFile(store->path, "w+b");
+    }
+    return store;
+}
+
+void SessionStore_Destroy(SessionStore* store)
+{
+    if (!store) return;
+    Slab_Release(store->records);
+    for (Slab &s : store->logs) Slab_Release(s);
+    if (store->file)
+    {
+        fclose(store->file);
+        remove(store->path.c_str());
+    }
+    delete store;
+}
+
+uint32_t SessionStore_New(SessionStore* store, int size, int flags)
+{
+    if (!Position_HasStandardSetup(size)) return 0;
+    uint32_t index;
+    if (!store->freeEntries.empty())
+    {
+        index = store->freeEntries.back();
+        store->freeEntries.pop_back();
+    }
+    else
+    {
+        if (store->entries.size() + 1 >= (1u << kIndexBits)) return 0;
+        index = (uint32_t)store->entries.size();
+        store->entries.push_back(SessionEntry{ nullptr, kNoRecord, 0 });
+    }
+    CompactSession* s = (CompactSession*)Slab_Alloc(store->records);
+    if (!s)
+    {
+        store->freeEntries.push_back(index);
+        return 0;
+    }
+    Position pos;
+    Position_Init(pos, size);
+    FromPosition(s, pos, flags & (SESSION_AI_WHITE | SESSION_AI_BLACK));
+    s->lastUsed = Now(store);
+    SessionEntry &e = store->entries[index];
+    e.live = s;
+    ++store->live;
+    return ((uint32_t)e.generation << kIndexBits) | (index + 1);
+}
+
+// reads an evicted session back; nullptr if its record cannot be read
+static CompactSession* Reload(SessionStore* store, SessionEntry &e)
+{
+    uint8_t head[8];
+    if (!store->file || !SeekTo(store->file, e.diskOffset) || fread(head, 1, sizeof(head), store->file) != sizeof(head)) return nullptr;
+    uint64_t bytes = RecordBytes(head);
+    if (bytes > sizeof(head) + POSITION_MAX_SQUARES * sizeof(ArchiveMove)) return nullptr;
+    std::vector<uint8_t> rec((size_t)bytes);
+    memcpy(rec.data(), head, sizeof(head));
+    ArchiveGame game;
+    if (fread(rec.data() + sizeof(head), 1, rec.size() - sizeof(head), store->file) != rec.size() - sizeof(head)
+        || Archive_DecodeGame(rec.data(), rec.size(), game) != rec.size())
+        return nullptr;
+
+    Position pos;
+    Position_Init(pos, game.boardSize);
+    for (const ArchiveMove &am : game.moves)
+    {
+        PosMove m = { am.from, am.to, am.arrow };
+        Position_MakeMove(pos, m);
+    }
+    CompactSession* s = (CompactSession*)Slab_Alloc(store->records);
+    if (!s) return nullptr;
+    int flags = game.opponentIsAI ? (game.aiFirst ? SESSION_AI_BLACK : SESSION_AI_WHITE) : 0;
+    FromPosition(s, pos, flags);
+    if (!game.moves.empty())
+    {
+        int c = 0;
+        while (kLogMoves[c] < (int)game.moves.size()) ++c;
+        s->log = (uint8_t*)Slab_Alloc(store->logs[c]);
+        if (!s->log)
+        {
+            Slab_Free(store->records, s);
+            return nullptr;
+        }
+        s->logClass = (uint16_t)c;
+        memcpy(s->log, game.moves.data(), game.moves.size() * sizeof(ArchiveMove));
+        s->moveCount = (uint16_t)game.moves.size();
+    }
+    store->diskLive -= rec.size();
+    return s;
+}
+
+CompactSession* SessionStore_Get(SessionStore* store, uint32_t id)
+{
+    SessionEntry* e = FindEntry(store, id);
+    if (!e) return nullptr;
+    if (!e->live)
+    {
+        e->live = Reload(store, *e);
+        if (!e->live) return nullptr;
+        e->diskOffset = kNoRecord;
+        --store->evicted;
+        ++store->live;
+        ++store->reloads;
+    }
+    e->live->lastUsed = Now(store);
+    return e->live;
+}
+
+void SessionStore_Close(SessionStore* store, uint32_t id)
+{
+    SessionEntry* e = FindEntry(store, id);
+    if (!e) return;
+    if (e->live)
+    {
+        FreeSession(store, e->live);
+        --store->live;
+    }
+    else
+    {
+        // the record stays in the file until the next rewrite; only its size is needed to account for it
+        uint8_t head[8];
+        if (store->file && SeekTo(store->file, e->diskOffset) && fread(head, 1, sizeof(head), store->file) == sizeof(head))
+            store->diskLive -= RecordBytes(head);
+        --store->evicted;
+    }
+    e->live = nullptr;
+    e->diskOffset = kNoRecord;
+    e->generation = (e->generation + 1) & 0xff;
+    store->freeEntries.push_back((uint32_t)(e - store->entries.data()));
+}
+
+static bool EncodeSession(const CompactSession* s, std::string &out)
+{
+    ArchiveGame game;
+    game.boardSize = s->size;
+    game.opponentIsAI = (s->flags & (SESSION_AI_WHITE | SESSION_AI_BLACK)) != 0;
+    game.aiFirst = (s->flags & SESSION_AI_BLACK) != 0;
+    game.moves.resize(s->moveCount);
+    if (s->moveCount) memcpy(game.moves.data(), s->log, s->moveCount * sizeof(ArchiveMove));
+    out.clear();
+    Archive_EncodeGame(game, out);
+    return true;
+}
+
+// Rewrites the eviction file with only the records still referenced; on any error the old file
+// and offsets stay in use.
+static void CompactFile(SessionStore* store)
+{
+    std::string tmpPath = store->path + ".tmp";
+    FILE* out = ByteIO_OpenFile(tmpPath, "w+b");
+    if (!out) return;
+    std::vector<uint64_t> offsets(store->entries.size(), kNoRecord);
+    uint64_t offset = 0;
+    std::vector<uint8_t> rec;
+    bool ok = true;
+    for (size_t i = 0; i < store->entries.size() && ok; ++i)
+    {
+        const SessionEntry &e = store->entries[i];
+        if (e.live || e.diskOffset == kNoRecord) continue;
+        uint8_t head[8];
+        ok = SeekTo(store->file, e.diskOffset) && fread(head, 1, sizeof(head), store->file) == sizeof(head);
+        if (!ok) break;
+        size_t n = (size_t)RecordBytes(head) - sizeof(head);
+        rec.resize(sizeof(head) + n);
+        memcpy(rec.data(), head, sizeof(head));
+        ok = fread(rec.data() + sizeof(head), 1, n, store->file) == n && fwrite(rec.data(), 1, rec.size(), out) == rec.size();
+        offsets[i] = offset;
+        offset += rec.size();
+    }
+    if (fclose(out) != 0) ok = false;
+    if (!ok)
+    {
+        remove(tmpPath.c_str());
+        return;
+    }
+    // the old file is set aside rather than removed until the new one is open in its place
+    // (rename does not replace an existing file on Windows)
+    std::string oldPath = store->path + ".old";
+    fclose(store->file);
+    remove(oldPath.c_str());
+    bool setAside = rename(store->path.c_str(), oldPath.c_str()) == 0;
+    bool placed = setAside && rename(tmpPath.c_str(), store->path.c_str()) == 0;
+    FILE* compacted = placed ? ByteIO_OpenFile(store->path, "r+b") : nullptr;
+    if (!compacted)
+    {
+        if (placed) remove(store->path.c_str());
+        if (setAside) rename(oldPath.c_str(), store->path.c_str());
+        remove(tmpPath.c_str());
+        store->file = ByteIO_OpenFile(store->path, "r+b");
+        return;
+    }
+    remove(oldPath.c_str());
+    store->file = compacted;
+    for (size_t i = 0; i < offsets.size(); ++i)
+        if (offsets[i] != kNoRecord) store->entries[i].diskOffset = offsets[i];
+    store->fileSize = offset;
+    store->diskLive = offset;
+}
+
+int SessionStore_EvictIdle(SessionStore* store, uint32_t idleSeconds)
+{
+    if (!store->file) return 0;
+    uint32_t now = Now(store);
+    int count = 0;
+    std::string rec;
+    for (SessionEntry &e : store->entries)
+    {
+        CompactSession* s = e.live;
+        if (!s || (s->flags & SESSION_BUSY) || now - s->lastUsed < idleSeconds) continue;
+        EncodeSession(s, rec);
+        if (!SeekTo(store->file, store->fileSize) || fwrite(rec.data(), 1, rec.size(), store->file) != rec.size()) break;
+        e.diskOffset = store->fileSize;
+        e.live = nullptr;
+        store->fileSize += rec.size();
+        store->diskLive += rec.size();
+        FreeSession(store, s);
+        --store->live;
+        ++store->evicted;
+        ++store->evictions;
+        ++count;
+    }
+    fflush(store->file);
+    if (store->fileSize > kCompactMinBytes && store->fileSize > 2 * store->diskLive) CompactFile(store);
+    return count;
+}
+
+void SessionStore_GetStats(const SessionStore* store, SessionStoreStats &out)
+{
+    out = SessionStoreStats();
+    out.live = store->live;
+    out.evicted = store->evicted;
+    out.bytesInUse = store->records.used * store->records.slotSize
+        + store->entries.size() * sizeof(SessionEntry) + store->freeEntries.size() * sizeof(uint32_t);
+    out.bytesReserved = store->records.blocks.size() * kSlabBlock
+        + store->entries.capacity() * sizeof(SessionEntry) + store->freeEntries.capacity() * sizeof(uint32_t);
+    for (const Slab &s : store->logs)
+    {
+        out.bytesInUse += s.used * s.slotSize;
+        out.bytesReserved += s.blocks.size() * kSlabBlock;
+    }
+    out.diskBytes = store->fileSize;
+    out.evictions = store->evictions;
+    out.reloads = store->reloads;
+}
+
+// ---- playing ----
+
+void Session_GetPosition(const CompactSession* s, Position &out)
+{
+    uint8_t cells[POSITION_MAX_SQUARES] = {};
+    for (int sq = 0; sq < s->size * s->size; ++sq)
+        if ((s->arrows[sq >> 6] >> (sq & 63)) & 1) cells[sq] = CELL_ARROW;
+    for (int i = 0; i < POSITION_AMAZONS; ++i)
+    {
+        cells[s->amazon[0][i]] = CELL_WHITE;
+        cells[s->amazon[1][i]] = CELL_BLACK;
+    }
+    Position_SetFromCells(out, s->size, cells, (s->flags & SESSION_BLACK_TO_MOVE) != 0);
+}
+
+bool Session_MakeMove(SessionStore* store, CompactSession* s, const PosMove &m)
+{
+    if (s->moveCount == LogCapacity(s))
+    {
+        // next size class; the first move gets the smallest
+        int c = s->log ? s->logClass + 1 : 0;
+        uint8_t* log = (uint8_t*)Slab_Alloc(store->logs[c]);
+        if (!log) return false;
+        if (s->log)
+        {
+            memcpy(log, s->log, s->moveCount * sizeof(ArchiveMove));
+            Slab_Free(store->logs[s->logClass], s->log);
+        }
+        s->log = log;
+        s->logClass = (uint16_t)c;
+    }
+    uint8_t* rec = s->log + s->moveCount * sizeof(ArchiveMove);
+    rec[0] = m.from;
+    rec[1] = m.to;
+    rec[2] = m.arrow;
+    ++s->moveCount;
+    int side = (s->flags & SESSION_BLACK_TO_MOVE) ? 1 : 0;
+    for (int i = 0; i < POSITION_AMAZONS; ++i)
+        if (s->amazon[side][i] == m.from) s->amazon[side][i] = m.to;
+    s->arrows[m.arrow >> 6] |= 1ull << (m.arrow & 63);
+    s->flags ^= SESSION_BLACK_TO_MOVE;
+    return true;
+}
+
+void Session_UnmakeMove(CompactSession* s)
+{
+    if (s->moveCount == 0) return;
+    PosMove m = Session_GetMove(s, s->moveCount - 1);
+    --s->moveCount;
+    s->flags ^= SESSION_BLACK_TO_MOVE;
+    int side = (s->flags & SESSION_BLACK_TO_MOVE) ? 1 : 0;
+    s->arrows[m.arrow >> 6] &= ~(1ull << (m.arrow & 63));
+    for (int i = 0; i < POSITION_AMAZONS; ++i)
+        if (s->amazon[side][i] == m.to) s->amazon[side][i] = m.from;
+}
+
+PosMove Session_GetMove(const CompactSession* s, int index)
+{
+    const uint8_t* rec = s->log + index * sizeof(ArchiveMove);
+    PosMove m = { rec[0], rec[1], rec[2] };
+    return m;
+}
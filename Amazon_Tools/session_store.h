@@ -0,0 +1,76 @@
+#pragma once
+
+// Compact storage for the game sessions of the server (server_tools.cpp).
+//
+// A session is a fixed 64-byte record: the arrows as a bitboard (bitboard.h layout, up to 16x16),
+// the eight amazon squares, side to move and flags, and a pointer to its move log, which holds
+// 3 bytes per move (ArchiveMove) in a block of one of a few size classes. Records and
+// log blocks come from slabs, so a session costs no allocator overhead beyond its own bytes, and
+// freed slots are reused by later sessions.
+//
+// Sessions idle longer than a given time can be evicted: the session is appended to a disk file as
+// an .amzb game record (game_archive.h) and its memory released. Looking up an evicted session
+// reloads it by replaying the record. The file is private to one store; it is rewritten without
+// stale records once they make up most of it.
+//
+// Not thread-safe: callers serialise all calls on one store.
+
+#include "position.h"
+#include <cstddef>
+#include <cstdint>
+
+enum
+{
+    SESSION_BLACK_TO_MOVE = 1,
+    SESSION_BUSY = 2,           // set and cleared by the caller; busy sessions are never evicted
+    SESSION_AI_WHITE = 4,
+    SESSION_AI_BLACK = 8,
+};
+
+struct CompactSession
+{
+    uint64_t arrows[4];             // bit sq of word sq / 64
+    uint8_t amazon[2][POSITION_AMAZONS];    // [0] white, [1] black
+    uint8_t size;
+    uint8_t flags;                  // SESSION_*
+    uint16_t moveCount;
+    uint16_t logClass;              // size class of the log block
+    uint16_t reserved;
+    uint32_t lastUsed;              // store clock (seconds) of the last lookup
+    uint8_t* log;                   // moveCount moves of 3 bytes: from, to, arrow
+};
+
+struct SessionStore;
+
+struct SessionStoreStats
+{
+    uint64_t live = 0;              // sessions in memory
+    uint64_t evicted = 0;           // sessions on disk
+    uint64_t bytesInUse = 0;        // session records, move logs and the id table
+    uint64_t bytesReserved = 0;     // slab blocks and table capacity, free slots included
+    uint64_t diskBytes = 0;         // size of the eviction file
+    uint64_t evictions = 0;
+    uint64_t reloads = 0;
+};
+
+// evictPath: file for evicted sessions (created or truncated); nullptr disables eviction
+SessionStore* SessionStore_Create(const char* evictPath);
+void SessionStore_Destroy(SessionStore* store);     // also deletes the eviction file
+
+// New session of the standard setup for 'size' (Position_HasStandardSetup); 0 if the size has none
+// or the id space is exhausted. Ids are never 0 and are not reused while their session exists.
+uint32_t SessionStore_New(SessionStore* store, int size, int flags);
+// the session in memory (reloaded if it was evicted), nullptr for unknown ids; valid until the
+// session is closed or evicted
+CompactSession* SessionStore_Get(SessionStore* store, uint32_t id);
+void SessionStore_Close(SessionStore* store, uint32_t id);
+// Evicts every session not looked up for 'idleSeconds' and not busy; returns how many.
+int SessionStore_EvictIdle(SessionStore* store, uint32_t idleSeconds);
+void SessionStore_GetStats(const SessionStore* store, SessionStoreStats &out);
+
+// playing; moves are assumed legal (check them on the Position first). Session_MakeMove returns
+// false, with the session unchanged, if its move log cannot grow.
+void Session_GetPosition(const CompactSession* s, Position &out);
+bool Session_MakeMove(SessionStore* store, CompactSession* s, const PosMove &m);
+void Session_UnmakeMove(CompactSession* s);         // takes back the last move, if any
+PosMove Session_GetMove(const CompactSession* s, int index);
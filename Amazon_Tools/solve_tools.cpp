@@ -0,0 +1,349 @@
+// solve_tools.cpp : exact solver for small boards and queries of the solved-position table.
+//
+// Every position below the root is solved depth-first (the side to move wins iff some move leaves
+// the opponent in a lost position) and its result kept in one lock-free table shared by all threads,
+// so the table ends up holding the whole proof: every position reached while proving the root. Each
+// thread searches from the root with its own move ordering near the root; results are exact, so
+// whatever one thread proves is reused by all others, and the first thread to finish ends the solve.
+
+#include "tools.h"
+#include "engine.h"
+#include "eval.h"
+#include "position.h"
+#include "solved_table.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi")
+#else
+#include <sys/resource.h>
+#endif
+
+#define SOLVE_MAX_PLY (SOLVED_TABLE_MAX_SIDE * SOLVED_TABLE_MAX_SIDE)
+
+// peak resident memory of the process (0 if unknown)
+static uint64_t PeakMemoryBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return pmc.PeakWorkingSetSize;
+    return 0;
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+    return (uint64_t)ru.ru_maxrss * 1024;   // kilobytes on Linux
+#endif
+}
+
+// ---- shared result table ----
+
+// open addressing with linear probing; a slot holds code << 2 | 2 (win) or | 1 (loss), 0 when free
+struct ResultTable
+{
+    std::unique_ptr<std::atomic<uint64_t>[]> slots;
+    uint64_t mask = 0;
+    int shift = 0;
+    uint64_t limit = 0;                     // fill level at which the solve gives up
+    std::atomic<uint64_t> used;
+};
+
+static void ResultTable_Init(ResultTable &t, size_t megabytes)
+{
+    uint64_t wanted = ((uint64_t)megabytes << 20) / sizeof(uint64_t);
+    uint64_t entries = 1;
+    int bits = 0;
+    while (entries * 2 <= wanted) { entries *= 2; ++bits; }
+    t.slots.reset(new std::atomic<uint64_t>[entries]);
+    for (uint64_t i = 0; i < entries; ++i) t.slots[i].store(0, std::memory_order_relaxed);
+    t.mask = entries - 1;
+    t.shift = 64 - bits;
+    t.limit = entries / 8 * 7;              // linear probing slows down sharply beyond this
+    t.used = 0;
+}
+
+static inline uint64_t SlotOf(const ResultTable &t, uint64_t code)
+{
+    return t.shift >= 64 ? 0 : (code * 0x9E3779B97F4A7C15ull) >> t.shift;
+}
+
+static bool ResultTable_Find(const ResultTable &t, uint64_t code, bool &win)
+{
+    for (uint64_t i = SlotOf(t, code); ; i = (i + 1) & t.mask)
+    {
+        uint64_t v = t.slots[i].load(std::memory_order_relaxed);
+        if (v == 0) return false;
+        if ((v >> 2) == code) { win = (v & 2) != 0; return true; }
+    }
+}
+
+static void ResultTable_Store(ResultTable &t, uint64_t code, bool win)
+{
+    uint64_t entry = code << 2 | (win ? 2 : 1);
+    for (uint64_t i = SlotOf(t, code); ; i = (i + 1) & t.mask)
+    {
+        uint64_t v = t.slots[i].load(std::memory_order_relaxed);
+        if (v == 0)
+        {
+            if (t.slots[i].compare_exchange_strong(v, entry, std::memory_order_relaxed))
+            {
+                t.used.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        if ((v >> 2) == code) return;       // another thread proved the same position
+    }
+}
+
+// ---- solver ----
+
+struct Solver
+{
+    ResultTable table;
+    const PositionKernels* kernels = nullptr;
+    EvalFunc evaluate = nullptr;
+    std::atomic<bool> stop;
+    std::atomic<bool> tableFull;
+    std::atomic<uint64_t> nodes;
+    std::atomic<int> finished;              // id of the thread that solved the root, -1 while running
+};
+
+struct SolverThread
+{
+    int id = 0;
+    uint32_t rng = 0;
+    uint64_t nodes = 0;
+    bool rootWin = false;
+    std::vector<PosMove> moves[SOLVE_MAX_PLY + 1];
+    std::vector<std::pair<int, int>> order[SOLVE_MAX_PLY + 1];   // (ordering key, move index)
+};
+
+// Solves 'pos' for the side to move; false if the solve was stopped before the result was known.
+static bool SolvePosition(Solver &s, SolverThread &t, Position &pos, int ply, bool &win)
+{
+    if ((++t.nodes & 1023) == 0)
+    {
+        s.nodes.fetch_add(1024, std::memory_order_relaxed);
+        if (s.table.used.load(std::memory_order_relaxed) > s.table.limit) s.tableFull = true;
+        if (s.tableFull || s.stop) return false;
+    }
+    uint64_t code;
+    SolvedTable_Code(pos, code);
+    if (ResultTable_Find(s.table, code, win)) return true;
+
+    std::vector<PosMove> &moves = t.moves[ply];
+    std::vector<std::pair<int, int>> &order = t.order[ply];
+    s.kernels->generateMoves(pos, moves);
+    order.clear();
+    win = false;
+    // cheap proofs first: a move that leaves the opponent stuck or in a position already known lost
+    for (size_t i = 0; i < moves.size() && !win; ++i)
+    {
+        s.kernels->makeMove(pos, moves[i]);
+        uint64_t childCode;
+        bool childWin;
+        if (!s.kernels->hasAnyMove(pos)) win = true;
+        else if (SolvedTable_Code(pos, childCode) && ResultTable_Find(s.table, childCode, childWin)) win = !childWin;
+        else
+        {
+            // best first for the mover: lowest territory score for the opponent. Helpers shuffle
+            // only near the root: deeper down, a different winning move just means a different proof.
+            int key = s.evaluate(pos);
+            if (t.id != 0 && ply < 2)
+            {
+                t.rng = t.rng * 1664525u + 1013904223u;
+                key += (int)(t.rng >> 24) % (2 * EVAL_SQUARE);
+            }
+            order.push_back(std::make_pair(key, (int)i));
+        }
+        s.kernels->unmakeMove(pos, moves[i]);
+    }
+    if (!win)
+    {
+        std::sort(order.begin(), order.end());
+        for (size_t i = 0; i < order.size() && !win; ++i)
+        {
+            // the child lists of this ply may be reused below, so copy the move first
+            PosMove m = t.moves[ply][order[i].second];
+            bool childWin;
+            s.kernels->makeMove(pos, m);
+            bool solved = SolvePosition(s, t, pos, ply + 1, childWin);
+            s.kernels->unmakeMove(pos, m);
+            if (!solved) return false;
+            win = !childWin;
+        }
+    }
+    ResultTable_Store(s.table, code, win);
+    return true;
+}
+
+static void SolverLoop(Solver &s, SolverThread &t, Position pos)
+{
+    if (!SolvePosition(s, t, pos, 0, t.rootWin)) return;
+    int none = -1;
+    s.finished.compare_exchange_strong(none, t.id);
+    s.stop = true;
+}
+
+// Parses "<size>" (standard setup) or "<game.pbn>" (its setup and moves) into a root position.
+static bool LoadRoot(const char* arg, Position &out)
+{
+    bool number = *arg != 0;
+    for (const char* p = arg; *p; ++p) number = number && *p >= '0' && *p <= '9';
+    if (!number) return Tool_LoadPbnPosition(arg, -1, out);
+    int size = atoi(arg);
+    if (!Position_HasStandardSetup(size))
+    {
+        fprintf(stderr, "%dx%d has no standard setup; give a .pbn with WhiteAmazons/BlackAmazons headers\n", size, size);
+        return false;
+    }
+    Position_Init(out, size);
+    return true;
+}
+
+int Tool_Solve(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: solve <out.amzs> <size|game.pbn> [threads] [tableMB]\n");
+        return 1;
+    }
+    Position root;
+    if (!LoadRoot(argv[1], root)) return 1;
+    if (SolvedTable_CodeBits(root.size) == 0)
+    {
+        fprintf(stderr, "boards above %dx%d cannot be solved\n", SOLVED_TABLE_MAX_SIDE, SOLVED_TABLE_MAX_SIDE);
+        return 1;
+    }
+    int threads = (argc > 2) ? atoi(argv[2]) : (int)std::thread::hardware_concurrency();
+    int tableMB = (argc > 3) ? atoi(argv[3]) : 1024;
+    threads = std::max(1, std::min(threads, 64));
+    tableMB = std::max(tableMB, 1);
+
+    Solver s;
+    ResultTable_Init(s.table, (size_t)tableMB);
+    s.kernels = &Position_GetKernels(root.size);
+    s.evaluate = Eval_GetTerritoryKernel(root.size);
+    s.stop = false;
+    s.tableFull = false;
+    s.nodes = 0;
+    s.finished = -1;
+
+    printf("solving %dx%d on %d threads, %d MB table (%llu slots)\n", root.size, root.size, threads, tableMB,
+        (unsigned long long)(s.table.mask + 1));
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::unique_ptr<SolverThread>> state;
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i)
+    {
+        state.emplace_back(new SolverThread());
+        state.back()->id = i;
+        state.back()->rng = 0x9E3779B9u * (uint32_t)(i + 1);
+    }
+    for (int i = 0; i < threads; ++i) workers.emplace_back(SolverLoop, std::ref(s), std::ref(*state[i]), root);
+
+    // progress once a second until a thread finishes or the table fills up
+    double lastReport = 0.0;
+    while (!s.stop && !s.tableFull)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (secs - lastReport < 1.0) continue;
+        lastReport = secs;
+        uint64_t used = s.table.used.load(std::memory_order_relaxed);
+        uint64_t nodes = s.nodes.load(std::memory_order_relaxed);
+        printf("[%6.0fs] nodes %llu (%.2f M/s)  solved %llu (%.1f%% of table)  peak memory %.0f MB\n", secs,
+            (unsigned long long)nodes, nodes / secs / 1e6, (unsigned long long)used, 100.0 * used / (s.table.mask + 1),
+            PeakMemoryBytes() / 1048576.0);
+        fflush(stdout);
+    }
+    for (auto &w : workers) w.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t nodes = 0;
+    for (auto &t : state) nodes += t->nodes;
+
+    if (s.finished < 0)
+    {
+        fprintf(stderr, "result table full after %.0f s (%llu positions); rerun with a larger tableMB\n", secs,
+            (unsigned long long)s.table.used.load());
+        return 2;
+    }
+    printf("%s to move %s: %llu nodes in %.1f s (%.2f M/s), %llu positions solved, thread %d finished\n",
+        root.blackToMove ? "black" : "white", state[s.finished]->rootWin ? "wins" : "loses", (unsigned long long)nodes, secs,
+        nodes / secs / 1e6, (unsigned long long)s.table.used.load(), s.finished.load());
+
+    // the table's own slots become the list of entries: code << 1 | win, sorted by the writer
+    std::vector<uint64_t> entries;
+    entries.reserve((size_t)s.table.used.load());
+    for (uint64_t i = 0; i <= s.table.mask; ++i)
+    {
+        uint64_t v = s.table.slots[i].load(std::memory_order_relaxed);
+        if (v) entries.push_back((v >> 2) << 1 | ((v & 2) ? 1 : 0));
+    }
+    s.table.slots.reset();
+    if (!SolvedTable_Write(argv[0], root.size, entries))
+    {
+        fprintf(stderr, "cannot write %s\n", argv[0]);
+        return 1;
+    }
+    SolvedTable written;
+    if (SolvedTable_Open(written, argv[0]))
+    {
+        printf("wrote %s: %llu positions, %.1f bits each (%d-bit codes), peak memory %.0f MB\n", argv[0],
+            (unsigned long long)written.entryCount, written.file.size * 8.0 / std::max<uint64_t>(written.entryCount, 1),
+            SolvedTable_CodeBits(root.size), PeakMemoryBytes() / 1048576.0);
+        SolvedTable_Close(written);
+    }
+    return 0;
+}
+
+int Tool_SolveQuery(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: solve-query <table.amzs> <game.pbn> [ply]\n");
+        return 1;
+    }
+    SolvedTable table;
+    if (!SolvedTable_Open(table, argv[0]))
+    {
+        fprintf(stderr, "cannot open %s\n", argv[0]);
+        return 1;
+    }
+    Position pos;
+    int ply = (argc > 2) ? atoi(argv[2]) : -1;
+    if (!Tool_LoadPbnPosition(argv[1], ply, pos))
+    {
+        SolvedTable_Close(table);
+        return 1;
+    }
+    bool win;
+    if (!SolvedTable_Probe(table, pos, win))
+    {
+        printf("position not in the table\n");
+        SolvedTable_Close(table);
+        return 0;
+    }
+    printf("%s to move %s\n", pos.blackToMove ? "black" : "white", win ? "wins" : "loses");
+    std::vector<PosMove> moves;
+    Position_GenerateMoves(pos, moves);
+    for (const PosMove &m : moves)
+    {
+        Position child = pos;
+        Position_MakeMove(child, m);
+        bool childWin;
+        bool known = SolvedTable_Probe(table, child, childWin);
+        bool stuck = !Position_HasAnyMove(child);
+        if (stuck || (known && !childWin)) printf("  winning move %s\n", Engine_MoveToString(pos, m).c_str());
+    }
+    SolvedTable_Close(table);
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include "thread_pool.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct PoolWorker
+{
+    std::mutex lock;
+    std::deque<ThreadPoolTask> tasks;
+    std::thread thread;
+};
+
+struct ThreadPool
+{
+    std::vector<std::unique_ptr<PoolWorker>> workers;
+    std::atomic<size_t> queued{ 0 };
+    std::atomic<size_t> nextWorker{ 0 };
+    std::atomic<uint64_t> steals{ 0 };
+    std::mutex sleepLock;                   // guards the wait on 'wake' and 'stopping'
+    std::condition_variable wake;
+    bool stopping = false;
+};
+
+static bool TakeTask(ThreadPool* pool, int self, ThreadPoolTask &out)
+{
+    int n = (int)pool->workers.size();
+    for (int k = 0; k < n; ++k)
+    {
+        PoolWorker &w = *pool->workers[(size_t)((self + k) % n)];
+        std::lock_guard<std::mutex> guard(w.lock);
+        if (w.tasks.empty()) continue;
+        if (k == 0)
+        {
+            out = std::move(w.tasks.front());
+            w.tasks.pop_front();
+        }
+        else
+        {
+            out = std::move(w.tasks.back());
+            w.tasks.pop_back();
+            pool->steals.fetch_add(1, std::memory_order_relaxed);
+        }
+        pool->queued.fetch_sub(1);
+        return true;
+    }
+    return false;
+}
+
+static void WorkerLoop(ThreadPool* pool, int self)
+{
+    for (;;)
+    {
+        ThreadPoolTask task;
+        if (TakeTask(pool, self, task))
+        {
+            task(self);
+            continue;
+        }
+        std::unique_lock<std::mutex> guard(pool->sleepLock);
+        pool->wake.wait(guard, [pool]() { return pool->queued.load() > 0 || pool->stopping; });
+        if (pool->stopping && pool->queued.load() == 0) return;
+    }
+}
+
+ThreadPool* ThreadPool_Create(int threads)
+{
+    ThreadPool* pool = new ThreadPool();
+    if (threads < 1) threads = 1;
+    for (int i = 0; i < threads; ++i) pool->workers.emplace_back(new PoolWorker());
+    for (int i = 0; i < threads; ++i) pool->workers[(size_t)i]->thread = std::thread(WorkerLoop, pool, i);
+    return pool;
+}
+
+void ThreadPool_Destroy(ThreadPool* pool)
+{
+    if (!pool) return;
+    {
+        std::lock_guard<std::mutex> guard(pool->sleepLock);
+        pool->stopping = true;
+    }
+    pool->wake.notify_all();
+    for (auto &w : pool->workers) w->thread.join();
+    delete pool;
+}
+
+void ThreadPool_Submit(ThreadPool* pool, ThreadPoolTask task)
+{
+    {
+        // counted before it is queued, so 'queued' never drops below zero when a worker takes it at
+        // once; under the lock so a worker between its predicate check and its wait gets the wakeup
+        std::lock_guard<std::mutex> guard(pool->sleepLock);
+        pool->queued.fetch_add(1);
+    }
+    size_t i = pool->nextWorker.fetch_add(1) % pool->workers.size();
+    {
+        std::lock_guard<std::mutex> guard(pool->workers[i]->lock);
+        pool->workers[i]->tasks.push_back(std::move(task));
+    }
+    pool->wake.notify_one();
+}
+
+int ThreadPool_Threads(const ThreadPool* pool) { return (int)pool->workers.size(); }
+size_t ThreadPool_Queued(const ThreadPool* pool) { return pool->queued.load(); }
+uint64_t ThreadPool_Steals(const ThreadPool* pool) { return pool->steals.load(); }
@@ -0,0 +1,23 @@
+#pragma once
+
+// Fixed set of worker threads with a task deque each. Submitted tasks are dealt to the deques in
+// turn; a worker runs its own tasks oldest first and, once its deque is empty, steals the newest task
+// of another worker, so one long task does not hold up the tasks queued behind it.
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// receives the index of the worker running it (0 .. threads-1), e.g. to pick per-worker state
+typedef std::function<void(int worker)> ThreadPoolTask;
+
+struct ThreadPool;
+
+ThreadPool* ThreadPool_Create(int threads);
+// runs the tasks still queued, then stops and joins the workers
+void ThreadPool_Destroy(ThreadPool* pool);
+
+void ThreadPool_Submit(ThreadPool* pool, ThreadPoolTask task);
+int ThreadPool_Threads(const ThreadPool* pool);
+size_t ThreadPool_Queued(const ThreadPool* pool);     // submitted and not yet started
+uint64_t ThreadPool_Steals(const ThreadPool* pool);   // tasks run by a worker other than the one dealt
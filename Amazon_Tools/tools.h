@@ -0,0 +1,47 @@
+#pragma once
+
+// Headless command-line tools for the Amazons project (benchmarks, converters).
+// Each command receives the arguments after its name and returns a process exit code.
+
+#include <string>
+
+struct Position;
+struct SearchLimits;
+
+int Tool_BenchSeek(int argc, char** argv);
+int Tool_PbnToArchive(int argc, char** argv);
+int Tool_ArchiveToPbn(int argc, char** argv);
+int Tool_ArchiveInfo(int argc, char** argv);
+int Tool_PbnBench(int argc, char** argv);
+int Tool_IndexBuild(int argc, char** argv);
+int Tool_IndexQuery(int argc, char** argv);
+int Tool_Search(int argc, char** argv);
+int Tool_TraceSearch(int argc, char** argv);
+int Tool_BenchBoard(int argc, char** argv);
+int Tool_Solve(int argc, char** argv);
+int Tool_SolveQuery(int argc, char** argv);
+int Tool_BenchEndgame(int argc, char** argv);
+int Tool_Match(int argc, char** argv);
+int Tool_MatchCoordinator(int argc, char** argv);
+int Tool_MatchWorker(int argc, char** argv);
+int Tool_Serve(int argc, char** argv);
+int Tool_ServeLoad(int argc, char** argv);
+int Tool_BenchSessions(int argc, char** argv);
+int Tool_BenchEval(int argc, char** argv);
+int Tool_SelfPlay(int argc, char** argv);
+int Tool_ShardInfo(int argc, char** argv);
+int Tool_BenchShards(int argc, char** argv);
+int Tool_BenchSuite(int argc, char** argv);
+int Tool_Analyze(int argc, char** argv);
+int Tool_CodecPack(int argc, char** argv);
+int Tool_CodecUnpack(int argc, char** argv);
+int Tool_BenchCodec(int argc, char** argv);
+
+// whole-file helpers shared by the commands (binary mode)
+bool Tool_ReadFile(const char* path, std::string &out);
+bool Tool_WriteFile(const char* path, const std::string &data);
+// position after 'ply' moves (< 0: all moves) of the first game in a .pbn file; reports errors itself
+bool Tool_LoadPbnPosition(const char* path, int ply, Position &out);
+// selective search settings "lmr,destinations,arrows" (SearchLimits::lmrMoves, keepDestinations,
+// keepArrows); "-" leaves them off
+bool Tool_ParseSelective(const char* text, SearchLimits &limits);
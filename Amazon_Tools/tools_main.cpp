@@ -0,0 +1,133 @@
+// tools_main.cpp : entry point of the headless Amazons tool; dispatches to one command per sub-name.
+//
+
+#include "tools.h"
+#include "byte_io.h"
+#include "engine.h"
+#include "game_archive.h"
+#include "position.h"
+#include <cstdio>
+#include <cstring>
+
+struct ToolCommand
+{
+    const char* name;
+    int (*run)(int argc, char** argv);
+    const char* help;
+};
+
+static const ToolCommand s_commands[] =
+{
+    { "bench-seek",   Tool_BenchSeek,    "[games] [seeks]                 time random history seeks on long random games" },
+    { "pbn2bin",      Tool_PbnToArchive, "<out.amzb> <in.pbn>...          pack .pbn games into a binary archive" },
+    { "bin2pbn",      Tool_ArchiveToPbn, "<in.amzb> <index> <out.pbn>     extract one archived game as .pbn" },
+    { "archive-info", Tool_ArchiveInfo,  "<in.amzb>                       print game and move counts" },
+    { "pbn-bench",    Tool_PbnBench,     "<in.pbn> [passes]               measure .pbn parse throughput" },
+    { "index-build",  Tool_IndexBuild,   "<out.amzx> <in.amzb>            index every position of an archive" },
+    { "index-query",  Tool_IndexQuery,   "<index.amzx> <game.pbn> [ply]   games that reached a .pbn position" },
+    { "analyze",      Tool_Analyze,      "<outPrefix> <threads|0> <plies>[:minGames] <in.amzb|in.pbn>...  opening win rates, heatmaps, game lengths as JSON/CSV" },
+    { "amzc-pack",    Tool_CodecPack,    "<out.amzc> <in.amzb> [gamesPerBlock] [threads]  entropy-code an archive for cold storage" },
+    { "amzc-unpack",  Tool_CodecUnpack,  "<in.amzc> <out.amzb> [threads]  decode a coded archive back to .amzb" },
+    { "bench-codec",  Tool_BenchCodec,   "<in.amzb> [threads] [gamesPerBlock] [out.pbn]  .pbn/.amzb/.amzc sizes, coding speed, round trip" },
+    { "bench-board",  Tool_BenchBoard,   "[games]                         movegen and eval throughput per board size" },
+    { "bench-eval",   Tool_BenchEval,    "[games] [size] [nodes]          incremental vs. full territory eval on self-play positions" },
+    { "bench-suite",  Tool_BenchSuite,   "[out.json|-] [baseline.json|-] [threshold%] [corpus.amzb|-] [reps]  every hot path, compared to a baseline" },
+    { "solve",        Tool_Solve,        "<out.amzs> <size|game.pbn> [threads] [tableMB]  solve a 5x5/6x6 position, export the table" },
+    { "solve-query",  Tool_SolveQuery,   "<table.amzs> <game.pbn> [ply]   solved result and winning moves of a position" },
+    { "bench-endgame", Tool_BenchEndgame, "[positions] [nodes] [empty]     df-pn solve times on a fixed 10x10 endgame suite" },
+    { "match",        Tool_Match,        "<out.amzb> <games> [size] [A] [B] [threads] [seed]  engine A vs B on paired openings; A/B: <nodes>|<ms>ms[:depth[:lmr,dest,arrows]]" },
+    { "match-coord",  Tool_MatchCoordinator, "<out.amzb> <games> <port> [size] [A] [B] [seed] [timeoutS]  hand match games to workers over TCP" },
+    { "match-worker", Tool_MatchWorker,  "<host> <port> [threads]         play match games for a coordinator" },
+    { "selfplay",     Tool_SelfPlay,     "<prefix> <games> [size] [engine] [threads] [seed] [every] [shardRecords]  self-play into training shards" },
+    { "shard-info",   Tool_ShardInfo,    "<prefix> [show] [seed]          training shard counts, label checks, shuffled samples" },
+    { "bench-shards", Tool_BenchShards,  "<prefix> [samples] [threads] [shardRecords]  training shard write and read throughput" },
+    { "serve",        Tool_Serve,        "<port> [threads] [defaultMs] [maxMs] [seconds] [evict.file] [idleS]  host human-vs-AI games, NDJSON on 127.0.0.1" },
+    { "serve-load",   Tool_ServeLoad,    "<host> <port> [clients] [seconds] [ms] [size]  simulated players against serve" },
+    { "bench-sessions", Tool_BenchSessions, "[sessions] [evict.file]      memory per server session, eviction round trip" },
+    { "search",       Tool_Search,       "<game.pbn> [ply] [ms] [depth] [threads] [multipv] [solved.amzs|-] [solverNodes] [lmr,dest,arrows]  search a position, print JSON stats" },
+    { "trace-search", Tool_TraceSearch,  "<game.pbn> <out.json> [ply] [ms] [threads]  record one search as a Chrome trace" },
+};
+
+bool Tool_ReadFile(const char* path, std::string &out)
+{
+    FILE* f = ByteIO_OpenFile(path, "rb");
+    if (!f) return false;
+    out.clear();
+    char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+    bool ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
+
+bool Tool_WriteFile(const char* path, const std::string &data)
+{
+    FILE* f = ByteIO_OpenFile(path, "wb");
+    if (!f) return false;
+    bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+    if (fclose(f) != 0) ok = false;
+    return ok;
+}
+
+bool Tool_LoadPbnPosition(const char* path, int ply, Position &out)
+{
+    std::string text;
+    ArchiveGame game;
+    int badLine = 0;
+    if (!Tool_ReadFile(path, text) || !Archive_GameFromPbn(text.data(), text.size(), game, &badLine))
+    {
+        fprintf(stderr, "cannot read %s (line %d)\n", path, badLine);
+        return false;
+    }
+    size_t count = (ply < 0 || (size_t)ply > game.moves.size()) ? game.moves.size() : (size_t)ply;
+    Position_InitSetup(out, game.boardSize, game.setup);
+    for (size_t i = 0; i < count; ++i)
+    {
+        PosMove m = { game.moves[i].from, game.moves[i].to, game.moves[i].arrow };
+        if (!Position_IsLegalMove(out, m))
+        {
+            fprintf(stderr, "illegal move %zu in %s\n", i + 1, path);
+            return false;
+        }
+        Position_MakeMove(out, m);
+    }
+    return true;
+}
+
+bool Tool_ParseSelective(const char* text, SearchLimits &limits)
+{
+    if (strcmp(text, "-") == 0) return true;
+    int lmr = 0, dest = 0, arrows = 0;
+    if (sscanf(text, "%d,%d,%d", &lmr, &dest, &arrows) != 3 || lmr < 0 || dest < 0 || arrows < 0)
+    {
+        fprintf(stderr, "selective settings are lmr,destinations,arrows (0: off)\n");
+        return false;
+    }
+    limits.lmrMoves = lmr;
+    limits.keepDestinations = dest;
+    limits.keepArrows = arrows;
+    return true;
+}
+
+static void PrintUsage()
+{
+    printf("usage: Amazon_Tools <command> [args]\n\ncommands:\n");
+    for (const auto &c : s_commands) printf("  %-14s %s\n", c.name, c.help);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        PrintUsage();
+        return 1;
+    }
+    for (const auto &c : s_commands)
+    {
+        if (strcmp(argv[1], c.name) == 0) return c.run(argc - 2, argv + 2);
+    }
+    fprintf(stderr, "unknown command: %s\n", argv[1]);
+    PrintUsage();
+    return 1;
+}
@@ -0,0 +1,292 @@
+#include "training_shards.h"
+#include "byte_io.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+static const char kShardMagic[4] = { 'A', 'M', 'Z', 'T' };
+static const char kIndexMagic[4] = { 'A', 'M', 'Z', 'I' };
+static const size_t kShardHeaderSize = 32;
+static const size_t kIndexHeaderSize = 32;
+
+
+static std::string ShardPath(const std::string &prefix, uint32_t shard)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "-%05u.amzt", shard);
+    return prefix + name;
+}
+
+// ---- records ----
+
+// arrow bits, amazons, flags (bit 0: black to move, bits 1-2: result), score, best move
+static size_t ArrowBytes(int size) { return (size_t)(size * size + 7) / 8; }
+
+size_t TrainingSample_RecordSize(int size)
+{
+    return ArrowBytes(size) + 2 * POSITION_AMAZONS + 1 + 2 + 3;
+}
+
+static void Pack(const TrainingSample &s, unsigned char* p)
+{
+    size_t arrowBytes = ArrowBytes(s.boardSize);
+    for (size_t i = 0; i < arrowBytes; ++i) p[i] = (unsigned char)(s.arrows[i >> 3] >> (8 * (i & 7)));
+    p += arrowBytes;
+    memcpy(p, s.amazon, 2 * POSITION_AMAZONS);
+    p += 2 * POSITION_AMAZONS;
+    *p++ = (unsigned char)((s.blackToMove ? 1 : 0) | ((s.result & 3) << 1));
+    ByteIO_PutU16(p, (uint16_t)s.score);
+    p[2] = s.best.from;
+    p[3] = s.best.to;
+    p[4] = s.best.arrow;
+}
+
+void TrainingSample_FromPosition(const Position &pos, TrainingSample &out)
+{
+    memset(out.arrows, 0, sizeof(out.arrows));
+    for (int sq = 0; sq < pos.size * pos.size; ++sq)
+        if (pos.cell[sq] == CELL_ARROW) out.arrows[sq >> 6] |= 1ull << (sq & 63);
+    memcpy(out.amazon, pos.amazon, sizeof(out.amazon));
+    out.boardSize = (uint8_t)pos.size;
+    out.blackToMove = pos.blackToMove;
+}
+
+void TrainingSample_ToPosition(const TrainingSample &s, Position &out)
+{
+    uint8_t cells[POSITION_MAX_SQUARES] = {};
+    for (int sq = 0; sq < s.boardSize * s.boardSize; ++sq)
+        if ((s.arrows[sq >> 6] >> (sq & 63)) & 1) cells[sq] = CELL_ARROW;
+    for (int i = 0; i < POSITION_AMAZONS; ++i)
+    {
+        cells[s.amazon[0][i]] = CELL_WHITE;
+        cells[s.amazon[1][i]] = CELL_BLACK;
+    }
+    Position_SetFromCells(out, s.boardSize, cells, s.blackToMove);
+}
+
+// ---- writing ----
+
+struct TrainingWriter
+{
+    std::string prefix;
+    int boardSize = 0;
+    size_t recordSize = 0;
+    uint32_t perShard = 0;
+
+    std::mutex lock;                // guards the fields below
+    std::string shard;              // records of the shard being filled
+    uint32_t shardNumber = 0;
+    bool failed = false;
+
+    std::mutex indexLock;           // guards 'written' and the index file
+    std::vector<uint64_t> written;  // records per completed shard (0 while one is being written)
+};
+
+static bool WriteIndex(TrainingWriter* w)
+{
+    std::vector<unsigned char> bytes(kIndexHeaderSize + 8 * w->written.size());
+    uint64_t total = 0;
+    for (size_t i = 0; i < w->written.size(); ++i)
+    {
+        ByteIO_PutU64(&bytes[kIndexHeaderSize + 8 * i], w->written[i]);
+        total += w->written[i];
+    }
+    memcpy(&bytes[0], kIndexMagic, 4);
+    ByteIO_PutU32(&bytes[4], TRAINING_SHARD_VERSION);
+    ByteIO_PutU32(&bytes[8], (uint32_t)w->boardSize);
+    ByteIO_PutU32(&bytes[12], (uint32_t)w->recordSize);
+    ByteIO_PutU32(&bytes[16], (uint32_t)w->written.size());
+    ByteIO_PutU64(&bytes[24], total);
+    FILE* f = ByteIO_OpenFile(w->prefix + ".amzi", "wb");
+    if (!f) return false;
+    bool ok = fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+    return fclose(f) == 0 && ok;
+}
+
+static bool WriteShard(TrainingWriter* w, uint32_t number, const std::string &records)
+{
+    uint64_t count = records.size() / w->recordSize;
+    unsigned char header[kShardHeaderSize] = {};
+    memcpy(header, kShardMagic, 4);
+    ByteIO_PutU32(header + 4, TRAINING_SHARD_VERSION);
+    ByteIO_PutU32(header + 8, (uint32_t)w->boardSize);
+    ByteIO_PutU32(header + 12, (uint32_t)w->recordSize);
+    ByteIO_PutU64(header + 16, count);
+    bool ok = false;
+    if (FILE* f = ByteIO_OpenFile(ShardPath(w->prefix, number), "wb"))
+    {
+        ok = fwrite(header, 1, kShardHeaderSize, f) == kShardHeaderSize;
+        ok = ok && fwrite(records.data(), 1, records.size(), f) == records.size();
+        ok = (fclose(f) == 0) && ok;
+    }
+    std::lock_guard<std::mutex> guard(w->indexLock);
+    if (w->written.size() <= number) w->written.resize(number + 1, 0);
+    w->written[number] = ok ? count : 0;
+    return WriteIndex(w) && ok;
+}
+
+TrainingWriter* TrainingWriter_Create(const std::string &prefix, int boardSize, uint32_t recordsPerShard)
+{
+    if (boardSize < POSITION_MIN_SIDE || boardSize > POSITION_MAX_SIDE) return nullptr;
+    TrainingWriter* w = new TrainingWriter();
+    w->prefix = prefix;
+    w->boardSize = boardSize;
+    w->recordSize = TrainingSample_RecordSize(boardSize);
+    w->perShard = std::max<uint32_t>(recordsPerShard, 1);
+    w->shard.reserve((size_t)w->perShard * w->recordSize);
+    return w;
+}
+
+bool TrainingWriter_Add(TrainingWriter* w, const TrainingSample* samples, size_t count)
+{
+    // pack outside the lock; only the copy into the shard is serialised
+    std::string packed(count * w->recordSize, '\0');
+    for (size_t i = 0; i < count; ++i) Pack(samples[i], (unsigned char*)&packed[i * w->recordSize]);
+
+    size_t done = 0;
+    while (done < packed.size())
+    {
+        std::string full;
+        uint32_t number = 0;
+        {
+            std::lock_guard<std::mutex> guard(w->lock);
+            if (w->failed) return false;
+            size_t capacity = (size_t)w->perShard * w->recordSize;
+            size_t take = std::min(packed.size() - done, capacity - w->shard.size());
+            w->shard.append(packed, done, take);
+            done += take;
+            if (w->shard.size() < capacity) break;
+            full.swap(w->shard);
+            w->shard.reserve(capacity);
+            number = w->shardNumber++;
+        }
+        if (!WriteShard(w, number, full))
+        {
+            std::lock_guard<std::mutex> guard(w->lock);
+            w->failed = true;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TrainingWriter_Finish(TrainingWriter* w, uint64_t* outRecords, uint32_t* outShards)
+{
+    bool ok = !w->failed;
+    if (ok && !w->shard.empty()) ok = WriteShard(w, w->shardNumber++, w->shard);
+    if (ok && w->written.empty()) ok = WriteIndex(w);     // no samples: an empty index
+    if (outRecords)
+    {
+        *outRecords = 0;
+        for (uint64_t c : w->written) *outRecords += c;
+    }
+    if (outShards) *outShards = (uint32_t)w->written.size();
+    delete w;
+    return ok;
+}
+
+// ---- reading ----
+
+bool TrainingReader_Open(TrainingReader &r, const std::string &prefix)
+{
+    TrainingReader_Close(r);
+    MappedFile index;
+    if (!MappedFile_Open(index, prefix + ".amzi")) return false;
+    const unsigned char* p = (const unsigned char*)index.data;
+    bool ok = index.size >= kIndexHeaderSize && memcmp(p, kIndexMagic, 4) == 0 && ByteIO_GetU32(p + 4) == TRAINING_SHARD_VERSION;
+    uint32_t shards = ok ? ByteIO_GetU32(p + 16) : 0;
+    ok = ok && index.size >= kIndexHeaderSize + 8ull * shards;
+    if (ok)
+    {
+        r.boardSize = (int)ByteIO_GetU32(p + 8);
+        r.recordSize = ByteIO_GetU32(p + 12);
+        ok = r.boardSize >= POSITION_MIN_SIDE && r.boardSize <= POSITION_MAX_SIDE
+            && r.recordSize == TrainingSample_RecordSize(r.boardSize);
+    }
+    for (uint32_t i = 0; ok && i < shards; ++i)
+    {
+        uint64_t count = ByteIO_GetU64(p + kIndexHeaderSize + 8 * i);
+        if (count == 0) continue;   // not completed when the index was written
+        r.shards.emplace_back();
+        TrainingShard &s = r.shards.back();
+        ok = MappedFile_Open(s.file, ShardPath(prefix, i));
+        const unsigned char* h = (const unsigned char*)s.file.data;
+        ok = ok && s.file.size >= kShardHeaderSize + count * r.recordSize && memcmp(h, kShardMagic, 4) == 0
+            && ByteIO_GetU32(h + 4) == TRAINING_SHARD_VERSION && ByteIO_GetU32(h + 8) == (uint32_t)r.boardSize
+            && ByteIO_GetU32(h + 12) == r.recordSize && ByteIO_GetU64(h + 16) == count;
+        s.records = h + kShardHeaderSize;
+        s.count = count;
+        s.first = r.count;
+        r.count += count;
+    }
+    MappedFile_Close(index);
+    if (!ok) TrainingReader_Close(r);
+    return ok;
+}
+
+void TrainingReader_Close(TrainingReader &r)
+{
+    for (TrainingShard &s : r.shards) MappedFile_Close(s.file);
+    r = TrainingReader();
+}
+
+const uint8_t* TrainingReader_Record(const TrainingReader &r, uint64_t i)
+{
+    // the last shard starting at or before i
+    auto it = std::upper_bound(r.shards.begin(), r.shards.end(), i,
+        [](uint64_t v, const TrainingShard &s) { return v < s.first; });
+    const TrainingShard &s = *(it - 1);
+    return s.records + (i - s.first) * r.recordSize;
+}
+
+void TrainingReader_Decode(const TrainingReader &r, const uint8_t* p, TrainingSample &out)
+{
+    size_t arrowBytes = ArrowBytes(r.boardSize);
+    memset(out.arrows, 0, sizeof(out.arrows));
+    for (size_t i = 0; i < arrowBytes; ++i) out.arrows[i >> 3] |= (uint64_t)p[i] << (8 * (i & 7));
+    p += arrowBytes;
+    memcpy(out.amazon, p, 2 * POSITION_AMAZONS);
+    p += 2 * POSITION_AMAZONS;
+    out.boardSize = (uint8_t)r.boardSize;
+    out.blackToMove = (*p & 1) != 0;
+    out.result = (uint8_t)((*p >> 1) & 3);
+    ++p;
+    out.score = (int16_t)ByteIO_GetU16(p);
+    out.best.from = p[2];
+    out.best.to = p[3];
+    out.best.arrow = p[4];
+}
+
+static uint64_t Mix(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// A four-round Feistel network permutes the smallest even power of two covering count; values
+// landing outside 0..count-1 are permuted again until they fall inside (cycle walking), which keeps
+// the map a permutation and takes fewer than four passes on average.
+uint64_t TrainingReader_Shuffled(const TrainingReader &r, uint64_t seed, uint64_t i)
+{
+    if (r.count <= 1) return 0;
+    int bits = 2;
+    while (bits < 64 && (1ull << bits) < r.count) bits += 2;
+    int half = bits / 2;
+    uint64_t mask = (1ull << half) - 1;
+    uint64_t x = i;
+    do
+    {
+        uint64_t left = x >> half, right = x & mask;
+        for (uint64_t round = 0; round < 4; ++round)
+        {
+            uint64_t f = Mix(right ^ Mix(seed + round)) & mask;
+            uint64_t next = left ^ f;
+            left = right;
+            right = next;
+        }
+        x = (left << half) | right;
+    } while (x >= r.count);
+    return x;
+}
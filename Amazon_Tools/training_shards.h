@@ -0,0 +1,84 @@
+#pragma once
+
+// Labelled positions for training evaluators, written by self-play (selfplay in match_tools.cpp)
+// into numbered shard files and read back in place through memory maps.
+//
+// A sample is a position (arrow bitboard, amazon squares, side to move), the search score and best
+// move for the side to move, and the result of the game it came from. Records are bit-packed to a
+// fixed size per board: the arrows take one bit per square, so a 10x10 sample is 27 bytes. Fixed
+// records let a reader reach any sample with one multiplication and decode it straight from the
+// mapping, without reading or unpacking a shard.
+//
+// Files for a prefix P (little-endian):
+//   P-00000.amzt ...   shard: "AMZT", u32 version, u32 boardSize, u32 recordSize, u64 records,
+//                      u64 reserved, then the records
+//   P.amzi             index: "AMZI", u32 version, u32 boardSize, u32 recordSize, u32 shards,
+//                      u32 reserved, u64 records, then u64 records per shard
+// Every shard holds the writer's recordsPerShard samples except the last. The index is rewritten as
+// each shard completes, so an interrupted run leaves the finished shards readable.
+
+#include "mapped_file.h"
+#include "position.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define TRAINING_SHARD_VERSION 1
+
+struct TrainingSample
+{
+    uint64_t arrows[4] = {};        // bit sq of word sq / 64 (bitboard.h layout)
+    uint8_t amazon[2][POSITION_AMAZONS] = {};   // [0] white, [1] black
+    uint8_t boardSize = 0;
+    bool blackToMove = false;
+    uint8_t result = 0;             // GAME_RESULT_* (position_index.h)
+    int16_t score = 0;              // search score for the side to move, clamped to int16
+    PosMove best = {};
+};
+
+// record bytes of one sample on a board of 'size'
+size_t TrainingSample_RecordSize(int size);
+void TrainingSample_FromPosition(const Position &pos, TrainingSample &out);
+// the position of a sample (arrows and amazons; hashes recomputed)
+void TrainingSample_ToPosition(const TrainingSample &s, Position &out);
+
+// ---- writing ----
+
+struct TrainingWriter;
+
+// recordsPerShard: samples per shard file (at least 1)
+TrainingWriter* TrainingWriter_Create(const std::string &prefix, int boardSize, uint32_t recordsPerShard);
+// Thread-safe. Samples are packed by the caller's thread; a thread that fills a shard writes it out
+// while the others carry on with the next one. False once a write has failed.
+bool TrainingWriter_Add(TrainingWriter* w, const TrainingSample* samples, size_t count);
+// writes the last, partial shard and the index, and frees the writer; false if any write failed
+bool TrainingWriter_Finish(TrainingWriter* w, uint64_t* outRecords = nullptr, uint32_t* outShards = nullptr);
+
+// ---- reading ----
+
+struct TrainingShard
+{
+    MappedFile file;
+    const uint8_t* records = nullptr;
+    uint64_t count = 0;
+    uint64_t first = 0;             // index of its first sample across all shards
+};
+
+struct TrainingReader
+{
+    std::vector<TrainingShard> shards;
+    uint64_t count = 0;
+    int boardSize = 0;
+    size_t recordSize = 0;
+};
+
+bool TrainingReader_Open(TrainingReader &r, const std::string &prefix);
+void TrainingReader_Close(TrainingReader &r);
+// record bytes of sample i (< r.count) inside the mapping
+const uint8_t* TrainingReader_Record(const TrainingReader &r, uint64_t i);
+void TrainingReader_Decode(const TrainingReader &r, const uint8_t* record, TrainingSample &out);
+// A permutation of 0..r.count-1 chosen by 'seed', computed per position without a table, so a
+// shuffled pass over any number of samples needs no memory: visit TrainingReader_Shuffled(r, seed, i)
+// for i = 0, 1, ...
+uint64_t TrainingReader_Shuffled(const TrainingReader &r, uint64_t seed, uint64_t i);
@@ -0,0 +1,208 @@
+// training_tools.cpp : inspecting training shards (training_shards.h) and timing their writer and
+// reader. The shards themselves are produced by selfplay (match_tools.cpp).
+
+#include "tools.h"
+#include "engine.h"
+#include "position.h"
+#include "position_index.h"
+#include "training_shards.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+static double SecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// order-independent fingerprint of a sample; sums over a set compare written and read data
+static uint64_t SampleHash(const TrainingSample &s)
+{
+    uint64_t h = 0x9e3779b97f4a7c15ull;
+    auto mix = [&h](uint64_t v) { h = (h ^ v) * 0x100000001b3ull; h ^= h >> 29; };
+    for (int i = 0; i < 4; ++i) mix(s.arrows[i]);
+    uint64_t amazons;
+    memcpy(&amazons, s.amazon, sizeof(amazons));
+    mix(amazons);
+    mix((uint64_t)(s.blackToMove ? 1 : 0) | (uint64_t)s.result << 1 | (uint64_t)(uint16_t)s.score << 8);
+    mix((uint64_t)s.best.from | (uint64_t)s.best.to << 8 | (uint64_t)s.best.arrow << 16);
+    return h;
+}
+
+// the sample's squares are consistent and its move is legal
+static bool IsValidSample(const TrainingSample &s)
+{
+    int n = s.boardSize * s.boardSize;
+    uint8_t used[POSITION_MAX_SQUARES] = {};
+    for (int sq = 0; sq < n; ++sq) used[sq] = (s.arrows[sq >> 6] >> (sq & 63)) & 1;
+    for (int side = 0; side < 2; ++side)
+        for (int i = 0; i < POSITION_AMAZONS; ++i)
+        {
+            int sq = s.amazon[side][i];
+            if (sq >= n || used[sq]) return false;
+            used[sq] = 1;
+        }
+    Position pos;
+    TrainingSample_ToPosition(s, pos);
+    return Position_IsLegalMove(pos, s.best);
+}
+
+// shard-info <prefix> [show] [seed]
+int Tool_ShardInfo(int argc, char** argv)
+{
+    if (argc < 1)
+    {
+        fprintf(stderr, "usage: shard-info <prefix> [show] [seed]\n");
+        return 1;
+    }
+    int show = (argc > 1) ? atoi(argv[1]) : 5;
+    uint64_t seed = (argc > 2) ? strtoull(argv[2], nullptr, 10) : 1;
+    TrainingReader r;
+    if (!TrainingReader_Open(r, argv[0]))
+    {
+        fprintf(stderr, "cannot open training shards %s\n", argv[0]);
+        return 1;
+    }
+    printf("%dx%d, %llu samples in %zu shards, %zu bytes each\n", r.boardSize, r.boardSize,
+        (unsigned long long)r.count, r.shards.size(), r.recordSize);
+
+    // one shuffled pass over everything
+    uint64_t blackToMove = 0, blackWins = 0, agree = 0, decided = 0, invalid = 0;
+    double absScore = 0.0;
+    TrainingSample s;
+    Position pos;
+    for (uint64_t i = 0; i < r.count; ++i)
+    {
+        TrainingReader_Decode(r, TrainingReader_Record(r, TrainingReader_Shuffled(r, seed, i)), s);
+        if (!IsValidSample(s)) ++invalid;
+        blackToMove += s.blackToMove;
+        blackWins += s.result == GAME_RESULT_BLACK;
+        absScore += std::abs(s.score);
+        if (s.score != 0)
+        {
+            // a positive score for the side to move predicts that side's win
+            bool moverWon = (s.result == GAME_RESULT_BLACK) == s.blackToMove;
+            ++decided;
+            agree += (s.score > 0) == moverWon;
+        }
+        if ((int64_t)i < show)
+        {
+            TrainingSample_ToPosition(s, pos);
+            printf("  #%llu %s to move, score %d, best %s, %s won\n",
+                (unsigned long long)TrainingReader_Shuffled(r, seed, i), s.blackToMove ? "black" : "white", s.score,
+                Engine_MoveToString(pos, s.best).c_str(), s.result == GAME_RESULT_BLACK ? "black" : "white");
+        }
+    }
+    double n = (double)std::max<uint64_t>(r.count, 1);
+    printf("black to move %.1f%%, black won %.1f%%, mean |score| %.0f\n", 100.0 * blackToMove / n, 100.0 * blackWins / n,
+        absScore / n);
+    printf("score sign matches the result in %.1f%% of %llu samples; %llu invalid\n",
+        100.0 * agree / std::max<uint64_t>(decided, 1), (unsigned long long)decided, (unsigned long long)invalid);
+    TrainingReader_Close(r);
+    return invalid ? 1 : 0;
+}
+
+// bench-shards <prefix> [samples] [threads] [shardRecords]
+// Writes random-game positions from several threads, then reads them back in order and shuffled.
+int Tool_BenchShards(int argc, char** argv)
+{
+    if (argc < 1)
+    {
+        fprintf(stderr, "usage: bench-shards <prefix> [samples] [threads] [shardRecords]\n");
+        return 1;
+    }
+    uint64_t total = (argc > 1) ? strtoull(argv[1], nullptr, 10) : 4000000;
+    int threads = (argc > 2) ? atoi(argv[2]) : (int)std::thread::hardware_concurrency();
+    uint32_t perShard = (argc > 3) ? (uint32_t)strtoul(argv[3], nullptr, 10) : (1u << 20);
+    if (threads < 1) threads = 1;
+    const int kSize = 10;
+    const size_t kBatch = 40;   // about the samples of one game
+
+    // a pool of sampled positions from random games
+    std::mt19937 rng(7);
+    std::vector<TrainingSample> pool;
+    std::vector<PosMove> moves;
+    while (pool.size() < 100000)
+    {
+        Position pos;
+        Position_Init(pos, kSize);
+        for (;;)
+        {
+            Position_GenerateMoves(pos, moves);
+            if (moves.empty()) break;
+            TrainingSample s;
+            TrainingSample_FromPosition(pos, s);
+            s.best = moves[rng() % moves.size()];
+            s.score = (int16_t)((int)(rng() % 4001) - 2000);
+            s.result = (rng() & 1) ? GAME_RESULT_BLACK : GAME_RESULT_WHITE;
+            pool.push_back(s);
+            Position_MakeMove(pos, s.best);
+        }
+    }
+    uint64_t expected = 0;
+    for (uint64_t i = 0; i < total; ++i) expected += SampleHash(pool[(size_t)(i % pool.size())]);
+
+    TrainingWriter* writer = TrainingWriter_Create(argv[0], kSize, perShard);
+    if (!writer) return 1;
+    std::atomic<uint64_t> next(0);
+    std::atomic<bool> failed(false);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&]() {
+            std::vector<TrainingSample> batch;
+            for (uint64_t first; !failed && (first = next.fetch_add(kBatch)) < total; )
+            {
+                batch.clear();
+                for (uint64_t i = first; i < std::min<uint64_t>(first + kBatch, total); ++i)
+                    batch.push_back(pool[(size_t)(i % pool.size())]);
+                if (!TrainingWriter_Add(writer, batch.data(), batch.size())) failed = true;
+            }
+        });
+    }
+    for (auto &w : workers) w.join();
+    uint64_t records = 0;
+    uint32_t shards = 0;
+    bool ok = TrainingWriter_Finish(writer, &records, &shards) && !failed && records == total;
+    double writeSeconds = SecondsSince(start);
+    double mb = records * TrainingSample_RecordSize(kSize) / 1048576.0;
+    printf("wrote %llu samples in %u shards (%.1f MB) with %d threads in %.2f s: %.2f M samples/s, %.0f MB/s\n",
+        (unsigned long long)records, shards, mb, threads, writeSeconds, records / writeSeconds / 1e6, mb / writeSeconds);
+    if (!ok)
+    {
+        fprintf(stderr, "write error on %s\n", argv[0]);
+        return 1;
+    }
+
+    TrainingReader r;
+    if (!TrainingReader_Open(r, argv[0]))
+    {
+        fprintf(stderr, "cannot open training shards %s\n", argv[0]);
+        return 1;
+    }
+    TrainingSample s;
+    for (int shuffled = 0; shuffled < 2; ++shuffled)
+    {
+        uint64_t sum = 0;
+        start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < r.count; ++i)
+        {
+            uint64_t k = shuffled ? TrainingReader_Shuffled(r, 42, i) : i;
+            TrainingReader_Decode(r, TrainingReader_Record(r, k), s);
+            sum += SampleHash(s);
+        }
+        double seconds = SecondsSince(start);
+        printf("read %s: %.2f M samples/s, samples %s\n", shuffled ? "shuffled" : "in order",
+            r.count / seconds / 1e6, sum == expected ? "ok" : "MISMATCH");
+        ok = ok && sum == expected;
+    }
+    TrainingReader_Close(r);
+    return ok ? 0 : 1;
+}